@@ -2068,6 +2068,18 @@ public static partial class bgfx
 		public long cpuTimeEnd;
 	}
 	
+	public unsafe struct FrameTiming
+	{
+		public uint frameNum;
+		public uint gpuLatency;
+		public long cpuTimeSubmitBegin;
+		public long cpuTimeSubmitEnd;
+		public long cpuTimeRenderBegin;
+		public long cpuTimeRenderEnd;
+		public long gpuTimeBegin;
+		public long gpuTimeEnd;
+	}
+	
 	public unsafe struct Stats
 	{
 		public long cpuTimeFrame;
@@ -2083,6 +2095,7 @@ public static partial class bgfx
 		public uint numCompute;
 		public uint numBlit;
 		public uint maxGpuLatency;
+		public uint gpuFrameLatency;
 		public ushort numDynamicIndexBuffers;
 		public ushort numDynamicVertexBuffers;
 		public ushort numFrameBuffers;
@@ -2109,6 +2122,9 @@ public static partial class bgfx
 		public ViewStats* viewStats;
 		public byte numEncoders;
 		public EncoderStats* encoderStats;
+		public ushort numFrameTimings;
+		public FrameTiming* frameTimings;
+		public uint numFrames;
 	}
 	
 	public unsafe struct VertexLayout
@@ -2368,6 +2384,15 @@ public static partial class bgfx
 	[DllImport(DllName, EntryPoint="bgfx_frame", CallingConvention = CallingConvention.Cdecl)]
 	public static extern unsafe uint frame(bool _capture);
 	
+	/// <summary>
+	/// Sleep API thread just long enough that following `bgfx::frame` call doesn't
+	/// have to wait for render thread. Call it right before sampling input, to
+	/// reduce input latency. Sleep time is predicted from frame timing history.
+	/// </summary>
+	///
+	[DllImport(DllName, EntryPoint="bgfx_pace_frame", CallingConvention = CallingConvention.Cdecl)]
+	public static extern unsafe long pace_frame();
+	
 	/// <summary>
 	/// Returns current renderer backend API type.
 	/// @remarks
@@ -2747,6 +2772,23 @@ public static partial class bgfx
 	[DllImport(DllName, EntryPoint="bgfx_alloc_instance_data_buffer", CallingConvention = CallingConvention.Cdecl)]
 	public static extern unsafe void alloc_instance_data_buffer(InstanceDataBuffer* _idb, uint _num, ushort _stride);
 	
+	/// <summary>
+	/// Check for required space and allocate instance data buffer. If space
+	/// requirement is satisfied function returns true, otherwise `_idb` is
+	/// left untouched.
+	/// @remarks
+	///   Check and allocation are done atomically, it's safe to call from
+	///   multiple threads.
+	/// </summary>
+	///
+	/// <param name="_idb">InstanceDataBuffer structure is filled and is valid for duration of frame, and it can be reused for multiple draw calls.</param>
+	/// <param name="_num">Number of instances.</param>
+	/// <param name="_stride">Instance stride. Must be multiple of 16.</param>
+	///
+	[DllImport(DllName, EntryPoint="bgfx_try_alloc_instance_data_buffer", CallingConvention = CallingConvention.Cdecl)]
+	[return: MarshalAs(UnmanagedType.I1)]
+	public static extern unsafe bool try_alloc_instance_data_buffer(InstanceDataBuffer* _idb, uint _num, ushort _stride);
+	
 	/// <summary>
 	/// Create draw indirect buffer.
 	/// </summary>
@@ -3199,6 +3241,16 @@ public static partial class bgfx
 	[DllImport(DllName, EntryPoint="bgfx_get_result", CallingConvention = CallingConvention.Cdecl)]
 	public static extern unsafe OcclusionQueryResult get_result(OcclusionQueryHandle _handle, int* _result);
 	
+	/// <summary>
+	/// Retrieve number of frames passed since occlusion query result was read back
+	/// from GPU.
+	/// </summary>
+	///
+	/// <param name="_handle">Handle to occlusion query object.</param>
+	///
+	[DllImport(DllName, EntryPoint="bgfx_get_result_age", CallingConvention = CallingConvention.Cdecl)]
+	public static extern unsafe uint get_result_age(OcclusionQueryHandle _handle);
+	
 	/// <summary>
 	/// Destroy occlusion query.
 	/// </summary>
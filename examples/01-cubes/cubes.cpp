@@ -289,10 +289,23 @@ public:
 		m_program = bgfx::createProgram(vsh, fsh, true /* destroy shaders when program is destroyed */);
 #else
 #if !COLORS
-		m_program = loadProgram("vs_cubes", "fs_cubes");
+		const char* fsName = "fs_cubes";
 #else
-		m_program = loadProgram("vs_cubes", "fs_cubes_color");
+		const char* fsName = "fs_cubes_color";
 #endif
+		// Prefer shader archive built with `make archive`, fall back to individual shader
+		// binaries when archive is missing or doesn't contain shaders for this renderer.
+		m_archive = shaderArchiveLoad("01-cubes.sar");
+		m_program.idx = bgfx::kInvalidHandle;
+		if (NULL != m_archive)
+		{
+			m_program = loadProgram(m_archive, "vs_cubes", fsName);
+		}
+
+		if (!bgfx::isValid(m_program) )
+		{
+			m_program = loadProgram("vs_cubes", fsName);
+		}
 #endif
 
 		m_timeOffset = bx::getHPCounter();
@@ -329,6 +342,11 @@ public:
 		// Shutdown bgfx.
 		bgfx::shutdown();
 
+#if !EMBEDDED
+		// Archive memory is referenced by shaders until bgfx is shut down.
+		shaderArchiveUnload(m_archive);
+#endif
+
 		return 0;
 	}
 
@@ -472,6 +490,9 @@ public:
 	bgfx::IndexBufferHandle m_ibh[BX_COUNTOF(s_ptState)];
 	bgfx::UniformHandle u_color;
 	bgfx::ProgramHandle m_program;
+#if !EMBEDDED
+	ShaderArchive* m_archive;
+#endif
 	int64_t m_timeOffset;
 	int32_t m_pt;
 
@@ -116,6 +116,7 @@ public:
 			const bx::Vec3 eye = { 0.0f, 1.0f, -2.5f };
 
 			// Set view and projection matrix for view 0.
+			float viewProj[16];
 			{
 				float view[16];
 				bx::mtxLookAt(view, eye, at);
@@ -123,6 +124,7 @@ public:
 				float proj[16];
 				bx::mtxProj(proj, 60.0f, float(m_width)/float(m_height), 0.1f, 100.0f, bgfx::getCaps()->homogeneousDepth);
 				bgfx::setViewTransform(0, view, proj);
+				bx::mtxMul(viewProj, view, proj);
 
 				// Set view 0 default viewport.
 				bgfx::setViewRect(0, 0, 0, uint16_t(m_width), uint16_t(m_height) );
@@ -134,7 +136,8 @@ public:
 				, time*0.37f
 				);
 
-			meshSubmit(m_mesh, 0, m_program, mtx);
+			// Groups outside of view frustum are not submitted.
+			meshSubmitCulled(m_mesh, 0, m_program, mtx, viewProj);
 
 			// Advance to next frame. Rendering thread will be kicked to
 			// process submitted rendering primitives.
@@ -89,8 +89,10 @@ public:
 						   , 0
 						   );
 
-		// Init the text rendering system.
-		m_fontManager = new FontManager(512);
+		// Init the text rendering system. Glyphs which are not preloaded are
+		// rasterized by worker threads, and drawn as placeholders until they
+		// are added to the atlas.
+		m_fontManager = new FontManager(512, 2);
 		m_textBufferManager = new TextBufferManager(m_fontManager);
 
 		// Load some TTF files.
@@ -124,9 +126,50 @@ public:
 		m_visitor10 = m_fontManager->createFontByPixelSize(m_visitorTtf, 0, 10);
 
 		//create a static text buffer compatible with alpha font
-		//a static text buffer content cannot be modified after its first submit.
+		//static text buffer is uploaded into shared static pool only when its content changes.
 		m_staticText = m_textBufferManager->createTextBuffer(FONT_TYPE_ALPHA, BufferType::Static);
 
+		buildStaticText();
+
+		// Create a transient buffer for real-time data.
+		m_transientText = m_textBufferManager->createTextBuffer(FONT_TYPE_ALPHA, BufferType::Transient);
+
+		imguiCreate();
+	}
+
+	virtual int shutdown() override
+	{
+		imguiDestroy();
+
+		m_fontManager->destroyTtf(m_fontKenneyTtf);
+		m_fontManager->destroyTtf(m_fontAwesomeTtf);
+		m_fontManager->destroyTtf(m_visitorTtf);
+
+		// Destroy the fonts.
+		m_fontManager->destroyFont(m_fontKenney64);
+		m_fontManager->destroyFont(m_fontAwesome72);
+		m_fontManager->destroyFont(m_visitor10);
+		for (uint32_t ii = 0; ii < numFonts; ++ii)
+		{
+			m_fontManager->destroyFont(m_fonts[ii]);
+		}
+
+		m_textBufferManager->destroyTextBuffer(m_staticText);
+		m_textBufferManager->destroyTextBuffer(m_transientText);
+
+		delete m_textBufferManager;
+		delete m_fontManager;
+
+		// Shutdown bgfx.
+		bgfx::shutdown();
+
+		return 0;
+	}
+
+	void buildStaticText()
+	{
+		m_textBufferManager->clearTextBuffer(m_staticText);
+
 		// The pen position represent the top left of the box of the first line
 		// of text.
 		m_textBufferManager->setPenPosition(m_staticText, 24.0f, 100.0f);
@@ -185,40 +228,6 @@ public:
 			" " ICON_KI_DOWNLOAD
 			"\n"
 			);
-
-		// Create a transient buffer for real-time data.
-		m_transientText = m_textBufferManager->createTextBuffer(FONT_TYPE_ALPHA, BufferType::Transient);
-
-		imguiCreate();
-	}
-
-	virtual int shutdown() override
-	{
-		imguiDestroy();
-
-		m_fontManager->destroyTtf(m_fontKenneyTtf);
-		m_fontManager->destroyTtf(m_fontAwesomeTtf);
-		m_fontManager->destroyTtf(m_visitorTtf);
-
-		// Destroy the fonts.
-		m_fontManager->destroyFont(m_fontKenney64);
-		m_fontManager->destroyFont(m_fontAwesome72);
-		m_fontManager->destroyFont(m_visitor10);
-		for (uint32_t ii = 0; ii < numFonts; ++ii)
-		{
-			m_fontManager->destroyFont(m_fonts[ii]);
-		}
-
-		m_textBufferManager->destroyTextBuffer(m_staticText);
-		m_textBufferManager->destroyTextBuffer(m_transientText);
-
-		delete m_textBufferManager;
-		delete m_fontManager;
-
-		// Shutdown bgfx.
-		bgfx::shutdown();
-
-		return 0;
 	}
 
 	bool update() override
@@ -239,6 +248,15 @@ public:
 
 			imguiEndFrame();
 
+			// Add glyphs rasterized since last frame to the atlas. Static text
+			// still contains placeholders for them, and must be rebuilt. It
+			// must be rebuilt also when its glyphs were evicted from the atlas.
+			if (0 < m_fontManager->update()
+			||  m_textBufferManager->isTextBufferStale(m_staticText) )
+			{
+				buildStaticText();
+			}
+
 			// This dummy draw call is here to make sure that view 0 is cleared
 			// if no other draw calls are submitted to view 0.
 			bgfx::touch(0);
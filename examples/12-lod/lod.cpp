@@ -95,11 +95,31 @@ public:
 		m_meshTrunk[1] = meshLoad("meshes/tree1b_lod1_2.bin");
 		m_meshTrunk[2] = meshLoad("meshes/tree1b_lod2_2.bin");
 
+		// Same trees with LOD chain generated by geometryc (--lod), simplified levels are
+		// streamed in from the same file.
+		m_meshChainTop   = meshLoad("meshes/tree1b_1.bin");
+		m_meshChainTrunk = meshLoad("meshes/tree1b_2.bin");
+
+		m_hasLodChain = false;
+		if (NULL != m_meshChainTop
+		&&  NULL != m_meshChainTrunk)
+		{
+			for (uint8_t lod = 1; lod < BX_COUNTOF(m_meshTop); ++lod)
+			{
+				meshLoadLod(m_meshChainTop,   "meshes/tree1b_1.bin", lod);
+				meshLoadLod(m_meshChainTrunk, "meshes/tree1b_2.bin", lod);
+			}
+
+			m_hasLodChain = true;
+		}
+
 		// Imgui.
 		imguiCreate();
 
 		m_scrollArea  = 0;
 		m_transitions = true;
+		m_lodChain    = false;
+		m_pixelError  = 1.0f;
 
 		m_transitionFrame = 0;
 		m_currLod         = 0;
@@ -116,6 +136,16 @@ public:
 			meshUnload(m_meshTrunk[ii]);
 		}
 
+		if (NULL != m_meshChainTop)
+		{
+			meshUnload(m_meshChainTop);
+		}
+
+		if (NULL != m_meshChainTrunk)
+		{
+			meshUnload(m_meshChainTrunk);
+		}
+
 		// Cleanup.
 		bgfx::destroy(m_program);
 
@@ -167,6 +197,16 @@ public:
 			static float distance = 2.0f;
 			ImGui::SliderFloat("Distance", &distance, 2.0f, 6.0f);
 
+			if (m_hasLodChain)
+			{
+				ImGui::Checkbox("Generated LOD chain", &m_lodChain);
+
+				if (m_lodChain)
+				{
+					ImGui::SliderFloat("Pixel error", &m_pixelError, 0.25f, 8.0f);
+				}
+			}
+
 			ImGui::End();
 
 			imguiEndFrame();
@@ -200,6 +240,8 @@ public:
 			float stipple[3];
 			float stippleInv[3];
 
+			const bool lodChain = m_lodChain && m_hasLodChain;
+
 			const int currentLODframe = m_transitions ? 32-m_transitionFrame : 32;
 			const int mainLOD = m_transitions ? m_currLod : m_targetLod;
 
@@ -211,50 +253,37 @@ public:
 			stippleInv[1] = 1.0f;
 			stippleInv[2] = (float(m_transitionFrame)*4.0f/255.0f) - (1.0f/255.0f);
 
-			const uint64_t stateTransparent = 0
-				| BGFX_STATE_WRITE_RGB
-				| BGFX_STATE_WRITE_A
-				| BGFX_STATE_DEPTH_TEST_LESS
-				| BGFX_STATE_CULL_CCW
-				| BGFX_STATE_MSAA
-				| BGFX_STATE_BLEND_ALPHA
-				;
-
-			const uint64_t stateOpaque = BGFX_STATE_DEFAULT;
-
-			bgfx::setTexture(0, s_texColor, m_textureBark);
-			bgfx::setTexture(1, s_texStipple, m_textureStipple);
-			bgfx::setUniform(u_stipple, stipple);
-			meshSubmit(m_meshTrunk[mainLOD], 0, m_program, mtx, stateOpaque);
-
-			bgfx::setTexture(0, s_texColor, m_textureLeafs);
-			bgfx::setTexture(1, s_texStipple, m_textureStipple);
-			bgfx::setUniform(u_stipple, stipple);
-			meshSubmit(m_meshTop[mainLOD], 0, m_program, mtx, stateTransparent);
+			submitTree(lodChain, mainLOD, mtx, stipple);
 
 			if (m_transitions
 			&& (m_transitionFrame != 0) )
 			{
-				bgfx::setTexture(0, s_texColor, m_textureBark);
-				bgfx::setTexture(1, s_texStipple, m_textureStipple);
-				bgfx::setUniform(u_stipple, stippleInv);
-				meshSubmit(m_meshTrunk[m_targetLod], 0, m_program, mtx, stateOpaque);
-
-				bgfx::setTexture(0, s_texColor, m_textureLeafs);
-				bgfx::setTexture(1, s_texStipple, m_textureStipple);
-				bgfx::setUniform(u_stipple, stippleInv);
-				meshSubmit(m_meshTop[m_targetLod], 0, m_program, mtx, stateTransparent);
+				submitTree(lodChain, m_targetLod, mtx, stippleInv);
 			}
 
 			int lod = 0;
-			if (eye.z < -2.5f)
+			if (lodChain)
 			{
-				lod = 1;
+				// LOD error is in mesh units, mesh is scaled down by mtx.
+				const float projScale = float(m_height) / (2.0f*bx::tan(bx::toRad(60.0f)*0.5f) ) * 0.1f;
+				const float dist      = bx::length(eye);
+
+				lod = bx::min(
+					  m_meshChainTop->calcLod(dist, projScale, m_pixelError)
+					, m_meshChainTrunk->calcLod(dist, projScale, m_pixelError)
+					);
 			}
-
-			if (eye.z < -5.0f)
+			else
 			{
-				lod = 2;
+				if (eye.z < -2.5f)
+				{
+					lod = 1;
+				}
+
+				if (eye.z < -5.0f)
+				{
+					lod = 2;
+				}
 			}
 
 			if (m_targetLod != lod)
@@ -286,6 +315,46 @@ public:
 		return false;
 	}
 
+	void submitTree(bool _lodChain, int32_t _lod, const float* _mtx, const float* _stipple)
+	{
+		const uint64_t stateTransparent = 0
+			| BGFX_STATE_WRITE_RGB
+			| BGFX_STATE_WRITE_A
+			| BGFX_STATE_DEPTH_TEST_LESS
+			| BGFX_STATE_CULL_CCW
+			| BGFX_STATE_MSAA
+			| BGFX_STATE_BLEND_ALPHA
+			;
+
+		const uint64_t stateOpaque = BGFX_STATE_DEFAULT;
+
+		bgfx::setTexture(0, s_texColor, m_textureBark);
+		bgfx::setTexture(1, s_texStipple, m_textureStipple);
+		bgfx::setUniform(u_stipple, _stipple);
+
+		if (_lodChain)
+		{
+			meshSubmitLod(m_meshChainTrunk, 0, m_program, _mtx, uint8_t(_lod), stateOpaque);
+		}
+		else
+		{
+			meshSubmit(m_meshTrunk[_lod], 0, m_program, _mtx, stateOpaque);
+		}
+
+		bgfx::setTexture(0, s_texColor, m_textureLeafs);
+		bgfx::setTexture(1, s_texStipple, m_textureStipple);
+		bgfx::setUniform(u_stipple, _stipple);
+
+		if (_lodChain)
+		{
+			meshSubmitLod(m_meshChainTop, 0, m_program, _mtx, uint8_t(_lod), stateTransparent);
+		}
+		else
+		{
+			meshSubmit(m_meshTop[_lod], 0, m_program, _mtx, stateTransparent);
+		}
+	}
+
 	entry::MouseState m_mouseState;
 	uint32_t m_width;
 	uint32_t m_height;
@@ -294,6 +363,8 @@ public:
 
 	Mesh* m_meshTop[3];
 	Mesh* m_meshTrunk[3];
+	Mesh* m_meshChainTop;
+	Mesh* m_meshChainTrunk;
 
 	bgfx::ProgramHandle m_program;
 	bgfx::UniformHandle s_texColor;
@@ -308,7 +379,10 @@ public:
 	int32_t m_transitionFrame;
 	int32_t m_currLod;
 	int32_t m_targetLod;
+	float   m_pixelError;
 	bool    m_transitions;
+	bool    m_lodChain;
+	bool    m_hasLodChain;
 };
 
 } // namespace
@@ -974,8 +974,20 @@ struct Mesh
 
 		for (::GroupArray::iterator it = mesh->m_groups.begin(), itEnd = mesh->m_groups.end(); it != itEnd; ++it)
 		{
+			// Shadow volume construction works on 16-bit indices only. Skip groups stored with
+			// 32-bit indices (geometryc --index32) or as meshlets only.
+			if (NULL == it->m_indices
+			||  UINT16_MAX < it->m_numVertices)
+			{
+				DBG("%s: Skipping group with %u vertices, shadow volumes require 16-bit indices."
+					, _filePath
+					, it->m_numVertices
+					);
+				continue;
+			}
+
 			Group group;
-			group.m_numVertices = it->m_numVertices;
+			group.m_numVertices = uint16_t(it->m_numVertices);
 			const uint32_t vertexSize = group.m_numVertices*stride;
 			group.m_vertices = (uint8_t*)malloc(vertexSize);
 			bx::memCopy(group.m_vertices, it->m_vertices, vertexSize);
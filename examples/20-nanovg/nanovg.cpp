@@ -1423,6 +1423,10 @@ public:
 		m_nvg = nvgCreate(1, 0);
 		bgfx::setViewMode(0, bgfx::ViewMode::Sequential);
 
+		// Batched rendering packs paint parameters into compute buffer, it's
+		// ignored without compute support.
+		nvgSetBatched(m_nvg, 0 != (bgfx::getCaps()->supported & BGFX_CAPS_COMPUTE) );
+
 		loadDemoData(m_nvg, &m_data);
 
 		bndSetFont(createFont(m_nvg, "droidsans", "font/droidsans.ttf") );
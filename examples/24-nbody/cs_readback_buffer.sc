@@ -0,0 +1,26 @@
+/*
+ * Copyright 2011-2019 Branimir Karadzic. All rights reserved.
+ * License: https://github.com/bkaradzic/bgfx#license-bsd-2-clause
+ */
+
+#include "bgfx_compute.sh"
+
+BUFFER_RO(srcBuffer, vec4, 0);
+IMAGE2D_WR(s_dst, rgba32f, 1);
+
+uniform vec4 u_readbackParams;
+
+#define u_readbackNum   floatBitsToUint(u_readbackParams.x)
+#define u_readbackWidth floatBitsToUint(u_readbackParams.y)
+
+NUM_THREADS(64, 1, 1)
+void main()
+{
+	uint idx = gl_GlobalInvocationID.x;
+
+	if (idx < u_readbackNum)
+	{
+		ivec2 pos = ivec2(int(idx % u_readbackWidth), int(idx / u_readbackWidth) );
+		imageStore(s_dst, pos, srcBuffer[idx]);
+	}
+}
@@ -7,6 +7,7 @@
 #include "bgfx_utils.h"
 #include "imgui/imgui.h"
 #include "camera.h"
+#include "readback.h"
 #include <bgfx/bgfx.h>
 
 #define WEBGPU 1
@@ -154,6 +155,8 @@ public:
 
 		imguiCreate();
 
+		m_readback = NULL;
+
 		if (m_computeSupported)
 		{
 			bgfx::VertexLayout quadVertexLayout;
@@ -215,10 +218,45 @@ public:
 
 			m_useIndirect = false;
 
+			// Position readback is optional, it's disabled when copy shader is not available.
+			m_readbackProgram = loadProgram("cs_readback_buffer", NULL);
+			if (bgfx::isValid(m_readbackProgram) )
+			{
+				m_readback = new ReadbackQueue;
+				m_readback->setCopyProgram(m_readbackProgram);
+			}
+			m_readbackEnabled = false;
+			m_centerOfMass[0] = 0.0f;
+			m_centerOfMass[1] = 0.0f;
+			m_centerOfMass[2] = 0.0f;
+			m_readbackLatency = 0;
+
 			m_timeOffset = bx::getHPCounter();
 		}
 	}
 
+	static void readbackCb(void* _userData, ReadbackFence /*_fence*/, const void* _data, uint32_t _size)
+	{
+		ExampleNbody* self = (ExampleNbody*)_userData;
+
+		const float* positions = (const float*)_data;
+		const uint32_t num = _size / (4*sizeof(float) );
+
+		float sum[3] = { 0.0f, 0.0f, 0.0f };
+		for (uint32_t ii = 0; ii < num; ++ii)
+		{
+			sum[0] += positions[ii*4+0];
+			sum[1] += positions[ii*4+1];
+			sum[2] += positions[ii*4+2];
+		}
+
+		const float invNum = 1.0f/float(bx::max<uint32_t>(num, 1) );
+		self->m_centerOfMass[0] = sum[0]*invNum;
+		self->m_centerOfMass[1] = sum[1]*invNum;
+		self->m_centerOfMass[2] = sum[2]*invNum;
+		self->m_readbackLatency = self->m_readback->getNumPending();
+	}
+
 	virtual int shutdown() override
 	{
 		// Cleanup.
@@ -233,6 +271,12 @@ public:
 				bgfx::destroy(m_indirectBuffer);
 			}
 
+			if (NULL != m_readback)
+			{
+				delete m_readback;
+				bgfx::destroy(m_readbackProgram);
+			}
+
 			bgfx::destroy(u_params);
 			bgfx::destroy(m_currPositionBuffer0);
 			bgfx::destroy(m_currPositionBuffer1);
@@ -334,6 +378,21 @@ public:
 					ImGui::Checkbox("Use draw/dispatch indirect", &m_useIndirect);
 				}
 
+				if (NULL != m_readback)
+				{
+					ImGui::Checkbox("Read back positions", &m_readbackEnabled);
+				}
+
+				if (m_readbackEnabled)
+				{
+					ImGui::Text("Center of mass: %.2f, %.2f, %.2f"
+						, m_centerOfMass[0]
+						, m_centerOfMass[1]
+						, m_centerOfMass[2]
+						);
+					ImGui::Text("Readbacks in flight: %u", m_readbackLatency);
+				}
+
 				ImGui::End();
 
 				if (reset)
@@ -369,6 +428,18 @@ public:
 				bx::swap(m_currPositionBuffer0, m_currPositionBuffer1);
 				bx::swap(m_prevPositionBuffer0, m_prevPositionBuffer1);
 
+				if (m_readbackEnabled)
+				{
+					// Readback is skipped while all staging memory is in flight, simulation never
+					// waits for it.
+					m_readback->readBufferAsync(0, 1
+						, m_currPositionBuffer0
+						, m_paramsData.dispatchSize * kThreadGroupUpdateSize
+						, readbackCb
+						, this
+						);
+				}
+
 				// Update camera.
 				cameraUpdate(deltaTime, m_mouseState);
 
@@ -426,7 +497,11 @@ public:
 			static bool capture = false;
 			uint32_t frame = bgfx::frame(capture);
 			capture = frame % capture_freq == 0;
-			BX_UNUSED(frame);
+
+			if (NULL != m_readback)
+			{
+				m_readback->update(frame);
+			}
 
 			return true;
 		}
@@ -459,6 +534,12 @@ public:
 	bgfx::DynamicVertexBufferHandle m_prevPositionBuffer1;
 	bgfx::UniformHandle u_params;
 
+	bgfx::ProgramHandle m_readbackProgram;
+	ReadbackQueue* m_readback;
+	bool m_readbackEnabled;
+	float m_centerOfMass[3];
+	uint32_t m_readbackLatency;
+
 	int64_t m_timeOffset;
 };
 
@@ -6,6 +6,7 @@
 #include "common.h"
 #include "bgfx_utils.h"
 #include "camera.h"
+#include "cpu_occlusion.h"
 #include "imgui/imgui.h"
 
 namespace
@@ -134,6 +135,10 @@ public:
 				m_occlusionQueries[ii] = bgfx::createOcclusionQuery();
 			}
 		}
+		else
+		{
+			m_cpuOcclusion.create(256, 128);
+		}
 
 		cameraCreate();
 
@@ -159,6 +164,10 @@ public:
 				bgfx::destroy(m_occlusionQueries[ii]);
 			}
 		}
+		else
+		{
+			m_cpuOcclusion.destroy();
+		}
 
 		bgfx::destroy(m_ibh);
 		bgfx::destroy(m_vbh);
@@ -184,15 +193,10 @@ public:
 				, uint16_t(m_height)
 				);
 
-			showExampleDialog(this
-				, !m_occlusionQuerySupported
-				? "Occlusion query is not supported."
-				: NULL
-				);
+			showExampleDialog(this);
 
 			imguiEndFrame();
 
-			if (m_occlusionQuerySupported)
 			{
 				int64_t now = bx::getHPCounter();
 				static int64_t last = now;
@@ -207,10 +211,13 @@ public:
 				cameraUpdate(deltaTime, m_state.m_mouse);
 				cameraGetViewMtx(view);
 
+				float viewProj[16];
+
 				// Set view and projection matrix for view 0.
 				{
 					float proj[16];
 					bx::mtxProj(proj, 90.0f, float(m_width)/float(m_height), 0.1f, 10000.0f, bgfx::getCaps()->homogeneousDepth);
+					bx::mtxMul(viewProj, view, proj);
 
 					bgfx::setViewTransform(0, view, proj);
 					bgfx::setViewRect(0, 0, 0, uint16_t(m_width), uint16_t(m_height) );
@@ -229,45 +236,104 @@ public:
 				bgfx::touch(0);
 				bgfx::touch(2);
 
-				uint8_t img[CUBES_DIM*CUBES_DIM*2];
+				float mtxs[CUBES_DIM*CUBES_DIM][16];
 
 				for (uint32_t yy = 0; yy < CUBES_DIM; ++yy)
 				{
 					for (uint32_t xx = 0; xx < CUBES_DIM; ++xx)
 					{
-						float mtx[16];
+						float* mtx = mtxs[yy*CUBES_DIM+xx];
 						bx::mtxRotateXY(mtx, time + xx*0.21f, time + yy*0.37f);
 						mtx[12] = -(CUBES_DIM-1) * 3.0f / 2.0f + float(xx)*3.0f;
 						mtx[13] = 0.0f;
 						mtx[14] = -(CUBES_DIM-1) * 3.0f / 2.0f + float(yy)*3.0f;
+					}
+				}
+
+				uint8_t img[CUBES_DIM*CUBES_DIM*2];
 
-						bgfx::OcclusionQueryHandle occlusionQuery = m_occlusionQueries[yy*CUBES_DIM+xx];
-
-						bgfx::setTransform(mtx);
-						bgfx::setVertexBuffer(0, m_vbh);
-						bgfx::setIndexBuffer(m_ibh);
-						bgfx::setCondition(occlusionQuery, true);
-						bgfx::setState(BGFX_STATE_DEFAULT);
-						bgfx::submit(0, m_program);
-
-						bgfx::setTransform(mtx);
-						bgfx::setVertexBuffer(0, m_vbh);
-						bgfx::setIndexBuffer(m_ibh);
-						bgfx::setState(0
-							| BGFX_STATE_DEPTH_TEST_LEQUAL
-							| BGFX_STATE_CULL_CW
+				if (!m_occlusionQuerySupported)
+				{
+					// Without GPU occlusion queries, cubes are rasterized into CPU depth buffer, and
+					// tested against its Hi-Z before submitting.
+					m_cpuOcclusion.begin(viewProj, bgfx::getCaps()->homogeneousDepth);
+
+					for (uint32_t ii = 0; ii < CUBES_DIM*CUBES_DIM; ++ii)
+					{
+						m_cpuOcclusion.addOccluder(
+							  mtxs[ii]
+							, s_cubeVertices
+							, BX_COUNTOF(s_cubeVertices)
+							, sizeof(PosColorVertex)
+							, s_cubeIndices
+							, BX_COUNTOF(s_cubeIndices)
 							);
-						bgfx::submit(1, m_program, occlusionQuery);
+					}
 
-						bgfx::setTransform(mtx);
-						bgfx::setVertexBuffer(0, m_vbh);
-						bgfx::setIndexBuffer(m_ibh);
-						bgfx::setCondition(occlusionQuery, true);
-						bgfx::setState(BGFX_STATE_DEFAULT);
-						bgfx::submit(2, m_program);
+					m_cpuOcclusion.end();
 
-						img[(yy*CUBES_DIM+xx)*2+0] = " \xfex"[bgfx::getResult(occlusionQuery)];
-						img[(yy*CUBES_DIM+xx)*2+1] = 0xf;
+					for (uint32_t ii = 0; ii < CUBES_DIM*CUBES_DIM; ++ii)
+					{
+						Aabb aabb;
+						toAabb(aabb, mtxs[ii], s_cubeVertices, BX_COUNTOF(s_cubeVertices), sizeof(PosColorVertex) );
+
+						const bool visible = m_cpuOcclusion.isVisible(aabb);
+
+						if (visible)
+						{
+							bgfx::setTransform(mtxs[ii]);
+							bgfx::setVertexBuffer(0, m_vbh);
+							bgfx::setIndexBuffer(m_ibh);
+							bgfx::setState(BGFX_STATE_DEFAULT);
+							bgfx::submit(0, m_program);
+
+							bgfx::setTransform(mtxs[ii]);
+							bgfx::setVertexBuffer(0, m_vbh);
+							bgfx::setIndexBuffer(m_ibh);
+							bgfx::setState(BGFX_STATE_DEFAULT);
+							bgfx::submit(2, m_program);
+						}
+
+						img[ii*2+0] = visible ? uint8_t(0xfe) : uint8_t(' ');
+						img[ii*2+1] = 0xf;
+					}
+				}
+				else
+				{
+					for (uint32_t yy = 0; yy < CUBES_DIM; ++yy)
+					{
+						for (uint32_t xx = 0; xx < CUBES_DIM; ++xx)
+						{
+							const float* mtx = mtxs[yy*CUBES_DIM+xx];
+
+							bgfx::OcclusionQueryHandle occlusionQuery = m_occlusionQueries[yy*CUBES_DIM+xx];
+
+							bgfx::setTransform(mtx);
+							bgfx::setVertexBuffer(0, m_vbh);
+							bgfx::setIndexBuffer(m_ibh);
+							bgfx::setCondition(occlusionQuery, true);
+							bgfx::setState(BGFX_STATE_DEFAULT);
+							bgfx::submit(0, m_program);
+
+							bgfx::setTransform(mtx);
+							bgfx::setVertexBuffer(0, m_vbh);
+							bgfx::setIndexBuffer(m_ibh);
+							bgfx::setState(0
+								| BGFX_STATE_DEPTH_TEST_LEQUAL
+								| BGFX_STATE_CULL_CW
+								);
+							bgfx::submit(1, m_program, occlusionQuery);
+
+							bgfx::setTransform(mtx);
+							bgfx::setVertexBuffer(0, m_vbh);
+							bgfx::setIndexBuffer(m_ibh);
+							bgfx::setCondition(occlusionQuery, true);
+							bgfx::setState(BGFX_STATE_DEFAULT);
+							bgfx::submit(2, m_program);
+
+							img[(yy*CUBES_DIM+xx)*2+0] = " \xfex"[bgfx::getResult(occlusionQuery)];
+							img[(yy*CUBES_DIM+xx)*2+1] = 0xf;
+						}
 					}
 				}
 
@@ -276,9 +342,22 @@ public:
 					bgfx::dbgTextImage(5 + xx*2, 20, 1, CUBES_DIM, img + xx*2, CUBES_DIM*2);
 				}
 
-				int32_t numPixels = 0;
-				bgfx::getResult(m_occlusionQueries[0], &numPixels);
-				bgfx::dbgTextPrintf(5, 20 + CUBES_DIM + 1, 0xf, "Passing pixels count: %d", numPixels);
+				if (m_occlusionQuerySupported)
+				{
+					int32_t numPixels = 0;
+					bgfx::getResult(m_occlusionQueries[0], &numPixels);
+					bgfx::dbgTextPrintf(5, 20 + CUBES_DIM + 1, 0xf, "Passing pixels count: %d", numPixels);
+
+					const uint32_t age = bgfx::getResultAge(m_occlusionQueries[0]);
+					if (UINT32_MAX != age)
+					{
+						bgfx::dbgTextPrintf(5, 20 + CUBES_DIM + 2, 0xf, "Result age: %d frames", age);
+					}
+				}
+				else
+				{
+					bgfx::dbgTextPrintf(5, 20 + CUBES_DIM + 1, 0xf, "Occlusion query is not supported, using CPU Hi-Z.");
+				}
 			}
 
 			// Advance to next frame. Rendering thread will be kicked to
@@ -305,6 +384,7 @@ public:
 	bool m_occlusionQuerySupported;
 
 	bgfx::OcclusionQueryHandle m_occlusionQueries[CUBES_DIM*CUBES_DIM];
+	CpuOcclusion m_cpuOcclusion;
 
 	entry::WindowState m_state;
 };
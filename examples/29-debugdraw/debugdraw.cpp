@@ -11,6 +11,8 @@
 #include "camera.h"
 #include "imgui/imgui.h"
 
+#include <bx/rng.h>
+#include <bx/timer.h>
 #include <bx/uint32_t.h>
 
 #define WEBGPU 1
@@ -760,6 +762,65 @@ void imageCheckerboard(void* _dst, uint32_t _width, uint32_t _height, uint32_t _
 	}
 }
 
+struct BoundsBenchmark
+{
+	double m_scalarFrustum;
+	double m_batchFrustum;
+	double m_scalarRay;
+	double m_batchRay;
+	uint32_t m_numVisible[2];
+	uint32_t m_numHit[2];
+};
+
+// Compares scalar loop against SIMD batch bounds routines.
+static void benchmarkBounds(BoundsBenchmark& _out, const float* _viewProj, const Ray& _ray, uint32_t _num)
+{
+	bx::AllocatorI* allocator = entry::getAllocator();
+
+	Aabb*    aabb = (Aabb*   )BX_ALLOC(allocator, _num*sizeof(Aabb) );
+	uint8_t* mask = (uint8_t*)BX_ALLOC(allocator, _num);
+
+	bx::RngMwc rng;
+	for (uint32_t ii = 0; ii < _num; ++ii)
+	{
+		const bx::Vec3 center = bx::mul(bx::randUnitSphere(&rng), 50.0f);
+		const float    size   = 0.1f + bx::frnd(&rng);
+		toAabb(aabb[ii], center, { size, size, size });
+	}
+
+	bx::Plane planes[6];
+	buildFrustumPlanes(planes, _viewProj);
+
+	const double toMs = 1000.0/double(bx::getHPFrequency() );
+
+	int64_t start = bx::getHPCounter();
+	_out.m_numVisible[0] = 0;
+	for (uint32_t ii = 0; ii < _num; ++ii)
+	{
+		_out.m_numVisible[0] += overlap(aabb[ii], planes, 6);
+	}
+	_out.m_scalarFrustum = double(bx::getHPCounter() - start)*toMs;
+
+	start = bx::getHPCounter();
+	_out.m_numVisible[1] = overlapBatch(mask, aabb, _num, planes);
+	_out.m_batchFrustum = double(bx::getHPCounter() - start)*toMs;
+
+	start = bx::getHPCounter();
+	_out.m_numHit[0] = 0;
+	for (uint32_t ii = 0; ii < _num; ++ii)
+	{
+		_out.m_numHit[0] += intersect(_ray, aabb[ii]);
+	}
+	_out.m_scalarRay = double(bx::getHPCounter() - start)*toMs;
+
+	start = bx::getHPCounter();
+	_out.m_numHit[1] = intersectBatch(mask, NULL, _ray, aabb, _num);
+	_out.m_batchRay = double(bx::getHPCounter() - start)*toMs;
+
+	BX_FREE(allocator, mask);
+	BX_FREE(allocator, aabb);
+}
+
 class ExampleDebugDraw : public entry::AppI
 {
 public:
@@ -816,6 +877,9 @@ public:
 			, s_bunnyTriList
 			);
 
+		m_runBenchmark = false;
+		m_hasBenchmark = false;
+
 		imguiCreate();
 	}
 
@@ -894,6 +958,18 @@ public:
 			static float timeScale = 1.0f;
 			ImGui::SliderFloat("T scale", &timeScale, -1.0f, 1.0f);
 
+			ImGui::Separator();
+
+			m_runBenchmark = ImGui::Button("Benchmark bounds");
+
+			if (m_hasBenchmark)
+			{
+				ImGui::Text("Frustum scalar %.3f ms, %d", m_benchmark.m_scalarFrustum, m_benchmark.m_numVisible[0]);
+				ImGui::Text("Frustum batch  %.3f ms, %d", m_benchmark.m_batchFrustum,  m_benchmark.m_numVisible[1]);
+				ImGui::Text("Ray scalar     %.3f ms, %d", m_benchmark.m_scalarRay,     m_benchmark.m_numHit[0]);
+				ImGui::Text("Ray batch      %.3f ms, %d", m_benchmark.m_batchRay,      m_benchmark.m_numHit[1]);
+			}
+
 			ImGui::End();
 
 			imguiEndFrame();
@@ -939,6 +1015,12 @@ public:
 				, mtxInvVp
 				);
 
+			if (m_runBenchmark)
+			{
+				benchmarkBounds(m_benchmark, mtxVp, ray, 1<<16);
+				m_hasBenchmark = true;
+			}
+
 			constexpr uint32_t kSelected = 0xff80ffff;
 			constexpr uint32_t kOverlapA = 0xff0000ff;
 			constexpr uint32_t kOverlapB = 0xff8080ff;
@@ -1216,6 +1298,10 @@ public:
 	SpriteHandle   m_sprite;
 	GeometryHandle m_bunny;
 
+	BoundsBenchmark m_benchmark;
+	bool m_runBenchmark;
+	bool m_hasBenchmark;
+
 	int64_t m_timeOffset;
 
 	uint32_t m_width;
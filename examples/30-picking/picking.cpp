@@ -5,6 +5,8 @@
 
 #include "common.h"
 #include "bgfx_utils.h"
+#include "bvh.h"
+#include "readback.h"
 #include "imgui/imgui.h"
 #include <bx/rng.h>
 #include <map>
@@ -91,10 +93,11 @@ public:
 		};
 
 		m_highlighted = UINT32_MAX;
-		m_reading = 0;
-		m_currFrame = UINT32_MAX;
+		m_readback = new ReadbackQueue(ID_DIM*ID_DIM*4);
+		m_readFence.id = 0;
 		m_fov = 3.0f;
 		m_cameraSpin = false;
+		m_cpuPicking = false;
 
 		bx::RngMwc mwc;  // Random number generator
 		for (uint32_t ii = 0; ii < 12; ++ii)
@@ -176,6 +179,8 @@ public:
 		bgfx::destroy(m_pickingRTDepth);
 		bgfx::destroy(m_blitTex);
 
+		delete m_readback;
+
 		imguiDestroy();
 
 		// Shutdown bgfx.
@@ -184,6 +189,78 @@ public:
 		return 0;
 	}
 
+	static void readbackCb(void* _userData, ReadbackFence /*_fence*/, const void* _data, uint32_t /*_size*/)
+	{
+		ExamplePicking* self = (ExamplePicking*)_userData;
+		self->m_readFence.id = 0;
+		self->pick( (const uint8_t*)_data);
+	}
+
+	// Look at ID buffer read back from GPU on CPU. Whatever mesh has the most pixels in the ID
+	// buffer is the one the user clicked on.
+	void pick(const uint8_t* _data)
+	{
+		std::map<uint32_t, uint32_t> ids;  // This contains all the IDs found in the buffer
+		uint32_t maxAmount = 0;
+		for (const uint8_t* x = _data; x < _data + ID_DIM * ID_DIM * 4;)
+		{
+			uint8_t rr = *x++;
+			uint8_t gg = *x++;
+			uint8_t bb = *x++;
+			uint8_t aa = *x++;
+
+			if (bgfx::RendererType::Direct3D9 == bgfx::getCaps()->rendererType)
+			{
+				// Comes back as BGRA
+				uint8_t temp = rr;
+				rr = bb;
+				bb = temp;
+			}
+
+			if (0 == (rr|gg|bb) ) // Skip background
+			{
+				continue;
+			}
+
+			uint32_t hashKey = rr + (gg << 8) + (bb << 16) + (aa << 24);
+			std::map<uint32_t, uint32_t>::iterator mapIter = ids.find(hashKey);
+			uint32_t amount = 1;
+			if (mapIter != ids.end() )
+			{
+				amount = mapIter->second + 1;
+			}
+
+			ids[hashKey] = amount; // Amount of times this ID (color) has been clicked on in buffer
+			maxAmount = maxAmount > amount
+				? maxAmount
+				: amount
+				;
+		}
+
+		uint32_t idKey = 0;
+		m_highlighted = UINT32_MAX;
+		if (maxAmount)
+		{
+			for (std::map<uint32_t, uint32_t>::iterator mapIter = ids.begin(); mapIter != ids.end(); mapIter++)
+			{
+				if (mapIter->second == maxAmount)
+				{
+					idKey = mapIter->first;
+					break;
+				}
+			}
+
+			for (uint32_t ii = 0; ii < 12; ++ii)
+			{
+				if (m_idsU[ii] == idKey)
+				{
+					m_highlighted = ii;
+					break;
+				}
+			}
+		}
+	}
+
 	bool update() override
 	{
 		if (!entry::processEvents(m_width, m_height, m_debug, m_reset, &m_mouseState) )
@@ -227,6 +304,7 @@ public:
 				ImGui::Image(m_pickingRT, ImVec2(m_width / 5.0f - 16.0f, m_width / 5.0f - 16.0f) );
 				ImGui::SliderFloat("Field of view", &m_fov, 1.0f, 60.0f);
 				ImGui::Checkbox("Spin Camera", &m_cameraSpin);
+				ImGui::Checkbox("CPU picking (BVH)", &m_cpuPicking);
 
 				ImGui::End();
 
@@ -289,6 +367,8 @@ public:
 				const float tintBasic[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
 				const float tintHighlighted[4] = { 0.3f, 0.3f, 2.0f, 1.0f };
 
+				Aabb meshAabb[12];
+
 				for (uint32_t mesh = 0; mesh < 12; ++mesh)
 				{
 					const float scale = m_meshScale[mesh];
@@ -305,6 +385,29 @@ public:
 						, 0.0f
 						);
 
+					// World space bounds of mesh, used by CPU picking.
+					{
+						Aabb aabb = m_meshes[mesh]->m_groups[0].m_aabb;
+						for (uint32_t ii = 1, num = uint32_t(m_meshes[mesh]->m_groups.size() ); ii < num; ++ii)
+						{
+							aabbExpand(aabb, m_meshes[mesh]->m_groups[ii].m_aabb.min);
+							aabbExpand(aabb, m_meshes[mesh]->m_groups[ii].m_aabb.max);
+						}
+
+						const bx::Vec3 corners[8] =
+						{
+							{ aabb.min.x, aabb.min.y, aabb.min.z },
+							{ aabb.max.x, aabb.min.y, aabb.min.z },
+							{ aabb.min.x, aabb.max.y, aabb.min.z },
+							{ aabb.max.x, aabb.max.y, aabb.min.z },
+							{ aabb.min.x, aabb.min.y, aabb.max.z },
+							{ aabb.max.x, aabb.min.y, aabb.max.z },
+							{ aabb.min.x, aabb.max.y, aabb.max.z },
+							{ aabb.max.x, aabb.max.y, aabb.max.z },
+						};
+						toAabb(meshAabb[mesh], mtx, corners, BX_COUNTOF(corners), sizeof(bx::Vec3) );
+					}
+
 					// Submit mesh to both of our render passes
 					// Set uniform based on if this is the highlighted mesh
 					bgfx::setUniform(u_tint
@@ -319,79 +422,33 @@ public:
 					meshSubmit(m_meshes[mesh], RENDER_PASS_ID, m_idProgram, mtx);
 				}
 
-				// If the user previously clicked, and we're done reading data from GPU, look at ID buffer on CPU
-				// Whatever mesh has the most pixels in the ID buffer is the one the user clicked on.
-				if (m_reading == m_currFrame)
+				// Objects move every frame, so hierarchy is only refit after it's built once.
+				if (0 == m_bvh.getNumObjects() )
 				{
-					m_reading = 0;
-					std::map<uint32_t, uint32_t> ids;  // This contains all the IDs found in the buffer
-					uint32_t maxAmount = 0;
-					for (uint8_t *x = m_blitData; x < m_blitData + ID_DIM * ID_DIM * 4;)
-					{
-						uint8_t rr = *x++;
-						uint8_t gg = *x++;
-						uint8_t bb = *x++;
-						uint8_t aa = *x++;
-
-						if (bgfx::RendererType::Direct3D9 == caps->rendererType)
-						{
-							// Comes back as BGRA
-							uint8_t temp = rr;
-							rr = bb;
-							bb = temp;
-						}
-
-						if (0 == (rr|gg|bb) ) // Skip background
-						{
-							continue;
-						}
-
-						uint32_t hashKey = rr + (gg << 8) + (bb << 16) + (aa << 24);
-						std::map<uint32_t, uint32_t>::iterator mapIter = ids.find(hashKey);
-						uint32_t amount = 1;
-						if (mapIter != ids.end() )
-						{
-							amount = mapIter->second + 1;
-						}
-
-						ids[hashKey] = amount; // Amount of times this ID (color) has been clicked on in buffer
-						maxAmount = maxAmount > amount
-							? maxAmount
-							: amount
-							;
-					}
+					m_bvh.build(meshAabb, BX_COUNTOF(meshAabb) );
+				}
+				else
+				{
+					m_bvh.refit(meshAabb);
+				}
 
-					uint32_t idKey = 0;
-					m_highlighted = UINT32_MAX;
-					if (maxAmount)
+				if (m_cpuPicking)
+				{
+					if (m_mouseState.m_buttons[entry::MouseButton::Left])
 					{
-						for (std::map<uint32_t, uint32_t>::iterator mapIter = ids.begin(); mapIter != ids.end(); mapIter++)
-						{
-							if (mapIter->second == maxAmount)
-							{
-								idKey = mapIter->first;
-								break;
-							}
-						}
-
-						for (uint32_t ii = 0; ii < 12; ++ii)
-						{
-							if (m_idsU[ii] == idKey)
-							{
-								m_highlighted = ii;
-								break;
-							}
-						}
+						const Ray ray = makeRay(mouseXNDC, mouseYNDC, invViewProj);
+						m_highlighted = m_bvh.intersect(ray);
 					}
 				}
 
 				// Start a new readback?
-				if (!m_reading
+				if (!m_cpuPicking
+				&&  !isValid(m_readFence)
 				&&  m_mouseState.m_buttons[entry::MouseButton::Left])
 				{
-					// Blit and read
+					// Blit and read, result is picked up in readbackCb once available.
 					bgfx::blit(RENDER_PASS_BLIT, m_blitTex, 0, 0, m_pickingRT);
-					m_reading = bgfx::readTexture(m_blitTex, m_blitData);
+					m_readFence = m_readback->readTextureAsync(m_blitTex, ID_DIM*ID_DIM*4, 0, readbackCb, this);
 				}
 			}
 
@@ -399,7 +456,8 @@ public:
 
 			// Advance to next frame. Rendering thread will be kicked to
 			// process submitted rendering primitives.
-			m_currFrame = bgfx::frame();
+			const uint32_t frame = bgfx::frame();
+			m_readback->update(frame);
 
 			return true;
 		}
@@ -431,13 +489,14 @@ public:
 	bgfx::TextureHandle m_blitTex;
 	bgfx::FrameBufferHandle m_pickingFB;
 
-	uint8_t m_blitData[ID_DIM*ID_DIM * 4]; // Read blit into this
+	ReadbackQueue* m_readback;
+	ReadbackFence m_readFence;
 
-	uint32_t m_reading;
-	uint32_t m_currFrame;
+	Bvh m_bvh;
 
 	float m_fov;
 	bool  m_cameraSpin;
+	bool  m_cpuPicking;
 };
 
 } // namespace
@@ -0,0 +1,18 @@
+/*
+ * Copyright 2011-2019 Branimir Karadzic. All rights reserved.
+ * License: https://github.com/bkaradzic/bgfx#license-bsd-2-clause
+ */
+
+#include "particle.sh"
+
+BUFFER_RW(counterBuffer,  uint,  2);
+BUFFER_WR(indirectBuffer, uvec4, 3);
+
+NUM_THREADS(1, 1, 1)
+void main()
+{
+	uint count;
+	atomicFetchAndExchange(counterBuffer[0], 0u, count);
+
+	drawIndexedIndirect(indirectBuffer, 0, 6u, count, 0u, 0u, 0u);
+}
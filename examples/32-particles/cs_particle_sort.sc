@@ -0,0 +1,35 @@
+/*
+ * Copyright 2011-2019 Branimir Karadzic. All rights reserved.
+ * License: https://github.com/bkaradzic/bgfx#license-bsd-2-clause
+ */
+
+#include "particle.sh"
+
+BUFFER_RW(sortBuffer, uint, 1);
+
+// Single step of bitonic sort, called for each block and stride.
+NUM_THREADS(256, 1, 1)
+void main()
+{
+	uint ii = gl_GlobalInvocationID.x;
+	uint jj = ii ^ u_sortStride;
+
+	if (jj > ii)
+	{
+		uint keyI = sortBuffer[ii*2u];
+		uint keyJ = sortBuffer[jj*2u];
+
+		bool ascending = 0u == (ii & u_sortBlock);
+
+		if ( (keyI > keyJ) == ascending)
+		{
+			uint valueI = sortBuffer[ii*2u+1u];
+			uint valueJ = sortBuffer[jj*2u+1u];
+
+			sortBuffer[ii*2u+0u] = keyJ;
+			sortBuffer[ii*2u+1u] = valueJ;
+			sortBuffer[jj*2u+0u] = keyI;
+			sortBuffer[jj*2u+1u] = valueI;
+		}
+	}
+}
@@ -0,0 +1,107 @@
+/*
+ * Copyright 2011-2019 Branimir Karadzic. All rights reserved.
+ * License: https://github.com/bkaradzic/bgfx#license-bsd-2-clause
+ */
+
+#include "particle.sh"
+
+BUFFER_RW(particleBuffer, vec4, 0);
+
+uint hash(uint _x)
+{
+	_x = (_x ^ 61u) ^ (_x >> 16u);
+	_x = _x * 9u;
+	_x = _x ^ (_x >> 4u);
+	_x = _x * 0x27d4eb2du;
+	_x = _x ^ (_x >> 15u);
+	return _x;
+}
+
+float frnd(inout uint _seed)
+{
+	_seed = hash(_seed);
+	return float(_seed & 0xffffffu) / 16777216.0;
+}
+
+float frndh(inout uint _seed)
+{
+	return frnd(_seed)*2.0 - 1.0;
+}
+
+vec3 randUnitCircle(inout uint _seed)
+{
+	float angle = frnd(_seed)*6.2831853;
+	return vec3(cos(angle), 0.0, sin(angle) );
+}
+
+vec3 randUnitSphere(inout uint _seed)
+{
+	float rand0 = frndh(_seed);
+	float rand1 = frnd(_seed)*6.2831853;
+	float sqrtf1 = sqrt(1.0 - rand0*rand0);
+	return vec3(sqrtf1*cos(rand1), sqrtf1*sin(rand1), rand0);
+}
+
+NUM_THREADS(64, 1, 1)
+void main()
+{
+	uint ii = gl_GlobalInvocationID.x;
+
+	if (ii >= u_numSpawn)
+	{
+		return;
+	}
+
+	uint slot = (u_head + ii) & (u_capacity - 1u);
+	uint seed = hash(u_seed + ii);
+
+	vec3 pos;
+	if (0u == u_shape)
+	{
+		pos = randUnitSphere(seed);
+	}
+	else if (1u == u_shape)
+	{
+		pos = randUnitSphere(seed);
+		pos.y = abs(pos.y);
+	}
+	else if (2u == u_shape)
+	{
+		pos = randUnitCircle(seed);
+	}
+	else if (3u == u_shape)
+	{
+		pos = randUnitCircle(seed) * frnd(seed);
+	}
+	else
+	{
+		pos = vec3(frndh(seed), 0.0, frndh(seed) );
+	}
+
+	vec3 dir = 0u == u_direction
+		? vec3(0.0, 1.0, 0.0)
+		: normalize(pos)
+		;
+
+	vec3  start    = pos * mix(u_offsetStart.x, u_offsetStart.y, frnd(seed) );
+	vec3  end      = dir * mix(u_offsetEnd.x,   u_offsetEnd.y,   frnd(seed) ) + start;
+	float lifeSpan = mix(u_lifeSpan.x, u_lifeSpan.y, frnd(seed) );
+	vec3  gravity  = vec3(0.0, -9.81 * u_gravityScale * lifeSpan * lifeSpan, 0.0);
+
+	vec3 start0 = mul(u_emitterMtx, vec4(start, 1.0) ).xyz;
+	vec3 end0   = mul(u_emitterMtx, vec4(end,   1.0) ).xyz;
+	vec3 end1   = end0 + gravity;
+
+	// Particles spawned earlier in the frame are older.
+	float life = float(u_numSpawn - 1u - ii) * u_timePerParticle / lifeSpan;
+
+	particleBuffer[slot*4u+0u] = vec4(start0, life);
+	particleBuffer[slot*4u+1u] = vec4(end0, 1.0/lifeSpan);
+	particleBuffer[slot*4u+2u] = vec4(end1, 0.0);
+	particleBuffer[slot*4u+3u] = vec4(
+		  mix(u_blendStart.x, u_blendStart.y, frnd(seed) )
+		, mix(u_blendEnd.x,   u_blendEnd.y,   frnd(seed) )
+		, mix(u_scaleStart.x, u_scaleStart.y, frnd(seed) )
+		, mix(u_scaleEnd.x,   u_scaleEnd.y,   frnd(seed) )
+		);
+}
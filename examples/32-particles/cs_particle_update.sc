@@ -0,0 +1,44 @@
+/*
+ * Copyright 2011-2019 Branimir Karadzic. All rights reserved.
+ * License: https://github.com/bkaradzic/bgfx#license-bsd-2-clause
+ */
+
+#include "particle.sh"
+
+BUFFER_RW(particleBuffer, vec4, 0);
+BUFFER_WR(sortBuffer,     uint, 1);
+BUFFER_RW(counterBuffer,  uint, 2);
+
+NUM_THREADS(256, 1, 1)
+void main()
+{
+	uint ii = gl_GlobalInvocationID.x;
+
+	vec4 p0 = particleBuffer[ii*4u+0u];
+	vec4 p1 = particleBuffer[ii*4u+1u];
+
+	// Dead particles are sorted to the end, and they are not drawn.
+	uint key = 0xffffffffu;
+
+	if (0.0 < p1.w
+	&&  1.0 >= p0.w)
+	{
+		p0.w += u_dt * p1.w;
+		particleBuffer[ii*4u+0u] = p0;
+
+		if (1.0 >= p0.w)
+		{
+			vec3 p2  = particleBuffer[ii*4u+2u].xyz;
+			vec3 pos = particlePos(p0.xyz, p1.xyz, p2, easeLut(p0.w).x);
+
+			// Farthest particle gets smallest key, so that particles are drawn back to front.
+			key = 0x7fffffffu - floatBitsToUint(length(u_eye - pos) );
+
+			uint count;
+			atomicFetchAndAdd(counterBuffer[0], 1u, count);
+		}
+	}
+
+	sortBuffer[ii*2u+0u] = key;
+	sortBuffer[ii*2u+1u] = ii;
+}
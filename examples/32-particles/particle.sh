@@ -0,0 +1,67 @@
+/*
+ * Copyright 2011-2019 Branimir Karadzic. All rights reserved.
+ * License: https://github.com/bkaradzic/bgfx#license-bsd-2-clause
+ */
+
+#include "bgfx_compute.sh"
+
+uniform vec4 u_params[10];
+uniform vec4 u_rgba[5];
+uniform vec4 u_easeLut[32];
+uniform mat4 u_emitterMtx;
+uniform vec4 u_sortParams;
+
+#define u_dt               u_params[0].x
+#define u_numSpawn         floatBitsToUint(u_params[0].y)
+#define u_head             floatBitsToUint(u_params[0].z)
+#define u_capacity         floatBitsToUint(u_params[0].w)
+
+#define u_seed             floatBitsToUint(u_params[1].x)
+#define u_shape            floatBitsToUint(u_params[1].y)
+#define u_direction        floatBitsToUint(u_params[1].z)
+#define u_gravityScale     u_params[1].w
+
+#define u_offsetStart      u_params[2].xy
+#define u_offsetEnd        u_params[2].zw
+
+#define u_lifeSpan         u_params[3].xy
+#define u_timePerParticle  u_params[3].z
+
+#define u_blendStart       u_params[4].xy
+#define u_blendEnd         u_params[4].zw
+
+#define u_scaleStart       u_params[5].xy
+#define u_scaleEnd         u_params[5].zw
+
+#define u_eye              u_params[6].xyz
+
+#define u_uvRect           u_params[7]
+
+#define u_viewRight        u_params[8].xyz
+#define u_viewUp           u_params[9].xyz
+
+#define u_sortBlock        floatBitsToUint(u_sortParams.x)
+#define u_sortStride       floatBitsToUint(u_sortParams.y)
+
+// Particle is stored as 4 vec4:
+//   0 - start position, normalized life
+//   1 - end position, inverse life span (0 when slot was never used)
+//   2 - end position with gravity
+//   3 - blend start, blend end, scale start, scale end
+
+// Easing curves are sampled on CPU into lookup table, x - position, y - color, z - blend,
+// w - scale.
+vec4 easeLut(float _tt)
+{
+	float tt = clamp(_tt, 0.0, 1.0)*31.0;
+	int   i0 = int(floor(tt) );
+	int   i1 = min(i0+1, 31);
+	return mix(u_easeLut[i0], u_easeLut[i1], tt - float(i0) );
+}
+
+vec3 particlePos(vec3 _start, vec3 _end0, vec3 _end1, float _tt)
+{
+	vec3 p0 = mix(_start, _end0, _tt);
+	vec3 p1 = mix(_end0,  _end1, _tt);
+	return mix(p0, p1, _tt);
+}
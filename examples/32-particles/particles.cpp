@@ -92,13 +92,15 @@ struct Emitter
 
 	EmitterShape::Enum     m_shape;
 	EmitterDirection::Enum m_direction;
+	EmitterBackend::Enum   m_backend;
 
 	void create()
 	{
 		m_shape      = EmitterShape::Sphere;
 		m_direction  = EmitterDirection::Outward;
+		m_backend    = EmitterBackend::Cpu;
 
-		m_handle = psCreateEmitter(m_shape, m_direction, 1024);
+		m_handle = psCreateEmitter(m_shape, m_direction, 1024, m_backend);
 		m_uniforms.reset();
 	}
 
@@ -112,15 +114,20 @@ struct Emitter
 		psUpdateEmitter(m_handle, &m_uniforms);
 	}
 
-	void imgui()
+	void imgui(bool _gpuAvailable)
 	{
 //		if (ImGui::CollapsingHeader("General") )
 		{
+			bool gpu = EmitterBackend::Gpu == m_backend;
+
 			if (ImGui::Combo("Shape", (int*)&m_shape, s_shapeNames, BX_COUNTOF(s_shapeNames) )
-			||  ImGui::Combo("Direction", (int*)&m_direction, s_directionName, BX_COUNTOF(s_directionName) ) )
+			||  ImGui::Combo("Direction", (int*)&m_direction, s_directionName, BX_COUNTOF(s_directionName) )
+			|| (_gpuAvailable && ImGui::Checkbox("GPU simulation", &gpu) ) )
 			{
+				m_backend = gpu ? EmitterBackend::Gpu : EmitterBackend::Cpu;
+
 				psDestroyEmitter(m_handle);
-				m_handle = psCreateEmitter(m_shape, m_direction, 1024);
+				m_handle = psCreateEmitter(m_shape, m_direction, 1024, m_backend);
 			}
 
 			ImGui::SliderInt("particles / s", (int*)&m_uniforms.m_particlesPerSecond, 0, 1024);
@@ -268,6 +275,45 @@ public:
 
 		psInit();
 
+		m_gpuPrograms.spawn    = BGFX_INVALID_HANDLE;
+		m_gpuPrograms.update   = BGFX_INVALID_HANDLE;
+		m_gpuPrograms.sort     = BGFX_INVALID_HANDLE;
+		m_gpuPrograms.indirect = BGFX_INVALID_HANDLE;
+		m_gpuPrograms.draw     = BGFX_INVALID_HANDLE;
+
+		const uint64_t gpuCaps = 0
+			| BGFX_CAPS_COMPUTE
+			| BGFX_CAPS_DRAW_INDIRECT
+			| BGFX_CAPS_INSTANCING
+			;
+
+		m_gpuAvailable = gpuCaps == (bgfx::getCaps()->supported & gpuCaps);
+
+		if (m_gpuAvailable)
+		{
+			m_gpuPrograms.spawn    = loadProgram("cs_particle_spawn",    NULL);
+			m_gpuPrograms.update   = loadProgram("cs_particle_update",   NULL);
+			m_gpuPrograms.sort     = loadProgram("cs_particle_sort",     NULL);
+			m_gpuPrograms.indirect = loadProgram("cs_particle_indirect", NULL);
+			m_gpuPrograms.draw     = loadProgram("vs_particle_gpu", "fs_particle_gpu");
+
+			m_gpuAvailable = true
+				&& bgfx::isValid(m_gpuPrograms.spawn)
+				&& bgfx::isValid(m_gpuPrograms.update)
+				&& bgfx::isValid(m_gpuPrograms.sort)
+				&& bgfx::isValid(m_gpuPrograms.indirect)
+				&& bgfx::isValid(m_gpuPrograms.draw)
+				;
+
+			if (!m_gpuAvailable)
+			{
+				// Shaders are not built for this renderer, emitters stay on CPU backend.
+				destroyGpuPrograms();
+			}
+		}
+
+		psSetGpuPrograms(m_gpuPrograms);
+
 		bimg::ImageContainer* image = imageLoad(
 			  "textures/particle.ktx"
 			, bgfx::TextureFormat::BGRA8
@@ -298,6 +344,27 @@ public:
 		m_timeOffset = bx::getHPCounter();
 	}
 
+	void destroyGpuPrograms()
+	{
+		bgfx::ProgramHandle* programs[] =
+		{
+			&m_gpuPrograms.spawn,
+			&m_gpuPrograms.update,
+			&m_gpuPrograms.sort,
+			&m_gpuPrograms.indirect,
+			&m_gpuPrograms.draw,
+		};
+
+		for (uint32_t ii = 0; ii < BX_COUNTOF(programs); ++ii)
+		{
+			if (bgfx::isValid(*programs[ii]) )
+			{
+				bgfx::destroy(*programs[ii]);
+				programs[ii]->idx = bgfx::kInvalidHandle;
+			}
+		}
+	}
+
 	virtual int shutdown() override
 	{
 		for (uint32_t ii = 0; ii < BX_COUNTOF(m_emitter); ++ii)
@@ -307,6 +374,8 @@ public:
 
 		psShutdown();
 
+		destroyGpuPrograms();
+
 		ddShutdown();
 
 		imguiDestroy();
@@ -397,7 +466,7 @@ public:
 				ImGui::RadioButton(name, &currentEmitter, ii);
 			}
 
-			m_emitter[currentEmitter].imgui();
+			m_emitter[currentEmitter].imgui(m_gpuAvailable);
 
 			ImGui::End();
 
@@ -450,6 +519,9 @@ public:
 	uint32_t m_reset;
 
 	Emitter m_emitter[4];
+
+	EmitterGpuPrograms m_gpuPrograms;
+	bool m_gpuAvailable;
 };
 
 } // namespace
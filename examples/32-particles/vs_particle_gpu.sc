@@ -0,0 +1,37 @@
+$input a_position
+$output v_color0, v_texcoord0
+
+/*
+ * Copyright 2011-2019 Branimir Karadzic. All rights reserved.
+ * License: https://github.com/bkaradzic/bgfx#license-bsd-2-clause
+ */
+
+#include "particle.sh"
+
+BUFFER_RO(particleBuffer, vec4, 1);
+BUFFER_RO(sortBuffer,     uint, 2);
+
+void main()
+{
+	uint idx = sortBuffer[uint(gl_InstanceID)*2u+1u];
+
+	vec4 p0 = particleBuffer[idx*4u+0u];
+	vec4 p1 = particleBuffer[idx*4u+1u];
+	vec4 p2 = particleBuffer[idx*4u+2u];
+	vec4 p3 = particleBuffer[idx*4u+3u];
+
+	vec4  ease  = easeLut(p0.w);
+	vec3  pos   = particlePos(p0.xyz, p1.xyz, p2.xyz, ease.x);
+	float blend = mix(p3.x, p3.y, clamp(ease.z, 0.0, 1.0) );
+	float scale = mix(p3.z, p3.w, ease.w);
+
+	float ttRgba  = clamp(ease.y, 0.0, 1.0)*4.0;
+	int   segment = min(int(ttRgba), 3);
+	vec4  color   = mix(u_rgba[segment], u_rgba[segment+1], ttRgba - float(segment) );
+
+	vec3 wpos = pos + (u_viewRight*a_position.x + u_viewUp*a_position.y)*scale;
+
+	gl_Position = mul(u_viewProj, vec4(wpos, 1.0) );
+	v_color0    = color;
+	v_texcoord0 = vec4(mix(u_uvRect.xy, u_uvRect.zw, a_position*0.5 + 0.5), blend, 0.0);
+}
@@ -0,0 +1,42 @@
+/*
+ * Copyright 2011-2019 Branimir Karadzic. All rights reserved.
+ * License: https://github.com/bkaradzic/bgfx#license-bsd-2-clause
+ */
+
+#include "bgfx_compute.sh"
+
+BUFFER_RW(b_counts,  uint, 1);
+BUFFER_RO(b_counter, uint, 2);
+BUFFER_RO(b_list,    uint, 3);
+UIMAGE2D_WR(s_list, r32ui, 4);
+
+// x - feedback width, y - feedback height, z - page table size, w - list capacity
+uniform vec4 u_vt_feedback;
+
+NUM_THREADS(64, 1, 1)
+void main()
+{
+	uint capacity = uint(u_vt_feedback.w);
+	uint width    = uint(u_vt_feedback.x);
+	uint count    = min(b_counter[0], capacity);
+	uint ii       = gl_GlobalInvocationID.x;
+
+	// First texel holds number of unique pages
+	if (ii == 0u)
+	{
+		imageStore(s_list, ivec2(0, 0), uvec4(count, 0u, 0u, 0u) );
+	}
+
+	if (ii >= count)
+	{
+		return;
+	}
+
+	// Pack page index with number of requests, and reset count for next frame
+	uint index    = b_list[ii];
+	uint requests = min(b_counts[index], 255u);
+	b_counts[index] = 0u;
+
+	uint slot = ii + 1u;
+	imageStore(s_list, ivec2(int(slot % width), int(slot / width) ), uvec4(index | (requests << 24u), 0u, 0u, 0u) );
+}
@@ -0,0 +1,69 @@
+/*
+ * Copyright 2011-2019 Branimir Karadzic. All rights reserved.
+ * License: https://github.com/bkaradzic/bgfx#license-bsd-2-clause
+ */
+
+#include "bgfx_compute.sh"
+
+SAMPLER2D(s_vt_feedback, 0);
+BUFFER_RW(b_counts,  uint, 1);
+BUFFER_RW(b_counter, uint, 2);
+BUFFER_WR(b_list,    uint, 3);
+
+// x - feedback width, y - feedback height, z - page table size, w - list capacity
+uniform vec4 u_vt_feedback;
+
+NUM_THREADS(8, 8, 1)
+void main()
+{
+	ivec2 coord = ivec2(gl_GlobalInvocationID.xy);
+
+	if (coord.x >= int(u_vt_feedback.x)
+	||  coord.y >= int(u_vt_feedback.y) )
+	{
+		return;
+	}
+
+	vec4 color = texelFetch(s_vt_feedback, coord, 0);
+
+	if (color.w < 0.5)
+	{
+		return;
+	}
+
+	// Same encoding as fs_vt_mip, page x/y in red/green, mip level in blue
+	ivec3 page = ivec3(floor(color.xyz * 255.0 + 0.5) );
+
+	// Index matches PageIndexer, mip levels are stored one after another
+	int mipSize = int(u_vt_feedback.z);
+	int offset  = 0;
+	for (int ii = 0; ii < page.z; ++ii)
+	{
+		offset  += mipSize * mipSize;
+		mipSize /= 2;
+	}
+
+	if (mipSize <= 0
+	||  page.x >= mipSize
+	||  page.y >= mipSize)
+	{
+		return;
+	}
+
+	uint index = uint(offset + page.y * mipSize + page.x);
+
+	uint prev;
+	atomicFetchAndAdd(b_counts[index], 1u, prev);
+
+	// First request of page appends it to list
+	if (prev == 0u)
+	{
+		uint slot;
+		atomicFetchAndAdd(b_counter[0], 1u, slot);
+
+		if (slot < uint(u_vt_feedback.w) )
+		{
+			b_list[slot] = index;
+		}
+	}
+}
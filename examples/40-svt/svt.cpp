@@ -144,6 +144,16 @@ public:
 		m_vti->m_tileSize = 128;
 		m_vti->m_borderSize = 1;
 
+		// Use block compressed tiles if supported, to reduce disk bandwidth and atlas memory
+		if (0 != (m_caps->formats[bgfx::TextureFormat::BC1] & BGFX_CAPS_FORMAT_TEXTURE_2D) )
+		{
+			m_vti->m_format = bimg::TextureFormat::BC1;
+		}
+		else if (0 != (m_caps->formats[bgfx::TextureFormat::ASTC4x4] & BGFX_CAPS_FORMAT_TEXTURE_2D) )
+		{
+			m_vti->m_format = bimg::TextureFormat::ASTC4x4;
+		}
+
 		// Generate tile data file (if not yet created)
 		{
 			vt::TileGenerator tileGenerator(m_vti);
@@ -151,12 +161,14 @@ public:
 		}
 
 		// Load tile data file
-		auto tileDataFile = new vt::TileDataFile("temp/8k_mars.vt", m_vti);
+		auto tileDataFile = new vt::TileDataFile(vt::TileGenerator::getTileDataFilePath("textures/8k_mars.jpg", m_vti->m_format), m_vti);
 		tileDataFile->readInfo();
 
 		// Create virtual texture and feedback buffer
 		m_vt = new vt::VirtualTexture(tileDataFile, m_vti, 2048, 1);
-		m_feedbackBuffer = new vt::FeedbackBuffer(m_vti, 64, 64);
+		// Reduce feedback to unique page list on GPU when compute is supported
+		m_feedbackBuffer = new vt::FeedbackBuffer(m_vti, 64, 64, 0 != (m_caps->supported & BGFX_CAPS_COMPUTE) );
+		m_frame = 0;
 
 	}
 
@@ -174,9 +186,9 @@ public:
 		bgfx::destroy(m_vt_unlit);
 		bgfx::destroy(m_vt_mip);
 
-		delete m_vti;
 		delete m_vt;
 		delete m_feedbackBuffer;
+		delete m_vti;
 
 		// Shutdown bgfx.
 		bgfx::shutdown();
@@ -256,6 +268,14 @@ public:
 					m_vt->setUploadsPerFrame(uploadsperframe);
 				}
 
+				const vt::PageCache::Stats stats = m_vt->getCacheStats();
+				ImGui::Text("Cache hits %u, misses %u, evictions %u", stats.m_hits, stats.m_misses, stats.m_evictions);
+				ImGui::Text("Resident %u, loading %u", stats.m_resident, stats.m_loading);
+				if (ImGui::Button("Reset stats"))
+				{
+					m_vt->resetCacheStats();
+				}
+
 				ImGui::ImageButton(m_vt->getAtlastTexture(), ImVec2(m_width / 5.0f - 16.0f, m_width / 5.0f - 16.0f));
 				ImGui::ImageButton(bgfx::getTexture(m_feedbackBuffer->getFrameBuffer()), ImVec2(m_width / 5.0f - 16.0f, m_width / 5.0f - 16.0f));
 
@@ -318,14 +338,14 @@ public:
 					if (i == 0)
 					{
 						bgfx::submit(i, m_vt_mip);
-						// Download previous frame feedback info
-						m_feedbackBuffer->download();
+						// Download feedback info from previous frames that is already available
+						m_feedbackBuffer->download(m_frame);
 						// Update and upload new requests
 						m_vt->update(m_feedbackBuffer->getRequests(), 4);
 						// Clear feedback
 						m_feedbackBuffer->clear();
-						// Copy new frame feedback buffer
-						m_feedbackBuffer->copy(3);
+						// Reduce and copy new frame feedback buffer
+						m_feedbackBuffer->copy(3, 2);
 					}
 					else
 					{
@@ -339,7 +359,7 @@ public:
 
 			// Advance to next frame. Rendering thread will be kicked to
 			// process submitted rendering primitives.
-			bgfx::frame();
+			m_frame = bgfx::frame();
 
 			return true;
 		}
@@ -357,6 +377,7 @@ public:
 	uint32_t m_height;
 	uint32_t m_debug;
 	uint32_t m_reset;
+	uint32_t m_frame;
 
 	int32_t m_scrollArea;
 
@@ -15,6 +15,11 @@
 
 #include <bx/file.h>
 #include <bx/sort.h>
+#include <bimg/encode.h>
+
+#if BX_PLATFORM_POSIX
+#	include <unistd.h>
+#endif // BX_PLATFORM_POSIX
 
 #include "vt.h"
 
@@ -24,6 +29,7 @@ namespace vt
 // Constants
 static const int s_channelCount = 4;
 static const int s_tileFileDataOffset = sizeof(VirtualTextureInfo);
+static const int s_maxRequestAge = 8; // Pending requests older than this many frames are cancelled
 
 // Page
 Page::operator size_t() const {
@@ -53,6 +59,7 @@ VirtualTextureInfo::VirtualTextureInfo()
 	: m_virtualTextureSize(0)
 	, m_tileSize(0)
 	, m_borderSize(0)
+	, m_format(bimg::TextureFormat::BGRA8)
 {
 }
 int VirtualTextureInfo::GetPageSize() const
@@ -65,12 +72,24 @@ int VirtualTextureInfo::GetPageTableSize() const
 	return m_virtualTextureSize / m_tileSize;
 }
 
+int VirtualTextureInfo::GetPageDataSize() const
+{
+	auto pagesize = uint16_t(GetPageSize());
+	return (int)bimg::imageGetSize(nullptr, pagesize, pagesize, 1, false, false, 1, m_format);
+}
+
+bool VirtualTextureInfo::IsCompressed() const
+{
+	return bimg::isCompressed(m_format);
+}
+
 // StagingPool
-StagingPool::StagingPool(int _width, int _height, int _count, bool _readBack)
+StagingPool::StagingPool(int _width, int _height, int _count, bool _readBack, bgfx::TextureFormat::Enum _format)
 	: m_stagingTextureIndex(0)
 	, m_width(_width)
 	, m_height(_height)
 	, m_flags(0)
+	, m_format(_format)
 {
 	m_flags = BGFX_TEXTURE_BLIT_DST | BGFX_SAMPLER_UVW_CLAMP;
 	if (_readBack)
@@ -92,7 +111,7 @@ void StagingPool::grow(int count)
 {
 	while ((int)m_stagingTextures.size() < count)
 	{
-		auto stagingTexture = bgfx::createTexture2D((uint16_t)m_width, (uint16_t)m_height, false, 1, bgfx::TextureFormat::BGRA8, m_flags);
+		auto stagingTexture = bgfx::createTexture2D((uint16_t)m_width, (uint16_t)m_height, false, 1, m_format, m_flags);
 		m_stagingTextures.push_back(stagingTexture);
 	}
 }
@@ -496,28 +515,263 @@ bgfx::TextureHandle PageTable::getTexture()
 }
 
 // PageLoader
-PageLoader::PageLoader(TileDataFile* _tileDataFile, PageIndexer* _indexer, VirtualTextureInfo* _info)
+PageLoader::PageLoader(TileDataFile* _tileDataFile, PageIndexer* _indexer, VirtualTextureInfo* _info, int _numThreads)
 	: m_colorMipLevels(false)
 	, m_showBorders(false)
 	, m_tileDataFile(_tileDataFile)
 	, m_indexer(_indexer)
 	, m_info(_info)
+	, m_threads(nullptr)
+	, m_numThreads(bx::max(0, _numThreads))
+	, m_exit(false)
+	, m_frame(0)
+	, m_generation(0)
+{
+	if (m_numThreads > 0)
+	{
+		m_threads = new bx::Thread[m_numThreads];
+		for (int i = 0; i < m_numThreads; ++i)
+		{
+			m_threads[i].init(workerThreadFunc, this, 0, "vt page loader");
+		}
+	}
+}
+
+PageLoader::~PageLoader()
+{
+	if (m_numThreads > 0)
+	{
+		{
+			bx::MutexScope lock(m_mutex);
+			m_exit = true;
+		}
+
+		for (int i = 0; i < m_numThreads; ++i)
+		{
+			m_sem.post();
+		}
+
+		for (int i = 0; i < m_numThreads; ++i)
+		{
+			m_threads[i].shutdown();
+		}
+
+		delete [] m_threads;
+	}
+
+	for (auto state : m_completed)
+	{
+		delete state;
+	}
+}
+
+void PageLoader::submit(Page request, int priority)
+{
+	// Without worker threads pages are loaded synchronously
+	if (m_numThreads == 0)
+	{
+		ReadState state;
+		state.m_page = request;
+		state.m_generation = m_generation;
+		state.m_colorMipLevels = m_colorMipLevels;
+		state.m_showBorders = m_showBorders;
+		loadPage(state);
+		onPageLoadComplete(state);
+		return;
+	}
+
+	{
+		bx::MutexScope lock(m_mutex);
+		m_pending.push_back({ request, priority, m_frame, m_colorMipLevels, m_showBorders });
+	}
+
+	m_sem.post();
+}
+
+void PageLoader::touch(Page request, int priority)
+{
+	bx::MutexScope lock(m_mutex);
+	for (auto& pending : m_pending)
+	{
+		if (pending.m_page == request)
+		{
+			pending.m_priority = priority;
+			pending.m_frame = m_frame;
+			return;
+		}
+	}
+}
+
+void PageLoader::cancelStale(int maxAge)
+{
+	tinystl::vector<Page> cancelled;
+
+	{
+		bx::MutexScope lock(m_mutex);
+		for (int i = 0; i < (int)m_pending.size(); )
+		{
+			if (m_frame - m_pending[i].m_frame > uint32_t(maxAge))
+			{
+				cancelled.push_back(m_pending[i].m_page);
+				m_pending[i] = m_pending.back();
+				m_pending.pop_back();
+			}
+			else
+			{
+				++i;
+			}
+		}
+	}
+
+	for (auto page : cancelled)
+	{
+		loadCancelled(page);
+	}
+}
+
+void PageLoader::flush()
+{
+	tinystl::vector<Page> cancelled;
+
+	{
+		bx::MutexScope lock(m_mutex);
+		for (auto& pending : m_pending)
+		{
+			cancelled.push_back(pending.m_page);
+		}
+		m_pending.clear();
+
+		// Pages already being loaded will be discarded when handed back
+		++m_generation;
+	}
+
+	for (auto page : cancelled)
+	{
+		loadCancelled(page);
+	}
+}
+
+void PageLoader::update(int maxCount)
 {
+	tinystl::vector<ReadState*> completed;
+	uint32_t generation;
+
+	{
+		bx::MutexScope lock(m_mutex);
+		int count = bx::min(maxCount, (int)m_completed.size());
+		for (int i = 0; i < count; ++i)
+		{
+			completed.push_back(m_completed[i]);
+		}
+		m_completed.erase(m_completed.begin(), m_completed.begin() + count);
+		generation = m_generation;
+		++m_frame;
+	}
+
+	for (auto state : completed)
+	{
+		if (state->m_generation == generation)
+		{
+			onPageLoadComplete(*state);
+		}
+		else
+		{
+			loadCancelled(state->m_page);
+		}
+		delete state;
+	}
 }
 
-void PageLoader::submit(Page request)
+int32_t PageLoader::workerThreadFunc(bx::Thread* _thread, void* _userData)
 {
-	ReadState state;
-	state.m_page = request;
-	loadPage(state);
-	onPageLoadComplete(state);
+	BX_UNUSED(_thread);
+	return ((PageLoader*)_userData)->worker();
+}
+
+int32_t PageLoader::worker()
+{
+	for (;;)
+	{
+		m_sem.wait();
+
+		ReadState* state = nullptr;
+
+		{
+			bx::MutexScope lock(m_mutex);
+			if (m_exit)
+			{
+				break;
+			}
+
+			if (m_pending.empty())
+			{
+				// Request was cancelled before any worker picked it up
+				continue;
+			}
+
+			// Pick highest priority request
+			int best = 0;
+			for (int i = 1; i < (int)m_pending.size(); ++i)
+			{
+				if (m_pending[i].m_priority > m_pending[best].m_priority)
+				{
+					best = i;
+				}
+			}
+
+			state = new ReadState;
+			state->m_page = m_pending[best].m_page;
+			state->m_generation = m_generation;
+			state->m_colorMipLevels = m_pending[best].m_colorMipLevels;
+			state->m_showBorders = m_pending[best].m_showBorders;
+
+			m_pending[best] = m_pending.back();
+			m_pending.pop_back();
+		}
+
+		loadPage(*state);
+
+		bx::MutexScope lock(m_mutex);
+		m_completed.push_back(state);
+	}
+
+	return 0;
 }
 
 void PageLoader::loadPage(ReadState& state)
 {
-	int size = m_info->GetPageSize() * m_info->GetPageSize() * s_channelCount;
+	int size = m_info->GetPageDataSize();
 	state.m_data.resize(size);
-	if (m_colorMipLevels)
+
+	// Compressed pages are uploaded as is, only debug overlays need to round trip through BGRA8
+	if (m_info->IsCompressed()
+	&& (state.m_colorMipLevels || state.m_showBorders))
+	{
+		auto pagesize = uint32_t(m_info->GetPageSize());
+		auto pitch = pagesize * s_channelCount;
+		tinystl::vector<uint8_t> image(pagesize * pitch);
+
+		if (state.m_colorMipLevels)
+		{
+			copyColor(&image[0], state.m_page);
+		}
+		else if (m_tileDataFile != nullptr)
+		{
+			m_tileDataFile->readPage(m_indexer->getIndexFromPage(state.m_page), &state.m_data[0]);
+			bimg::imageDecodeToBgra8(VirtualTexture::getAllocator(), &image[0], &state.m_data[0], pagesize, pagesize, pitch, m_info->m_format);
+		}
+		if (state.m_showBorders)
+		{
+			copyBorder(&image[0]);
+		}
+
+		bx::Error err;
+		bimg::imageSwizzleBgra8(&image[0], pitch, pagesize, pagesize, &image[0], pitch);
+		bimg::imageEncodeFromRgba8(VirtualTexture::getAllocator(), &state.m_data[0], &image[0], pagesize, pagesize, 1, m_info->m_format, bimg::Quality::Fastest, &err);
+		return;
+	}
+
+	if (state.m_colorMipLevels)
 	{
 		copyColor(&state.m_data[0], state.m_page);
 	}
@@ -525,7 +779,7 @@ void PageLoader::loadPage(ReadState& state)
 	{
 		m_tileDataFile->readPage(m_indexer->getIndexFromPage(state.m_page), &state.m_data[0]);
 	}
-	if (m_showBorders)
+	if (state.m_showBorders)
 	{
 		copyBorder(&state.m_data[0]);
 	}
@@ -593,9 +847,12 @@ PageCache::PageCache(TextureAtlas* _atlas, PageLoader* _loader, int _count)
 	: m_atlas(_atlas)
 	, m_loader(_loader)
 	, m_count(_count)
+	, m_frame(0)
 {
-	clear();
+	resetStats();
 	m_loader->loadComplete = [&](Page page, uint8_t* data) { loadComplete(page, data); };
+	m_loader->loadCancelled = [&](Page page) { loadCancelled(page); };
+	clear();
 }
 
 // Update the pages's position in the lru
@@ -603,28 +860,29 @@ bool PageCache::touch(Page page)
 {
 	if (m_loading.find(page) == m_loading.end())
 	{
-		if (m_lru_used.find(page) != m_lru_used.end())
+		auto it = m_lru_used.find(page);
+		if (it != m_lru_used.end())
 		{
-			// Find the page (slow!!) and add it to the back of the list
-			for (auto it = m_lru.begin(); it != m_lru.end(); ++it)
+			// Move the page to the back of the list, once per frame is enough
+			int slot = it->second;
+			if (m_lru[slot].m_frame != m_frame)
 			{
-				if (it->m_page == page)
-				{
-					auto lruPage = *it;
-					m_lru.erase(it);
-					m_lru.push_back(lruPage);
-					return true;
-				}
+				m_lru[slot].m_frame = m_frame;
+				unlink(slot);
+				linkBack(slot);
 			}
-			return false;
+			++m_stats.m_hits;
+			return true;
 		}
+
+		++m_stats.m_misses;
 	}
 
 	return false;
 }
 
 // Schedule a load if not already loaded or loading
-bool PageCache::request(Page request, bgfx::ViewId blitViewId)
+bool PageCache::request(Page request, bgfx::ViewId blitViewId, int priority)
 {
 	m_blitViewId = blitViewId;
 	if (m_loading.find(request) == m_loading.end())
@@ -632,27 +890,42 @@ bool PageCache::request(Page request, bgfx::ViewId blitViewId)
 		if (m_lru_used.find(request) == m_lru_used.end())
 		{
 			m_loading.insert(request);
-			m_loader->submit(request);
+			m_loader->submit(request, priority);
 			return true;
 		}
 	}
+	else
+	{
+		// Already requested, keep it from being cancelled as stale
+		m_loader->touch(request, priority);
+	}
 
 	return false;
 }
 
+// Hand loaded pages over to the atlas, and drop requests nobody asked for recently
+void PageCache::update(bgfx::ViewId blitViewId, int uploadsPerFrame)
+{
+	++m_frame;
+	m_blitViewId = blitViewId;
+	m_loader->update(uploadsPerFrame);
+	m_loader->cancelStale(s_maxRequestAge);
+}
+
 void PageCache::clear()
 {
+	m_loader->flush();
+
 	for (auto& lru_page : m_lru)
 	{
-		if (m_lru_used.find(lru_page.m_page) != m_lru_used.end())
-		{
-			removed(lru_page.m_page, lru_page.m_point);
-		}
+		removed(lru_page.m_page, lru_page.m_point);
 	}
 	m_lru_used.clear();
 	m_lru.clear();
 	m_lru.reserve(m_count * m_count);
 	m_current = 0;
+	m_head = -1;
+	m_tail = -1;
 }
 
 void PageCache::loadComplete(Page page, uint8_t* data)
@@ -660,21 +933,24 @@ void PageCache::loadComplete(Page page, uint8_t* data)
 	m_loading.erase(page);
 
 	// Find a place in the atlas for the data
-	Point pt;
+	int slot;
 
 	if (m_current == m_count * m_count)
 	{
-		// Remove the oldest lru page and remember it's location so we can use it
-		auto lru_page = m_lru[0];
-		m_lru.erase(m_lru.begin());
+		// Remove the oldest lru page and reuse it's slot
+		slot = m_head;
+		unlink(slot);
+
+		auto& lru_page = m_lru[slot];
 		m_lru_used.erase(lru_page.m_page);
-		pt = lru_page.m_point;
+		++m_stats.m_evictions;
 		// Notify that we removed a page
 		removed(lru_page.m_page, lru_page.m_point);
 	}
 	else
 	{
-		pt = { m_current % m_count, m_current / m_count };
+		slot = m_current;
+		m_lru.push_back({ page, { m_current % m_count, m_current / m_count }, -1, -1, 0 });
 		++m_current;
 
 		if (m_current == m_count * m_count)
@@ -683,24 +959,90 @@ void PageCache::loadComplete(Page page, uint8_t* data)
 		}
 	}
 
+	auto& lru_page = m_lru[slot];
+	lru_page.m_page = page;
+	lru_page.m_frame = m_frame;
+	linkBack(slot);
+
 	// Notify atlas that he can upload the page and add the page to lru
-	m_atlas->uploadPage(pt, data, m_blitViewId);
-	m_lru.push_back({ page, pt });
-	m_lru_used.insert(page);
+	m_atlas->uploadPage(lru_page.m_point, data, m_blitViewId);
+	m_lru_used.insert(tinystl::make_pair(page, slot));
 
 	// Signal that we added a page
-	added(page, pt);
+	added(page, lru_page.m_point);
+}
+
+void PageCache::loadCancelled(Page page)
+{
+	m_loading.erase(page);
+}
+
+PageCache::Stats PageCache::getStats() const
+{
+	Stats stats = m_stats;
+	stats.m_resident = uint32_t(m_lru_used.size());
+	stats.m_loading = uint32_t(m_loading.size());
+	return stats;
+}
+
+void PageCache::resetStats()
+{
+	bx::memSet(&m_stats, 0, sizeof(m_stats));
+}
+
+void PageCache::unlink(int slot)
+{
+	auto& lru_page = m_lru[slot];
+
+	if (lru_page.m_prev != -1)
+	{
+		m_lru[lru_page.m_prev].m_next = lru_page.m_next;
+	}
+	else
+	{
+		m_head = lru_page.m_next;
+	}
+
+	if (lru_page.m_next != -1)
+	{
+		m_lru[lru_page.m_next].m_prev = lru_page.m_prev;
+	}
+	else
+	{
+		m_tail = lru_page.m_prev;
+	}
+
+	lru_page.m_prev = -1;
+	lru_page.m_next = -1;
+}
+
+void PageCache::linkBack(int slot)
+{
+	auto& lru_page = m_lru[slot];
+	lru_page.m_prev = m_tail;
+	lru_page.m_next = -1;
+
+	if (m_tail != -1)
+	{
+		m_lru[m_tail].m_next = slot;
+	}
+	else
+	{
+		m_head = slot;
+	}
+
+	m_tail = slot;
 }
 
 // TextureAtlas
 TextureAtlas::TextureAtlas(VirtualTextureInfo* _info, int _count, int _uploadsperframe)
 	: m_info(_info)
-	, m_stagingPool(_info->GetPageSize(), _info->GetPageSize(), _uploadsperframe, false)
+	, m_stagingPool(_info->GetPageSize(), _info->GetPageSize(), _uploadsperframe, false, bgfx::TextureFormat::Enum(_info->m_format))
 {
-	// Create atlas texture
+	// Create atlas texture, in the same format pages are stored in
 	int pagesize = m_info->GetPageSize();
 	int size = _count * pagesize;
-	m_texture = bgfx::createTexture2D((uint16_t)size, (uint16_t)size, false, 1, bgfx::TextureFormat::BGRA8, BGFX_SAMPLER_UVW_CLAMP);
+	m_texture = bgfx::createTexture2D((uint16_t)size, (uint16_t)size, false, 1, bgfx::TextureFormat::Enum(m_info->m_format), BGFX_SAMPLER_UVW_CLAMP);
 }
 
 TextureAtlas::~TextureAtlas()
@@ -721,7 +1063,7 @@ void TextureAtlas::uploadPage(Point pt, uint8_t* data, bgfx::ViewId blitViewId)
 
 	// Update texture with new atlas data
 	auto   pagesize = uint16_t(m_info->GetPageSize());
-	bgfx::updateTexture2D(writer, 0, 0, 0, 0, pagesize, pagesize, bgfx::copy(data, pagesize * pagesize * s_channelCount));
+	bgfx::updateTexture2D(writer, 0, 0, 0, 0, pagesize, pagesize, bgfx::copy(data, uint32_t(m_info->GetPageDataSize())));
 
 	// Copy the texture part to the actual atlas texture
 	auto xpos = uint16_t(pt.m_x * pagesize);
@@ -735,18 +1077,18 @@ bgfx::TextureHandle TextureAtlas::getTexture()
 }
 
 // FeedbackBuffer
-FeedbackBuffer::FeedbackBuffer(VirtualTextureInfo* _info, int _width, int _height)
+FeedbackBuffer::FeedbackBuffer(VirtualTextureInfo* _info, int _width, int _height, bool _gpuReduce)
 	: m_info(_info)
 	, m_width(_width)
 	, m_height(_height)
-	, m_stagingPool(_width, _height, 1, true)
+	, m_gpuReduce(_gpuReduce)
+	, m_listWidth(0)
+	, m_listHeight(0)
+	, m_listCapacity(0)
 {
 	// Setup classes
 	m_indexer = BX_NEW(VirtualTexture::getAllocator(), PageIndexer)(m_info);
 	m_requests.resize(m_indexer->getCount());
-	// Initialize and clear buffers
-	m_downloadBuffer.resize(m_width * m_height * s_channelCount);
-	bx::memSet(&m_downloadBuffer[0], 0, m_width * m_height * s_channelCount);
 	clear();
 	// Initialize feedback frame buffer
 	bgfx::TextureHandle feedbackFrameBufferTextures[] =
@@ -755,13 +1097,110 @@ FeedbackBuffer::FeedbackBuffer(VirtualTextureInfo* _info, int _width, int _heigh
 		bgfx::createTexture2D(uint16_t(m_width), uint16_t(m_height), false, 1, bgfx::TextureFormat::D24S8, BGFX_TEXTURE_RT),
 	};
 	m_feedbackFrameBuffer = bgfx::createFrameBuffer(BX_COUNTOF(feedbackFrameBufferTextures), feedbackFrameBufferTextures, true);
-	m_lastStagingTexture = { bgfx::kInvalidHandle };
+
+	m_listTexture    = BGFX_INVALID_HANDLE;
+	m_countBuffer    = BGFX_INVALID_HANDLE;
+	m_counterBuffer  = BGFX_INVALID_HANDLE;
+	m_listBuffer     = BGFX_INVALID_HANDLE;
+	m_clearProgram   = BGFX_INVALID_HANDLE;
+	m_reduceProgram  = BGFX_INVALID_HANDLE;
+	m_compactProgram = BGFX_INVALID_HANDLE;
+	u_vt_feedback    = BGFX_INVALID_HANDLE;
+	s_vt_feedback    = BGFX_INVALID_HANDLE;
+
+	m_gpuReduce = m_gpuReduce && 0 != (bgfx::getCaps()->supported & BGFX_CAPS_COMPUTE);
+
+	if (m_gpuReduce)
+	{
+		m_clearProgram   = loadProgram("cs_vt_feedback_clear", nullptr);
+		m_reduceProgram  = loadProgram("cs_vt_feedback_reduce", nullptr);
+		m_compactProgram = loadProgram("cs_vt_feedback_compact", nullptr);
+
+		// Compute shaders might not be built for this renderer, use CPU reduction then
+		if (!bgfx::isValid(m_clearProgram)
+		||  !bgfx::isValid(m_reduceProgram)
+		||  !bgfx::isValid(m_compactProgram) )
+		{
+			DBG("Feedback compute shaders not available, falling back to CPU readback.");
+
+			bgfx::ProgramHandle* programs[] = { &m_clearProgram, &m_reduceProgram, &m_compactProgram };
+			for (bgfx::ProgramHandle* program : programs)
+			{
+				if (bgfx::isValid(*program) )
+				{
+					bgfx::destroy(*program);
+				}
+			}
+
+			m_clearProgram   = BGFX_INVALID_HANDLE;
+			m_reduceProgram  = BGFX_INVALID_HANDLE;
+			m_compactProgram = BGFX_INVALID_HANDLE;
+			m_gpuReduce      = false;
+		}
+	}
+
+	uint16_t readbackWidth = uint16_t(m_width);
+	uint16_t readbackHeight = uint16_t(m_height);
+	bgfx::TextureFormat::Enum readbackFormat = bgfx::TextureFormat::BGRA8;
+
+	if (m_gpuReduce)
+	{
+		// There can't be more unique pages than pixels or pages, one more texel for count
+		m_listCapacity = bx::min(m_width * m_height, m_indexer->getCount());
+		m_listWidth = m_width;
+		m_listHeight = (m_listCapacity + 1 + m_listWidth - 1) / m_listWidth;
+
+		m_listTexture = bgfx::createTexture2D(uint16_t(m_listWidth), uint16_t(m_listHeight), false, 1, bgfx::TextureFormat::R32U, BGFX_TEXTURE_COMPUTE_WRITE);
+
+		// Request counts must start at zero, compact pass resets counts it has consumed
+		const bgfx::Memory* mem = bgfx::alloc(uint32_t(m_indexer->getCount() * sizeof(uint32_t)));
+		bx::memSet(mem->data, 0, mem->size);
+		m_countBuffer   = bgfx::createDynamicIndexBuffer(mem, BGFX_BUFFER_COMPUTE_READ_WRITE | BGFX_BUFFER_INDEX32);
+		m_counterBuffer = bgfx::createDynamicIndexBuffer(1, BGFX_BUFFER_COMPUTE_READ_WRITE | BGFX_BUFFER_INDEX32);
+		m_listBuffer    = bgfx::createDynamicIndexBuffer(uint32_t(m_listCapacity), BGFX_BUFFER_COMPUTE_READ_WRITE | BGFX_BUFFER_INDEX32);
+
+		u_vt_feedback = bgfx::createUniform("u_vt_feedback", bgfx::UniformType::Vec4);
+		s_vt_feedback = bgfx::createUniform("s_vt_feedback", bgfx::UniformType::Sampler);
+
+		readbackWidth = uint16_t(m_listWidth);
+		readbackHeight = uint16_t(m_listHeight);
+		readbackFormat = bgfx::TextureFormat::R32U;
+	}
+
+	// Initialize readback ring. This doesn't go through ReadbackQueue: each slot owns its
+	// read-back texture and data, and a frame is skipped when every slot is in flight, so
+	// there is nothing to gain from the queue's shared staging ring.
+	for (auto& readback : m_readbacks)
+	{
+		readback.m_texture = bgfx::createTexture2D(readbackWidth, readbackHeight, false, 1, readbackFormat, BGFX_TEXTURE_BLIT_DST | BGFX_TEXTURE_READ_BACK | BGFX_SAMPLER_UVW_CLAMP);
+		readback.m_frame = 0;
+		readback.m_pending = false;
+		readback.m_data.resize(readbackWidth * readbackHeight * 4);
+	}
 }
 
 FeedbackBuffer::~FeedbackBuffer()
 {
 	BX_DELETE(VirtualTexture::getAllocator(), m_indexer);
 	bgfx::destroy(m_feedbackFrameBuffer);
+
+	for (auto& readback : m_readbacks)
+	{
+		bgfx::destroy(readback.m_texture);
+	}
+
+	if (m_gpuReduce)
+	{
+		bgfx::destroy(m_listTexture);
+		bgfx::destroy(m_countBuffer);
+		bgfx::destroy(m_counterBuffer);
+		bgfx::destroy(m_listBuffer);
+		bgfx::destroy(m_clearProgram);
+		bgfx::destroy(m_reduceProgram);
+		bgfx::destroy(m_compactProgram);
+		bgfx::destroy(u_vt_feedback);
+		bgfx::destroy(s_vt_feedback);
+	}
 }
 
 void FeedbackBuffer::clear()
@@ -770,26 +1209,112 @@ void FeedbackBuffer::clear()
 	bx::memSet(&m_requests[0], 0, sizeof(int) * m_indexer->getCount());
 }
 
-void FeedbackBuffer::copy(bgfx::ViewId viewId)
+void FeedbackBuffer::copy(bgfx::ViewId viewId, bgfx::ViewId computeViewId)
 {
-	m_lastStagingTexture = m_stagingPool.getTexture();
-	// Copy feedback buffer render target to staging texture
-	bgfx::blit(viewId, m_lastStagingTexture, 0, 0, bgfx::getTexture(m_feedbackFrameBuffer));
-	m_stagingPool.next();
+	// Find free readback slot, if all are in flight skip this frame rather than wait
+	Readback* readback = nullptr;
+	for (auto& it : m_readbacks)
+	{
+		if (!it.m_pending)
+		{
+			readback = &it;
+			break;
+		}
+	}
+
+	if (readback == nullptr)
+	{
+		return;
+	}
+
+	if (m_gpuReduce)
+	{
+		const float params[4] =
+		{
+			float(m_width),
+			float(m_height),
+			float(m_info->GetPageTableSize()),
+			float(m_listCapacity),
+		};
+
+		bgfx::setBuffer(2, m_counterBuffer, bgfx::Access::Write);
+		bgfx::dispatch(computeViewId, m_clearProgram, 1, 1, 1);
+
+		// Mark requested pages, and append first request of each page to list
+		bgfx::setUniform(u_vt_feedback, params);
+		bgfx::setTexture(0, s_vt_feedback, bgfx::getTexture(m_feedbackFrameBuffer));
+		bgfx::setBuffer(1, m_countBuffer, bgfx::Access::ReadWrite);
+		bgfx::setBuffer(2, m_counterBuffer, bgfx::Access::ReadWrite);
+		bgfx::setBuffer(3, m_listBuffer, bgfx::Access::Write);
+		bgfx::dispatch(computeViewId, m_reduceProgram, uint32_t(m_width + 7) / 8, uint32_t(m_height + 7) / 8, 1);
+
+		// Pack page indices with request counts into list texture
+		bgfx::setUniform(u_vt_feedback, params);
+		bgfx::setBuffer(1, m_countBuffer, bgfx::Access::ReadWrite);
+		bgfx::setBuffer(2, m_counterBuffer, bgfx::Access::Read);
+		bgfx::setBuffer(3, m_listBuffer, bgfx::Access::Read);
+		bgfx::setImage(4, m_listTexture, 0, bgfx::Access::Write, bgfx::TextureFormat::R32U);
+		bgfx::dispatch(computeViewId, m_compactProgram, uint32_t(m_listCapacity + 63) / 64, 1, 1);
+
+		bgfx::blit(viewId, readback->m_texture, 0, 0, m_listTexture);
+	}
+	else
+	{
+		// Copy feedback buffer render target to staging texture
+		bgfx::blit(viewId, readback->m_texture, 0, 0, bgfx::getTexture(m_feedbackFrameBuffer));
+	}
+
+	readback->m_frame = bgfx::readTexture(readback->m_texture, &readback->m_data[0]);
+	readback->m_pending = true;
 }
 
-void FeedbackBuffer::download()
+void FeedbackBuffer::download(uint32_t frame)
 {
-	// Check if there's an already rendered feedback buffer available
-	if (m_lastStagingTexture.idx == bgfx::kInvalidHandle)
+	// Consume readbacks in the order they were issued
+	for (;;)
 	{
+		Readback* oldest = nullptr;
+		for (auto& it : m_readbacks)
+		{
+			if (it.m_pending
+			&&  it.m_frame <= frame
+			&& (oldest == nullptr || it.m_frame < oldest->m_frame))
+			{
+				oldest = &it;
+			}
+		}
+
+		if (oldest == nullptr)
+		{
+			break;
+		}
+
+		process(&oldest->m_data[0]);
+		oldest->m_pending = false;
+	}
+}
+
+void FeedbackBuffer::process(const uint8_t* data)
+{
+	if (m_gpuReduce)
+	{
+		// Only unique pages are touched
+		auto list = (const uint32_t*)data;
+		int count = bx::min(int(list[0]), m_listCapacity);
+		for (int i = 0; i < count; ++i)
+		{
+			uint32_t entry = list[1 + i];
+			int index = int(entry & 0xffffff);
+			if (index < m_indexer->getCount())
+			{
+				addRequestAndParents(m_indexer->getPageFromIndex(index), int(entry >> 24));
+			}
+		}
 		return;
 	}
-	// Read the texture
-	bgfx::readTexture(m_lastStagingTexture, &m_downloadBuffer[0]);
+
 	// Loop through pixels and check if anything was written
-	auto data = &m_downloadBuffer[0];
-	auto colors = (Color*)data;
+	auto colors = (const Color*)data;
 	auto dataSize = m_width * m_height;
 	for (int i = 0; i < dataSize; ++i)
 	{
@@ -799,20 +1324,18 @@ void FeedbackBuffer::download()
 			// Page found! Add it to the request queue
 			Page request = { color.m_b, color.m_g, color.m_r };
 			addRequestAndParents(request);
-			// Clear the pixel, so that we don't have to do it in another pass
-			color = { 0,0,0,0 };
 		}
 	}
 }
 
 // This function validates the pages and adds the page's parents
 // We do this so that we can fall back to them if we run out of memory
-void FeedbackBuffer::addRequestAndParents(Page request)
+void FeedbackBuffer::addRequestAndParents(Page request, int count)
 {
 	auto PageTableSizeLog2 = m_indexer->getMipCount();
-	auto count = PageTableSizeLog2 - request.m_mip;
+	auto mipCount = PageTableSizeLog2 - request.m_mip;
 
-	for (int i = 0; i < count; ++i)
+	for (int i = 0; i < mipCount; ++i)
 	{
 		int xpos = request.m_x >> i;
 		int ypos = request.m_y >> i;
@@ -825,10 +1348,15 @@ void FeedbackBuffer::addRequestAndParents(Page request)
 			return;
 		}
 
-		++m_requests[m_indexer->getIndexFromPage(page)];
+		m_requests[m_indexer->getIndexFromPage(page)] += count;
 	}
 }
 
+bool FeedbackBuffer::isGpuReduceEnabled() const
+{
+	return m_gpuReduce;
+}
+
 const tinystl::vector<int>& FeedbackBuffer::getRequests() const
 {
 	return m_requests;
@@ -878,10 +1406,10 @@ VirtualTexture::VirtualTexture(TileDataFile* _tileDataFile, VirtualTextureInfo*
 
 VirtualTexture::~VirtualTexture()
 {
-	// Destroy
+	// Destroy, loader goes first so worker threads are stopped before anything they use
+	BX_DELETE(VirtualTexture::getAllocator(), m_loader);
 	BX_DELETE(VirtualTexture::getAllocator(), m_indexer);
 	BX_DELETE(VirtualTexture::getAllocator(), m_atlas);
-	BX_DELETE(VirtualTexture::getAllocator(), m_loader);
 	BX_DELETE(VirtualTexture::getAllocator(), m_cache);
 	BX_DELETE(VirtualTexture::getAllocator(), m_pageTable);
 	// Destroy all uniforms and textures
@@ -949,6 +1477,16 @@ int VirtualTexture::getUploadsPerFrame() const
 	return m_uploadsPerFrame;
 }
 
+PageCache::Stats VirtualTexture::getCacheStats() const
+{
+	return m_cache->getStats();
+}
+
+void VirtualTexture::resetCacheStats()
+{
+	m_cache->resetStats();
+}
+
 
 void VirtualTexture::enableShowBoarders(bool enable)
 {
@@ -999,6 +1537,9 @@ void VirtualTexture::update(const tinystl::vector<int>& requests, bgfx::ViewId b
 {
 	m_pagesToLoad.clear();
 
+	// Upload pages loaded since last update
+	m_cache->update(blitViewId, m_uploadsPerFrame);
+
 	// Find out what is already in memory
 	// If it is, update it's position in the LRU collection
 	// Otherwise add it to the list of pages to load
@@ -1036,7 +1577,11 @@ void VirtualTexture::update(const tinystl::vector<int>& requests, bgfx::ViewId b
 		// if more pages than will fit in memory or more than update per frame drop high res pages with lowest use count
 		int loadcount = bx::min(bx::min((int)m_pagesToLoad.size(), m_uploadsPerFrame), m_atlasCount * m_atlasCount);
 		for (int i = 0; i < loadcount; ++i)
-			m_cache->request(m_pagesToLoad[i].m_page, blitViewId);
+		{
+			// Low res pages first, then by number of requests
+			const PageCount& pc = m_pagesToLoad[i];
+			m_cache->request(pc.m_page, blitViewId, (pc.m_page.m_mip << 16) | bx::min(pc.m_count, 0xffff));
+		}
 	}
 	else
 	{
@@ -1061,11 +1606,13 @@ bx::AllocatorI* VirtualTexture::getAllocator()
 	return s_allocator;
 }
 
-TileDataFile::TileDataFile(const bx::FilePath& filename, VirtualTextureInfo* _info, bool _readWrite) : m_info(_info)
+TileDataFile::TileDataFile(const bx::FilePath& filename, VirtualTextureInfo* _info, bool _readWrite)
+	: m_info(_info)
+	, m_readWrite(_readWrite)
 {
 	const char* access = _readWrite ? "w+b" : "rb";
 	m_file = fopen(filename.getCPtr(), access);
-	m_size = m_info->GetPageSize() * m_info->GetPageSize() * s_channelCount;
+	m_size = m_info->GetPageDataSize();
 }
 
 TileDataFile::~TileDataFile()
@@ -1078,7 +1625,7 @@ void TileDataFile::readInfo()
 	fseek(m_file, 0, SEEK_SET);
 	auto ret = fread(m_info, sizeof(*m_info), 1, m_file);
 	BX_UNUSED(ret);
-	m_size = m_info->GetPageSize() * m_info->GetPageSize() * s_channelCount;
+	m_size = m_info->GetPageDataSize();
 }
 
 void TileDataFile::writeInfo()
@@ -1090,6 +1637,18 @@ void TileDataFile::writeInfo()
 
 void TileDataFile::readPage(int index, uint8_t* data)
 {
+#if BX_PLATFORM_POSIX
+	// Positional read doesn't touch shared file position, so worker threads don't contend.
+	// Writable file goes through stdio, since it may have buffered writes.
+	if (!m_readWrite)
+	{
+		auto ret = pread(fileno(m_file), data, m_size, off_t(m_size) * index + s_tileFileDataOffset);
+		BX_UNUSED(ret);
+		return;
+	}
+#endif // BX_PLATFORM_POSIX
+
+	bx::MutexScope lock(m_mutex);
 	fseek(m_file, m_size * index + s_tileFileDataOffset, SEEK_SET);
 	auto ret = fread(data, m_size, 1, m_file);
 	BX_UNUSED(ret);
@@ -1097,6 +1656,7 @@ void TileDataFile::readPage(int index, uint8_t* data)
 
 void TileDataFile::writePage(int index, uint8_t* data)
 {
+	bx::MutexScope lock(m_mutex);
 	fseek(m_file, m_size * index + s_tileFileDataOffset, SEEK_SET);
 	auto ret = fwrite(data, m_size, 1, m_file);
 	BX_UNUSED(ret);
@@ -1134,17 +1694,33 @@ TileGenerator::~TileGenerator()
 	BX_DELETE(VirtualTexture::getAllocator(), m_tileImage);
 }
 
-bool TileGenerator::generate(const bx::FilePath& _filePath)
+bx::FilePath TileGenerator::getTileDataFilePath(const bx::FilePath& _filePath, bimg::TextureFormat::Enum _format)
 {
 	const bx::StringView baseName = _filePath.getBaseName();
 
-	// Generate cache filename
+	// Generate cache filename, format is part of the name so that different formats can coexist
 	char tmp[256];
-	bx::snprintf(tmp, sizeof(tmp), "%.*s.vt", baseName.getLength(), baseName.getPtr() );
+	bx::snprintf(tmp, sizeof(tmp), "%.*s_%s.vt", baseName.getLength(), baseName.getPtr(), bimg::getName(_format) );
 
 	bx::FilePath cacheFilePath("temp");
 	cacheFilePath.join(tmp);
 
+	return cacheFilePath;
+}
+
+bool TileGenerator::generate(const bx::FilePath& _filePath)
+{
+	const bx::FilePath cacheFilePath = getTileDataFilePath(_filePath, m_info->m_format);
+
+	// Block compressed tiles are encoded from uncompressed intermediate file
+	bx::FilePath rawFilePath = cacheFilePath;
+	if (m_info->IsCompressed())
+	{
+		char tmp[256];
+		bx::snprintf(tmp, sizeof(tmp), "%s.raw", cacheFilePath.getCPtr() );
+		rawFilePath.set(tmp);
+	}
+
 	// Check if tile file already exist
 	{
 		bx::Error err;
@@ -1206,8 +1782,25 @@ bool TileGenerator::generate(const bx::FilePath& _filePath)
 	m_info->m_virtualTextureSize = int(m_sourceImage->m_width);
 	m_indexer = BX_NEW(VirtualTexture::getAllocator(), PageIndexer)(m_info);
 
-	// Open tile data file
-	m_tileDataFile = BX_NEW(VirtualTexture::getAllocator(), TileDataFile)(cacheFilePath, m_info, true);
+	if (m_info->IsCompressed())
+	{
+		// Pages must start and end on block boundary, grow border until page size is multiple
+		// of block size, so that each page is encoded with its own border.
+		const bimg::ImageBlockInfo& blockInfo = bimg::getBlockInfo(m_info->m_format);
+		while (0 != m_info->GetPageSize() % blockInfo.blockWidth
+		||     0 != m_info->GetPageSize() % blockInfo.blockHeight)
+		{
+			++m_info->m_borderSize;
+		}
+
+		m_pagesize = m_info->GetPageSize();
+		bx::debugPrintf("Border size %d, page size %d for %s.\n", m_info->m_borderSize, m_pagesize, bimg::getName(m_info->m_format) );
+	}
+
+	// Open tile data file, pages are generated uncompressed, since lower mips are built from higher ones
+	VirtualTextureInfo rawInfo = *m_info;
+	rawInfo.m_format = bimg::TextureFormat::BGRA8;
+	m_tileDataFile = BX_NEW(VirtualTexture::getAllocator(), TileDataFile)(rawFilePath, &rawInfo, true);
 	m_page1Image   = BX_NEW(VirtualTexture::getAllocator(), SimpleImage)(m_pagesize, m_pagesize, s_channelCount, 0xff);
 	m_page2Image   = BX_NEW(VirtualTexture::getAllocator(), SimpleImage)(m_pagesize, m_pagesize, s_channelCount, 0xff);
 	m_tileImage    = BX_NEW(VirtualTexture::getAllocator(), SimpleImage)(m_tilesize, m_tilesize, s_channelCount, 0xff);
@@ -1238,10 +1831,58 @@ bool TileGenerator::generate(const bx::FilePath& _filePath)
 	// Close tile file
 	BX_DELETE(VirtualTexture::getAllocator(), m_tileDataFile);
 	m_tileDataFile = nullptr;
+
+	if (m_info->IsCompressed()
+	&& !compress(rawFilePath, cacheFilePath))
+	{
+		return false;
+	}
+
 	bx::debugPrintf("Done!\n");
 	return true;
 }
 
+bool TileGenerator::compress(const bx::FilePath& _rawFilePath, const bx::FilePath& _filePath)
+{
+	bx::debugPrintf("Compressing tiles to %s\n", bimg::getName(m_info->m_format) );
+
+	{
+		VirtualTextureInfo rawInfo = *m_info;
+		rawInfo.m_format = bimg::TextureFormat::BGRA8;
+
+		TileDataFile rawFile(_rawFilePath, &rawInfo);
+		TileDataFile file(_filePath, m_info, true);
+
+		auto pitch = uint32_t(m_pagesize * s_channelCount);
+		tinystl::vector<uint8_t> image(m_pagesize * pitch);
+		tinystl::vector<uint8_t> data(m_info->GetPageDataSize());
+
+		for (int i = 0; i < m_indexer->getCount(); ++i)
+		{
+			rawFile.readPage(i, &image[0]);
+
+			// Tiles are stored as BGRA8, encoder expects RGBA8
+			bimg::imageSwizzleBgra8(&image[0], pitch, m_pagesize, m_pagesize, &image[0], pitch);
+
+			bx::Error err;
+			bimg::imageEncodeFromRgba8(VirtualTexture::getAllocator(), &data[0], &image[0], m_pagesize, m_pagesize, 1, m_info->m_format, bimg::Quality::Default, &err);
+
+			if (!err.isOk())
+			{
+				bx::debugPrintf("Tile encoding failed '%s'.\n", _filePath.getCPtr() );
+				return false;
+			}
+
+			file.writePage(i, &data[0]);
+		}
+
+		file.writeInfo();
+	}
+
+	remove(_rawFilePath.getCPtr());
+	return true;
+}
+
 void TileGenerator::CopyTile(SimpleImage& image, Page request)
 {
 	if (request.m_mip == 0)
@@ -16,7 +16,11 @@
 #pragma once
 
 #include <bimg/decode.h>
+#include <bx/mutex.h>
+#include <bx/semaphore.h>
+#include <bx/thread.h>
 #include <tinystl/allocator.h>
+#include <tinystl/unordered_map.h>
 #include <tinystl/unordered_set.h>
 #include <tinystl/vector.h>
 #include <functional>
@@ -102,17 +106,20 @@ struct VirtualTextureInfo
 	VirtualTextureInfo();
 	int GetPageSize() const;
 	int GetPageTableSize() const;
+	int GetPageDataSize() const;
+	bool IsCompressed() const;
 
 	int m_virtualTextureSize = 0;
 	int m_tileSize = 0;
 	int m_borderSize = 0;
+	bimg::TextureFormat::Enum m_format = bimg::TextureFormat::BGRA8; // Page storage and atlas format
 };
 
 // StagingPool
 class StagingPool
 {
 public:
-	StagingPool(int _width, int _height, int _count, bool _readBack);
+	StagingPool(int _width, int _height, int _count, bool _readBack, bgfx::TextureFormat::Enum _format = bgfx::TextureFormat::BGRA8);
 	~StagingPool();
 
 	void grow(int count);
@@ -127,6 +134,7 @@ private:
 	int			m_width;
 	int			m_height;
 	uint64_t	m_flags;
+	bgfx::TextureFormat::Enum m_format;
 };
 
 // PageIndexer
@@ -213,42 +221,102 @@ private:
 };
 
 // PageLoader
+// Loads pages on a pool of worker threads. Requests are served highest priority first,
+// requests that were not refreshed for a few frames are cancelled before they hit the disk,
+// and completed pages are handed back on the main thread from update().
 class PageLoader
 {
 public:
+	// Debug overlay flags are copied into each request when it's queued, so that workers
+	// never read loader state that main thread can change.
 	struct ReadState
 	{
 		Page						m_page;
+		uint32_t					m_generation;
+		bool						m_colorMipLevels;
+		bool						m_showBorders;
 		tinystl::vector<uint8_t>	m_data;
 	};
 
-	PageLoader(TileDataFile* _tileDataFile, PageIndexer* _indexer, VirtualTextureInfo* _info);
-	void submit(Page request);
+	struct Request
+	{
+		Page		m_page;
+		int			m_priority;
+		uint32_t	m_frame;
+		bool		m_colorMipLevels;
+		bool		m_showBorders;
+	};
+
+	PageLoader(TileDataFile* _tileDataFile, PageIndexer* _indexer, VirtualTextureInfo* _info, int _numThreads = 2);
+	~PageLoader();
+
+	// Adds request, page must not be already submitted
+	void submit(Page request, int priority = 0);
+	// Refreshes priority and frame of request if it's still pending
+	void touch(Page request, int priority = 0);
+	// Cancels pending requests not submitted within last maxAge frames
+	void cancelStale(int maxAge);
+	// Drops all pending requests, and discards pages loaded before this call
+	void flush();
+	// Hands back at most maxCount loaded pages, must be called from main thread
+	void update(int maxCount);
+
 	void loadPage(ReadState& state);
 	void onPageLoadComplete(ReadState& state);
 	void copyBorder(uint8_t* image);
 	void copyColor(uint8_t* image, Page request);
 
 	std::function<void(Page, uint8_t*)> loadComplete;
+	std::function<void(Page)>           loadCancelled;
 
+	// Main thread only
 	bool m_colorMipLevels;
 	bool m_showBorders;
 
 private:
+	static int32_t workerThreadFunc(bx::Thread* _thread, void* _userData);
+	int32_t worker();
+
 	TileDataFile*		m_tileDataFile;
 	PageIndexer*        m_indexer;
 	VirtualTextureInfo* m_info;
+
+	bx::Thread*			m_threads;
+	int					m_numThreads;
+
+	bx::Mutex			m_mutex;
+	bx::Semaphore		m_sem;
+	bool				m_exit;
+	uint32_t			m_frame;
+	uint32_t			m_generation;
+
+	tinystl::vector<Request>	m_pending;
+	tinystl::vector<ReadState*>	m_completed;
 };
 
 // PageCache
 class PageCache
 {
 public:
+	struct Stats
+	{
+		uint32_t m_hits;      // Touches of resident pages
+		uint32_t m_misses;    // Touches of pages neither resident nor loading
+		uint32_t m_evictions; // Pages removed to make room for new ones
+		uint32_t m_resident;
+		uint32_t m_loading;
+	};
+
 	PageCache(TextureAtlas* _atlas, PageLoader* _loader, int _count);
 	bool touch(Page page);
-	bool request(Page request, bgfx::ViewId blitViewId);
+	bool request(Page request, bgfx::ViewId blitViewId, int priority = 0);
+	void update(bgfx::ViewId blitViewId, int uploadsPerFrame);
 	void clear();
 	void loadComplete(Page page, uint8_t* data);
+	void loadCancelled(Page page);
+
+	Stats getStats() const;
+	void resetStats();
 
 	// These callbacks are used to notify the other systems
 	std::function<void(Page, Point)> removed;
@@ -260,22 +328,30 @@ private:
 
 	int m_count;
 
+	// One entry per atlas slot, linked into intrusive list from least to most recently used
 	struct LruPage
 	{
-		Page	m_page;
-		Point	m_point;
-
-		bool operator==(const Page& other) const
-		{
-			return m_page == other;
-		}
+		Page		m_page;
+		Point		m_point;
+		int			m_prev;
+		int			m_next;
+		uint32_t	m_frame; // Frame of last touch, page is moved at most once per frame
 	};
 
+	void unlink(int slot);
+	void linkBack(int slot);
+
 	int m_current; // This is used for generating the texture atlas indices before the lru is full
+	int m_head;    // Least recently used slot
+	int m_tail;    // Most recently used slot
+
+	uint32_t m_frame;
 
-	tinystl::unordered_set<Page>    m_lru_used;
-	tinystl::vector<LruPage>		m_lru;
-	tinystl::unordered_set<Page>	m_loading;
+	tinystl::unordered_map<Page, int>	m_lru_used; // Page to atlas slot
+	tinystl::vector<LruPage>			m_lru;
+	tinystl::unordered_set<Page>		m_loading;
+
+	Stats m_stats;
 
 	bgfx::ViewId m_blitViewId;
 };
@@ -299,20 +375,27 @@ private:
 };
 
 // FeedbackBuffer
+// Feedback render target holds page requested by each pixel. It's either read back as is and
+// scanned on CPU, or reduced by compute shaders into list of unique pages with request counts.
+// Readbacks go through small ring of staging textures, and are consumed only once frame
+// returned by bgfx::readTexture is reached, so CPU never waits on GPU.
 class FeedbackBuffer
 {
 public:
-	FeedbackBuffer(VirtualTextureInfo* _info, int _width, int _height);
+	FeedbackBuffer(VirtualTextureInfo* _info, int _width, int _height, bool _gpuReduce = false);
 	~FeedbackBuffer();
 
 	void clear();
 
-	void copy(bgfx::ViewId viewId);
-	void download();
+	// Reduces feedback on computeViewId (when GPU reduction is enabled), and copies result
+	// for readback on viewId. Compute view must be submitted before copy view.
+	void copy(bgfx::ViewId viewId, bgfx::ViewId computeViewId);
+	// Processes readbacks that are available in frame returned by bgfx::frame
+	void download(uint32_t frame);
 
 	// This function validates the pages and adds the page's parents
 	// We do this so that we can fall back to them if we run out of memory
-	void addRequestAndParents(Page request);
+	void addRequestAndParents(Page request, int count = 1);
 
 	const tinystl::vector<int>& getRequests() const;
 	bgfx::FrameBufferHandle getFrameBuffer();
@@ -320,20 +403,48 @@ public:
 	int getWidth() const;
 	int getHeight() const;
 
+	bool isGpuReduceEnabled() const;
+
 private:
+	void process(const uint8_t* data);
+
+	struct Readback
+	{
+		bgfx::TextureHandle			m_texture;
+		uint32_t					m_frame;
+		bool						m_pending;
+		tinystl::vector<uint8_t>	m_data;
+	};
+
+	static const int kReadbackCount = 3;
+
 	VirtualTextureInfo* m_info;
 	PageIndexer*		m_indexer;
 
 	int m_width = 0;
 	int m_height = 0;
 
-	StagingPool				m_stagingPool;
-	bgfx::TextureHandle		m_lastStagingTexture;
+	Readback				m_readbacks[kReadbackCount];
 	bgfx::FrameBufferHandle m_feedbackFrameBuffer;
 
+	// GPU reduction, list texture has request count in first texel, followed by packed
+	// page index (low 24 bits) and number of requests (high 8 bits)
+	bool							m_gpuReduce;
+	int								m_listWidth;
+	int								m_listHeight;
+	int								m_listCapacity;
+	bgfx::TextureHandle				m_listTexture;
+	bgfx::DynamicIndexBufferHandle	m_countBuffer;
+	bgfx::DynamicIndexBufferHandle	m_counterBuffer;
+	bgfx::DynamicIndexBufferHandle	m_listBuffer;
+	bgfx::ProgramHandle				m_clearProgram;
+	bgfx::ProgramHandle				m_reduceProgram;
+	bgfx::ProgramHandle				m_compactProgram;
+	bgfx::UniformHandle				u_vt_feedback;
+	bgfx::UniformHandle				s_vt_feedback;
+
 	// This stores the pages by index.  The int value is number of requests.
 	tinystl::vector<int>		m_requests;
-	tinystl::vector<uint8_t>	m_downloadBuffer;
 };
 
 // VirtualTexture
@@ -349,6 +460,9 @@ public:
 	void setUploadsPerFrame(int count);
 	int getUploadsPerFrame() const;
 
+	PageCache::Stats getCacheStats() const;
+	void resetCacheStats();
+
 	void enableShowBoarders(bool enable);
 	bool isShowBoardersEnabled() const;
 
@@ -400,6 +514,7 @@ public:
 	void readInfo();
 	void writeInfo();
 
+	// Thread safe, can be called from page loader worker threads
 	void readPage(int index, uint8_t* data);
 	void writePage(int index, uint8_t* data);
 
@@ -407,6 +522,8 @@ private:
 	VirtualTextureInfo*	m_info;
 	int					m_size;
 	FILE*				m_file;
+	bool				m_readWrite;
+	bx::Mutex			m_mutex;
 };
 
 // TileGenerator
@@ -416,10 +533,15 @@ public:
 	TileGenerator(VirtualTextureInfo* _info);
 	~TileGenerator();
 
+	// Generates tiles in format set in info, block compressed formats are encoded from
+	// uncompressed intermediate tile file
 	bool generate(const bx::FilePath& filename);
 
+	static bx::FilePath getTileDataFilePath(const bx::FilePath& filename, bimg::TextureFormat::Enum format);
+
 private:
 	void CopyTile(SimpleImage& image, Page request);
+	bool compress(const bx::FilePath& rawFilePath, const bx::FilePath& filePath);
 
 private:
 	VirtualTextureInfo* m_info;
@@ -13,6 +13,7 @@ namespace stl = tinystl;
 #include <bgfx/bgfx.h>
 #include <bx/commandline.h>
 #include <bx/endian.h>
+#include <bx/hash.h>
 #include <bx/math.h>
 #include <bx/readerwriter.h>
 #include <bx/string.h>
@@ -23,6 +24,13 @@ namespace stl = tinystl;
 
 #include <bimg/decode.h>
 
+#if BX_PLATFORM_POSIX
+#	include <fcntl.h>
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#	include <unistd.h>
+#endif // BX_PLATFORM_POSIX
+
 void* load(bx::FileReaderI* _reader, bx::AllocatorI* _allocator, const char* _filePath, uint32_t* _size)
 {
 	if (bx::open(_reader, _filePath) )
@@ -96,10 +104,8 @@ static void* loadMem(bx::FileReaderI* _reader, bx::AllocatorI* _allocator, const
 	return NULL;
 }
 
-static bgfx::ShaderHandle loadShader(bx::FileReaderI* _reader, const char* _name)
+static const char* getShaderPath()
 {
-	char filePath[512];
-
 	const char* shaderPath = "???";
 
 	switch (bgfx::getRendererType() )
@@ -121,11 +127,25 @@ static bgfx::ShaderHandle loadShader(bx::FileReaderI* _reader, const char* _name
 		break;
 	}
 
-	bx::strCopy(filePath, BX_COUNTOF(filePath), shaderPath);
+	return shaderPath;
+}
+
+static bgfx::ShaderHandle loadShader(bx::FileReaderI* _reader, const char* _name)
+{
+	char filePath[512];
+
+	bx::strCopy(filePath, BX_COUNTOF(filePath), getShaderPath() );
 	bx::strCat(filePath, BX_COUNTOF(filePath), _name);
 	bx::strCat(filePath, BX_COUNTOF(filePath), ".bin");
 
-	bgfx::ShaderHandle handle = bgfx::createShader(loadMem(_reader, filePath) );
+	const bgfx::Memory* mem = loadMem(_reader, filePath);
+	if (NULL == mem)
+	{
+		bgfx::ShaderHandle invalid = BGFX_INVALID_HANDLE;
+		return invalid;
+	}
+
+	bgfx::ShaderHandle handle = bgfx::createShader(mem);
 	bgfx::setName(handle, _name);
 
 	return handle;
@@ -136,6 +156,192 @@ bgfx::ShaderHandle loadShader(const char* _name)
 	return loadShader(entry::getFileReader(), _name);
 }
 
+#define BGFX_CHUNK_MAGIC_SVP BX_MAKEFOURCC('S', 'V', 'P', 0x1)
+
+bgfx::ShaderHandle createShaderVariant(const void* _data, uint32_t _size, const char* _keywords)
+{
+	bgfx::ShaderHandle handle = BGFX_INVALID_HANDLE;
+
+	bx::MemoryReader reader(_data, _size);
+	bx::Error err;
+
+	uint32_t magic;
+	bx::read(&reader, magic, &err);
+
+	if (!err.isOk()
+	||  BGFX_CHUNK_MAGIC_SVP != magic)
+	{
+		DBG("Invalid shader variant pack.");
+		return handle;
+	}
+
+	uint8_t numKeywords;
+	bx::read(&reader, numKeywords, &err);
+
+	bx::StringView keywords[32];
+	if (!err.isOk()
+	||  BX_COUNTOF(keywords) < numKeywords)
+	{
+		DBG("Invalid shader variant pack.");
+		return handle;
+	}
+
+	for (uint32_t ii = 0; ii < numKeywords && err.isOk(); ++ii)
+	{
+		uint8_t len;
+		bx::read(&reader, len, &err);
+
+		const uint32_t offset = uint32_t(reader.seek() );
+		if (!err.isOk()
+		||  len > _size - offset)
+		{
+			DBG("Invalid shader variant pack.");
+			return handle;
+		}
+
+		const char* name = (const char*)_data + offset;
+		bx::skip(&reader, len);
+
+		keywords[ii].set(name, len);
+	}
+
+	if (!err.isOk() )
+	{
+		DBG("Invalid shader variant pack.");
+		return handle;
+	}
+
+	uint32_t mask = 0;
+
+	bx::StringView parse(NULL != _keywords ? _keywords : "");
+	while (!parse.isEmpty() )
+	{
+		bx::StringView eok = bx::strFind(parse, ';');
+		bx::StringView keyword = bx::strRTrim(bx::strLTrimSpace(bx::StringView(parse.getPtr(), eok.getPtr() ) ), " \t");
+
+		if (!keyword.isEmpty() )
+		{
+			uint32_t idx = 0;
+			for (; idx < numKeywords; ++idx)
+			{
+				if (0 == bx::strCmp(keyword, keywords[idx]) )
+				{
+					mask |= UINT32_C(1) << idx;
+					break;
+				}
+			}
+
+			if (idx == numKeywords)
+			{
+				DBG("Unknown shader variant keyword %.*s.", keyword.getLength(), keyword.getPtr() );
+				return handle;
+			}
+		}
+
+		parse = eok.isEmpty() ? bx::StringView() : bx::StringView(eok.getPtr()+1, parse.getTerm() );
+	}
+
+	uint16_t numVariants;
+	bx::read(&reader, numVariants, &err);
+
+	uint32_t shaderIndex = UINT32_MAX;
+	for (uint32_t ii = 0; ii < numVariants && err.isOk(); ++ii)
+	{
+		uint32_t variantMask;
+		uint16_t variantShaderIndex;
+		bx::read(&reader, variantMask, &err);
+		bx::read(&reader, variantShaderIndex, &err);
+
+		if (variantMask == mask)
+		{
+			shaderIndex = variantShaderIndex;
+		}
+	}
+
+	uint16_t numShaders;
+	bx::read(&reader, numShaders, &err);
+
+	for (uint32_t ii = 0; ii < numShaders && err.isOk(); ++ii)
+	{
+		uint32_t size;
+		bx::read(&reader, size, &err);
+
+		const uint32_t offset = uint32_t(reader.seek() );
+		if (!err.isOk()
+		||  size > _size - offset)
+		{
+			DBG("Invalid shader variant pack.");
+			break;
+		}
+
+		if (ii == shaderIndex)
+		{
+			const uint8_t* shader = (const uint8_t*)_data + offset;
+			handle = bgfx::createShader(bgfx::copy(shader, size) );
+			break;
+		}
+
+		bx::skip(&reader, size);
+	}
+
+	if (!bgfx::isValid(handle) )
+	{
+		DBG("Shader variant 0x%08x not found.", mask);
+	}
+
+	return handle;
+}
+
+bgfx::ShaderHandle loadShaderVariant(const char* _name, const char* _keywords)
+{
+	char filePath[512];
+
+	bx::strCopy(filePath, BX_COUNTOF(filePath), getShaderPath() );
+	bx::strCat(filePath, BX_COUNTOF(filePath), _name);
+	bx::strCat(filePath, BX_COUNTOF(filePath), ".bin");
+
+	bgfx::ShaderHandle handle = BGFX_INVALID_HANDLE;
+
+	uint32_t size;
+	void* data = load(filePath, &size);
+	if (NULL != data)
+	{
+		handle = createShaderVariant(data, size, _keywords);
+		unload(data);
+
+		if (bgfx::isValid(handle) )
+		{
+			bgfx::setName(handle, _name);
+		}
+	}
+
+	return handle;
+}
+
+static bgfx::ProgramHandle createProgram(bgfx::ShaderHandle _vsh, bgfx::ShaderHandle _fsh, bool _hasFs)
+{
+	// Don't let missing fragment shader turn graphics program into compute program, and
+	// don't leak shader that was loaded when the other one is missing.
+	if (!bgfx::isValid(_vsh)
+	||  (_hasFs && !bgfx::isValid(_fsh) ) )
+	{
+		if (bgfx::isValid(_vsh) )
+		{
+			bgfx::destroy(_vsh);
+		}
+
+		if (bgfx::isValid(_fsh) )
+		{
+			bgfx::destroy(_fsh);
+		}
+
+		bgfx::ProgramHandle invalid = BGFX_INVALID_HANDLE;
+		return invalid;
+	}
+
+	return bgfx::createProgram(_vsh, _fsh, true /* destroy shaders when program is destroyed */);
+}
+
 bgfx::ProgramHandle loadProgram(bx::FileReaderI* _reader, const char* _vsName, const char* _fsName)
 {
 	bgfx::ShaderHandle vsh = loadShader(_reader, _vsName);
@@ -145,7 +351,7 @@ bgfx::ProgramHandle loadProgram(bx::FileReaderI* _reader, const char* _vsName, c
 		fsh = loadShader(_reader, _fsName);
 	}
 
-	return bgfx::createProgram(vsh, fsh, true /* destroy shaders when program is destroyed */);
+	return createProgram(vsh, fsh, NULL != _fsName);
 }
 
 bgfx::ProgramHandle loadProgram(const char* _vsName, const char* _fsName)
@@ -153,6 +359,172 @@ bgfx::ProgramHandle loadProgram(const char* _vsName, const char* _fsName)
 	return loadProgram(entry::getFileReader(), _vsName, _fsName);
 }
 
+#define BGFX_CHUNK_MAGIC_SAR BX_MAKEFOURCC('S', 'A', 'R', 0x1)
+
+struct ShaderArchive
+{
+	struct Entry
+	{
+		uint32_t m_hash;
+		uint32_t m_offset;
+		uint32_t m_size;
+	};
+
+	const uint8_t* m_data;
+	uint32_t m_size;
+	uint32_t m_numEntries;
+	const Entry* m_entries;
+	bool m_mapped;
+};
+
+ShaderArchive* shaderArchiveLoad(const char* _filePath)
+{
+	const uint8_t* data = NULL;
+	uint32_t size = 0;
+	bool mapped = false;
+
+#if BX_PLATFORM_POSIX
+	char filePath[512];
+	bx::strCopy(filePath, BX_COUNTOF(filePath), entry::getCurrentDir() );
+	bx::strCat(filePath, BX_COUNTOF(filePath), _filePath);
+
+	int fd = ::open(filePath, O_RDONLY);
+	if (-1 != fd)
+	{
+		struct stat st;
+		if (0 == ::fstat(fd, &st)
+		&&  0 < st.st_size)
+		{
+			void* ptr = ::mmap(NULL, size_t(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+			if (MAP_FAILED != ptr)
+			{
+				data = (const uint8_t*)ptr;
+				size = uint32_t(st.st_size);
+				mapped = true;
+			}
+		}
+
+		::close(fd);
+	}
+#endif // BX_PLATFORM_POSIX
+
+	if (!mapped)
+	{
+		data = (const uint8_t*)load(_filePath, &size);
+	}
+
+	if (NULL == data)
+	{
+		return NULL;
+	}
+
+	const uint32_t* header = (const uint32_t*)data;
+	if (sizeof(uint32_t)*2 > size
+	||  BGFX_CHUNK_MAGIC_SAR != header[0]
+	||  sizeof(uint32_t)*2 + uint64_t(sizeof(ShaderArchive::Entry) )*header[1] > size)
+	{
+		DBG("Invalid shader archive %s.", _filePath);
+
+#if BX_PLATFORM_POSIX
+		if (mapped)
+		{
+			::munmap(const_cast<uint8_t*>(data), size);
+		}
+		else
+#endif // BX_PLATFORM_POSIX
+		{
+			unload(const_cast<uint8_t*>(data) );
+		}
+
+		return NULL;
+	}
+
+	ShaderArchive* archive = new ShaderArchive;
+	archive->m_data       = data;
+	archive->m_size       = size;
+	archive->m_numEntries = header[1];
+	archive->m_entries    = (const ShaderArchive::Entry*)&header[2];
+	archive->m_mapped     = mapped;
+
+	return archive;
+}
+
+void shaderArchiveUnload(ShaderArchive* _archive)
+{
+	if (NULL == _archive)
+	{
+		return;
+	}
+
+#if BX_PLATFORM_POSIX
+	if (_archive->m_mapped)
+	{
+		::munmap(const_cast<uint8_t*>(_archive->m_data), _archive->m_size);
+	}
+	else
+#endif // BX_PLATFORM_POSIX
+	{
+		unload(const_cast<uint8_t*>(_archive->m_data) );
+	}
+
+	delete _archive;
+}
+
+bgfx::ShaderHandle loadShader(const ShaderArchive* _archive, const char* _name)
+{
+	char name[512];
+	bx::strCopy(name, BX_COUNTOF(name), getShaderPath() );
+	bx::strCat(name, BX_COUNTOF(name), _name);
+
+	const uint32_t hash = bx::hash<bx::HashMurmur2A>(name, uint32_t(bx::strLen(name) ) );
+
+	uint32_t first = 0;
+	uint32_t last  = _archive->m_numEntries;
+	while (first < last)
+	{
+		const uint32_t mid = first + (last - first)/2;
+		const ShaderArchive::Entry& entry = _archive->m_entries[mid];
+
+		if (entry.m_hash < hash)
+		{
+			first = mid + 1;
+		}
+		else if (entry.m_hash > hash)
+		{
+			last = mid;
+		}
+		else
+		{
+			if (entry.m_offset > _archive->m_size
+			||  entry.m_size   > _archive->m_size - entry.m_offset)
+			{
+				break;
+			}
+
+			bgfx::ShaderHandle handle = bgfx::createShader(bgfx::makeRef(&_archive->m_data[entry.m_offset], entry.m_size) );
+			bgfx::setName(handle, _name);
+			return handle;
+		}
+	}
+
+	DBG("Shader %s not found in archive.", name);
+
+	bgfx::ShaderHandle invalid = BGFX_INVALID_HANDLE;
+	return invalid;
+}
+
+bgfx::ProgramHandle loadProgram(const ShaderArchive* _archive, const char* _vsName, const char* _fsName)
+{
+	bgfx::ShaderHandle vsh = loadShader(_archive, _vsName);
+	bgfx::ShaderHandle fsh = BGFX_INVALID_HANDLE;
+	if (NULL != _fsName)
+	{
+		fsh = loadShader(_archive, _fsName);
+	}
+
+	return createProgram(vsh, fsh, NULL != _fsName);
+}
+
 static void imageReleaseCb(void* _ptr, void* _userData)
 {
 	BX_UNUSED(_ptr);
@@ -371,7 +743,14 @@ void Group::reset()
 	m_vertices = NULL;
 	m_numIndices = 0;
 	m_indices = NULL;
+	m_indices32 = NULL;
 	m_prims.clear();
+	m_meshlets.clear();
+	m_numMeshletVertices = 0;
+	m_meshletVertices = NULL;
+	m_numMeshletTriangles = 0;
+	m_meshletTriangles = NULL;
+	m_lods.clear();
 }
 
 namespace bgfx
@@ -379,6 +758,12 @@ namespace bgfx
 	int32_t read(bx::ReaderI* _reader, bgfx::VertexLayout& _layout, bx::Error* _err = NULL);
 }
 
+Mesh::Mesh()
+	: m_groupBounds(NULL)
+	, m_numGroupBounds(0)
+{
+}
+
 void Mesh::load(bx::ReaderSeekerI* _reader, bool _ramcopy)
 {
 #define BGFX_CHUNK_MAGIC_VB  BX_MAKEFOURCC('V', 'B', ' ', 0x1)
@@ -387,6 +772,13 @@ void Mesh::load(bx::ReaderSeekerI* _reader, bool _ramcopy)
 #define BGFX_CHUNK_MAGIC_IBC BX_MAKEFOURCC('I', 'B', 'C', 0x1)
 #define BGFX_CHUNK_MAGIC_PRI BX_MAKEFOURCC('P', 'R', 'I', 0x0)
 
+#define BGFX_CHUNK_MAGIC_VB32  BX_MAKEFOURCC('V', 'B', ' ', 0x2)
+#define BGFX_CHUNK_MAGIC_VBC32 BX_MAKEFOURCC('V', 'B', 'C', 0x1)
+#define BGFX_CHUNK_MAGIC_IB32  BX_MAKEFOURCC('I', 'B', ' ', 0x1)
+#define BGFX_CHUNK_MAGIC_IBC32 BX_MAKEFOURCC('I', 'B', 'C', 0x2)
+#define BGFX_CHUNK_MAGIC_MSH   BX_MAKEFOURCC('M', 'S', 'H', 0x0)
+#define BGFX_CHUNK_MAGIC_LOD   BX_MAKEFOURCC('L', 'O', 'D', 0x0)
+
 	using namespace bx;
 	using namespace bgfx;
 	
@@ -402,6 +794,7 @@ void Mesh::load(bx::ReaderSeekerI* _reader, bool _ramcopy)
 		switch (chunk)
 		{
 			case BGFX_CHUNK_MAGIC_VB:
+			case BGFX_CHUNK_MAGIC_VB32:
 			{
 				read(_reader, group.m_sphere);
 				read(_reader, group.m_aabb);
@@ -411,7 +804,17 @@ void Mesh::load(bx::ReaderSeekerI* _reader, bool _ramcopy)
 				
 				uint16_t stride = m_layout.getStride();
 				
-				read(_reader, group.m_numVertices);
+				if (BGFX_CHUNK_MAGIC_VB32 == chunk)
+				{
+					read(_reader, group.m_numVertices);
+				}
+				else
+				{
+					uint16_t numVertices;
+					read(_reader, numVertices);
+					group.m_numVertices = numVertices;
+				}
+
 				const bgfx::Memory* mem = bgfx::alloc(group.m_numVertices*stride);
 				read(_reader, mem->data, mem->size);
 				if ( _ramcopy )
@@ -424,6 +827,7 @@ void Mesh::load(bx::ReaderSeekerI* _reader, bool _ramcopy)
 				break;
 				
 			case BGFX_CHUNK_MAGIC_VBC:
+			case BGFX_CHUNK_MAGIC_VBC32:
 			{
 				read(_reader, group.m_sphere);
 				read(_reader, group.m_aabb);
@@ -433,7 +837,16 @@ void Mesh::load(bx::ReaderSeekerI* _reader, bool _ramcopy)
 				
 				uint16_t stride = m_layout.getStride();
 				
-				read(_reader, group.m_numVertices);
+				if (BGFX_CHUNK_MAGIC_VBC32 == chunk)
+				{
+					read(_reader, group.m_numVertices);
+				}
+				else
+				{
+					uint16_t numVertices;
+					read(_reader, numVertices);
+					group.m_numVertices = numVertices;
+				}
 				
 				const bgfx::Memory* mem = bgfx::alloc(group.m_numVertices*stride);
 				
@@ -471,7 +884,99 @@ void Mesh::load(bx::ReaderSeekerI* _reader, bool _ramcopy)
 				group.m_ibh = bgfx::createIndexBuffer(mem);
 			}
 				break;
+
+			case BGFX_CHUNK_MAGIC_IB32:
+			{
+				read(_reader, group.m_numIndices);
+				const bgfx::Memory* mem = bgfx::alloc(group.m_numIndices*4);
+				read(_reader, mem->data, mem->size);
+				if ( _ramcopy )
+				{
+					group.m_indices32 = (uint32_t*)BX_ALLOC(allocator, group.m_numIndices*4);
+					bx::memCopy(group.m_indices32, mem->data, mem->size);
+				}
+
+				group.m_ibh = bgfx::createIndexBuffer(mem, BGFX_BUFFER_INDEX32);
+			}
+				break;
+
+			case BGFX_CHUNK_MAGIC_IBC32:
+			{
+				bx::read(_reader, group.m_numIndices);
+
+				const bgfx::Memory* mem = bgfx::alloc(group.m_numIndices*4);
+
+				uint32_t compressedSize;
+				bx::read(_reader, compressedSize);
+
+				void* compressedIndices = BX_ALLOC(allocator, compressedSize);
+
+				bx::read(_reader, compressedIndices, compressedSize);
+
+				meshopt_decodeIndexBuffer(mem->data, group.m_numIndices, 4, (uint8_t*)compressedIndices, compressedSize);
+
+				BX_FREE(allocator, compressedIndices);
+
+				if ( _ramcopy )
+				{
+					group.m_indices32 = (uint32_t*)BX_ALLOC(allocator, group.m_numIndices*4);
+					bx::memCopy(group.m_indices32, mem->data, mem->size);
+				}
+
+				group.m_ibh = bgfx::createIndexBuffer(mem, BGFX_BUFFER_INDEX32);
+			}
+				break;
+
+			case BGFX_CHUNK_MAGIC_MSH:
+			{
+				uint32_t numMeshlets;
+				read(_reader, numMeshlets);
+
+				group.m_meshlets.resize(numMeshlets);
+				for (uint32_t ii = 0; ii < numMeshlets; ++ii)
+				{
+					Meshlet& meshlet = group.m_meshlets[ii];
+					read(_reader, meshlet.m_vertexOffset);
+					read(_reader, meshlet.m_triangleOffset);
+					read(_reader, meshlet.m_numVertices);
+					read(_reader, meshlet.m_numTriangles);
+					read(_reader, meshlet.m_sphere);
+					read(_reader, meshlet.m_coneApex);
+					read(_reader, meshlet.m_coneAxis);
+					read(_reader, meshlet.m_coneCutoff);
+				}
+
+				read(_reader, group.m_numMeshletVertices);
+				group.m_meshletVertices = (uint32_t*)BX_ALLOC(allocator, group.m_numMeshletVertices*sizeof(uint32_t) );
+				read(_reader, group.m_meshletVertices, group.m_numMeshletVertices*sizeof(uint32_t) );
+
+				read(_reader, group.m_numMeshletTriangles);
+				group.m_meshletTriangles = (uint32_t*)BX_ALLOC(allocator, group.m_numMeshletTriangles*sizeof(uint32_t) );
+				read(_reader, group.m_meshletTriangles, group.m_numMeshletTriangles*sizeof(uint32_t) );
+			}
+				break;
 				
+			case BGFX_CHUNK_MAGIC_LOD:
+			{
+				uint32_t size;
+				read(_reader, size);
+
+				GroupLod lod;
+				lod.m_vbh.idx = bgfx::kInvalidHandle;
+				lod.m_ibh.idx = bgfx::kInvalidHandle;
+				lod.m_offset  = bx::seek(_reader);
+
+				uint8_t indexSize;
+				read(_reader, lod.m_lod);
+				read(_reader, indexSize);
+				read(_reader, lod.m_error);
+
+				group.m_lods.push_back(lod);
+
+				bx::seek(_reader, lod.m_offset + size, bx::Whence::Begin);
+			}
+				break;
+
 			case BGFX_CHUNK_MAGIC_IBC:
 			{
 				bx::read(_reader, group.m_numIndices);
@@ -541,6 +1046,151 @@ void Mesh::load(bx::ReaderSeekerI* _reader, bool _ramcopy)
 				break;
 		}
 	}
+
+	const uint32_t numGroups = uint32_t(m_groups.size() );
+	const uint32_t numSimd   = (numGroups+3)/4;
+
+	if (NULL != m_groupBounds)
+	{
+		BX_ALIGNED_FREE(allocator, m_groupBounds, 16);
+		m_groupBounds = NULL;
+	}
+
+	m_numGroupBounds = numSimd;
+	if (0 < numSimd)
+	{
+		m_groupBounds = (GroupBoundsSoa*)BX_ALIGNED_ALLOC(allocator, numSimd*sizeof(GroupBoundsSoa), 16);
+	}
+
+	m_visible.resize(numGroups);
+
+	for (uint32_t ii = 0; ii < numSimd; ++ii)
+	{
+		BX_ALIGN_DECL_16(float center[3][4])  = {};
+		BX_ALIGN_DECL_16(float extents[3][4]) = {};
+
+		for (uint32_t lane = 0; lane < 4; ++lane)
+		{
+			const uint32_t group = ii*4 + lane;
+			if (group >= numGroups)
+			{
+				// Padding lanes get negative extent so they are always classified as outside.
+				extents[0][lane] = -1.0f;
+				continue;
+			}
+
+			const Aabb& aabb = m_groups[group].m_aabb;
+			center[0][lane]  = (aabb.min.x + aabb.max.x) * 0.5f;
+			center[1][lane]  = (aabb.min.y + aabb.max.y) * 0.5f;
+			center[2][lane]  = (aabb.min.z + aabb.max.z) * 0.5f;
+			extents[0][lane] = (aabb.max.x - aabb.min.x) * 0.5f;
+			extents[1][lane] = (aabb.max.y - aabb.min.y) * 0.5f;
+			extents[2][lane] = (aabb.max.z - aabb.min.z) * 0.5f;
+		}
+
+		GroupBoundsSoa& bounds = m_groupBounds[ii];
+		for (uint32_t axis = 0; axis < 3; ++axis)
+		{
+			bounds.m_center[axis]  = bx::simd_ld<bx::simd128_t>(center[axis]);
+			bounds.m_extents[axis] = bx::simd_ld<bx::simd128_t>(extents[axis]);
+		}
+	}
+}
+
+void Mesh::loadLod(bx::ReaderSeekerI* _reader, uint8_t _lod)
+{
+	const uint16_t stride = m_layout.getStride();
+
+	for (GroupArray::iterator it = m_groups.begin(), itEnd = m_groups.end(); it != itEnd; ++it)
+	{
+		for (GroupLodArray::iterator lt = it->m_lods.begin(), ltEnd = it->m_lods.end(); lt != ltEnd; ++lt)
+		{
+			GroupLod& lod = *lt;
+
+			if (_lod != lod.m_lod
+			||  bgfx::isValid(lod.m_vbh) )
+			{
+				continue;
+			}
+
+			bx::seek(_reader, lod.m_offset, bx::Whence::Begin);
+
+			uint8_t level;
+			uint8_t indexSize;
+			float error;
+			bx::read(_reader, level);
+			bx::read(_reader, indexSize);
+			bx::read(_reader, error);
+
+			uint32_t numVertices;
+			bx::read(_reader, numVertices);
+			const bgfx::Memory* mem = bgfx::alloc(numVertices*stride);
+			bx::read(_reader, mem->data, mem->size);
+			lod.m_vbh = bgfx::createVertexBuffer(mem, m_layout);
+
+			uint32_t numIndices;
+			bx::read(_reader, numIndices);
+			mem = bgfx::alloc(numIndices*indexSize);
+			bx::read(_reader, mem->data, mem->size);
+			lod.m_ibh = bgfx::createIndexBuffer(mem, 4 == indexSize ? BGFX_BUFFER_INDEX32 : BGFX_BUFFER_NONE);
+		}
+	}
+}
+
+void Mesh::unloadLod(uint8_t _lod)
+{
+	for (GroupArray::iterator it = m_groups.begin(), itEnd = m_groups.end(); it != itEnd; ++it)
+	{
+		for (GroupLodArray::iterator lt = it->m_lods.begin(), ltEnd = it->m_lods.end(); lt != ltEnd; ++lt)
+		{
+			GroupLod& lod = *lt;
+
+			if (_lod == lod.m_lod
+			&&  bgfx::isValid(lod.m_vbh) )
+			{
+				bgfx::destroy(lod.m_vbh);
+				bgfx::destroy(lod.m_ibh);
+				lod.m_vbh.idx = bgfx::kInvalidHandle;
+				lod.m_ibh.idx = bgfx::kInvalidHandle;
+			}
+		}
+	}
+}
+
+uint8_t Mesh::calcLod(float _distance, float _projScale, float _pixelError) const
+{
+	uint8_t numLods = 0;
+	for (GroupArray::const_iterator it = m_groups.begin(), itEnd = m_groups.end(); it != itEnd; ++it)
+	{
+		numLods = bx::max<uint8_t>(numLods, uint8_t(it->m_lods.size() ) );
+	}
+
+	const float scale = _projScale / bx::max(_distance, 0.0001f);
+
+	uint8_t result = 0;
+	for (uint8_t lod = 1; lod <= numLods; ++lod)
+	{
+		float error = 0.0f;
+		for (GroupArray::const_iterator it = m_groups.begin(), itEnd = m_groups.end(); it != itEnd; ++it)
+		{
+			for (GroupLodArray::const_iterator lt = it->m_lods.begin(), ltEnd = it->m_lods.end(); lt != ltEnd; ++lt)
+			{
+				if (lod == lt->m_lod)
+				{
+					error = bx::max(error, lt->m_error);
+				}
+			}
+		}
+
+		if (error*scale > _pixelError)
+		{
+			break;
+		}
+
+		result = lod;
+	}
+
+	return result;
 }
 
 void Mesh::unload()
@@ -551,6 +1201,15 @@ void Mesh::unload()
 	{
 		const Group& group = *it;
 		bgfx::destroy(group.m_vbh);
+
+		for (GroupLodArray::const_iterator lt = group.m_lods.begin(), ltEnd = group.m_lods.end(); lt != ltEnd; ++lt)
+		{
+			if (bgfx::isValid(lt->m_vbh) )
+			{
+				bgfx::destroy(lt->m_vbh);
+				bgfx::destroy(lt->m_ibh);
+			}
+		}
 		
 		if (bgfx::isValid(group.m_ibh) )
 		{
@@ -566,33 +1225,196 @@ void Mesh::unload()
 		{
 			BX_FREE(allocator, group.m_indices);
 		}
+
+		if ( NULL != group.m_indices32 )
+		{
+			BX_FREE(allocator, group.m_indices32);
+		}
+
+		if ( NULL != group.m_meshletVertices )
+		{
+			BX_FREE(allocator, group.m_meshletVertices);
+		}
+
+		if ( NULL != group.m_meshletTriangles )
+		{
+			BX_FREE(allocator, group.m_meshletTriangles);
+		}
 	}
 	m_groups.clear();
+
+	if (NULL != m_groupBounds)
+	{
+		BX_ALIGNED_FREE(allocator, m_groupBounds, 16);
+		m_groupBounds = NULL;
+	}
+
+	m_numGroupBounds = 0;
+
+	m_visible.clear();
 }
 
-void Mesh::submit(bgfx::ViewId _id, bgfx::ProgramHandle _program, const float* _mtx, uint64_t _state) const
+static uint64_t meshState(uint64_t _state)
 {
 	if (BGFX_STATE_MASK == _state)
 	{
-		_state = 0
-		| BGFX_STATE_WRITE_RGB
-		| BGFX_STATE_WRITE_A
-		| BGFX_STATE_WRITE_Z
-		| BGFX_STATE_DEPTH_TEST_LESS
-		| BGFX_STATE_CULL_CCW
-		| BGFX_STATE_MSAA
+		return 0
+			| BGFX_STATE_WRITE_RGB
+			| BGFX_STATE_WRITE_A
+			| BGFX_STATE_WRITE_Z
+			| BGFX_STATE_DEPTH_TEST_LESS
+			| BGFX_STATE_CULL_CCW
+			| BGFX_STATE_MSAA
+			;
+	}
+
+	return _state;
+}
+
+void Mesh::submit(bgfx::ViewId _id, bgfx::ProgramHandle _program, const float* _mtx, uint64_t _state) const
+{
+	submitLod(_id, _program, _mtx, _state, 0);
+}
+
+uint32_t Mesh::cull(uint8_t* _outVisible, const float* _mtx, const float* _viewProj) const
+{
+	float mvp[16];
+	bx::mtxMul(mvp, _mtx, _viewProj);
+
+	bx::Plane planes[6];
+	buildFrustumPlanes(planes, mvp);
+
+	PlaneSimd planesSimd[6];
+	toSimd(planesSimd, planes, 6);
+
+	const bx::simd128_t zero = bx::simd_zero<bx::simd128_t>();
+
+	const uint32_t numGroups = uint32_t(m_groups.size() );
+
+	uint32_t numVisible = 0;
+
+	for (uint32_t ii = 0; ii < m_numGroupBounds; ++ii)
+	{
+		const GroupBoundsSoa& bounds = m_groupBounds[ii];
+
+		// Padding lanes have negative extent.
+		const bx::simd128_t outside = bx::simd_or(
+			  bx::simd_cmplt(bounds.m_extents[0], zero)
+			, outsideMask(bounds.m_center, bounds.m_extents, planesSimd, 6)
+			);
+
+		const uint32_t mask = uint32_t(bx::simd_movemask(outside) );
+
+		for (uint32_t lane = 0, group = ii*4; lane < 4 && group < numGroups; ++lane, ++group)
+		{
+			const uint8_t visible = 0 == (mask & (1<<lane) );
+			_outVisible[group] = visible;
+			numVisible += visible;
+		}
+	}
+
+	return numVisible;
+}
+
+uint32_t Mesh::submitCulled(bgfx::ViewId _id, bgfx::ProgramHandle _program, const float* _mtx, const float* _viewProj, uint64_t _state, MeshOcclusion* _occlusion) const
+{
+	_state = meshState(_state);
+
+	const uint32_t numGroups = uint32_t(m_groups.size() );
+	if (0 == numGroups)
+	{
+		return 0;
+	}
+
+	// Scratch is sized by load, resize is no-op unless groups were added afterwards.
+	m_visible.resize(numGroups);
+	uint8_t* visible = &m_visible[0];
+	if (0 == cull(visible, _mtx, _viewProj) )
+	{
+		return 0;
+	}
+
+	if (NULL != _occlusion)
+	{
+		_occlusion->m_numOccluded = 0;
+	}
+
+	// Occluded groups are re-tested against depth buffer without writing anything.
+	const uint64_t queryState = 0
+		| BGFX_STATE_DEPTH_TEST_LEQUAL
+		| (_state & BGFX_STATE_CULL_MASK)
 		;
+
+	const uint32_t cached = bgfx::setTransform(_mtx);
+
+	uint32_t numSubmitted = 0;
+
+	for (uint32_t ii = 0; ii < numGroups; ++ii)
+	{
+		if (!visible[ii])
+		{
+			continue;
+		}
+
+		const Group& group = m_groups[ii];
+
+		bgfx::setTransform(cached);
+		bgfx::setIndexBuffer(group.m_ibh);
+		bgfx::setVertexBuffer(0, group.m_vbh);
+
+		if (NULL != _occlusion
+		&&  bgfx::isValid(_occlusion->m_queries[ii]) )
+		{
+			const bgfx::OcclusionQueryHandle query = _occlusion->m_queries[ii];
+
+			if (bgfx::OcclusionQueryResult::Invisible == bgfx::getResult(query) )
+			{
+				bgfx::setState(queryState);
+				bgfx::submit(_id, _program, query);
+				++_occlusion->m_numOccluded;
+				continue;
+			}
+
+			bgfx::setState(_state);
+			bgfx::submit(_id, _program, query);
+		}
+		else
+		{
+			bgfx::setState(_state);
+			bgfx::submit(_id, _program);
+		}
+
+		++numSubmitted;
 	}
-	
+
+	return numSubmitted;
+}
+
+void Mesh::submitLod(bgfx::ViewId _id, bgfx::ProgramHandle _program, const float* _mtx, uint64_t _state, uint8_t _lod) const
+{
 	bgfx::setTransform(_mtx);
-	bgfx::setState(_state);
-	
+	bgfx::setState(meshState(_state) );
+
 	for (GroupArray::const_iterator it = m_groups.begin(), itEnd = m_groups.end(); it != itEnd; ++it)
 	{
 		const Group& group = *it;
-		
-		bgfx::setIndexBuffer(group.m_ibh);
-		bgfx::setVertexBuffer(0, group.m_vbh);
+
+		bgfx::VertexBufferHandle vbh = group.m_vbh;
+		bgfx::IndexBufferHandle  ibh = group.m_ibh;
+
+		for (GroupLodArray::const_iterator lt = group.m_lods.begin(), ltEnd = group.m_lods.end(); lt != ltEnd; ++lt)
+		{
+			if (_lod == lt->m_lod
+			&&  bgfx::isValid(lt->m_vbh) )
+			{
+				vbh = lt->m_vbh;
+				ibh = lt->m_ibh;
+				break;
+			}
+		}
+
+		bgfx::setIndexBuffer(ibh);
+		bgfx::setVertexBuffer(0, vbh);
 		bgfx::submit(_id, _program, 0, it != itEnd-1);
 	}
 }
@@ -655,6 +1477,24 @@ void meshUnload(Mesh* _mesh)
 	delete _mesh;
 }
 
+bool meshLoadLod(Mesh* _mesh, const char* _filePath, uint8_t _lod)
+{
+	bx::FileReaderI* reader = entry::getFileReader();
+	if (bx::open(reader, _filePath) )
+	{
+		_mesh->loadLod(reader, _lod);
+		bx::close(reader);
+		return true;
+	}
+
+	return false;
+}
+
+void meshUnloadLod(Mesh* _mesh, uint8_t _lod)
+{
+	_mesh->unloadLod(_lod);
+}
+
 MeshState* meshStateCreate()
 {
 	MeshState* state = (MeshState*)BX_ALLOC(entry::getAllocator(), sizeof(MeshState) );
@@ -676,6 +1516,53 @@ void meshSubmit(const Mesh* _mesh, const MeshState*const* _state, uint8_t _numPa
 	_mesh->submit(_state, _numPasses, _mtx, _numMatrices);
 }
 
+void meshSubmitLod(const Mesh* _mesh, bgfx::ViewId _id, bgfx::ProgramHandle _program, const float* _mtx, uint8_t _lod, uint64_t _state)
+{
+	_mesh->submitLod(_id, _program, _mtx, _state, _lod);
+}
+
+uint32_t meshSubmitCulled(const Mesh* _mesh, bgfx::ViewId _id, bgfx::ProgramHandle _program, const float* _mtx, const float* _viewProj, uint64_t _state, MeshOcclusion* _occlusion)
+{
+	return _mesh->submitCulled(_id, _program, _mtx, _viewProj, _state, _occlusion);
+}
+
+MeshOcclusion* meshOcclusionCreate(const Mesh* _mesh)
+{
+	MeshOcclusion* occlusion = new MeshOcclusion;
+	occlusion->m_numOccluded = 0;
+
+	const bool supported = 0 != (bgfx::getCaps()->supported & BGFX_CAPS_OCCLUSION_QUERY);
+
+	const uint32_t numGroups = uint32_t(_mesh->m_groups.size() );
+	occlusion->m_queries.resize(numGroups);
+
+	for (uint32_t ii = 0; ii < numGroups; ++ii)
+	{
+		bgfx::OcclusionQueryHandle query = BGFX_INVALID_HANDLE;
+		if (supported)
+		{
+			query = bgfx::createOcclusionQuery();
+		}
+
+		occlusion->m_queries[ii] = query;
+	}
+
+	return occlusion;
+}
+
+void meshOcclusionDestroy(MeshOcclusion* _occlusion)
+{
+	for (uint32_t ii = 0, num = uint32_t(_occlusion->m_queries.size() ); ii < num; ++ii)
+	{
+		if (bgfx::isValid(_occlusion->m_queries[ii]) )
+		{
+			bgfx::destroy(_occlusion->m_queries[ii]);
+		}
+	}
+
+	delete _occlusion;
+}
+
 Args::Args(int _argc, const char* const* _argv)
 	: m_type(bgfx::RendererType::Count)
 	, m_pciId(BGFX_PCI_ID_NONE)
@@ -7,6 +7,7 @@
 #define BGFX_UTILS_H_HEADER_GUARD
 
 #include <bx/pixelformat.h>
+#include <bx/simd_t.h>
 #include <bgfx/bgfx.h>
 #include <bimg/bimg.h>
 #include "bounds.h"
@@ -28,6 +29,40 @@ bgfx::ShaderHandle loadShader(const char* _name);
 ///
 bgfx::ProgramHandle loadProgram(const char* _vsName, const char* _fsName);
 
+/// Creates shader from shader variant pack produced by `shaderc --variants`.
+///
+/// @param[in] _data Shader variant pack data.
+/// @param[in] _size Shader variant pack size.
+/// @param[in] _keywords Enabled keywords (semicolon separated).
+///
+/// @returns Invalid handle if pack is malformed, or if any of keywords is not in the pack.
+///
+bgfx::ShaderHandle createShaderVariant(const void* _data, uint32_t _size, const char* _keywords);
+
+///
+bgfx::ShaderHandle loadShaderVariant(const char* _name, const char* _keywords);
+
+///
+struct ShaderArchive;
+
+/// Maps shader archive produced by `shaderc --archive`. Shaders are created by reference
+/// to archive memory, archive must stay loaded until two frames after last shader
+/// is created from it.
+///
+/// @returns NULL if file is missing or it's not valid shader archive.
+///
+ShaderArchive* shaderArchiveLoad(const char* _filePath);
+
+///
+void shaderArchiveUnload(ShaderArchive* _archive);
+
+/// Creates shader for current renderer from shader archive.
+///
+bgfx::ShaderHandle loadShader(const ShaderArchive* _archive, const char* _name);
+
+///
+bgfx::ProgramHandle loadProgram(const ShaderArchive* _archive, const char* _vsName, const char* _fsName);
+
 ///
 bgfx::TextureHandle loadTexture(const char* _name, uint64_t _flags = BGFX_TEXTURE_NONE|BGFX_SAMPLER_NONE, uint8_t _skip = 0, bgfx::TextureInfo* _info = NULL, bimg::Orientation::Enum* _orientation = NULL);
 
@@ -98,6 +133,34 @@ struct Primitive
 
 typedef stl::vector<Primitive> PrimitiveArray;
 
+///
+struct Meshlet
+{
+	uint32_t m_vertexOffset;
+	uint32_t m_triangleOffset;
+	uint32_t m_numVertices;
+	uint32_t m_numTriangles;
+
+	Sphere   m_sphere;
+	bx::Vec3 m_coneApex;
+	bx::Vec3 m_coneAxis;
+	float    m_coneCutoff;
+};
+
+typedef stl::vector<Meshlet> MeshletArray;
+
+/// Simplified group LOD, streamed in separately from base group data.
+struct GroupLod
+{
+	bgfx::VertexBufferHandle m_vbh;
+	bgfx::IndexBufferHandle m_ibh;
+	int64_t m_offset;
+	float m_error;
+	uint8_t m_lod;
+};
+
+typedef stl::vector<GroupLod> GroupLodArray;
+
 struct Group
 {
 	Group();
@@ -105,26 +168,92 @@ struct Group
 	
 	bgfx::VertexBufferHandle m_vbh;
 	bgfx::IndexBufferHandle m_ibh;
-	uint16_t m_numVertices;
+	uint32_t m_numVertices;
 	uint8_t* m_vertices;
 	uint32_t m_numIndices;
 	uint16_t* m_indices;
+	uint32_t* m_indices32;
 	Sphere m_sphere;
 	Aabb m_aabb;
 	Obb m_obb;
 	PrimitiveArray m_prims;
+
+	MeshletArray m_meshlets;
+	uint32_t m_numMeshletVertices;
+	uint32_t* m_meshletVertices;
+	uint32_t m_numMeshletTriangles;
+	uint32_t* m_meshletTriangles;
+
+	GroupLodArray m_lods;
 };
 typedef stl::vector<Group> GroupArray;
 
+/// AABBs of four groups as centers and extents, packed as structure of arrays.
+struct GroupBoundsSoa
+{
+	bx::simd128_t m_center[3];
+	bx::simd128_t m_extents[3];
+};
+
+/// Per group occlusion query cache used by culled mesh submit.
+struct MeshOcclusion
+{
+	stl::vector<bgfx::OcclusionQueryHandle> m_queries;
+	uint32_t m_numOccluded;
+};
+
 struct Mesh
 {
+	Mesh();
+
 	void load(bx::ReaderSeekerI* _reader, bool _ramcopy);
 	void unload();
 	void submit(bgfx::ViewId _id, bgfx::ProgramHandle _program, const float* _mtx, uint64_t _state) const;
 	void submit(const MeshState*const* _state, uint8_t _numPasses, const float* _mtx, uint16_t _numMatrices) const;
 
+	/// Loads simplified LOD level of all groups. Mesh must be loaded first, LOD chunk
+	/// locations are recorded by `load`, but LOD data is not read until requested.
+	void loadLod(bx::ReaderSeekerI* _reader, uint8_t _lod);
+	void unloadLod(uint8_t _lod);
+
+	/// Returns highest LOD level whose error, projected to screen, is below `_pixelError`.
+	///
+	/// @param[in] _distance Distance from camera to mesh.
+	/// @param[in] _projScale Screen height divided by `2*tan(fovy/2)`.
+	/// @param[in] _pixelError Maximum allowed error in pixels.
+	///
+	uint8_t calcLod(float _distance, float _projScale, float _pixelError) const;
+
+	/// Submits LOD level, groups that don't have requested level loaded fall back to
+	/// base level. Level 0 is base level.
+	void submitLod(bgfx::ViewId _id, bgfx::ProgramHandle _program, const float* _mtx, uint64_t _state, uint8_t _lod) const;
+
+	/// Submits only groups whose bounds intersect view frustum. Culled groups are never
+	/// submitted.
+	///
+	/// @param[in] _viewProj View-projection matrix.
+	/// @param[in] _occlusion Optional occlusion query cache. Groups occluded in previous
+	///   frame are only re-tested with depth test, without writing color or depth.
+	///
+	/// @returns Number of groups submitted for drawing.
+	///
+	/// @remarks Uses per mesh visibility scratch buffer, the same mesh must not be submitted
+	///   culled from multiple threads at the same time.
+	///
+	uint32_t submitCulled(bgfx::ViewId _id, bgfx::ProgramHandle _program, const float* _mtx, const float* _viewProj, uint64_t _state, MeshOcclusion* _occlusion = NULL) const;
+
+	/// Writes visibility of each group into `_outVisible`, returns number of visible groups.
+	uint32_t cull(uint8_t* _outVisible, const float* _mtx, const float* _viewProj) const;
+
 	bgfx::VertexLayout m_layout;
 	GroupArray m_groups;
+
+	/// Group bounds, one entry per four groups, 16-byte aligned.
+	GroupBoundsSoa* m_groupBounds;
+	uint32_t m_numGroupBounds;
+
+	/// Group visibility scratch used by submitCulled, sized by load.
+	mutable stl::vector<uint8_t> m_visible;
 };
 
 ///
@@ -133,6 +262,12 @@ Mesh* meshLoad(const char* _filePath, bool _ramcopy = false);
 ///
 void meshUnload(Mesh* _mesh);
 
+///
+bool meshLoadLod(Mesh* _mesh, const char* _filePath, uint8_t _lod);
+
+///
+void meshUnloadLod(Mesh* _mesh, uint8_t _lod);
+
 ///
 MeshState* meshStateCreate();
 
@@ -145,6 +280,18 @@ void meshSubmit(const Mesh* _mesh, bgfx::ViewId _id, bgfx::ProgramHandle _progra
 ///
 void meshSubmit(const Mesh* _mesh, const MeshState*const* _state, uint8_t _numPasses, const float* _mtx, uint16_t _numMatrices = 1);
 
+///
+void meshSubmitLod(const Mesh* _mesh, bgfx::ViewId _id, bgfx::ProgramHandle _program, const float* _mtx, uint8_t _lod, uint64_t _state = BGFX_STATE_MASK);
+
+///
+uint32_t meshSubmitCulled(const Mesh* _mesh, bgfx::ViewId _id, bgfx::ProgramHandle _program, const float* _mtx, const float* _viewProj, uint64_t _state = BGFX_STATE_MASK, MeshOcclusion* _occlusion = NULL);
+
+///
+MeshOcclusion* meshOcclusionCreate(const Mesh* _mesh);
+
+///
+void meshOcclusionDestroy(MeshOcclusion* _occlusion);
+
 ///
 struct Args
 {
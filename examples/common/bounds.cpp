@@ -5,6 +5,7 @@
 
 #include <bx/rng.h>
 #include <bx/math.h>
+#include <bx/simd_t.h>
 #include "bounds.h"
 
 using namespace bx;
@@ -1231,6 +1232,267 @@ Vec3 closestPoint(const Triangle& _triangle, const Vec3& _point)
 	return cartesian(_triangle, clamp<Vec3>(uvw, Vec3(0.0f), Vec3(1.0f) ) );
 }
 
+struct Aabb4
+{
+	simd128_t min[3];
+	simd128_t max[3];
+};
+
+static void load(Aabb4& _outAabb, const Aabb* _aabb, uint32_t _num)
+{
+	// Transpose up to 4 AABBs into SoA layout. Unused lanes are zeroed, and results for them
+	// are never written out.
+	BX_ALIGN_DECL_16(float tmp[6][4]) = {};
+
+	for (uint32_t ii = 0, num = min(_num, 4u); ii < num; ++ii)
+	{
+		const Aabb& aabb = _aabb[ii];
+		tmp[0][ii] = aabb.min.x;
+		tmp[1][ii] = aabb.min.y;
+		tmp[2][ii] = aabb.min.z;
+		tmp[3][ii] = aabb.max.x;
+		tmp[4][ii] = aabb.max.y;
+		tmp[5][ii] = aabb.max.z;
+	}
+
+	for (uint32_t ii = 0; ii < 3; ++ii)
+	{
+		_outAabb.min[ii] = simd_ld<simd128_t>(tmp[ii  ]);
+		_outAabb.max[ii] = simd_ld<simd128_t>(tmp[ii+3]);
+	}
+}
+
+static uint32_t store(uint8_t* _outMask, simd128_t _mask, uint32_t _num)
+{
+	const uint32_t bits = uint32_t(simd_movemask(_mask) );
+
+	uint32_t count = 0;
+	for (uint32_t ii = 0, num = min(_num, 4u); ii < num; ++ii)
+	{
+		const uint8_t hit = uint8_t( (bits >> ii) & 1);
+		_outMask[ii] = hit;
+		count += hit;
+	}
+
+	return count;
+}
+
+uint32_t intersectBatch(uint8_t* _outMask, float* _outDist, const Ray& _ray, const Aabb* _aabb, uint32_t _num)
+{
+	const Vec3 invDir = rcp(_ray.dir);
+
+	const simd128_t pos[3] =
+	{
+		simd_splat(_ray.pos.x),
+		simd_splat(_ray.pos.y),
+		simd_splat(_ray.pos.z),
+	};
+
+	const simd128_t inv[3] =
+	{
+		simd_splat(invDir.x),
+		simd_splat(invDir.y),
+		simd_splat(invDir.z),
+	};
+
+	const simd128_t zero = simd_zero<simd128_t>();
+
+	uint32_t count = 0;
+
+	for (uint32_t ii = 0; ii < _num; ii += 4)
+	{
+		Aabb4 aabb;
+		load(aabb, &_aabb[ii], _num-ii);
+
+		simd128_t tmin = simd_splat(-kFloatMax);
+		simd128_t tmax = simd_splat( kFloatMax);
+
+		for (uint32_t axis = 0; axis < 3; ++axis)
+		{
+			const simd128_t t0 = simd_mul(simd_sub(aabb.min[axis], pos[axis]), inv[axis]);
+			const simd128_t t1 = simd_mul(simd_sub(aabb.max[axis], pos[axis]), inv[axis]);
+			tmin = simd_max(tmin, simd_min(t0, t1) );
+			tmax = simd_min(tmax, simd_max(t0, t1) );
+		}
+
+		const simd128_t hit = simd_and(simd_cmpge(tmax, zero), simd_cmple(tmin, tmax) );
+		count += store(&_outMask[ii], hit, _num-ii);
+
+		if (NULL != _outDist)
+		{
+			BX_ALIGN_DECL_16(float dist[4]);
+			simd_st(dist, tmin);
+
+			for (uint32_t jj = 0, num = min(_num-ii, 4u); jj < num; ++jj)
+			{
+				_outDist[ii+jj] = dist[jj];
+			}
+		}
+	}
+
+	return count;
+}
+
+bool overlap(const Aabb& _aabb, const Plane* _planes, uint32_t _numPlanes)
+{
+	const Vec3 center  = getCenter(_aabb);
+	const Vec3 extents = getExtents(_aabb);
+
+	for (uint32_t ii = 0; ii < _numPlanes; ++ii)
+	{
+		const Plane& plane = _planes[ii];
+
+		if (distance(plane, center) + dot(extents, abs(plane.normal) ) < 0.0f)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void toSimd(PlaneSimd* _outPlanes, const Plane* _planes, uint32_t _numPlanes)
+{
+	for (uint32_t ii = 0; ii < _numPlanes; ++ii)
+	{
+		const Plane& plane = _planes[ii];
+		PlaneSimd& dst = _outPlanes[ii];
+
+		dst.normal[0]    = simd_splat(plane.normal.x);
+		dst.normal[1]    = simd_splat(plane.normal.y);
+		dst.normal[2]    = simd_splat(plane.normal.z);
+		dst.absNormal[0] = simd_splat(bx::abs(plane.normal.x) );
+		dst.absNormal[1] = simd_splat(bx::abs(plane.normal.y) );
+		dst.absNormal[2] = simd_splat(bx::abs(plane.normal.z) );
+		dst.dist         = simd_splat(plane.dist);
+	}
+}
+
+simd128_t outsideMask(const simd128_t* _center, const simd128_t* _extents, const PlaneSimd* _planes, uint32_t _numPlanes)
+{
+	const simd128_t zero = simd_zero<simd128_t>();
+
+	simd128_t outside = zero;
+
+	for (uint32_t ii = 0; ii < _numPlanes; ++ii)
+	{
+		const PlaneSimd& plane = _planes[ii];
+
+		// AABB is outside when it's completely behind any of planes.
+		const simd128_t dist = simd_madd(_center[0], plane.normal[0]
+			, simd_madd(_center[1], plane.normal[1]
+			, simd_madd(_center[2], plane.normal[2]
+			, plane.dist) ) );
+
+		const simd128_t radius = simd_madd(_extents[0], plane.absNormal[0]
+			, simd_madd(_extents[1], plane.absNormal[1]
+			, simd_mul(_extents[2], plane.absNormal[2]) ) );
+
+		outside = simd_or(outside, simd_cmplt(simd_add(dist, radius), zero) );
+	}
+
+	return outside;
+}
+
+uint32_t overlapBatch(uint8_t* _outMask, const Aabb* _aabb, uint32_t _num, const Plane* _planes, uint32_t _numPlanes)
+{
+	BX_CHECK(32 >= _numPlanes, "Too many planes %d (max 32).", _numPlanes);
+	const uint32_t numPlanes = min(_numPlanes, 32u);
+
+	PlaneSimd planes[32];
+	toSimd(planes, _planes, numPlanes);
+
+	const simd128_t half = simd_splat(0.5f);
+	const simd128_t ones = simd_isplat<simd128_t>(UINT32_MAX);
+
+	uint32_t count = 0;
+
+	for (uint32_t ii = 0; ii < _num; ii += 4)
+	{
+		Aabb4 aabb;
+		load(aabb, &_aabb[ii], _num-ii);
+
+		simd128_t center[3];
+		simd128_t extents[3];
+		for (uint32_t axis = 0; axis < 3; ++axis)
+		{
+			center[axis]  = simd_mul(simd_add(aabb.max[axis], aabb.min[axis]), half);
+			extents[axis] = simd_mul(simd_sub(aabb.max[axis], aabb.min[axis]), half);
+		}
+
+		const simd128_t inside = simd_xor(outsideMask(center, extents, planes, numPlanes), ones);
+		count += store(&_outMask[ii], inside, _num-ii);
+	}
+
+	return count;
+}
+
+uint32_t overlapBatch(uint8_t* _outMask, const Aabb* _aabb, uint32_t _num, const Aabb& _aabbB)
+{
+	const simd128_t bmin[3] =
+	{
+		simd_splat(_aabbB.min.x),
+		simd_splat(_aabbB.min.y),
+		simd_splat(_aabbB.min.z),
+	};
+
+	const simd128_t bmax[3] =
+	{
+		simd_splat(_aabbB.max.x),
+		simd_splat(_aabbB.max.y),
+		simd_splat(_aabbB.max.z),
+	};
+
+	uint32_t count = 0;
+
+	for (uint32_t ii = 0; ii < _num; ii += 4)
+	{
+		Aabb4 aabb;
+		load(aabb, &_aabb[ii], _num-ii);
+
+		simd128_t result = simd_and(simd_cmpgt(aabb.max[0], bmin[0]), simd_cmpgt(bmax[0], aabb.min[0]) );
+		result = simd_and(result, simd_and(simd_cmpgt(aabb.max[1], bmin[1]), simd_cmpgt(bmax[1], aabb.min[1]) ) );
+		result = simd_and(result, simd_and(simd_cmpgt(aabb.max[2], bmin[2]), simd_cmpgt(bmax[2], aabb.min[2]) ) );
+
+		count += store(&_outMask[ii], result, _num-ii);
+	}
+
+	return count;
+}
+
+uint32_t overlapBatch(uint8_t* _outMask, const Aabb* _aabb, uint32_t _num, const Sphere& _sphere)
+{
+	const simd128_t center[3] =
+	{
+		simd_splat(_sphere.center.x),
+		simd_splat(_sphere.center.y),
+		simd_splat(_sphere.center.z),
+	};
+
+	const simd128_t radiusSq = simd_splat(square(_sphere.radius) );
+
+	uint32_t count = 0;
+
+	for (uint32_t ii = 0; ii < _num; ii += 4)
+	{
+		Aabb4 aabb;
+		load(aabb, &_aabb[ii], _num-ii);
+
+		// Squared distance from sphere center to closest point on AABB.
+		simd128_t distSq = simd_zero<simd128_t>();
+		for (uint32_t axis = 0; axis < 3; ++axis)
+		{
+			const simd128_t closest = simd_min(simd_max(center[axis], aabb.min[axis]), aabb.max[axis]);
+			const simd128_t delta   = simd_sub(closest, center[axis]);
+			distSq = simd_madd(delta, delta, distSq);
+		}
+
+		count += store(&_outMask[ii], simd_cmple(distSq, radiusSq), _num-ii);
+	}
+
+	return count;
+}
+
 bool overlap(const Aabb& _aabb, const Vec3& _pos)
 {
 	const Vec3 ac  = getCenter(_aabb);
@@ -7,6 +7,7 @@
 #define BOUNDS_H_HEADER_GUARD
 
 #include <bx/math.h>
+#include <bx/simd_t.h>
 
 ///
 struct Aabb
@@ -175,6 +176,14 @@ bool intersect(const Ray& _ray, const Sphere& _sphere, Hit* _hit = NULL);
 /// Intersect ray / triangle.
 bool intersect(const Ray& _ray, const Triangle& _triangle, Hit* _hit = NULL);
 
+/// Intersect ray against array of AABBs, four at a time with SIMD. Writes 1 into `_outMask`
+/// for each hit AABB, and 0 otherwise. Optional `_outDist` receives distance along ray to
+/// entry point of each hit AABB.
+///
+/// @returns Number of hit AABBs.
+///
+uint32_t intersectBatch(uint8_t* _outMask, float* _outDist, const Ray& _ray, const Aabb* _aabb, uint32_t _num);
+
 ///
 bool overlap(const Aabb& _aabb, const bx::Vec3& _pos);
 
@@ -205,6 +214,48 @@ bool overlap(const Aabb& _aabb, const Disk& _disk);
 ///
 bool overlap(const Aabb& _aabb, const Obb& _obb);
 
+/// Test AABB against convex volume bounded by planes (e.g. frustum planes returned by
+/// `buildFrustumPlanes`).
+bool overlap(const Aabb& _aabb, const bx::Plane* _planes, uint32_t _numPlanes);
+
+/// Plane broadcast into SIMD registers, for testing four AABBs at a time.
+struct PlaneSimd
+{
+	bx::simd128_t normal[3];
+	bx::simd128_t absNormal[3];
+	bx::simd128_t dist;
+};
+
+///
+void toSimd(PlaneSimd* _outPlanes, const bx::Plane* _planes, uint32_t _numPlanes);
+
+/// Test four AABBs, given as centers and extents in structure of arrays layout, against convex
+/// volume bounded by planes.
+///
+/// @returns Lane mask with all bits set for each AABB completely outside of the volume.
+///
+bx::simd128_t outsideMask(const bx::simd128_t* _center, const bx::simd128_t* _extents, const PlaneSimd* _planes, uint32_t _numPlanes);
+
+/// Test array of AABBs against convex volume bounded by up to 32 planes (e.g. frustum planes
+/// returned by `buildFrustumPlanes`), four at a time with SIMD. Writes 1 into `_outMask` for
+/// each AABB inside or intersecting the volume, and 0 otherwise.
+///
+/// @returns Number of AABBs inside or intersecting the volume.
+///
+uint32_t overlapBatch(uint8_t* _outMask, const Aabb* _aabb, uint32_t _num, const bx::Plane* _planes, uint32_t _numPlanes = 6);
+
+/// Test array of AABBs against AABB, four at a time with SIMD.
+///
+/// @returns Number of overlapping AABBs.
+///
+uint32_t overlapBatch(uint8_t* _outMask, const Aabb* _aabb, uint32_t _num, const Aabb& _aabbB);
+
+/// Test array of AABBs against sphere, four at a time with SIMD.
+///
+/// @returns Number of overlapping AABBs.
+///
+uint32_t overlapBatch(uint8_t* _outMask, const Aabb* _aabb, uint32_t _num, const Sphere& _sphere);
+
 ///
 bool overlap(const Capsule& _capsule, const bx::Vec3& _pos);
 
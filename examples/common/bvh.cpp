@@ -0,0 +1,698 @@
+/*
+ * Copyright 2011-2019 Branimir Karadzic. All rights reserved.
+ * License: https://github.com/bkaradzic/bgfx#license-bsd-2-clause
+ */
+
+#include <bx/cpu.h>
+#include <bx/math.h>
+#include <bx/thread.h>
+#include <bx/uint32_t.h>
+#include "bvh.h"
+
+static constexpr uint32_t kBvhNumBins     = 16;
+static constexpr uint32_t kBvhMaxLeafSize = 4;
+static constexpr uint32_t kBvhMaxDepth    = 64;
+static constexpr uint32_t kBvhInvalid     = UINT32_MAX;
+
+static float getAxis(const bx::Vec3& _v, uint32_t _axis)
+{
+	return (&_v.x)[_axis];
+}
+
+static void aabbInit(Aabb& _outAabb)
+{
+	_outAabb.min = {  bx::kFloatMax,  bx::kFloatMax,  bx::kFloatMax };
+	_outAabb.max = { -bx::kFloatMax, -bx::kFloatMax, -bx::kFloatMax };
+}
+
+static void aabbMerge(Aabb& _outAabb, const Aabb& _aabb)
+{
+	_outAabb.min = bx::min(_outAabb.min, _aabb.min);
+	_outAabb.max = bx::max(_outAabb.max, _aabb.max);
+}
+
+static float calcHalfArea(const Aabb& _aabb)
+{
+	const bx::Vec3 size = bx::sub(_aabb.max, _aabb.min);
+	return size.x*size.y + size.y*size.z + size.z*size.x;
+}
+
+struct BvhBuildTask
+{
+	uint32_t m_node;
+	uint32_t m_begin;
+	uint32_t m_end;
+	uint32_t m_depth;
+};
+
+struct BvhBuilder
+{
+	const Aabb*     m_aabb;
+	const bx::Vec3* m_centroid;
+	uint32_t*       m_indices;
+};
+
+// Returns split position in [_begin, _end) range, or _begin when range should become leaf.
+static uint32_t splitSah(const BvhBuilder& _builder, const Aabb& _bounds, uint32_t _begin, uint32_t _end)
+{
+	const uint32_t num = _end - _begin;
+
+	Aabb centroidBounds;
+	aabbInit(centroidBounds);
+	for (uint32_t ii = _begin; ii < _end; ++ii)
+	{
+		const bx::Vec3& centroid = _builder.m_centroid[_builder.m_indices[ii] ];
+		centroidBounds.min = bx::min(centroidBounds.min, centroid);
+		centroidBounds.max = bx::max(centroidBounds.max, centroid);
+	}
+
+	struct Bin
+	{
+		Aabb     m_aabb;
+		uint32_t m_count;
+	};
+
+	float    bestCost  = float(num);
+	uint32_t bestAxis  = UINT32_MAX;
+	uint32_t bestSplit = 0;
+
+	const float invArea = 1.0f/bx::max(calcHalfArea(_bounds), bx::kFloatMin);
+
+	for (uint32_t axis = 0; axis < 3; ++axis)
+	{
+		const float cmin   = getAxis(centroidBounds.min, axis);
+		const float extent = getAxis(centroidBounds.max, axis) - cmin;
+
+		if (0.0f >= extent)
+		{
+			continue;
+		}
+
+		Bin bins[kBvhNumBins];
+		for (uint32_t ii = 0; ii < kBvhNumBins; ++ii)
+		{
+			aabbInit(bins[ii].m_aabb);
+			bins[ii].m_count = 0;
+		}
+
+		const float scale = float(kBvhNumBins)/extent;
+		for (uint32_t ii = _begin; ii < _end; ++ii)
+		{
+			const uint32_t index = _builder.m_indices[ii];
+			const uint32_t bin   = bx::min(uint32_t( (getAxis(_builder.m_centroid[index], axis) - cmin)*scale), kBvhNumBins-1);
+			aabbMerge(bins[bin].m_aabb, _builder.m_aabb[index]);
+			++bins[bin].m_count;
+		}
+
+		// Sweep from right to accumulate area and count of right side of each split plane.
+		float    rightArea[kBvhNumBins];
+		uint32_t rightCount[kBvhNumBins];
+
+		Aabb     aabb;
+		uint32_t count = 0;
+		aabbInit(aabb);
+		for (uint32_t ii = kBvhNumBins-1; ii > 0; --ii)
+		{
+			aabbMerge(aabb, bins[ii].m_aabb);
+			count += bins[ii].m_count;
+			rightArea[ii]  = 0 == count ? 0.0f : calcHalfArea(aabb);
+			rightCount[ii] = count;
+		}
+
+		aabbInit(aabb);
+		count = 0;
+		for (uint32_t ii = 0; ii < kBvhNumBins-1; ++ii)
+		{
+			aabbMerge(aabb, bins[ii].m_aabb);
+			count += bins[ii].m_count;
+
+			if (0 == count
+			||  0 == rightCount[ii+1])
+			{
+				continue;
+			}
+
+			// Traversal cost relative to intersection cost is 1.
+			const float cost = 1.0f + (calcHalfArea(aabb)*float(count) + rightArea[ii+1]*float(rightCount[ii+1]) )*invArea;
+			if (cost < bestCost)
+			{
+				bestCost  = cost;
+				bestAxis  = axis;
+				bestSplit = ii+1;
+			}
+		}
+	}
+
+	if (UINT32_MAX == bestAxis)
+	{
+		if (num <= kBvhMaxLeafSize)
+		{
+			return _begin;
+		}
+
+		// Splitting doesn't pay off, but leaf would be too large. Split at median of largest
+		// centroid axis, or in the middle when all centroids are the same.
+		const bx::Vec3 size = bx::sub(centroidBounds.max, centroidBounds.min);
+		if (0.0f >= bx::max(size.x, size.y, size.z) )
+		{
+			return _begin + num/2;
+		}
+
+		const uint32_t axis = size.x > size.y
+			? (size.x > size.z ? 0 : 2)
+			: (size.y > size.z ? 1 : 2)
+			;
+		const float mid = getAxis(centroidBounds.min, axis) + getAxis(size, axis)*0.5f;
+
+		uint32_t split = _begin;
+		for (uint32_t ii = _begin; ii < _end; ++ii)
+		{
+			if (getAxis(_builder.m_centroid[_builder.m_indices[ii] ], axis) < mid)
+			{
+				bx::swap(_builder.m_indices[ii], _builder.m_indices[split]);
+				++split;
+			}
+		}
+
+		return split == _begin || split == _end ? _begin + num/2 : split;
+	}
+
+	const float cmin  = getAxis(centroidBounds.min, bestAxis);
+	const float scale = float(kBvhNumBins)/(getAxis(centroidBounds.max, bestAxis) - cmin);
+
+	uint32_t split = _begin;
+	for (uint32_t ii = _begin; ii < _end; ++ii)
+	{
+		const uint32_t index = _builder.m_indices[ii];
+		const uint32_t bin   = bx::min(uint32_t( (getAxis(_builder.m_centroid[index], bestAxis) - cmin)*scale), kBvhNumBins-1);
+
+		if (bin < bestSplit)
+		{
+			bx::swap(_builder.m_indices[ii], _builder.m_indices[split]);
+			++split;
+		}
+	}
+
+	return split;
+}
+
+// Builds subtree rooted at _root. Ranges smaller than _maxTaskSize are not built, but deferred
+// into _outTasks instead, when _outTasks is not NULL.
+static void buildSubtree(
+	  const BvhBuilder& _builder
+	, stl::vector<BvhNode>& _nodes
+	, const BvhBuildTask& _root
+	, stl::vector<BvhBuildTask>* _outTasks
+	, uint32_t _maxTaskSize
+	)
+{
+	stl::vector<BvhBuildTask> stack;
+	stack.push_back(_root);
+
+	while (!stack.empty() )
+	{
+		const BvhBuildTask task = stack.back();
+		stack.pop_back();
+
+		const uint32_t num = task.m_end - task.m_begin;
+
+		if (NULL != _outTasks
+		&&  num <= _maxTaskSize)
+		{
+			_outTasks->push_back(task);
+			continue;
+		}
+
+		Aabb bounds;
+		aabbInit(bounds);
+		for (uint32_t ii = task.m_begin; ii < task.m_end; ++ii)
+		{
+			aabbMerge(bounds, _builder.m_aabb[_builder.m_indices[ii] ]);
+		}
+
+		_nodes[task.m_node].m_aabb = bounds;
+
+		const uint32_t split = task.m_depth < kBvhMaxDepth
+			? splitSah(_builder, bounds, task.m_begin, task.m_end)
+			: task.m_begin
+			;
+
+		if (split == task.m_begin)
+		{
+			_nodes[task.m_node].m_first = task.m_begin;
+			_nodes[task.m_node].m_count = num;
+			continue;
+		}
+
+		const uint32_t left = uint32_t(_nodes.size() );
+		_nodes[task.m_node].m_first = left;
+		_nodes[task.m_node].m_count = 0;
+		_nodes.resize(left+2);
+
+		const BvhBuildTask rightTask = { left+1, split, task.m_end, task.m_depth+1 };
+		const BvhBuildTask leftTask  = { left, task.m_begin, split, task.m_depth+1 };
+		stack.push_back(rightTask);
+		stack.push_back(leftTask);
+	}
+}
+
+struct BvhParallelBuild
+{
+	const BvhBuilder*     m_builder;
+	const BvhBuildTask*   m_tasks;
+	stl::vector<BvhNode>* m_nodes;
+	uint32_t              m_num;
+	int32_t               m_next;
+};
+
+static int32_t bvhBuildThread(bx::Thread* /*_self*/, void* _userData)
+{
+	BvhParallelBuild* pb = (BvhParallelBuild*)_userData;
+
+	for (uint32_t idx = uint32_t(bx::atomicFetchAndAdd(&pb->m_next, 1) )
+		; idx < pb->m_num
+		; idx = uint32_t(bx::atomicFetchAndAdd(&pb->m_next, 1) )
+		)
+	{
+		// Each subtree is built into its own node array, with its root at index 0.
+		BvhBuildTask root = pb->m_tasks[idx];
+		root.m_node = 0;
+
+		stl::vector<BvhNode>& nodes = pb->m_nodes[idx];
+		nodes.resize(1);
+		buildSubtree(*pb->m_builder, nodes, root, NULL, 0);
+	}
+
+	return bx::kExitSuccess;
+}
+
+Bvh::Bvh()
+{
+}
+
+void Bvh::build(const Aabb* _aabb, uint32_t _num, uint32_t _numThreads)
+{
+	m_nodes.clear();
+	m_indices.resize(_num);
+	m_parent.clear();
+	m_leaf.resize(_num);
+	m_aabb.resize(_num);
+
+	if (0 == _num)
+	{
+		return;
+	}
+
+	stl::vector<bx::Vec3> centroid(_num);
+	for (uint32_t ii = 0; ii < _num; ++ii)
+	{
+		m_aabb[ii]    = _aabb[ii];
+		m_indices[ii] = ii;
+		centroid[ii]  = getCenter(_aabb[ii]);
+	}
+
+	BvhBuilder builder;
+	builder.m_aabb     = &m_aabb[0];
+	builder.m_centroid = &centroid[0];
+	builder.m_indices  = &m_indices[0];
+
+	m_nodes.resize(1);
+
+	const BvhBuildTask root = { 0, 0, _num, 0 };
+
+	if (1 >= _numThreads
+	||  4096 > _num)
+	{
+		buildSubtree(builder, m_nodes, root, NULL, 0);
+	}
+	else
+	{
+		// Split top of the tree serially until there are enough independent subtrees to keep
+		// all threads busy.
+		stl::vector<BvhBuildTask> tasks;
+		const uint32_t maxTaskSize = bx::max(_num/(_numThreads*4), 1024u);
+		buildSubtree(builder, m_nodes, root, &tasks, maxTaskSize);
+
+		const uint32_t numTasks = uint32_t(tasks.size() );
+		stl::vector<BvhNode>* subtree = new stl::vector<BvhNode>[numTasks];
+
+		BvhParallelBuild pb;
+		pb.m_builder = &builder;
+		pb.m_tasks   = &tasks[0];
+		pb.m_nodes   = subtree;
+		pb.m_num     = numTasks;
+		pb.m_next    = 0;
+
+		const uint32_t numThreads = bx::min(_numThreads, numTasks);
+
+		bx::Thread* threads = new bx::Thread[numThreads-1];
+		for (uint32_t ii = 0; ii < numThreads-1; ++ii)
+		{
+			threads[ii].init(bvhBuildThread, &pb, 0, "bvh - worker");
+		}
+
+		bvhBuildThread(NULL, &pb);
+
+		for (uint32_t ii = 0; ii < numThreads-1; ++ii)
+		{
+			threads[ii].shutdown();
+		}
+
+		delete [] threads;
+
+		// Append subtrees. Local root replaces placeholder node, and remaining nodes are moved
+		// after the end of the node array, which keeps children after their parents.
+		for (uint32_t ii = 0; ii < numTasks; ++ii)
+		{
+			const stl::vector<BvhNode>& nodes = subtree[ii];
+			const uint32_t base = uint32_t(m_nodes.size() ) - 1;
+
+			for (uint32_t jj = 0, num = uint32_t(nodes.size() ); jj < num; ++jj)
+			{
+				BvhNode node = nodes[jj];
+				if (0 == node.m_count)
+				{
+					node.m_first += base;
+				}
+
+				if (0 == jj)
+				{
+					m_nodes[tasks[ii].m_node] = node;
+				}
+				else
+				{
+					m_nodes.push_back(node);
+				}
+			}
+		}
+
+		delete [] subtree;
+	}
+
+	const uint32_t numNodes = uint32_t(m_nodes.size() );
+	m_parent.resize(numNodes);
+	m_parent[0] = kBvhInvalid;
+
+	for (uint32_t ii = 0; ii < numNodes; ++ii)
+	{
+		const BvhNode& node = m_nodes[ii];
+
+		if (0 == node.m_count)
+		{
+			m_parent[node.m_first  ] = ii;
+			m_parent[node.m_first+1] = ii;
+		}
+		else
+		{
+			for (uint32_t jj = node.m_first, end = node.m_first+node.m_count; jj < end; ++jj)
+			{
+				m_leaf[m_indices[jj] ] = ii;
+			}
+		}
+	}
+}
+
+void Bvh::refit(const Aabb* _aabb)
+{
+	const uint32_t num = uint32_t(m_aabb.size() );
+	for (uint32_t ii = 0; ii < num; ++ii)
+	{
+		m_aabb[ii] = _aabb[ii];
+	}
+
+	// Children are always stored after their parent, walking backward refits bottom-up.
+	for (uint32_t ii = uint32_t(m_nodes.size() ); ii-- > 0;)
+	{
+		BvhNode& node = m_nodes[ii];
+
+		if (0 == node.m_count)
+		{
+			node.m_aabb = m_nodes[node.m_first].m_aabb;
+			aabbMerge(node.m_aabb, m_nodes[node.m_first+1].m_aabb);
+		}
+		else
+		{
+			aabbInit(node.m_aabb);
+			for (uint32_t jj = node.m_first, end = node.m_first+node.m_count; jj < end; ++jj)
+			{
+				aabbMerge(node.m_aabb, m_aabb[m_indices[jj] ]);
+			}
+		}
+	}
+}
+
+void Bvh::update(uint32_t _index, const Aabb& _aabb)
+{
+	m_aabb[_index] = _aabb;
+
+	uint32_t nodeIdx = m_leaf[_index];
+
+	BvhNode& leaf = m_nodes[nodeIdx];
+	aabbInit(leaf.m_aabb);
+	for (uint32_t jj = leaf.m_first, end = leaf.m_first+leaf.m_count; jj < end; ++jj)
+	{
+		aabbMerge(leaf.m_aabb, m_aabb[m_indices[jj] ]);
+	}
+
+	for (nodeIdx = m_parent[nodeIdx]; kBvhInvalid != nodeIdx; nodeIdx = m_parent[nodeIdx])
+	{
+		BvhNode& node = m_nodes[nodeIdx];
+		node.m_aabb = m_nodes[node.m_first].m_aabb;
+		aabbMerge(node.m_aabb, m_nodes[node.m_first+1].m_aabb);
+	}
+}
+
+static bool intersectSlab(float& _outT, const Aabb& _aabb, const bx::Vec3& _pos, const bx::Vec3& _invDir, float _tmax)
+{
+	const bx::Vec3 t0 = bx::mul(bx::sub(_aabb.min, _pos), _invDir);
+	const bx::Vec3 t1 = bx::mul(bx::sub(_aabb.max, _pos), _invDir);
+	const bx::Vec3 mn = bx::min(t0, t1);
+	const bx::Vec3 mx = bx::max(t0, t1);
+
+	const float tmin = bx::max(mn.x, mn.y, mn.z);
+	const float tmax = bx::min(bx::min(mx.x, mx.y, mx.z), _tmax);
+
+	_outT = tmin;
+	return 0.0f <= tmax && tmin <= tmax;
+}
+
+uint32_t Bvh::intersect(const Ray& _ray, Hit* _hit, BvhRayFn _fn, void* _userData) const
+{
+	if (m_nodes.empty() )
+	{
+		return kBvhInvalid;
+	}
+
+	const bx::Vec3 invDir   = bx::rcp(_ray.dir);
+	const float    invLenSq = 1.0f/bx::dot(_ray.dir, _ray.dir);
+
+	uint32_t closest = kBvhInvalid;
+	float    closestT = bx::kFloatMax;
+	Hit      closestHit;
+
+	uint32_t stack[kBvhMaxDepth*2];
+	uint32_t top = 0;
+
+	float tt;
+	if (!intersectSlab(tt, m_nodes[0].m_aabb, _ray.pos, invDir, closestT) )
+	{
+		return kBvhInvalid;
+	}
+
+	stack[top++] = 0;
+
+	while (0 != top)
+	{
+		const BvhNode& node = m_nodes[stack[--top] ];
+
+		if (0 != node.m_count)
+		{
+			for (uint32_t ii = node.m_first, end = node.m_first+node.m_count; ii < end; ++ii)
+			{
+				const uint32_t index = m_indices[ii];
+
+				Hit hit;
+				const bool result = NULL != _fn
+					? _fn(_userData, index, _ray, &hit)
+					: ::intersect(_ray, m_aabb[index], &hit)
+					;
+
+				if (result)
+				{
+					const float hitT = bx::dot(bx::sub(hit.pos, _ray.pos), _ray.dir)*invLenSq;
+					if (hitT < closestT)
+					{
+						closest    = index;
+						closestT   = hitT;
+						closestHit = hit;
+					}
+				}
+			}
+
+			continue;
+		}
+
+		float t0, t1;
+		const bool hit0 = intersectSlab(t0, m_nodes[node.m_first  ].m_aabb, _ray.pos, invDir, closestT);
+		const bool hit1 = intersectSlab(t1, m_nodes[node.m_first+1].m_aabb, _ray.pos, invDir, closestT);
+
+		// Push farther child first, so that nearer child is visited first.
+		if (hit0 && hit1)
+		{
+			const bool swap = t1 < t0;
+			stack[top++] = node.m_first + (swap ? 0 : 1);
+			stack[top++] = node.m_first + (swap ? 1 : 0);
+		}
+		else if (hit0)
+		{
+			stack[top++] = node.m_first;
+		}
+		else if (hit1)
+		{
+			stack[top++] = node.m_first+1;
+		}
+	}
+
+	if (kBvhInvalid != closest
+	&&  NULL != _hit)
+	{
+		*_hit = closestHit;
+	}
+
+	return closest;
+}
+
+// Tests AABB only against planes in `_inOutPlaneMask`, returns false when it's completely behind
+// any of them. Planes AABB is completely in front of are cleared from the mask.
+static bool overlapPlanes(const Aabb& _aabb, const bx::Plane* _planes, uint32_t& _inOutPlaneMask)
+{
+	const bx::Vec3 center  = getCenter(_aabb);
+	const bx::Vec3 extents = getExtents(_aabb);
+
+	for (uint32_t bits = _inOutPlaneMask; 0 != bits; bits &= bits-1)
+	{
+		const uint32_t ii = bx::uint32_cnttz(bits);
+
+		const float dist   = bx::distance(_planes[ii], center);
+		const float radius = bx::dot(extents, bx::abs(_planes[ii].normal) );
+
+		if (dist + radius < 0.0f)
+		{
+			return false;
+		}
+
+		if (dist - radius >= 0.0f)
+		{
+			_inOutPlaneMask &= ~(1u<<ii);
+		}
+	}
+
+	return true;
+}
+
+uint32_t Bvh::overlap(uint32_t* _outIndices, uint32_t _max, const bx::Plane* _planes, uint32_t _numPlanes) const
+{
+	BX_CHECK(32 >= _numPlanes, "Too many planes %d (max 32).", _numPlanes);
+
+	if (m_nodes.empty()
+	||  0 == _numPlanes)
+	{
+		return 0;
+	}
+
+	struct Entry
+	{
+		uint32_t m_node;
+		uint32_t m_planeMask; //!< Planes node is not yet known to be fully inside of.
+	};
+
+	Entry stack[kBvhMaxDepth*2];
+	uint32_t top = 0;
+
+	const Entry root = { 0, UINT32_MAX >> (32 - bx::uint32_min(_numPlanes, 32) ) };
+	stack[top++] = root;
+
+	uint32_t num = 0;
+
+	while (0 != top
+	&&     num < _max)
+	{
+		Entry entry = stack[--top];
+		const BvhNode& node = m_nodes[entry.m_node];
+
+		if (!overlapPlanes(node.m_aabb, _planes, entry.m_planeMask) )
+		{
+			continue;
+		}
+
+		if (0 != node.m_count)
+		{
+			// Partially overlapping leaf is tested per object, only against planes node is
+			// not fully inside of.
+			for (uint32_t ii = node.m_first, end = node.m_first+node.m_count; ii < end && num < _max; ++ii)
+			{
+				const uint32_t index = m_indices[ii];
+
+				uint32_t planeMask = entry.m_planeMask;
+				if (overlapPlanes(m_aabb[index], _planes, planeMask) )
+				{
+					_outIndices[num++] = index;
+				}
+			}
+
+			continue;
+		}
+
+		const Entry right = { node.m_first+1, entry.m_planeMask };
+		const Entry left  = { node.m_first,   entry.m_planeMask };
+		stack[top++] = right;
+		stack[top++] = left;
+	}
+
+	return num;
+}
+
+uint32_t Bvh::overlap(uint32_t* _outIndices, uint32_t _max, const Aabb& _aabb) const
+{
+	if (m_nodes.empty() )
+	{
+		return 0;
+	}
+
+	uint32_t stack[kBvhMaxDepth*2];
+	uint32_t top = 0;
+
+	stack[top++] = 0;
+
+	uint32_t num = 0;
+
+	while (0 != top
+	&&     num < _max)
+	{
+		const BvhNode& node = m_nodes[stack[--top] ];
+
+		if (!::overlap(node.m_aabb, _aabb) )
+		{
+			continue;
+		}
+
+		if (0 != node.m_count)
+		{
+			for (uint32_t ii = node.m_first, end = node.m_first+node.m_count; ii < end && num < _max; ++ii)
+			{
+				const uint32_t index = m_indices[ii];
+				if (::overlap(m_aabb[index], _aabb) )
+				{
+					_outIndices[num++] = index;
+				}
+			}
+
+			continue;
+		}
+
+		stack[top++] = node.m_first+1;
+		stack[top++] = node.m_first;
+	}
+
+	return num;
+}
@@ -0,0 +1,77 @@
+/*
+ * Copyright 2011-2019 Branimir Karadzic. All rights reserved.
+ * License: https://github.com/bkaradzic/bgfx#license-bsd-2-clause
+ */
+
+#ifndef BVH_H_HEADER_GUARD
+#define BVH_H_HEADER_GUARD
+
+#include "bounds.h"
+
+#include <tinystl/allocator.h>
+#include <tinystl/vector.h>
+namespace stl = tinystl;
+
+///
+struct BvhNode
+{
+	Aabb     m_aabb;
+	uint32_t m_first; //!< Left child for interior node (right child is m_first+1), or first index for leaf.
+	uint32_t m_count; //!< Number of objects in leaf, 0 for interior node.
+};
+
+/// Exact ray test for object. Returns true and fills `_hit` when ray hits object.
+typedef bool (*BvhRayFn)(void* _userData, uint32_t _index, const Ray& _ray, Hit* _hit);
+
+/// Bounding volume hierarchy over object AABBs, built with binned surface area heuristic.
+///
+struct Bvh
+{
+	///
+	Bvh();
+
+	/// Build hierarchy. When `_numThreads` is larger than 1, top of the tree is split on calling
+	/// thread and remaining subtrees are built in parallel.
+	void build(const Aabb* _aabb, uint32_t _num, uint32_t _numThreads = 1);
+
+	/// Refit hierarchy to new object bounds without changing topology. Quality of the tree
+	/// degrades as objects move away from their original positions, rebuild occasionally.
+	void refit(const Aabb* _aabb);
+
+	/// Update bounds of single object, and refit its ancestors.
+	void update(uint32_t _index, const Aabb& _aabb);
+
+	/// Find closest object hit by ray. Object bounds are used as hit test unless `_fn` is
+	/// provided.
+	///
+	/// @returns Index of closest hit object, or UINT32_MAX if nothing was hit.
+	///
+	uint32_t intersect(const Ray& _ray, Hit* _hit = NULL, BvhRayFn _fn = NULL, void* _userData = NULL) const;
+
+	/// Find objects inside or intersecting convex volume bounded by up to 32 planes (e.g.
+	/// frustum planes returned by `buildFrustumPlanes`).
+	///
+	/// @returns Number of indices written into `_outIndices`.
+	///
+	uint32_t overlap(uint32_t* _outIndices, uint32_t _max, const bx::Plane* _planes, uint32_t _numPlanes = 6) const;
+
+	/// Find objects overlapping AABB.
+	///
+	/// @returns Number of indices written into `_outIndices`.
+	///
+	uint32_t overlap(uint32_t* _outIndices, uint32_t _max, const Aabb& _aabb) const;
+
+	///
+	uint32_t getNumObjects() const
+	{
+		return uint32_t(m_aabb.size() );
+	}
+
+	stl::vector<BvhNode>  m_nodes;
+	stl::vector<uint32_t> m_indices; //!< Object indices referenced by leafs.
+	stl::vector<uint32_t> m_parent;  //!< Parent of each node.
+	stl::vector<uint32_t> m_leaf;    //!< Leaf node containing each object.
+	stl::vector<Aabb>     m_aabb;    //!< Object bounds.
+};
+
+#endif // BVH_H_HEADER_GUARD
@@ -0,0 +1,288 @@
+/*
+ * Copyright 2011-2019 Branimir Karadzic. All rights reserved.
+ * License: https://github.com/bkaradzic/bgfx#license-bsd-2-clause
+ */
+
+#include <bx/math.h>
+#include "cpu_occlusion.h"
+
+static constexpr float kNearW = 1e-5f;
+
+struct ScreenPos
+{
+	float x;
+	float y;
+	float z;
+	float w;
+};
+
+static ScreenPos toScreen(const float* _mtx, const bx::Vec3& _pos, float _width, float _height, bool _homogeneousDepth)
+{
+	const float xx = _pos.x*_mtx[0] + _pos.y*_mtx[4] + _pos.z*_mtx[ 8] + _mtx[12];
+	const float yy = _pos.x*_mtx[1] + _pos.y*_mtx[5] + _pos.z*_mtx[ 9] + _mtx[13];
+	const float zz = _pos.x*_mtx[2] + _pos.y*_mtx[6] + _pos.z*_mtx[10] + _mtx[14];
+	const float ww = _pos.x*_mtx[3] + _pos.y*_mtx[7] + _pos.z*_mtx[11] + _mtx[15];
+
+	ScreenPos result;
+	result.w = ww;
+
+	if (kNearW >= ww)
+	{
+		result.x = 0.0f;
+		result.y = 0.0f;
+		result.z = 0.0f;
+		return result;
+	}
+
+	const float invW = 1.0f/ww;
+	result.x = (xx*invW*0.5f + 0.5f)*_width;
+	result.y = (0.5f - yy*invW*0.5f)*_height;
+	result.z = _homogeneousDepth
+		? zz*invW*0.5f + 0.5f
+		: zz*invW
+		;
+
+	return result;
+}
+
+static float edge(const ScreenPos& _a, const ScreenPos& _b, float _x, float _y)
+{
+	return (_b.x - _a.x)*(_y - _a.y) - (_b.y - _a.y)*(_x - _a.x);
+}
+
+CpuOcclusion::CpuOcclusion()
+	: m_homogeneousDepth(false)
+{
+	bx::mtxIdentity(m_viewProj);
+}
+
+void CpuOcclusion::create(uint32_t _width, uint32_t _height)
+{
+	m_level.clear();
+
+	uint32_t width  = bx::max<uint32_t>(_width,  1);
+	uint32_t height = bx::max<uint32_t>(_height, 1);
+	uint32_t offset = 0;
+
+	for (;;)
+	{
+		const Level level = { width, height, offset };
+		m_level.push_back(level);
+		offset += width*height;
+
+		if (1 == width
+		&&  1 == height)
+		{
+			break;
+		}
+
+		width  = (width +1)/2;
+		height = (height+1)/2;
+	}
+
+	m_depth.resize(offset);
+}
+
+void CpuOcclusion::destroy()
+{
+	m_depth.clear();
+	m_level.clear();
+}
+
+void CpuOcclusion::begin(const float* _viewProj, bool _homogeneousDepth)
+{
+	bx::memCopy(m_viewProj, _viewProj, sizeof(m_viewProj) );
+	m_homogeneousDepth = _homogeneousDepth;
+
+	const Level& level = m_level[0];
+	for (uint32_t ii = 0, num = level.m_width*level.m_height; ii < num; ++ii)
+	{
+		m_depth[ii] = 1.0f;
+	}
+}
+
+void CpuOcclusion::addOccluder(
+	  const float* _mtx
+	, const void* _vertices
+	, uint32_t _numVertices
+	, uint32_t _stride
+	, const uint16_t* _indices
+	, uint32_t _numIndices
+	)
+{
+	float mvp[16];
+	bx::mtxMul(mvp, _mtx, m_viewProj);
+
+	const Level& level = m_level[0];
+	const float width  = float(level.m_width);
+	const float height = float(level.m_height);
+
+	stl::vector<ScreenPos> screen(_numVertices);
+
+	const uint8_t* vertices = (const uint8_t*)_vertices;
+	for (uint32_t ii = 0; ii < _numVertices; ++ii)
+	{
+		const bx::Vec3 pos = bx::load<bx::Vec3>(&vertices[ii*_stride]);
+		screen[ii] = toScreen(mvp, pos, width, height, m_homogeneousDepth);
+	}
+
+	float* depth = &m_depth[0];
+
+	for (uint32_t ii = 0; ii+2 < _numIndices; ii += 3)
+	{
+		const ScreenPos& v0 = screen[_indices[ii+0] ];
+		const ScreenPos& v1 = screen[_indices[ii+1] ];
+		const ScreenPos& v2 = screen[_indices[ii+2] ];
+
+		// Skipping triangles crossing near plane only makes occluder smaller, which keeps test
+		// conservative.
+		if (kNearW >= v0.w
+		||  kNearW >= v1.w
+		||  kNearW >= v2.w)
+		{
+			continue;
+		}
+
+		const float area = edge(v0, v1, v2.x, v2.y);
+		if (bx::abs(area) < 1e-8f)
+		{
+			continue;
+		}
+
+		// Both windings are rasterized, occluders don't need to be closed.
+		const float invArea = 1.0f/area;
+
+		const int32_t minX = bx::max(int32_t(bx::floor(bx::min(v0.x, v1.x, v2.x) ) ), 0);
+		const int32_t minY = bx::max(int32_t(bx::floor(bx::min(v0.y, v1.y, v2.y) ) ), 0);
+		const int32_t maxX = bx::min(int32_t(bx::ceil(bx::max(v0.x, v1.x, v2.x) ) ), int32_t(level.m_width )-1);
+		const int32_t maxY = bx::min(int32_t(bx::ceil(bx::max(v0.y, v1.y, v2.y) ) ), int32_t(level.m_height)-1);
+
+		for (int32_t yy = minY; yy <= maxY; ++yy)
+		{
+			const float cy = float(yy) + 0.5f;
+
+			for (int32_t xx = minX; xx <= maxX; ++xx)
+			{
+				const float cx = float(xx) + 0.5f;
+
+				const float b0 = edge(v1, v2, cx, cy)*invArea;
+				const float b1 = edge(v2, v0, cx, cy)*invArea;
+				const float b2 = edge(v0, v1, cx, cy)*invArea;
+
+				if (0.0f > b0
+				||  0.0f > b1
+				||  0.0f > b2)
+				{
+					continue;
+				}
+
+				const float zz = b0*v0.z + b1*v1.z + b2*v2.z;
+
+				float& dst = depth[yy*level.m_width + xx];
+				dst = bx::min(dst, zz);
+			}
+		}
+	}
+}
+
+void CpuOcclusion::end()
+{
+	for (uint32_t ii = 1, num = uint32_t(m_level.size() ); ii < num; ++ii)
+	{
+		const Level& src = m_level[ii-1];
+		const Level& dst = m_level[ii];
+
+		const float* srcDepth = &m_depth[src.m_offset];
+		float*       dstDepth = &m_depth[dst.m_offset];
+
+		for (uint32_t yy = 0; yy < dst.m_height; ++yy)
+		{
+			const uint32_t y0 = yy*2;
+			const uint32_t y1 = bx::min(y0+1, src.m_height-1);
+
+			for (uint32_t xx = 0; xx < dst.m_width; ++xx)
+			{
+				const uint32_t x0 = xx*2;
+				const uint32_t x1 = bx::min(x0+1, src.m_width-1);
+
+				dstDepth[yy*dst.m_width + xx] = bx::max(
+					  bx::max(srcDepth[y0*src.m_width + x0], srcDepth[y0*src.m_width + x1])
+					, bx::max(srcDepth[y1*src.m_width + x0], srcDepth[y1*src.m_width + x1])
+					);
+			}
+		}
+	}
+}
+
+bool CpuOcclusion::isVisible(const Aabb& _aabb) const
+{
+	const Level& level0 = m_level[0];
+	const float width  = float(level0.m_width);
+	const float height = float(level0.m_height);
+
+	float minX = bx::kFloatMax, minY = bx::kFloatMax, minZ = bx::kFloatMax;
+	float maxX = -bx::kFloatMax, maxY = -bx::kFloatMax;
+
+	for (uint32_t ii = 0; ii < 8; ++ii)
+	{
+		const bx::Vec3 corner =
+		{
+			ii & 1 ? _aabb.max.x : _aabb.min.x,
+			ii & 2 ? _aabb.max.y : _aabb.min.y,
+			ii & 4 ? _aabb.max.z : _aabb.min.z,
+		};
+
+		const ScreenPos pos = toScreen(m_viewProj, corner, width, height, m_homogeneousDepth);
+		if (kNearW >= pos.w)
+		{
+			// Box is crossing near plane.
+			return true;
+		}
+
+		minX = bx::min(minX, pos.x);
+		minY = bx::min(minY, pos.y);
+		minZ = bx::min(minZ, pos.z);
+		maxX = bx::max(maxX, pos.x);
+		maxY = bx::max(maxY, pos.y);
+	}
+
+	if (0.0f > maxX || width  < minX
+	||  0.0f > maxY || height < minY
+	||  1.0f < minZ)
+	{
+		return false;
+	}
+
+	int32_t x0 = bx::clamp(int32_t(bx::floor(minX) ), 0, int32_t(level0.m_width )-1);
+	int32_t y0 = bx::clamp(int32_t(bx::floor(minY) ), 0, int32_t(level0.m_height)-1);
+	int32_t x1 = bx::clamp(int32_t(bx::floor(maxX) ), 0, int32_t(level0.m_width )-1);
+	int32_t y1 = bx::clamp(int32_t(bx::floor(maxY) ), 0, int32_t(level0.m_height)-1);
+
+	// Pick level where box covers at most 4x4 texels.
+	uint32_t lod = 0;
+	while (lod+1 < m_level.size()
+	&&    (x1-x0 > 3 || y1-y0 > 3) )
+	{
+		x0 >>= 1;
+		y0 >>= 1;
+		x1 >>= 1;
+		y1 >>= 1;
+		++lod;
+	}
+
+	const Level& level = m_level[lod];
+	const float* depth = &m_depth[level.m_offset];
+
+	for (int32_t yy = y0; yy <= y1; ++yy)
+	{
+		for (int32_t xx = x0; xx <= x1; ++xx)
+		{
+			if (depth[yy*level.m_width + xx] >= minZ)
+			{
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
@@ -0,0 +1,73 @@
+/*
+ * Copyright 2011-2019 Branimir Karadzic. All rights reserved.
+ * License: https://github.com/bkaradzic/bgfx#license-bsd-2-clause
+ */
+
+#ifndef CPU_OCCLUSION_H_HEADER_GUARD
+#define CPU_OCCLUSION_H_HEADER_GUARD
+
+#include "bounds.h"
+
+#include <tinystl/allocator.h>
+#include <tinystl/vector.h>
+namespace stl = tinystl;
+
+/// Software rasterized depth buffer with hierarchical max depth (Hi-Z), used to test occlusion
+/// on CPU when GPU occlusion queries are not available. It doesn't depend on renderer, and it can
+/// be used without bgfx being initialized.
+///
+/// Depth is stored in [0, 1] range, with 0 at near plane. Occluders are rasterized with
+/// nearest depth winning, and each Hi-Z level keeps farthest depth of 2x2 texels of level
+/// below, so occlusion test against it is conservative.
+///
+struct CpuOcclusion
+{
+	///
+	CpuOcclusion();
+
+	///
+	void create(uint32_t _width, uint32_t _height);
+
+	///
+	void destroy();
+
+	/// Clear depth buffer and set view-projection matrix used by following calls.
+	void begin(const float* _viewProj, bool _homogeneousDepth);
+
+	/// Rasterize occluder triangles. Triangles crossing near plane are skipped.
+	void addOccluder(
+		  const float* _mtx
+		, const void* _vertices
+		, uint32_t _numVertices
+		, uint32_t _stride
+		, const uint16_t* _indices
+		, uint32_t _numIndices
+		);
+
+	/// Build Hi-Z levels from depth buffer.
+	void end();
+
+	/// Returns false when AABB in world space is fully occluded, or outside of screen.
+	bool isVisible(const Aabb& _aabb) const;
+
+	///
+	uint32_t getNumLevels() const
+	{
+		return uint32_t(m_level.size() );
+	}
+
+	struct Level
+	{
+		uint32_t m_width;
+		uint32_t m_height;
+		uint32_t m_offset;
+	};
+
+	stl::vector<float> m_depth; //!< All levels, level 0 is depth buffer.
+	stl::vector<Level> m_level;
+
+	float m_viewProj[16];
+	bool  m_homogeneousDepth;
+};
+
+#endif // CPU_OCCLUSION_H_HEADER_GUARD
@@ -5,6 +5,7 @@
 
 #include "common.h"
 #include <bgfx/bgfx.h>
+#include <bx/sort.h>
 
 #include <limits.h> // INT_MAX
 #include <vector>
@@ -111,6 +112,13 @@ bool RectanglePacker::addRectangle(uint16_t _width, uint16_t _height, uint16_t&
 	best_width = INT_MAX;
 	for (uint16_t ii = 0, num = uint16_t(m_skyline.size() ); ii < num; ++ii)
 	{
+		// fit never places the rectangle below the node level, so skip the
+		// whole span scan when the node can't beat the best candidate
+		if (m_skyline[ii].y + _height > best_height)
+		{
+			continue;
+		}
+
 		int32_t yy = fit(ii, _width, _height);
 		if (yy >= 0)
 		{
@@ -249,6 +257,64 @@ struct Atlas::PackedLayer
 	AtlasRegion faceRegion;
 };
 
+struct Atlas::DirtyRegions
+{
+	std::vector<AtlasRegion> regions;
+};
+
+struct RegionUse
+{
+	uint32_t lastUsed;
+	uint16_t handle;
+};
+
+static int32_t compareRegionUse(const void* _lhs, const void* _rhs)
+{
+	const RegionUse& lhs = *(const RegionUse*)_lhs;
+	const RegionUse& rhs = *(const RegionUse*)_rhs;
+	return lhs.lastUsed < rhs.lastUsed ? -1 : (lhs.lastUsed > rhs.lastUsed ? 1 : 0);
+}
+
+struct RegionHeight
+{
+	uint16_t height;
+	uint16_t handle;
+};
+
+static int32_t compareRegionHeight(const void* _lhs, const void* _rhs)
+{
+	const RegionHeight& lhs = *(const RegionHeight*)_lhs;
+	const RegionHeight& rhs = *(const RegionHeight*)_rhs;
+	return int32_t(rhs.height) - int32_t(lhs.height);
+}
+
+/// merge _b into _a if both are on the same face, and merged region is still mostly dirty
+static bool mergeRegion(AtlasRegion& _a, const AtlasRegion& _b)
+{
+	if (_a.getFaceIndex() != _b.getFaceIndex() )
+	{
+		return false;
+	}
+
+	const uint32_t x0 = bx::min(_a.x, _b.x);
+	const uint32_t y0 = bx::min(_a.y, _b.y);
+	const uint32_t x1 = bx::max(_a.x + _a.width,  _b.x + _b.width);
+	const uint32_t y1 = bx::max(_a.y + _a.height, _b.y + _b.height);
+
+	// uploading some clean texels is cheaper than issuing another texture update
+	const uint32_t area = (x1 - x0) * (y1 - y0);
+	if (area > 2 * (_a.width * _a.height + _b.width * _b.height) )
+	{
+		return false;
+	}
+
+	_a.x = uint16_t(x0);
+	_a.y = uint16_t(y0);
+	_a.width = uint16_t(x1 - x0);
+	_a.height = uint16_t(y1 - y0);
+	return true;
+}
+
 Atlas::Atlas(uint16_t _textureSize, uint16_t _maxRegionsCount)
 	: m_usedLayers(0)
 	, m_usedFaces(0)
@@ -268,6 +334,10 @@ Atlas::Atlas(uint16_t _textureSize, uint16_t _maxRegionsCount)
 	}
 
 	m_regions = new AtlasRegion[_maxRegionsCount];
+	m_regionInfo = new RegionInfo[_maxRegionsCount];
+	bx::memSet(m_regionInfo, 0, _maxRegionsCount * sizeof(RegionInfo) );
+	m_freeRegions = new uint16_t[_maxRegionsCount];
+	m_dirty = new DirtyRegions;
 	m_textureBuffer = new uint8_t[ _textureSize * _textureSize * 6 * 4 ];
 	bx::memSet(m_textureBuffer, 0, _textureSize * _textureSize * 6 * 4);
 
@@ -290,9 +360,22 @@ Atlas::Atlas(uint16_t _textureSize, const uint8_t* _textureBuffer, uint16_t _reg
 	init();
 
 	m_regions = new AtlasRegion[_regionCount];
+	m_regionInfo = new RegionInfo[_regionCount];
+	m_freeRegions = new uint16_t[_regionCount];
+	m_dirty = new DirtyRegions;
 	m_textureBuffer = new uint8_t[getTextureBufferSize()];
 
 	bx::memCopy(m_regions, _regionBuffer, _regionCount * sizeof(AtlasRegion) );
+
+	for (uint16_t ii = 0; ii < _regionCount; ++ii)
+	{
+		RegionInfo& info = m_regionInfo[ii];
+		info.lastUsed = 0;
+		info.layer = 0;
+		info.outline = 0;
+		info.generation = 0;
+		info.used = true;
+	}
 	bx::memCopy(m_textureBuffer, _textureBuffer, getTextureBufferSize() );
 
 	m_textureHandle = bgfx::createTextureCube(_textureSize
@@ -310,11 +393,19 @@ Atlas::~Atlas()
 
 	delete [] m_layers;
 	delete [] m_regions;
+	delete [] m_regionInfo;
+	delete [] m_freeRegions;
+	delete m_dirty;
 	delete [] m_textureBuffer;
 }
 
 void Atlas::init()
 {
+	bx::memSet(&m_stats, 0, sizeof(m_stats) );
+	m_layers = NULL;
+	m_numFreeRegions = 0;
+	m_useCounter = 0;
+
 	m_texelSize = float(UINT16_MAX) / float(m_textureSize);
 	float texelHalf = m_texelSize/2.0f;
 	switch (bgfx::getRendererType() )
@@ -339,7 +430,8 @@ void Atlas::init()
 
 uint16_t Atlas::addRegion(uint16_t _width, uint16_t _height, const uint8_t* _bitmapBuffer, AtlasRegion::Type _type, uint16_t outline)
 {
-	if (m_regionCount >= m_maxRegionCount)
+	if (0 == m_numFreeRegions
+	&&  m_regionCount >= m_maxRegionCount)
 	{
 		return UINT16_MAX;
 	}
@@ -385,7 +477,12 @@ uint16_t Atlas::addRegion(uint16_t _width, uint16_t _height, const uint8_t* _bit
 		}
 	}
 
-	AtlasRegion& region = m_regions[m_regionCount];
+	const uint16_t handle = 0 < m_numFreeRegions
+		? m_freeRegions[--m_numFreeRegions]
+		: m_regionCount++
+		;
+
+	AtlasRegion& region = m_regions[handle];
 	region.x = xx;
 	region.y = yy;
 	region.width = _width;
@@ -399,51 +496,279 @@ uint16_t Atlas::addRegion(uint16_t _width, uint16_t _height, const uint8_t* _bit
 	region.width -= (outline * 2);
 	region.height -= (outline * 2);
 
-	return m_regionCount++;
+	RegionInfo& info = m_regionInfo[handle];
+	info.lastUsed = ++m_useCounter;
+	info.layer = uint16_t(idx);
+	info.outline = outline;
+	info.used = true;
+
+	return handle;
 }
 
-void Atlas::updateRegion(const AtlasRegion& _region, const uint8_t* _bitmapBuffer)
+void Atlas::removeRegion(uint16_t _regionHandle)
 {
-	uint32_t size = _region.width * _region.height * 4;
-	if (0 < size)
+	BX_CHECK(_regionHandle < m_regionCount && m_regionInfo[_regionHandle].used, "Invalid region handle %d.", _regionHandle);
+
+	m_regionInfo[_regionHandle].used = false;
+	m_regionInfo[_regionHandle].generation++;
+	m_freeRegions[m_numFreeRegions++] = _regionHandle;
+}
+
+void Atlas::markUsed(const uint16_t* _regionHandles, uint32_t _num) const
+{
+	const uint32_t lastUsed = ++m_useCounter;
+
+	for (uint32_t ii = 0; ii < _num; ++ii)
+	{
+		const uint16_t handle = _regionHandles[ii];
+		if (UINT16_MAX != handle)
+		{
+			m_regionInfo[handle].lastUsed = lastUsed;
+		}
+	}
+}
+
+uint16_t Atlas::getLeastRecentlyUsed(uint16_t* _outRegionHandles, uint16_t _max) const
+{
+	std::vector<RegionUse> regions;
+	regions.reserve(m_regionCount);
+
+	for (uint16_t ii = 0; ii < m_regionCount; ++ii)
+	{
+		if (m_regionInfo[ii].used)
+		{
+			RegionUse use = { m_regionInfo[ii].lastUsed, ii };
+			regions.push_back(use);
+		}
+	}
+
+	if (regions.empty() )
+	{
+		return 0;
+	}
+
+	bx::quickSort(&regions[0], uint32_t(regions.size() ), sizeof(RegionUse), compareRegionUse);
+
+	const uint16_t num = uint16_t(bx::min<size_t>(_max, regions.size() ) );
+	for (uint16_t ii = 0; ii < num; ++ii)
 	{
-		const bgfx::Memory* mem = bgfx::alloc(size);
-		bx::memSet(mem->data, 0, mem->size);
-		if (_region.getType() == AtlasRegion::TYPE_BGRA8)
+		_outRegionHandles[ii] = regions[ii].handle;
+	}
+
+	return num;
+}
+
+bool Atlas::compact()
+{
+	BX_CHECK(NULL != m_layers, "Static atlas can't be compacted.");
+
+	// Regions are repacked tallest first, which keeps the skyline flat, into fresh packers, so
+	// that atlas is left untouched if they don't fit.
+	std::vector<RegionHeight> order;
+	order.reserve(m_regionCount);
+
+	for (uint16_t ii = 0; ii < m_regionCount; ++ii)
+	{
+		if (m_regionInfo[ii].used)
 		{
-			const uint8_t* inLineBuffer = _bitmapBuffer;
-			uint8_t* outLineBuffer = m_textureBuffer + _region.getFaceIndex() * (m_textureSize * m_textureSize * 4) + ( ( (_region.y * m_textureSize) + _region.x) * 4);
+			RegionHeight rh = { uint16_t(m_regions[ii].height + m_regionInfo[ii].outline * 2), ii };
+			order.push_back(rh);
+		}
+	}
+
+	if (!order.empty() )
+	{
+		bx::quickSort(&order[0], uint32_t(order.size() ), sizeof(RegionHeight), compareRegionHeight);
+	}
+
+	PackedLayer* layers = new PackedLayer[24];
+	for (uint32_t ii = 0; ii < 24; ++ii)
+	{
+		layers[ii].packer.init(m_textureSize, m_textureSize);
+		layers[ii].faceRegion = m_layers[ii].faceRegion;
+	}
 
-			for (int yy = 0; yy < _region.height; ++yy)
+	std::vector<AtlasRegion> packed(order.size() );
+
+	for (uint32_t ii = 0, num = uint32_t(order.size() ); ii < num; ++ii)
+	{
+		const uint16_t handle = order[ii].handle;
+		const RegionInfo& info = m_regionInfo[handle];
+		const AtlasRegion& region = m_regions[handle];
+
+		AtlasRegion& dst = packed[ii];
+		dst.width = region.width + info.outline * 2;
+		dst.height = region.height + info.outline * 2;
+		dst.mask = region.mask;
+
+		if (!layers[info.layer].packer.addRectangle(dst.width + 1, dst.height + 1, dst.x, dst.y) )
+		{
+			delete [] layers;
+			return false;
+		}
+	}
+
+	// Gray regions own single channel of texels shared with other layers of the same face, so
+	// texels are moved on CPU, and used faces are uploaded again.
+	const uint32_t faceSize = m_textureSize * m_textureSize * 4;
+	uint8_t* textureBuffer = new uint8_t[getTextureBufferSize()];
+	bx::memSet(textureBuffer, 0, getTextureBufferSize() );
+
+	for (uint32_t ii = 0, num = uint32_t(order.size() ); ii < num; ++ii)
+	{
+		const uint16_t handle = order[ii].handle;
+		const RegionInfo& info = m_regionInfo[handle];
+		AtlasRegion& region = m_regions[handle];
+		const AtlasRegion& dst = packed[ii];
+
+		const uint8_t* inLineBuffer = m_textureBuffer + region.getFaceIndex() * faceSize + ( ( (region.y - info.outline) * m_textureSize) + region.x - info.outline) * 4;
+		uint8_t* outLineBuffer = textureBuffer + dst.getFaceIndex() * faceSize + ( (dst.y * m_textureSize) + dst.x) * 4;
+
+		if (region.getType() == AtlasRegion::TYPE_BGRA8)
+		{
+			for (int yy = 0; yy < dst.height; ++yy)
 			{
-				bx::memCopy(outLineBuffer, inLineBuffer, _region.width * 4);
-				inLineBuffer += _region.width * 4;
+				bx::memCopy(outLineBuffer, inLineBuffer, dst.width * 4);
+				inLineBuffer += m_textureSize * 4;
 				outLineBuffer += m_textureSize * 4;
 			}
-
-			bx::memCopy(mem->data, _bitmapBuffer, mem->size);
 		}
 		else
 		{
-			uint32_t layer = _region.getComponentIndex();
-			const uint8_t* inLineBuffer = _bitmapBuffer;
-			uint8_t* outLineBuffer = (m_textureBuffer + _region.getFaceIndex() * (m_textureSize * m_textureSize * 4) + ( ( (_region.y * m_textureSize) + _region.x) * 4) );
+			uint32_t layer = region.getComponentIndex();
 
-			for (int yy = 0; yy < _region.height; ++yy)
+			for (int yy = 0; yy < dst.height; ++yy)
 			{
-				for (int xx = 0; xx < _region.width; ++xx)
+				for (int xx = 0; xx < dst.width; ++xx)
 				{
-					outLineBuffer[(xx * 4) + layer] = inLineBuffer[xx];
+					outLineBuffer[(xx * 4) + layer] = inLineBuffer[(xx * 4) + layer];
 				}
 
-				bx::memCopy(mem->data + yy * _region.width * 4, outLineBuffer, _region.width * 4);
-				inLineBuffer += _region.width;
+				inLineBuffer += m_textureSize * 4;
 				outLineBuffer += m_textureSize * 4;
 			}
 		}
 
-		bgfx::updateTextureCube(m_textureHandle, 0, (uint8_t)_region.getFaceIndex(), 0, _region.x, _region.y, _region.width, _region.height, mem);
+		region.x = dst.x + info.outline;
+		region.y = dst.y + info.outline;
+	}
+
+	delete [] m_textureBuffer;
+	m_textureBuffer = textureBuffer;
+
+	delete [] m_layers;
+	m_layers = layers;
+
+	std::vector<AtlasRegion>& dirty = m_dirty->regions;
+	dirty.clear();
+
+	for (uint32_t ii = 0; ii < m_usedFaces; ++ii)
+	{
+		AtlasRegion face;
+		face.x = 0;
+		face.y = 0;
+		face.width = m_textureSize;
+		face.height = m_textureSize;
+		face.setMask(AtlasRegion::TYPE_BGRA8, ii, 0);
+		dirty.push_back(face);
 	}
+
+	return true;
+}
+
+void Atlas::updateRegion(const AtlasRegion& _region, const uint8_t* _bitmapBuffer)
+{
+	if (0 == _region.width * _region.height)
+	{
+		return;
+	}
+
+	uint8_t* outLineBuffer = m_textureBuffer + _region.getFaceIndex() * (m_textureSize * m_textureSize * 4) + ( ( (_region.y * m_textureSize) + _region.x) * 4);
+	const uint8_t* inLineBuffer = _bitmapBuffer;
+
+	if (_region.getType() == AtlasRegion::TYPE_BGRA8)
+	{
+		for (int yy = 0; yy < _region.height; ++yy)
+		{
+			bx::memCopy(outLineBuffer, inLineBuffer, _region.width * 4);
+			inLineBuffer += _region.width * 4;
+			outLineBuffer += m_textureSize * 4;
+		}
+	}
+	else
+	{
+		uint32_t layer = _region.getComponentIndex();
+
+		for (int yy = 0; yy < _region.height; ++yy)
+		{
+			for (int xx = 0; xx < _region.width; ++xx)
+			{
+				outLineBuffer[(xx * 4) + layer] = inLineBuffer[xx];
+			}
+
+			inLineBuffer += _region.width;
+			outLineBuffer += m_textureSize * 4;
+		}
+	}
+
+	m_dirty->regions.push_back(_region);
+}
+
+void Atlas::flush()
+{
+	std::vector<AtlasRegion>& dirty = m_dirty->regions;
+	if (dirty.empty() )
+	{
+		return;
+	}
+
+	m_stats.numRegions = uint32_t(dirty.size() );
+	m_stats.numUploads = 0;
+	m_stats.uploadSize = 0;
+
+	bool merged = true;
+	while (merged)
+	{
+		merged = false;
+
+		for (uint32_t ii = 0; ii < dirty.size(); ++ii)
+		{
+			for (uint32_t jj = ii + 1; jj < dirty.size();)
+			{
+				if (mergeRegion(dirty[ii], dirty[jj]) )
+				{
+					dirty.erase(dirty.begin() + jj);
+					merged = true;
+				}
+				else
+				{
+					++jj;
+				}
+			}
+		}
+	}
+
+	for (uint32_t ii = 0, num = uint32_t(dirty.size() ); ii < num; ++ii)
+	{
+		const AtlasRegion& region = dirty[ii];
+		const uint32_t pitch = region.width * 4;
+
+		const bgfx::Memory* mem = bgfx::alloc(pitch * region.height);
+		const uint8_t* inLineBuffer = m_textureBuffer + region.getFaceIndex() * (m_textureSize * m_textureSize * 4) + ( ( (region.y * m_textureSize) + region.x) * 4);
+
+		for (int yy = 0; yy < region.height; ++yy)
+		{
+			bx::memCopy(mem->data + yy * pitch, inLineBuffer, pitch);
+			inLineBuffer += m_textureSize * 4;
+		}
+
+		bgfx::updateTextureCube(m_textureHandle, 0, (uint8_t)region.getFaceIndex(), 0, region.x, region.y, region.width, region.height, mem);
+
+		m_stats.numUploads++;
+		m_stats.uploadSize += mem->size;
+	}
+
+	dirty.clear();
 }
 
 void Atlas::packFaceLayerUV(uint32_t _idx, uint8_t* _vertexBuffer, uint32_t _offset, uint32_t _stride) const
@@ -453,6 +778,10 @@ void Atlas::packFaceLayerUV(uint32_t _idx, uint8_t* _vertexBuffer, uint32_t _off
 
 void Atlas::packUV(uint16_t _regionHandle, uint8_t* _vertexBuffer, uint32_t _offset, uint32_t _stride) const
 {
+	BX_CHECK(_regionHandle < m_regionCount, "Invalid region handle %d.", _regionHandle);
+
+	m_regionInfo[_regionHandle].lastUsed = ++m_useCounter;
+
 	const AtlasRegion& region = m_regions[_regionHandle];
 	packUV(region, _vertexBuffer, _offset, _stride);
 }
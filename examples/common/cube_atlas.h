@@ -50,6 +50,14 @@ struct AtlasRegion
 	}
 };
 
+/// texture upload statistics of the last Atlas::flush that had dirty regions
+struct AtlasStats
+{
+	uint32_t numRegions; //!< regions updated since previous flush
+	uint32_t numUploads; //!< texture updates issued, after merging dirty regions
+	uint32_t uploadSize; //!< uploaded size in bytes
+};
+
 class Atlas
 {
 public:
@@ -68,11 +76,50 @@ public:
 	~Atlas();
 
 	/// add a region to the atlas, and copy the content of mem to the underlying texture
+	/// @remark texture is updated on next flush
+	/// @return UINT16_MAX if the atlas is full, space of removed regions is only reclaimed by compact
 	uint16_t addRegion(uint16_t _width, uint16_t _height, const uint8_t* _bitmapBuffer, AtlasRegion::Type _type = AtlasRegion::TYPE_BGRA8, uint16_t outline = 0);
 
+	/// remove a region from the atlas, its handle can be reused by following addRegion
+	/// @remark region generation is incremented, see getRegionGeneration.
+	void removeRegion(uint16_t _regionHandle);
+
+	/// retrieve the number of times a region handle was removed. Handle stored together with its
+	/// generation refers to the same region only while the generation doesn't change.
+	uint16_t getRegionGeneration(uint16_t _regionHandle) const
+	{
+		return m_regionInfo[_regionHandle].generation;
+	}
+
+	/// repack the remaining regions of every layer, to reclaim the space of removed regions.
+	/// Region handles stay valid, but their position changes, so UVs packed before must be packed again.
+	/// @return false if regions couldn't be repacked, atlas is left unchanged in that case
+	bool compact();
+
+	/// retrieve up to _max region handles, ordered from least to most recently packed with packUV
+	/// or marked with markUsed
+	/// @return number of handles written
+	uint16_t getLeastRecentlyUsed(uint16_t* _outRegionHandles, uint16_t _max) const;
+
+	/// mark regions as used, so that regions drawn from previously packed UVs are not the
+	/// first ones returned by getLeastRecentlyUsed. UINT16_MAX handles are skipped.
+	void markUsed(const uint16_t* _regionHandles, uint32_t _num) const;
+
 	/// update a preallocated region
+	/// @remark region is copied to the mirrored texture buffer and marked dirty, texture is updated on next flush
 	void updateRegion(const AtlasRegion& _region, const uint8_t* _bitmapBuffer);
 
+	/// upload dirty regions to the texture. Nearby dirty regions of the same face are merged,
+	/// so that regions added during a frame are uploaded with few texture updates. Must be
+	/// called before the texture is used, usually once per frame.
+	void flush();
+
+	/// retrieve texture upload statistics of the last flush that had dirty regions
+	const AtlasStats& getStats() const
+	{
+		return m_stats;
+	}
+
 	/// Pack the UV coordinates of the four corners of a region to a vertex buffer using the supplied vertex format.
 	/// v0 -- v3
 	/// |     |     encoded in that order:  v0,v1,v2,v3
@@ -83,6 +130,7 @@ public:
 	/// @param vertexBuffer address of the first vertex we want to update. Must be valid up to vertexBuffer + offset + 3*stride + 4*sizeof(int16_t), which means the buffer must contains at least 4 vertex includind the first.
 	/// @param offset byte offset to the first uv coordinate of the vertex in the buffer
 	/// @param stride stride between tho UV coordinates, usually size of a Vertex.
+	/// @remark packing by handle marks the region as used, see getLeastRecentlyUsed.
 	void packUV(uint16_t _regionHandle, uint8_t* _vertexBuffer, uint32_t _offset, uint32_t _stride) const;
 	void packUV(const AtlasRegion& _region, uint8_t* _vertexBuffer, uint32_t _offset, uint32_t _stride) const;
 
@@ -116,6 +164,12 @@ public:
 		return m_regionCount;
 	}
 
+	/// retrieve the maximum numbers of region in the atlas
+	uint16_t getMaxRegionCount() const
+	{
+		return m_maxRegionCount;
+	}
+
 	/// retrieve a pointer to the region buffer (in order to serialize it)
 	const AtlasRegion* getRegionBuffer() const
 	{
@@ -139,6 +193,23 @@ private:
 
 	struct PackedLayer;
 	PackedLayer* m_layers;
+	struct DirtyRegions;
+	DirtyRegions* m_dirty;
+
+	struct RegionInfo
+	{
+		uint32_t lastUsed;
+		uint16_t layer;
+		uint16_t outline;
+		uint16_t generation;
+		bool used;
+	};
+
+	RegionInfo* m_regionInfo;
+	uint16_t* m_freeRegions;
+	uint16_t m_numFreeRegions;
+	mutable uint32_t m_useCounter;
+	AtlasStats m_stats;
 	AtlasRegion* m_regions;
 	uint8_t* m_textureBuffer;
 
@@ -9,6 +9,7 @@
 #include "../bgfx_utils.h"
 #include "../packrect.h"
 
+#include <bx/cpu.h>
 #include <bx/mutex.h>
 #include <bx/math.h>
 #include <bx/sort.h>
@@ -149,6 +150,13 @@ static const uint16_t s_cubeIndices[36] =
 	6, 3, 7,
 };
 
+static const uint16_t s_cubeLineIndices[24] =
+{
+	0, 1, 1, 3, 3, 2, 2, 0,
+	4, 5, 5, 7, 7, 6, 6, 4,
+	0, 4, 1, 5, 2, 6, 3, 7,
+};
+
 static const uint8_t s_circleLod[] =
 {
 	37,
@@ -333,6 +341,10 @@ bx::Vec3 getPoint(Axis::Enum _axis, float _x, float _y)
 #include "fs_debugdraw_fill_lit.bin.h"
 #include "vs_debugdraw_fill_texture.bin.h"
 #include "fs_debugdraw_fill_texture.bin.h"
+#include "vs_debugdraw_instance.bin.h"
+#include "fs_debugdraw_instance.bin.h"
+#include "vs_debugdraw_instance_lit.bin.h"
+#include "fs_debugdraw_instance_lit.bin.h"
 
 static const bgfx::EmbeddedShader s_embeddedShaders[] =
 {
@@ -348,12 +360,76 @@ static const bgfx::EmbeddedShader s_embeddedShaders[] =
 	BGFX_EMBEDDED_SHADER(fs_debugdraw_fill_lit),
 	BGFX_EMBEDDED_SHADER(vs_debugdraw_fill_texture),
 	BGFX_EMBEDDED_SHADER(fs_debugdraw_fill_texture),
+	BGFX_EMBEDDED_SHADER(vs_debugdraw_instance),
+	BGFX_EMBEDDED_SHADER(fs_debugdraw_instance),
+	BGFX_EMBEDDED_SHADER(vs_debugdraw_instance_lit),
+	BGFX_EMBEDDED_SHADER(fs_debugdraw_instance_lit),
 
 	BGFX_EMBEDDED_SHADER_END()
 };
 
 #define SPRITE_TEXTURE_SIZE 1024
 
+/// Lock-free handle allocator. Free handles are kept in LIFO list, and list head is tagged with
+/// counter incremented on every change, so that compare-and-swap fails if handle was popped and
+/// pushed back in the meantime.
+template<uint16_t MaxHandlesT>
+struct HandleAllocLockFreeT
+{
+	BX_STATIC_ASSERT(MaxHandlesT < bx::kInvalidHandle, "Handle count must fit below invalid handle.");
+
+	HandleAllocLockFreeT()
+	{
+		for (uint16_t ii = 0; ii < MaxHandlesT; ++ii)
+		{
+			m_next[ii] = ii+1;
+		}
+
+		m_next[MaxHandlesT-1] = bx::kInvalidHandle;
+		m_head = 0;
+	}
+
+	uint16_t alloc()
+	{
+		for (;;)
+		{
+			const uint32_t head = m_head;
+			const uint16_t idx  = uint16_t(head);
+
+			if (bx::kInvalidHandle == idx)
+			{
+				return bx::kInvalidHandle;
+			}
+
+			const uint32_t next = ( (head + 0x10000) & 0xffff0000) | m_next[idx];
+			if (head == bx::atomicCompareAndSwap<uint32_t>(&m_head, head, next) )
+			{
+				return idx;
+			}
+		}
+	}
+
+	void free(uint16_t _handle)
+	{
+		BX_CHECK(_handle < MaxHandlesT, "Invalid handle %d.", _handle);
+
+		for (;;)
+		{
+			const uint32_t head = m_head;
+			m_next[_handle] = uint16_t(head);
+
+			const uint32_t next = ( (head + 0x10000) & 0xffff0000) | _handle;
+			if (head == bx::atomicCompareAndSwap<uint32_t>(&m_head, head, next) )
+			{
+				return;
+			}
+		}
+	}
+
+	volatile uint32_t m_head; //!< Tag in high 16 bits, first free handle in low 16 bits.
+	volatile uint16_t m_next[MaxHandlesT];
+};
+
 template<uint16_t MaxHandlesT = 256, uint16_t TextureSizeT = 1024>
 struct SpriteT
 {
@@ -364,25 +440,21 @@ struct SpriteT
 
 	SpriteHandle create(uint16_t _width, uint16_t _height)
 	{
-		bx::MutexScope lock(m_lock);
-
-		SpriteHandle handle = { bx::kInvalidHandle };
+		SpriteHandle handle = { m_handleAlloc.alloc() };
 
-		if (m_handleAlloc.getNumHandles() < m_handleAlloc.getMaxHandles() )
+		if (isValid(handle) )
 		{
-			Pack2D pack;
-			if (m_ra.find(_width, _height, pack) )
+			// Only rectangle packer is shared, handle is already owned by this thread.
+			bool found;
 			{
-				handle.idx = m_handleAlloc.alloc();
+				bx::MutexScope lock(m_lock);
+				found = m_ra.find(_width, _height, m_pack[handle.idx]);
+			}
 
-				if (isValid(handle) )
-				{
-					m_pack[handle.idx] = pack;
-				}
-				else
-				{
-					m_ra.clear(pack);
-				}
+			if (!found)
+			{
+				m_handleAlloc.free(handle.idx);
+				handle.idx = bx::kInvalidHandle;
 			}
 		}
 
@@ -391,8 +463,11 @@ struct SpriteT
 
 	void destroy(SpriteHandle _sprite)
 	{
-		const Pack2D& pack = m_pack[_sprite.idx];
-		m_ra.clear(pack);
+		{
+			bx::MutexScope lock(m_lock);
+			m_ra.clear(m_pack[_sprite.idx]);
+		}
+
 		m_handleAlloc.free(_sprite.idx);
 	}
 
@@ -401,10 +476,10 @@ struct SpriteT
 		return m_pack[_sprite.idx];
 	}
 
-	bx::Mutex                     m_lock;
-	bx::HandleAllocT<MaxHandlesT> m_handleAlloc;
-	Pack2D                        m_pack[MaxHandlesT];
-	RectPack2DT<256>              m_ra;
+	bx::Mutex                             m_lock; //!< Guards rectangle packer.
+	HandleAllocLockFreeT<MaxHandlesT>     m_handleAlloc;
+	Pack2D                                m_pack[MaxHandlesT];
+	RectPack2DT<256>                      m_ra;
 };
 
 template<uint16_t MaxHandlesT = DEBUG_DRAW_CONFIG_MAX_GEOMETRY>
@@ -418,11 +493,7 @@ struct GeometryT
 	{
 		BX_UNUSED(_numVertices, _vertices, _numIndices, _indices, _index32);
 
-		GeometryHandle handle;
-		{
-			bx::MutexScope lock(m_lock);
-			handle = { m_handleAlloc.alloc() };
-		}
+		GeometryHandle handle = { m_handleAlloc.alloc() };
 
 		if (isValid(handle) )
 		{
@@ -472,7 +543,6 @@ struct GeometryT
 
 	void destroy(GeometryHandle _handle)
 	{
-		bx::MutexScope lock(m_lock);
 		Geometry& geometry = m_geometry[_handle.idx];
 		bgfx::destroy(geometry.m_vbh);
 		bgfx::destroy(geometry.m_ibh);
@@ -495,8 +565,7 @@ struct GeometryT
 		uint32_t m_topologyNumIndices[2];
 	};
 
-	bx::Mutex m_lock;
-	bx::HandleAllocT<MaxHandlesT> m_handleAlloc;
+	HandleAllocLockFreeT<MaxHandlesT> m_handleAlloc;
 	Geometry m_geometry[MaxHandlesT];
 };
 
@@ -636,6 +705,25 @@ struct DebugDrawShared
 			, true
 			);
 
+		// Shapes are drawn as instanced unit meshes when instancing is supported.
+		m_instanceProgram[0] = BGFX_INVALID_HANDLE;
+		m_instanceProgram[1] = BGFX_INVALID_HANDLE;
+
+		if (0 != (bgfx::getCaps()->supported & BGFX_CAPS_INSTANCING) )
+		{
+			m_instanceProgram[0] = bgfx::createProgram(
+				  bgfx::createEmbeddedShader(s_embeddedShaders, type, "vs_debugdraw_instance")
+				, bgfx::createEmbeddedShader(s_embeddedShaders, type, "fs_debugdraw_instance")
+				, true
+				);
+
+			m_instanceProgram[1] = bgfx::createProgram(
+				  bgfx::createEmbeddedShader(s_embeddedShaders, type, "vs_debugdraw_instance_lit")
+				, bgfx::createEmbeddedShader(s_embeddedShaders, type, "fs_debugdraw_instance_lit")
+				, true
+				);
+		}
+
 		u_params   = bgfx::createUniform("u_params",   bgfx::UniformType::Vec4, 4);
 		s_texColor = bgfx::createUniform("s_texColor", bgfx::UniformType::Sampler);
 		m_texture  = bgfx::createTexture2D(SPRITE_TEXTURE_SIZE, SPRITE_TEXTURE_SIZE, false, 1, bgfx::TextureFormat::BGRA8);
@@ -913,10 +1001,10 @@ struct DebugDrawShared
 		m_mesh[DebugMesh::Cube].m_numVertices = BX_COUNTOF(s_cubeVertices);
 		m_mesh[DebugMesh::Cube].m_startIndex[0] = startIndex;
 		m_mesh[DebugMesh::Cube].m_numIndices[0] = BX_COUNTOF(s_cubeIndices);
-		m_mesh[DebugMesh::Cube].m_startIndex[1] = 0;
-		m_mesh[DebugMesh::Cube].m_numIndices[1] = 0;
+		m_mesh[DebugMesh::Cube].m_startIndex[1] = startIndex+BX_COUNTOF(s_cubeIndices);
+		m_mesh[DebugMesh::Cube].m_numIndices[1] = BX_COUNTOF(s_cubeLineIndices);
 		startVertex += m_mesh[DebugMesh::Cube].m_numVertices;
-		startIndex  += m_mesh[DebugMesh::Cube].m_numIndices[0];
+		startIndex  += m_mesh[DebugMesh::Cube].m_numIndices[0] + m_mesh[DebugMesh::Cube].m_numIndices[1];
 
 		const bgfx::Memory* vb = bgfx::alloc(startVertex*stride);
 		const bgfx::Memory* ib = bgfx::alloc(startIndex*sizeof(uint16_t) );
@@ -958,6 +1046,11 @@ struct DebugDrawShared
 			, sizeof(s_cubeIndices)
 			);
 
+		bx::memCopy(&ib->data[m_mesh[DebugMesh::Cube].m_startIndex[1] * sizeof(uint16_t)]
+			, s_cubeLineIndices
+			, sizeof(s_cubeLineIndices)
+			);
+
 		m_vbh = bgfx::createVertexBuffer(vb, DebugShapeVertex::ms_layout);
 		m_ibh = bgfx::createIndexBuffer(ib);
 	}
@@ -970,6 +1063,13 @@ struct DebugDrawShared
 		{
 			bgfx::destroy(m_program[ii]);
 		}
+		for (uint32_t ii = 0; ii < BX_COUNTOF(m_instanceProgram); ++ii)
+		{
+			if (bgfx::isValid(m_instanceProgram[ii]) )
+			{
+				bgfx::destroy(m_instanceProgram[ii]);
+			}
+		}
 		bgfx::destroy(u_params);
 		bgfx::destroy(s_texColor);
 		bgfx::destroy(m_texture);
@@ -1022,6 +1122,7 @@ struct DebugDrawShared
 	bgfx::UniformHandle s_texColor;
 	bgfx::TextureHandle m_texture;
 	bgfx::ProgramHandle m_program[Program::Count];
+	bgfx::ProgramHandle m_instanceProgram[2]; //!< Fill and lit fill, invalid without instancing.
 	bgfx::UniformHandle u_params;
 
 	bgfx::VertexBufferHandle m_vbh;
@@ -1035,25 +1136,39 @@ struct DebugDrawEncoderImpl
 	DebugDrawEncoderImpl()
 		: m_depthTestLess(true)
 		, m_state(State::Count)
-		, m_defaultEncoder(NULL)
+		, m_instanceCache(NULL)
 	{
 	}
 
-	void init(bgfx::Encoder* _encoder)
+	void init()
 	{
-		m_defaultEncoder = _encoder;
+		m_state          = State::Count;
+		m_encoder        = NULL;
+		m_ownEncoder     = false;
+		m_instanceCache  = NULL;
+		m_numInstanceBatches = 0;
 	}
 
 	void shutdown()
 	{
+		if (NULL != m_instanceCache)
+		{
+			BX_FREE(s_dds.m_allocator, m_instanceCache);
+			m_instanceCache = NULL;
+		}
 	}
 
 	void begin(bgfx::ViewId _viewId, bool _depthTestLess, bgfx::Encoder* _encoder)
 	{
 		BX_CHECK(State::Count == m_state);
 
+		// Without encoder, bgfx::begin returns main encoder on API thread, and dedicated encoder
+		// on any other thread, so encoders on different threads never share bgfx encoder.
+		m_ownEncoder    = NULL == _encoder;
+		m_encoder       = m_ownEncoder ? bgfx::begin() : _encoder;
+		BX_CHECK(NULL != m_encoder, "Failed to obtain bgfx encoder, increase BGFX_CONFIG_MAX_ENCODERS.");
+
 		m_viewId        = _viewId;
-		m_encoder       = _encoder == NULL ? m_defaultEncoder : _encoder;
 		m_state         = State::None;
 		m_stack         = 0;
 		m_depthTestLess = _depthTestLess;
@@ -1063,6 +1178,8 @@ struct DebugDrawEncoderImpl
 		m_vertexPos = 0;
 		m_posQuad   = 0;
 
+		m_numInstanceBatches = 0;
+
 		Attrib& attrib = m_attrib[0];
 		attrib.m_state = 0
 			| BGFX_STATE_WRITE_RGB
@@ -1088,6 +1205,12 @@ struct DebugDrawEncoderImpl
 
 		flushQuad();
 		flush();
+		flushInstances();
+
+		if (m_ownEncoder)
+		{
+			bgfx::end(m_encoder);
+		}
 
 		m_encoder = NULL;
 		m_state   = State::Count;
@@ -1301,6 +1424,9 @@ struct DebugDrawEncoderImpl
 
 		softFlush();
 
+		// Shapes drawn before this line are submitted first, so they are not drawn after it.
+		flushInstances();
+
 		m_state = State::MoveTo;
 
 		DebugVertex& vertex = m_cache[m_pos];
@@ -1335,6 +1461,8 @@ struct DebugDrawEncoderImpl
 			return;
 		}
 
+		flushInstances();
+
 		if (m_pos+2 > uint16_t(BX_COUNTOF(m_cache) ) )
 		{
 			uint32_t pos = m_pos;
@@ -1402,7 +1530,8 @@ struct DebugDrawEncoderImpl
 	void draw(const Aabb& _aabb)
 	{
 		const Attrib& attrib = m_attrib[m_stack];
-		if (attrib.m_wireframe)
+		if (attrib.m_wireframe
+		&&  !isInstanced(attrib) )
 		{
 			moveTo(_aabb.min.x, _aabb.min.y, _aabb.min.z);
 			lineTo(_aabb.max.x, _aabb.min.y, _aabb.min.z);
@@ -1432,7 +1561,7 @@ struct DebugDrawEncoderImpl
 		{
 			Obb obb;
 			toObb(obb, _aabb);
-			draw(DebugMesh::Cube, obb.mtx, 1, false);
+			draw(DebugMesh::Cube, obb.mtx, 1, attrib.m_wireframe);
 		}
 	}
 
@@ -1449,7 +1578,8 @@ struct DebugDrawEncoderImpl
 	void draw(const Obb& _obb)
 	{
 		const Attrib& attrib = m_attrib[m_stack];
-		if (attrib.m_wireframe)
+		if (attrib.m_wireframe
+		&&  !isInstanced(attrib) )
 		{
 			pushTransform(_obb.mtx, 1);
 
@@ -1481,7 +1611,7 @@ struct DebugDrawEncoderImpl
 		}
 		else
 		{
-			draw(DebugMesh::Cube, _obb.mtx, 1, false);
+			draw(DebugMesh::Cube, _obb.mtx, 1, attrib.m_wireframe);
 		}
 	}
 
@@ -1530,11 +1660,22 @@ struct DebugDrawEncoderImpl
 		}
 	}
 
-	void setUParams(const Attrib& _attrib, bool _wireframe)
+	uint64_t getMeshState(const Attrib& _attrib, bool _wireframe) const
 	{
-		const float flip = 0 == (_attrib.m_state & BGFX_STATE_CULL_CCW) ? 1.0f : -1.0f;
 		const uint8_t alpha = _attrib.m_abgr >> 24;
 
+		return 0
+			| _attrib.m_state
+			| (_wireframe ? BGFX_STATE_PT_LINES | BGFX_STATE_LINEAA | BGFX_STATE_BLEND_ALPHA
+			: (alpha < 0xff) ? BGFX_STATE_BLEND_ALPHA : 0)
+			;
+	}
+
+	void setUParams(uint64_t _state, uint32_t _abgr)
+	{
+		const float flip = 0 == (_state & BGFX_STATE_CULL_CCW) ? 1.0f : -1.0f;
+		const uint8_t alpha = _abgr >> 24;
+
 		float params[4][4] =
 		{
 			{ // lightDir
@@ -1556,25 +1697,27 @@ struct DebugDrawEncoderImpl
 				0.0f, // unused
 			},
 			{ // matColor
-				( (_attrib.m_abgr)       & 0xff) / 255.0f,
-				( (_attrib.m_abgr >> 8)  & 0xff) / 255.0f,
-				( (_attrib.m_abgr >> 16) & 0xff) / 255.0f,
+				( (_abgr)       & 0xff) / 255.0f,
+				( (_abgr >> 8)  & 0xff) / 255.0f,
+				( (_abgr >> 16) & 0xff) / 255.0f,
 				(alpha) / 255.0f,
 			},
 		};
 
 		bx::store(params[0], bx::normalize(bx::load<bx::Vec3>(params[0]) ) );
 		m_encoder->setUniform(s_dds.u_params, params, 4);
+	}
 
-		m_encoder->setState(0
-			| _attrib.m_state
-			| (_wireframe ? BGFX_STATE_PT_LINES | BGFX_STATE_LINEAA | BGFX_STATE_BLEND_ALPHA
-			: (alpha < 0xff) ? BGFX_STATE_BLEND_ALPHA : 0)
-			);
+	void setUParams(const Attrib& _attrib, bool _wireframe)
+	{
+		setUParams(_attrib.m_state, _attrib.m_abgr);
+		m_encoder->setState(getMeshState(_attrib, _wireframe) );
 	}
 
 	void draw(GeometryHandle _handle)
 	{
+		flushInstances();
+
 		const Geometry::Geometry& geometry = s_dds.m_geometry.m_geometry[_handle.idx];
 		m_encoder->setVertexBuffer(0, geometry.m_vbh);
 
@@ -1608,51 +1751,68 @@ struct DebugDrawEncoderImpl
 	{
 		flush();
 
-		if (_numVertices == bgfx::getAvailTransientVertexBuffer(_numVertices, DebugMeshVertex::ms_layout) )
+		const Attrib& attrib = m_attrib[m_stack];
+		const bool wireframe = _lineList || attrib.m_wireframe;
+		const bool convert   = !_lineList && wireframe && 0 < _numIndices;
+
+		// Vertices are always drawn indexed, so that both buffers can be allocated with single
+		// call, which is safe when other threads allocate transient memory too.
+		uint32_t numIndices = _numIndices;
+		if (convert)
 		{
-			bgfx::TransientVertexBuffer tvb;
-			bgfx::allocTransientVertexBuffer(&tvb, _numVertices, DebugMeshVertex::ms_layout);
-			bx::memCopy(tvb.data, _vertices, _numVertices * DebugMeshVertex::ms_layout.m_stride);
-			m_encoder->setVertexBuffer(0, &tvb);
+			numIndices = bgfx::topologyConvert(
+				  bgfx::TopologyConvert::TriListToLineList
+				, NULL
+				, 0
+				, _indices
+				, _numIndices
+				, false
+				);
+		}
+		else if (0 == _numIndices)
+		{
+			BX_WARN(UINT16_MAX >= _numVertices, "Non-indexed draw is limited to %d vertices.", UINT16_MAX+1);
+			if (UINT16_MAX < _numVertices)
+			{
+				return;
+			}
 
-			const Attrib& attrib = m_attrib[m_stack];
-			const bool wireframe = _lineList || attrib.m_wireframe;
-			setUParams(attrib, wireframe);
+			numIndices = _numVertices;
+		}
+
+		bgfx::TransientVertexBuffer tvb;
+		bgfx::TransientIndexBuffer tib;
+		if (bgfx::allocTransientBuffers(&tvb, DebugMeshVertex::ms_layout, _numVertices, &tib, numIndices) )
+		{
+			bx::memCopy(tvb.data, _vertices, _numVertices * DebugMeshVertex::ms_layout.m_stride);
 
-			if (0 < _numIndices)
+			uint16_t* indices = (uint16_t*)tib.data;
+			if (convert)
 			{
-				uint32_t numIndices = _numIndices;
-				bgfx::TransientIndexBuffer tib;
-				if (!_lineList && wireframe)
-				{
-					numIndices = bgfx::topologyConvert(
-						  bgfx::TopologyConvert::TriListToLineList
-						, NULL
-						, 0
-						, _indices
-						, _numIndices
-						, false
-						);
-
-					bgfx::allocTransientIndexBuffer(&tib, numIndices);
-					bgfx::topologyConvert(
-						  bgfx::TopologyConvert::TriListToLineList
-						, tib.data
-						, numIndices * sizeof(uint16_t)
-						, _indices
-						, _numIndices
-						, false
-					);
-				}
-				else
+				bgfx::topologyConvert(
+					  bgfx::TopologyConvert::TriListToLineList
+					, indices
+					, numIndices * sizeof(uint16_t)
+					, _indices
+					, _numIndices
+					, false
+				);
+			}
+			else if (0 == _numIndices)
+			{
+				for (uint32_t ii = 0; ii < numIndices; ++ii)
 				{
-					bgfx::allocTransientIndexBuffer(&tib, numIndices);
-					bx::memCopy(tib.data, _indices, numIndices * sizeof(uint16_t) );
+					indices[ii] = uint16_t(ii);
 				}
-
-				m_encoder->setIndexBuffer(&tib);
+			}
+			else
+			{
+				bx::memCopy(indices, _indices, numIndices * sizeof(uint16_t) );
 			}
 
+			setUParams(attrib, wireframe);
+			m_encoder->setVertexBuffer(0, &tvb);
+			m_encoder->setIndexBuffer(&tib);
 			m_encoder->setTransform(m_mtxStack[m_mtxStackCurrent].mtx);
 			bgfx::ProgramHandle program = s_dds.m_program[wireframe
 				? Program::FillMesh
@@ -1872,6 +2032,8 @@ struct DebugDrawEncoderImpl
 			flushQuad();
 		}
 
+		flushInstances();
+
 		const Attrib& attrib = m_attrib[m_stack];
 
 		bx::Vec3 udir, vdir;
@@ -2125,8 +2287,22 @@ struct DebugDrawEncoderImpl
 		pop();
 	}
 
+	bool isInstanced(const Attrib& _attrib) const
+	{
+		// Instanced wireframe is drawn with mesh shader, which doesn't support stipple.
+		return bgfx::isValid(s_dds.m_instanceProgram[0])
+			&& !_attrib.m_stipple
+			;
+	}
+
 	void draw(DebugMesh::Enum _mesh, const float* _mtx, uint16_t _num, bool _wireframe)
 	{
+		if (bgfx::isValid(s_dds.m_instanceProgram[0]) )
+		{
+			drawInstance(_mesh, _mtx, _num, _wireframe);
+			return;
+		}
+
 		pushTransform(_mtx, _num, false /* flush */);
 
 		const DebugMesh& mesh = s_dds.m_mesh[_mesh];
@@ -2151,6 +2327,123 @@ struct DebugDrawEncoderImpl
 		popTransform(false /* flush */);
 	}
 
+	void drawInstance(DebugMesh::Enum _mesh, const float* _mtx, uint16_t _num, bool _wireframe)
+	{
+		BX_CHECK(1 == _num || 2 == _num, "Mesh instance can have only 1 or 2 transforms (num %d).", _num);
+
+		const Attrib& attrib = m_attrib[m_stack];
+		const uint64_t state = getMeshState(attrib, _wireframe);
+
+		InstanceBatch* batch = NULL;
+		for (uint32_t ii = 0; ii < m_numInstanceBatches && NULL == batch; ++ii)
+		{
+			InstanceBatch& candidate = m_instanceBatch[ii];
+			if (candidate.m_mesh      == _mesh
+			&&  candidate.m_wireframe == _wireframe
+			&&  candidate.m_state     == state)
+			{
+				batch = &candidate;
+			}
+		}
+
+		if (NULL == batch)
+		{
+			if (kNumInstanceBatches == m_numInstanceBatches)
+			{
+				flushInstances();
+			}
+
+			if (NULL == m_instanceCache)
+			{
+				m_instanceCache = (Instance*)BX_ALLOC(s_dds.m_allocator, kNumInstanceBatches*kInstanceCacheSize*sizeof(Instance) );
+			}
+
+			batch = &m_instanceBatch[m_numInstanceBatches];
+			batch->m_instances = &m_instanceCache[m_numInstanceBatches*kInstanceCacheSize];
+			batch->m_state     = state;
+			batch->m_mesh      = _mesh;
+			batch->m_wireframe = _wireframe;
+			batch->m_num       = 0;
+			++m_numInstanceBatches;
+		}
+		else if (kInstanceCacheSize == batch->m_num)
+		{
+			flushInstances(*batch);
+		}
+
+		Instance& instance = batch->m_instances[batch->m_num++];
+
+		// Transform stack is applied on CPU, instances are submitted without transform.
+		const MatrixStack& stack = m_mtxStack[m_mtxStackCurrent];
+		bx::Vec3 to = bx::load<bx::Vec3>(&_mtx[(_num-1)*16+12]);
+
+		if (NULL == stack.data)
+		{
+			bx::memCopy(instance.m_mtx, _mtx, 64);
+		}
+		else
+		{
+			bx::mtxMul(instance.m_mtx, _mtx, stack.data);
+			to = bx::mul(to, stack.data);
+		}
+
+		// Transforms of two-bone meshes differ only in translation, so second translation is
+		// stored in otherwise unused projection column.
+		instance.m_mtx[ 3] = to.x;
+		instance.m_mtx[ 7] = to.y;
+		instance.m_mtx[11] = to.z;
+
+		instance.m_color[0] = ( (attrib.m_abgr)       & 0xff) / 255.0f;
+		instance.m_color[1] = ( (attrib.m_abgr >> 8)  & 0xff) / 255.0f;
+		instance.m_color[2] = ( (attrib.m_abgr >> 16) & 0xff) / 255.0f;
+		instance.m_color[3] = ( (attrib.m_abgr >> 24) & 0xff) / 255.0f;
+	}
+
+	void flushInstances(InstanceBatch& _batch)
+	{
+		const uint16_t stride = uint16_t(sizeof(Instance) );
+
+		// Encoders on other threads share transient memory, so check and allocation must be
+		// single operation.
+		bgfx::InstanceDataBuffer idb;
+		const bool allocated = bgfx::tryAllocInstanceDataBuffer(&idb, _batch.m_num, stride);
+
+		BX_WARN(allocated, "Dropped %u debug draw instances, instance data buffer is full.", _batch.m_num);
+
+		if (allocated)
+		{
+			bx::memCopy(idb.data, _batch.m_instances, _batch.m_num*stride);
+
+			const DebugMesh& mesh = s_dds.m_mesh[_batch.m_mesh];
+
+			if (0 != mesh.m_numIndices[_batch.m_wireframe])
+			{
+				m_encoder->setIndexBuffer(s_dds.m_ibh
+					, mesh.m_startIndex[_batch.m_wireframe]
+					, mesh.m_numIndices[_batch.m_wireframe]
+					);
+			}
+
+			setUParams(_batch.m_state, UINT32_MAX);
+			m_encoder->setState(_batch.m_state);
+			m_encoder->setVertexBuffer(0, s_dds.m_vbh, mesh.m_startVertex, mesh.m_numVertices);
+			m_encoder->setInstanceDataBuffer(&idb);
+			m_encoder->submit(m_viewId, s_dds.m_instanceProgram[_batch.m_wireframe ? 0 : 1]);
+		}
+
+		_batch.m_num = 0;
+	}
+
+	void flushInstances()
+	{
+		for (uint32_t ii = 0; ii < m_numInstanceBatches; ++ii)
+		{
+			flushInstances(m_instanceBatch[ii]);
+		}
+
+		m_numInstanceBatches = 0;
+	}
+
 	void softFlush()
 	{
 		if (m_pos == uint16_t(BX_COUNTOF(m_cache) ) )
@@ -2163,14 +2456,13 @@ struct DebugDrawEncoderImpl
 	{
 		if (0 != m_pos)
 		{
-			if (checkAvailTransientBuffers(m_pos, DebugVertex::ms_layout, m_indexPos) )
+			// Availability check and allocation must be single call, other threads could allocate
+			// transient memory in between.
+			bgfx::TransientVertexBuffer tvb;
+			bgfx::TransientIndexBuffer tib;
+			if (bgfx::allocTransientBuffers(&tvb, DebugVertex::ms_layout, m_pos, &tib, m_indexPos) )
 			{
-				bgfx::TransientVertexBuffer tvb;
-				bgfx::allocTransientVertexBuffer(&tvb, m_pos, DebugVertex::ms_layout);
 				bx::memCopy(tvb.data, m_cache, m_pos * DebugVertex::ms_layout.m_stride);
-
-				bgfx::TransientIndexBuffer tib;
-				bgfx::allocTransientIndexBuffer(&tib, m_indexPos);
 				bx::memCopy(tib.data, m_indices, m_indexPos * sizeof(uint16_t) );
 
 				const Attrib& attrib = m_attrib[m_stack];
@@ -2201,14 +2493,12 @@ struct DebugDrawEncoderImpl
 		if (0 != m_posQuad)
 		{
 			const uint32_t numIndices = m_posQuad/4*6;
-			if (checkAvailTransientBuffers(m_posQuad, DebugUvVertex::ms_layout, numIndices) )
+			bgfx::TransientVertexBuffer tvb;
+			bgfx::TransientIndexBuffer tib;
+			if (bgfx::allocTransientBuffers(&tvb, DebugUvVertex::ms_layout, m_posQuad, &tib, numIndices) )
 			{
-				bgfx::TransientVertexBuffer tvb;
-				bgfx::allocTransientVertexBuffer(&tvb, m_posQuad, DebugUvVertex::ms_layout);
 				bx::memCopy(tvb.data, m_cacheQuad, m_posQuad * DebugUvVertex::ms_layout.m_stride);
 
-				bgfx::TransientIndexBuffer tib;
-				bgfx::allocTransientIndexBuffer(&tib, numIndices);
 				uint16_t* indices = (uint16_t*)tib.data;
 				for (uint16_t ii = 0, num = m_posQuad/4; ii < num; ++ii)
 				{
@@ -2238,6 +2528,22 @@ struct DebugDrawEncoderImpl
 		}
 	}
 
+	/// Matches `i_data0`-`i_data4` of `examples/29-debugdraw/vs_debugdraw_instance.sc`.
+	struct Instance
+	{
+		float m_mtx[16];
+		float m_color[4];
+	};
+
+	struct InstanceBatch
+	{
+		Instance* m_instances;
+		uint64_t  m_state;
+		DebugMesh::Enum m_mesh;
+		bool      m_wireframe;
+		uint16_t  m_num;
+	};
+
 	struct State
 	{
 		enum Enum
@@ -2253,6 +2559,8 @@ struct DebugDrawEncoderImpl
 	static const uint32_t kCacheSize = 1024;
 	static const uint32_t kStackSize = 16;
 	static const uint32_t kCacheQuadSize = 1024;
+	static const uint32_t kInstanceCacheSize = 256;
+	static const uint32_t kNumInstanceBatches = 4;
 	BX_STATIC_ASSERT(kCacheSize >= 3, "Cache must be at least 3 elements.");
 
 	DebugVertex   m_cache[kCacheSize+1];
@@ -2289,21 +2597,22 @@ struct DebugDrawEncoderImpl
 	State::Enum m_state;
 
 	bgfx::Encoder* m_encoder;
-	bgfx::Encoder* m_defaultEncoder;
+	bool m_ownEncoder; //!< Encoder was obtained with bgfx::begin, and it's ended in end.
+
+	Instance* m_instanceCache; //!< Allocated on first instanced draw.
+	InstanceBatch m_instanceBatch[kNumInstanceBatches];
+	uint32_t m_numInstanceBatches;
 };
 
-static DebugDrawEncoderImpl s_dde;
 BX_STATIC_ASSERT(sizeof(DebugDrawEncoderImpl) <= sizeof(DebugDrawEncoder), "Size must match");
 
 void ddInit(bx::AllocatorI* _allocator)
 {
 	s_dds.init(_allocator);
-	s_dde.init(bgfx::begin() );
 }
 
 void ddShutdown()
 {
-	s_dde.shutdown();
 	s_dds.shutdown();
 }
 
@@ -2331,7 +2640,7 @@ void ddDestroy(GeometryHandle _handle)
 
 DebugDrawEncoder::DebugDrawEncoder()
 {
-	DEBUG_DRAW_ENCODER(init(s_dde.m_defaultEncoder) );
+	DEBUG_DRAW_ENCODER(init() );
 }
 
 DebugDrawEncoder::~DebugDrawEncoder()
@@ -33,13 +33,17 @@ inline bool isValid(SpriteHandle _handle) { return _handle.idx != UINT16_MAX; }
 struct GeometryHandle { uint16_t idx; };
 inline bool isValid(GeometryHandle _handle) { return _handle.idx != UINT16_MAX; }
 
-///
+/// When `BGFX_CAPS_INSTANCING` is supported, shapes (AABB, OBB, sphere, cone, cylinder and
+/// capsule) are drawn as instanced unit meshes. Shapes with the same mesh and state are collected
+/// per encoder and submitted as single instanced draw, instead of one draw per shape. Collected
+/// shapes are submitted when the next line, quad or geometry is drawn with the encoder, or at
+/// `end`, so shapes are not drawn after draws made after them.
 void ddInit(bx::AllocatorI* _allocator = NULL);
 
 ///
 void ddShutdown();
 
-///
+/// Sprites and geometries can be created and destroyed from any thread.
 SpriteHandle ddCreateSprite(uint16_t _width, uint16_t _height, const void* _data);
 
 ///
@@ -51,6 +55,9 @@ GeometryHandle ddCreateGeometry(uint32_t _numVertices, const DdVertex* _vertices
 ///
 void ddDestroy(GeometryHandle _handle);
 
+/// Debug draw encoder. Encoders don't share any mutable state, so each thread can record
+/// debug geometry with its own encoder in parallel. Draws from all encoders are merged and
+/// sorted per view by bgfx when frame is submitted.
 ///
 struct DebugDrawEncoder
 {
@@ -60,7 +67,9 @@ struct DebugDrawEncoder
 	///
 	~DebugDrawEncoder();
 
-	///
+	/// Begin recording into view `_viewId`. Without `_encoder`, bgfx encoder is obtained with
+	/// `bgfx::begin` and ended in `end`, which is main encoder on API thread, and dedicated
+	/// encoder on other threads.
 	void begin(uint16_t _viewId, bool _depthTestLess = true, bgfx::Encoder* _encoder = NULL);
 
 	///
@@ -0,0 +1,13 @@
+$input v_color0
+
+/*
+ * Copyright 2011-2019 Branimir Karadzic. All rights reserved.
+ * License: https://github.com/bkaradzic/bgfx#license-bsd-2-clause
+ */
+
+#include "../common.sh"
+
+void main()
+{
+	gl_FragColor = v_color0;
+}
@@ -0,0 +1,26 @@
+$input a_position, a_indices, i_data0, i_data1, i_data2, i_data3, i_data4
+$output v_color0
+
+/*
+ * Copyright 2011-2019 Branimir Karadzic. All rights reserved.
+ * License: https://github.com/bkaradzic/bgfx#license-bsd-2-clause
+ */
+
+#include "../common.sh"
+
+void main()
+{
+	// i_data0-i_data2 are axes, i_data3 is translation of first bone, and w components of
+	// axes are translation of second bone, selected by a_indices.x.
+	vec3 from = i_data3.xyz;
+	vec3 to   = vec3(i_data0.w, i_data1.w, i_data2.w);
+
+	vec3 world = a_position.x*i_data0.xyz
+		+ a_position.y*i_data1.xyz
+		+ a_position.z*i_data2.xyz
+		+ mix(from, to, float(a_indices.x) )
+		;
+
+	gl_Position = mul(u_viewProj, vec4(world, 1.0) );
+	v_color0 = i_data4;
+}
@@ -0,0 +1,27 @@
+$input a_position, a_indices, i_data0, i_data1, i_data2, i_data3, i_data4
+$output v_view, v_world, v_color0
+
+/*
+ * Copyright 2011-2019 Branimir Karadzic. All rights reserved.
+ * License: https://github.com/bkaradzic/bgfx#license-bsd-2-clause
+ */
+
+#include "../common.sh"
+
+void main()
+{
+	vec3 from = i_data3.xyz;
+	vec3 to   = vec3(i_data0.w, i_data1.w, i_data2.w);
+
+	vec4 world = vec4(a_position.x*i_data0.xyz
+		+ a_position.y*i_data1.xyz
+		+ a_position.z*i_data2.xyz
+		+ mix(from, to, float(a_indices.x) )
+		, 1.0
+		);
+
+	gl_Position = mul(u_viewProj, world);
+	v_view   = mul(u_view, world).xyz;
+	v_world  = world.xyz;
+	v_color0 = i_data4;
+}
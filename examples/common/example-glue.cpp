@@ -329,6 +329,25 @@ void showExampleDialog(entry::AppI* _app, const char* _errorText)
 		, stats->maxGpuLatency
 		);
 
+	const bgfx::FrameTiming* rendered = NULL;
+	for (uint32_t ii = 0; ii < stats->numFrameTimings; ++ii)
+	{
+		const bgfx::FrameTiming& timing = stats->frameTimings[ii];
+		if (0 != timing.cpuTimeRenderEnd
+		&& (NULL == rendered || timing.frameNum > rendered->frameNum) )
+		{
+			rendered = &timing;
+		}
+	}
+
+	if (NULL != rendered)
+	{
+		ImGui::Text("Submit to render %0.3f (GPU frames queued: %d)"
+			, double(rendered->cpuTimeRenderEnd - rendered->cpuTimeSubmitBegin)*toMsCpu
+			, stats->gpuFrameLatency
+			);
+	}
+
 	if (-INT64_MAX != stats->gpuMemoryUsed)
 	{
 		char tmp0[64];
@@ -25,6 +25,9 @@ BX_PRAGMA_DIAGNOSTIC_POP();
 #include "../common.h"
 
 #include <bgfx/bgfx.h>
+#include <bx/mutex.h>
+#include <bx/semaphore.h>
+#include <bx/thread.h>
 
 #define SDF_IMPLEMENTATION
 #include <sdf/sdf.h>
@@ -33,6 +36,7 @@ BX_PRAGMA_DIAGNOSTIC_POP();
 
 #include <tinystl/allocator.h>
 #include <tinystl/unordered_map.h>
+#include <tinystl/vector.h>
 namespace stl = tinystl;
 
 #include "font_manager.h"
@@ -336,6 +340,24 @@ bool TrueTypeFont::bakeGlyphDistance(CodePoint _codePoint, GlyphInfo& _glyphInfo
 	return true;
 }
 
+static bool bakeGlyph(TrueTypeFont* _ttf, uint32_t _fontType, CodePoint _codePoint, GlyphInfo& _glyphInfo, uint8_t* _buffer)
+{
+	switch (_fontType)
+	{
+	case FONT_TYPE_ALPHA:
+		return _ttf->bakeGlyphAlpha(_codePoint, _glyphInfo, _buffer);
+
+	case FONT_TYPE_DISTANCE:
+	case FONT_TYPE_DISTANCE_SUBPIXEL:
+		return _ttf->bakeGlyphDistance(_codePoint, _glyphInfo, _buffer);
+
+	default:
+		BX_CHECK(false, "TextureType not supported yet");
+	}
+
+	return false;
+}
+
 typedef stl::unordered_map<CodePoint, GlyphInfo> GlyphHashMap;
 
 // cache font data
@@ -343,6 +365,9 @@ struct FontManager::CachedFont
 {
 	CachedFont()
 		: trueTypeFont(NULL)
+		, ttfBuffer(NULL)
+		, ttfSize(0)
+		, typefaceIndex(0)
 	{
 		masterFontHandle.idx = bx::kInvalidHandle;
 	}
@@ -350,6 +375,10 @@ struct FontManager::CachedFont
 	FontInfo fontInfo;
 	GlyphHashMap cachedGlyphs;
 	TrueTypeFont* trueTypeFont;
+	// TrueType file data, used by rasterization threads to open their own face
+	const uint8_t* ttfBuffer;
+	uint32_t ttfSize;
+	uint32_t typefaceIndex;
 	// an handle to a master font in case of sub distance field font
 	FontHandle masterFontHandle;
 	int16_t padding;
@@ -357,25 +386,156 @@ struct FontManager::CachedFont
 
 #define MAX_FONT_BUFFER_SIZE (512 * 512 * 4)
 
-FontManager::FontManager(Atlas* _atlas)
+struct GlyphRequest
+{
+	FontHandle font;
+	CodePoint codePoint;
+	uint32_t fontType;
+	uint32_t pixelSize;
+	uint32_t typefaceIndex;
+	const uint8_t* ttfBuffer;
+	uint32_t ttfSize;
+};
+
+struct GlyphResult
+{
+	FontHandle font;
+	CodePoint codePoint;
+	GlyphInfo glyphInfo;
+	uint8_t* data;
+};
+
+// FreeType faces can't be used from multiple threads at once, so each worker
+// opens its own face for every font it rasterizes glyphs for.
+struct GlyphWorker
+{
+	GlyphQueue* queue;
+	bx::Thread thread;
+	TrueTypeFont* faces[MAX_OPENED_FONT];
+	uint8_t* buffer;
+};
+
+struct GlyphQueue
+{
+	bx::Mutex mutex;
+	bx::Semaphore sem;
+	bx::Semaphore done; //!< Posted once for every result.
+	stl::vector<GlyphRequest> requests;
+	uint32_t head;
+	stl::vector<GlyphResult> results;
+	GlyphWorker* workers;
+	uint32_t numWorkers;
+	bool exit;
+};
+
+static int32_t glyphWorkerThread(bx::Thread* /*_thread*/, void* _userData)
+{
+	GlyphWorker* worker = (GlyphWorker*)_userData;
+	GlyphQueue*  queue  = worker->queue;
+
+	for (;;)
+	{
+		queue->sem.wait();
+
+		GlyphRequest req;
+		{
+			bx::MutexScope lock(queue->mutex);
+			if (queue->exit)
+			{
+				break;
+			}
+
+			req = queue->requests[queue->head++];
+			if (queue->head == queue->requests.size() )
+			{
+				queue->requests.clear();
+				queue->head = 0;
+			}
+		}
+
+		GlyphResult result;
+		result.font = req.font;
+		result.codePoint = req.codePoint;
+		result.data = NULL;
+		bx::memSet(&result.glyphInfo, 0, sizeof(GlyphInfo) );
+
+		TrueTypeFont*& ttf = worker->faces[req.font.idx];
+		if (NULL == ttf)
+		{
+			ttf = new TrueTypeFont();
+			if (!ttf->init(req.ttfBuffer, req.ttfSize, req.typefaceIndex, req.pixelSize) )
+			{
+				delete ttf;
+				ttf = NULL;
+			}
+		}
+
+		if (NULL != ttf
+		&&  bakeGlyph(ttf, req.fontType, req.codePoint, result.glyphInfo, worker->buffer) )
+		{
+			const uint32_t size = uint32_t(bx::ceil(result.glyphInfo.width) * bx::ceil(result.glyphInfo.height) );
+			if (0 < size)
+			{
+				result.data = new uint8_t[size];
+				bx::memCopy(result.data, worker->buffer, size);
+			}
+		}
+		else
+		{
+			bx::memSet(&result.glyphInfo, 0, sizeof(GlyphInfo) );
+		}
+
+		{
+			bx::MutexScope lock(queue->mutex);
+			queue->results.push_back(result);
+		}
+
+		queue->done.post();
+	}
+
+	return 0;
+}
+
+FontManager::FontManager(Atlas* _atlas, uint32_t _numThreads)
 	: m_ownAtlas(false)
 	, m_atlas(_atlas)
 {
-	init();
+	init(_numThreads);
 }
 
-FontManager::FontManager(uint16_t _textureSideWidth)
+FontManager::FontManager(uint16_t _textureSideWidth, uint32_t _numThreads)
 	: m_ownAtlas(true)
 	, m_atlas(new Atlas(_textureSideWidth) )
 {
-	init();
+	init(_numThreads);
 }
 
-void FontManager::init()
+void FontManager::init(uint32_t _numThreads)
 {
 	m_cachedFiles = new CachedFile[MAX_OPENED_FILES];
 	m_cachedFonts = new CachedFont[MAX_OPENED_FONT];
 	m_buffer = new uint8_t[MAX_FONT_BUFFER_SIZE];
+	m_queue = NULL;
+	m_numPendingGlyphs = 0;
+	m_atlasGeneration = 0;
+
+	if (0 < _numThreads)
+	{
+		m_queue = new GlyphQueue;
+		m_queue->head = 0;
+		m_queue->exit = false;
+		m_queue->numWorkers = _numThreads;
+		m_queue->workers = new GlyphWorker[_numThreads];
+
+		for (uint32_t ii = 0; ii < _numThreads; ++ii)
+		{
+			GlyphWorker& worker = m_queue->workers[ii];
+			worker.queue = m_queue;
+			worker.buffer = new uint8_t[MAX_FONT_BUFFER_SIZE];
+			bx::memSet(worker.faces, 0, sizeof(worker.faces) );
+			worker.thread.init(glyphWorkerThread, &worker, 0, "FontManager glyph worker");
+		}
+	}
 
 	const uint32_t W = 3;
 	// Create filler rectangle
@@ -392,6 +552,38 @@ void FontManager::init()
 FontManager::~FontManager()
 {
 	BX_CHECK(m_fontHandles.getNumHandles() == 0, "All the fonts must be destroyed before destroying the manager");
+
+	if (NULL != m_queue)
+	{
+		{
+			bx::MutexScope lock(m_queue->mutex);
+			m_queue->exit = true;
+		}
+
+		m_queue->sem.post(m_queue->numWorkers);
+
+		for (uint32_t ii = 0; ii < m_queue->numWorkers; ++ii)
+		{
+			GlyphWorker& worker = m_queue->workers[ii];
+			worker.thread.shutdown();
+
+			for (uint32_t jj = 0; jj < MAX_OPENED_FONT; ++jj)
+			{
+				delete worker.faces[jj];
+			}
+
+			delete [] worker.buffer;
+		}
+
+		for (uint32_t ii = 0, num = uint32_t(m_queue->results.size() ); ii < num; ++ii)
+		{
+			delete [] m_queue->results[ii].data;
+		}
+
+		delete [] m_queue->workers;
+		delete m_queue;
+	}
+
 	delete [] m_cachedFonts;
 
 	BX_CHECK(m_filesHandles.getNumHandles() == 0, "All the font files must be destroyed before destroying the manager");
@@ -420,6 +612,10 @@ TrueTypeHandle FontManager::createTtf(const uint8_t* _buffer, uint32_t _size)
 void FontManager::destroyTtf(TrueTypeHandle _handle)
 {
 	BX_CHECK(bgfx::isValid(_handle), "Invalid handle used");
+
+	// Queued glyphs might still read from file buffer.
+	flush();
+
 	delete m_cachedFiles[_handle.idx].buffer;
 	m_cachedFiles[_handle.idx].bufferSize = 0;
 	m_cachedFiles[_handle.idx].buffer = NULL;
@@ -443,6 +639,9 @@ FontHandle FontManager::createFontByPixelSize(TrueTypeHandle _ttfHandle, uint32_
 
 	CachedFont& font = m_cachedFonts[fontIdx];
 	font.trueTypeFont = ttf;
+	font.ttfBuffer = m_cachedFiles[_ttfHandle.idx].buffer;
+	font.ttfSize = m_cachedFiles[_ttfHandle.idx].bufferSize;
+	font.typefaceIndex = _typefaceIndex;
 	font.fontInfo = ttf->getFontInfo();
 	font.fontInfo.fontType  = int16_t(_fontType);
 	font.fontInfo.pixelSize = uint16_t(_pixelSize);
@@ -494,6 +693,20 @@ void FontManager::destroyFont(FontHandle _handle)
 		font.trueTypeFont = NULL;
 	}
 
+	if (NULL != m_queue)
+	{
+		// Workers are idle after flush, so their faces for this font can be
+		// released before handle gets reused.
+		flush();
+
+		for (uint32_t ii = 0; ii < m_queue->numWorkers; ++ii)
+		{
+			TrueTypeFont*& ttf = m_queue->workers[ii].faces[_handle.idx];
+			delete ttf;
+			ttf = NULL;
+		}
+	}
+
 	font.cachedGlyphs.clear();
 	m_fontHandles.free(_handle.idx);
 }
@@ -534,26 +747,15 @@ bool FontManager::preloadGlyph(FontHandle _handle, CodePoint _codePoint)
 
 	if (NULL != font.trueTypeFont)
 	{
-		GlyphInfo glyphInfo;
-
-		switch (font.fontInfo.fontType)
+		if (NULL != m_queue)
 		{
-		case FONT_TYPE_ALPHA:
-			font.trueTypeFont->bakeGlyphAlpha(_codePoint, glyphInfo, m_buffer);
-			break;
-
-		case FONT_TYPE_DISTANCE:
-			font.trueTypeFont->bakeGlyphDistance(_codePoint, glyphInfo, m_buffer);
-			break;
-
-		case FONT_TYPE_DISTANCE_SUBPIXEL:
-			font.trueTypeFont->bakeGlyphDistance(_codePoint, glyphInfo, m_buffer);
-			break;
-
-		default:
-			BX_CHECK(false, "TextureType not supported yet");
+			requestGlyph(_handle, _codePoint);
+			return true;
 		}
 
+		GlyphInfo glyphInfo;
+		bakeGlyph(font.trueTypeFont, font.fontInfo.fontType, _codePoint, glyphInfo, m_buffer);
+
 		if (!addBitmap(glyphInfo, m_buffer) )
 		{
 			return false;
@@ -583,6 +785,14 @@ bool FontManager::preloadGlyph(FontHandle _handle, CodePoint _codePoint)
 		glyphInfo.height = (glyphInfo.height * fontInfo.scale);
 		glyphInfo.width = (glyphInfo.width * fontInfo.scale);
 
+		// Placeholder is not cached for scaled font, since master font is
+		// the one getting updated once glyph is rasterized.
+		if (isPlaceholder(glyphInfo) )
+		{
+			m_placeholderGlyph = glyphInfo;
+			return true;
+		}
+
 		font.cachedGlyphs[_codePoint] = glyphInfo;
 		return true;
 	}
@@ -609,6 +819,11 @@ const GlyphInfo* FontManager::getGlyphInfo(FontHandle _handle, CodePoint _codePo
 		}
 
 		it = cachedGlyphs.find(_codePoint);
+
+		if (it == cachedGlyphs.end() )
+		{
+			return &m_placeholderGlyph;
+		}
 	}
 
 	BX_CHECK(it != cachedGlyphs.end(), "Failed to preload glyph.");
@@ -617,11 +832,193 @@ const GlyphInfo* FontManager::getGlyphInfo(FontHandle _handle, CodePoint _codePo
 
 bool FontManager::addBitmap(GlyphInfo& _glyphInfo, const uint8_t* _data)
 {
-	_glyphInfo.regionIndex = m_atlas->addRegion(
-		  (uint16_t)bx::ceil(_glyphInfo.width)
-		, (uint16_t)bx::ceil(_glyphInfo.height)
-		, _data
-		, AtlasRegion::TYPE_GRAY
-		);
-	return true;
+	const uint16_t width  = (uint16_t)bx::ceil(_glyphInfo.width);
+	const uint16_t height = (uint16_t)bx::ceil(_glyphInfo.height);
+
+	_glyphInfo.regionIndex = m_atlas->addRegion(width, height, _data, AtlasRegion::TYPE_GRAY);
+
+	if (UINT16_MAX == _glyphInfo.regionIndex
+	&&  evictGlyphs() )
+	{
+		_glyphInfo.regionIndex = m_atlas->addRegion(width, height, _data, AtlasRegion::TYPE_GRAY);
+	}
+
+	BX_WARN(UINT16_MAX != _glyphInfo.regionIndex, "Glyph atlas is full.");
+
+	return UINT16_MAX != _glyphInfo.regionIndex;
+}
+
+bool FontManager::evictGlyphs()
+{
+	const uint16_t maxRegions = m_atlas->getMaxRegionCount();
+
+	// Least recently used half of the atlas regions are candidates, but only
+	// regions of cached glyphs are removed, since atlas might be shared.
+	uint16_t* regions = new uint16_t[maxRegions];
+	const uint16_t numRegions = m_atlas->getLeastRecentlyUsed(regions, maxRegions);
+
+	// 0 - keep, 1 - evict, 2 - already removed from the atlas.
+	uint8_t* evict = new uint8_t[maxRegions];
+	bx::memSet(evict, 0, maxRegions);
+
+	for (uint16_t ii = 0, num = numRegions / 2; ii < num; ++ii)
+	{
+		evict[regions[ii] ] = regions[ii] != m_blackGlyph.regionIndex ? 1 : 0;
+	}
+
+	stl::vector<CodePoint> codePoints;
+	uint32_t numEvicted = 0;
+
+	for (uint16_t ii = 0, num = m_fontHandles.getNumHandles(); ii < num; ++ii)
+	{
+		GlyphHashMap& cachedGlyphs = m_cachedFonts[m_fontHandles.getHandleAt(ii)].cachedGlyphs;
+
+		codePoints.clear();
+		for (GlyphHashMap::iterator it = cachedGlyphs.begin(), itEnd = cachedGlyphs.end(); it != itEnd; ++it)
+		{
+			const uint16_t regionIndex = it->second.regionIndex;
+			if (regionIndex < maxRegions
+			&&  0 != evict[regionIndex])
+			{
+				codePoints.push_back(it->first);
+			}
+		}
+
+		// Scaled fonts share regions with their master font, so region is
+		// removed from the atlas by whichever font sees it first.
+		for (uint32_t jj = 0, numCodePoints = uint32_t(codePoints.size() ); jj < numCodePoints; ++jj)
+		{
+			GlyphHashMap::iterator it = cachedGlyphs.find(codePoints[jj]);
+			const uint16_t regionIndex = it->second.regionIndex;
+			cachedGlyphs.erase(it);
+
+			if (1 == evict[regionIndex])
+			{
+				m_atlas->removeRegion(regionIndex);
+				evict[regionIndex] = 2;
+				++numEvicted;
+			}
+		}
+	}
+
+	delete [] evict;
+	delete [] regions;
+
+	if (0 == numEvicted)
+	{
+		return false;
+	}
+
+	++m_atlasGeneration;
+	return m_atlas->compact();
+}
+
+void FontManager::requestGlyph(FontHandle _handle, CodePoint _codePoint)
+{
+	CachedFont& font = m_cachedFonts[_handle.idx];
+
+	GlyphInfo glyphInfo;
+	glyphInfo.glyphIndex = -1;
+	glyphInfo.width = 0.0f;
+	glyphInfo.height = 0.0f;
+	glyphInfo.offset_x = 0.0f;
+	glyphInfo.offset_y = 0.0f;
+	glyphInfo.advance_x = font.fontInfo.maxAdvanceWidth;
+	glyphInfo.advance_y = 0.0f;
+	glyphInfo.regionIndex = m_blackGlyph.regionIndex;
+	font.cachedGlyphs[_codePoint] = glyphInfo;
+
+	GlyphRequest req;
+	req.font = _handle;
+	req.codePoint = _codePoint;
+	req.fontType = font.fontInfo.fontType;
+	req.pixelSize = font.fontInfo.pixelSize;
+	req.typefaceIndex = font.typefaceIndex;
+	req.ttfBuffer = font.ttfBuffer;
+	req.ttfSize = font.ttfSize;
+
+	{
+		bx::MutexScope lock(m_queue->mutex);
+		m_queue->requests.push_back(req);
+	}
+
+	++m_numPendingGlyphs;
+	m_queue->sem.post();
+}
+
+uint32_t FontManager::update()
+{
+	return addGlyphResults(false);
+}
+
+void FontManager::flush()
+{
+	if (0 == m_numPendingGlyphs)
+	{
+		return;
+	}
+
+	// Every queued glyph is signaled once its result is pushed, so after all
+	// signals are received every result is in the queue.
+	for (uint32_t ii = 0; ii < m_numPendingGlyphs; ++ii)
+	{
+		m_queue->done.wait();
+	}
+
+	addGlyphResults(true);
+}
+
+uint32_t FontManager::addGlyphResults(bool _signaled)
+{
+	if (0 == m_numPendingGlyphs)
+	{
+		return 0;
+	}
+
+	stl::vector<GlyphResult> results;
+	{
+		bx::MutexScope lock(m_queue->mutex);
+		results.swap(m_queue->results);
+	}
+
+	if (!_signaled)
+	{
+		// Worker posts right after pushing result, this doesn't block for
+		// long.
+		for (uint32_t ii = 0, num = uint32_t(results.size() ); ii < num; ++ii)
+		{
+			m_queue->done.wait();
+		}
+	}
+
+	// All glyphs completed since last update are added to the atlas at once.
+	for (uint32_t ii = 0, num = uint32_t(results.size() ); ii < num; ++ii)
+	{
+		GlyphResult& result = results[ii];
+		CachedFont& font = m_cachedFonts[result.font.idx];
+		FontInfo& fontInfo = font.fontInfo;
+
+		GlyphInfo glyphInfo = result.glyphInfo;
+		if (!addBitmap(glyphInfo, NULL != result.data ? result.data : m_buffer) )
+		{
+			// Atlas is full, glyph keeps being drawn as placeholder.
+			delete [] result.data;
+			continue;
+		}
+
+		glyphInfo.advance_x = (glyphInfo.advance_x * fontInfo.scale);
+		glyphInfo.advance_y = (glyphInfo.advance_y * fontInfo.scale);
+		glyphInfo.offset_x = (glyphInfo.offset_x * fontInfo.scale);
+		glyphInfo.offset_y = (glyphInfo.offset_y * fontInfo.scale);
+		glyphInfo.height = (glyphInfo.height * fontInfo.scale);
+		glyphInfo.width = (glyphInfo.width * fontInfo.scale);
+
+		font.cachedGlyphs[result.codePoint] = glyphInfo;
+
+		delete [] result.data;
+	}
+
+	const uint32_t num = uint32_t(results.size() );
+	m_numPendingGlyphs -= num;
+	return num;
 }
@@ -11,6 +11,7 @@
 #include <bgfx/bgfx.h>
 
 class Atlas;
+struct GlyphQueue;
 
 #define MAX_OPENED_FILES 64
 #define MAX_OPENED_FONT  64
@@ -122,11 +123,14 @@ class FontManager
 public:
 	/// Create the font manager using an external cube atlas (doesn't take
 	/// ownership of the atlas).
-	FontManager(Atlas* _atlas);
+	///
+	/// @param[in] _numThreads Number of glyph rasterization threads. When not
+	///   zero, glyphs are rasterized asynchronously, see `update`.
+	FontManager(Atlas* _atlas, uint32_t _numThreads = 0);
 
 	/// Create the font manager and create the texture cube as BGRA8 with
 	/// linear filtering.
-	FontManager(uint16_t _textureSideWidth = 512);
+	FontManager(uint16_t _textureSideWidth = 512, uint32_t _numThreads = 0);
 
 	~FontManager();
 
@@ -136,6 +140,13 @@ public:
 		return m_atlas;
 	}
 
+	/// Retrieve the atlas used by the font manager (e.g. to flush glyph
+	/// uploads before rendering)
+	Atlas* getAtlas()
+	{
+		return m_atlas;
+	}
+
 	/// Load a TrueType font from a given buffer. The buffer is copied and
 	/// thus can be freed or reused after this call.
 	///
@@ -161,8 +172,38 @@ public:
 	bool preloadGlyph(FontHandle _handle, const wchar_t* _string);
 
 	/// Preload a single glyph, return true on success.
+	///
+	/// @remark With rasterization threads, glyph is only queued, and
+	///   placeholder glyph is cached until it's rasterized.
 	bool preloadGlyph(FontHandle _handle, CodePoint _character);
 
+	/// Add glyphs rasterized by worker threads to the atlas, and replace
+	/// their placeholders. Must be called from the thread that owns the
+	/// manager, usually once per frame.
+	///
+	/// @return Number of glyphs replaced. When not zero, text buffers
+	///   built with placeholder glyphs should be rebuilt.
+	uint32_t update();
+
+	/// Wait for all queued glyphs to be rasterized, and add them to the
+	/// atlas.
+	void flush();
+
+	/// Return number of glyphs queued for rasterization, that are not yet
+	/// added to the atlas.
+	uint32_t getNumPendingGlyphs() const
+	{
+		return m_numPendingGlyphs;
+	}
+
+	/// Return true if glyph is placeholder for glyph still being
+	/// rasterized. Placeholder has no bitmap, and advances by the font's
+	/// maximum advance width.
+	static bool isPlaceholder(const GlyphInfo& _glyphInfo)
+	{
+		return -1 == _glyphInfo.glyphIndex;
+	}
+
 	/// Return the font descriptor of a font.
 	///
 	/// @remark the handle is required to be valid
@@ -171,6 +212,12 @@ public:
 	/// Return the rendering informations about the glyph region. Load the
 	/// glyph from a TrueType font if possible
 	///
+	/// @remark When the atlas is full, least recently used glyphs are
+	///   evicted and the atlas is compacted, which moves remaining glyphs.
+	///   TextBufferManager marks glyphs as used when text is drawn and
+	///   repacks UVs when `getAtlasGeneration` changes. Text that wasn't
+	///   drawn for a while may lose its glyphs and must be rebuilt, see
+	///   `TextBufferManager::isTextBufferStale`.
 	const GlyphInfo* getGlyphInfo(FontHandle _handle, CodePoint _codePoint);
 
 	const GlyphInfo& getBlackGlyph() const
@@ -178,6 +225,13 @@ public:
 		return m_blackGlyph;
 	}
 
+	/// Return number of times glyphs were evicted from the atlas. Glyph
+	/// UVs packed before the value changed are no longer valid.
+	uint32_t getAtlasGeneration() const
+	{
+		return m_atlasGeneration;
+	}
+
 private:
 	struct CachedFont;
 	struct CachedFile
@@ -186,8 +240,11 @@ private:
 		uint32_t bufferSize;
 	};
 
-	void init();
+	void init(uint32_t _numThreads);
 	bool addBitmap(GlyphInfo& _glyphInfo, const uint8_t* _data);
+	void requestGlyph(FontHandle _handle, CodePoint _codePoint);
+	uint32_t addGlyphResults(bool _signaled);
+	bool evictGlyphs();
 
 	bool m_ownAtlas;
 	Atlas* m_atlas;
@@ -199,9 +256,14 @@ private:
 	CachedFile* m_cachedFiles;
 
 	GlyphInfo m_blackGlyph;
+	GlyphInfo m_placeholderGlyph;
 
 	//temporary buffer to raster glyph
 	uint8_t* m_buffer;
+
+	GlyphQueue* m_queue;
+	uint32_t m_numPendingGlyphs;
+	uint32_t m_atlasGeneration;
 };
 
 #endif // FONT_MANAGER_H_HEADER_GUARD
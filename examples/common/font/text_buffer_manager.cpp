@@ -7,6 +7,7 @@
 
 #include <bgfx/bgfx.h>
 #include <bgfx/embedded_shader.h>
+#include <bx/sort.h>
 
 #include <stddef.h> // offsetof
 #include <wchar.h>  // wcslen
@@ -21,6 +22,7 @@
 #include "fs_font_distance_field.bin.h"
 #include "vs_font_distance_field_subpixel.bin.h"
 #include "fs_font_distance_field_subpixel.bin.h"
+#include "vs_font_instanced.bin.h"
 
 static const bgfx::EmbeddedShader s_embeddedShaders[] =
 {
@@ -30,12 +32,36 @@ static const bgfx::EmbeddedShader s_embeddedShaders[] =
 	BGFX_EMBEDDED_SHADER(fs_font_distance_field),
 	BGFX_EMBEDDED_SHADER(vs_font_distance_field_subpixel),
 	BGFX_EMBEDDED_SHADER(fs_font_distance_field_subpixel),
+	BGFX_EMBEDDED_SHADER(vs_font_instanced),
 
 	BGFX_EMBEDDED_SHADER_END()
 };
 
 #define MAX_BUFFERED_CHARACTERS (8192 - 5)
 
+/// One glyph quad drawn as instance, see `vs_font_instanced.sc`.
+struct GlyphInstance
+{
+	float rect[4];  //!< x0, y0, x1, y1.
+	float uvw0[4];  //!< Atlas coordinates at (x0, y0), atlas channel in w.
+	float uvw1[4];  //!< Atlas coordinates at (x1, y1), bit mask of coordinates following y in w.
+	float color[4];
+};
+
+static const float s_quadVertices[4][2] =
+{
+	{ 0.0f, 0.0f },
+	{ 0.0f, 1.0f },
+	{ 1.0f, 1.0f },
+	{ 1.0f, 0.0f },
+};
+
+static const uint16_t s_quadIndices[6] =
+{
+	0, 1, 2,
+	0, 2, 3,
+};
+
 class TextBuffer
 {
 public:
@@ -141,10 +167,39 @@ public:
 		return m_rectangle;
 	}
 
+	/// Mark atlas regions used by the buffer as used, so that glyphs of text that is still
+	/// drawn are not evicted first.
+	void markUsed() const
+	{
+		m_fontManager->getAtlas()->markUsed(m_regionBuffer, m_vertexCount/4);
+	}
+
+	/// Pack UVs again when glyphs were moved in the atlas since they were packed. Quads of glyphs
+	/// evicted from the atlas are hidden, and buffer is marked stale.
+	/// @return true if vertex buffer changed.
+	bool repackUV();
+
+	/// Return true if glyphs were evicted from the atlas since they were appended, text must be
+	/// cleared and appended again to show them.
+	bool isStale() const
+	{
+		return m_stale;
+	}
+
+	/// Write one instance per quad into `_dst`, which must have space for `getVertexCount()/4`
+	/// instances.
+	void writeInstances(GlyphInstance* _dst) const;
+
 private:
 	void appendGlyph(FontHandle _handle, CodePoint _codePoint);
+	void packUV(uint16_t _regionIndex);
 	void verticalCenterLastLine(float _txtDecalY, float _top, float _bottom);
 
+	static float toSnorm(int16_t _value)
+	{
+		return bx::max(float(_value)/float(INT16_MAX), -1.0f);
+	}
+
 	static uint32_t toABGR(uint32_t _rgba)
 	{
 		return ( ( (_rgba >>  0) & 0xff) << 24)
@@ -196,6 +251,10 @@ private:
 	TextVertex* m_vertexBuffer;
 	uint16_t* m_indexBuffer;
 	uint8_t* m_styleBuffer;
+	uint16_t* m_regionBuffer; //!< Atlas region of each quad, UINT16_MAX for atlas faces.
+	uint16_t* m_regionGenerationBuffer; //!< Generation of region when it was packed.
+	uint32_t m_atlasGeneration;
+	bool m_stale;
 
 	uint32_t m_indexCount;
 	uint32_t m_lineStartIndex;
@@ -220,6 +279,10 @@ TextBuffer::TextBuffer(FontManager* _fontManager)
 	, m_vertexBuffer(new TextVertex[MAX_BUFFERED_CHARACTERS * 4])
 	, m_indexBuffer(new uint16_t[MAX_BUFFERED_CHARACTERS * 6])
 	, m_styleBuffer(new uint8_t[MAX_BUFFERED_CHARACTERS * 4])
+	, m_regionBuffer(new uint16_t[MAX_BUFFERED_CHARACTERS])
+	, m_regionGenerationBuffer(new uint16_t[MAX_BUFFERED_CHARACTERS])
+	, m_atlasGeneration(_fontManager->getAtlasGeneration() )
+	, m_stale(false)
 	, m_indexCount(0)
 	, m_lineStartIndex(0)
 	, m_vertexCount(0)
@@ -233,6 +296,8 @@ TextBuffer::~TextBuffer()
 	delete [] m_vertexBuffer;
 	delete [] m_indexBuffer;
 	delete [] m_styleBuffer;
+	delete [] m_regionBuffer;
+	delete [] m_regionGenerationBuffer;
 }
 
 void TextBuffer::appendText(FontHandle _fontHandle, const char* _string, const char* _end)
@@ -307,6 +372,7 @@ void TextBuffer::appendAtlasFace(uint16_t _faceIndex)
 		, sizeof(TextVertex) * m_vertexCount + offsetof(TextVertex, u)
 		, sizeof(TextVertex)
 		);
+	m_regionBuffer[m_vertexCount/4] = UINT16_MAX;
 
 	setVertex(m_vertexCount + 0, x0, y0, m_backgroundColor);
 	setVertex(m_vertexCount + 1, x0, y1, m_backgroundColor);
@@ -338,6 +404,103 @@ void TextBuffer::clearTextBuffer()
 	m_lineGap = 0;
 	m_rectangle.width = 0;
 	m_rectangle.height = 0;
+	m_atlasGeneration = m_fontManager->getAtlasGeneration();
+	m_stale = false;
+}
+
+void TextBuffer::packUV(uint16_t _regionIndex)
+{
+	const Atlas* atlas = m_fontManager->getAtlas();
+	m_regionBuffer[m_vertexCount/4] = _regionIndex;
+	m_regionGenerationBuffer[m_vertexCount/4] = atlas->getRegionGeneration(_regionIndex);
+
+	atlas->packUV(_regionIndex
+		, (uint8_t*)m_vertexBuffer
+		, sizeof(TextVertex) * m_vertexCount + offsetof(TextVertex, u)
+		, sizeof(TextVertex)
+		);
+}
+
+bool TextBuffer::repackUV()
+{
+	const uint32_t generation = m_fontManager->getAtlasGeneration();
+	if (generation == m_atlasGeneration)
+	{
+		return false;
+	}
+
+	m_atlasGeneration = generation;
+
+	const Atlas* atlas = m_fontManager->getAtlas();
+
+	for (uint32_t ii = 0, num = m_vertexCount/4; ii < num; ++ii)
+	{
+		const uint16_t regionIndex = m_regionBuffer[ii];
+		if (UINT16_MAX == regionIndex)
+		{
+			continue;
+		}
+
+		// Region was removed since glyph was packed, its handle might be already reused by other
+		// glyph. Quad is collapsed to its first corner.
+		if (m_regionGenerationBuffer[ii] != atlas->getRegionGeneration(regionIndex) )
+		{
+			TextVertex* vertex = &m_vertexBuffer[ii*4];
+			for (uint32_t jj = 1; jj < 4; ++jj)
+			{
+				vertex[jj].x = vertex[0].x;
+				vertex[jj].y = vertex[0].y;
+			}
+
+			m_regionBuffer[ii] = UINT16_MAX;
+			m_stale = true;
+			continue;
+		}
+
+		atlas->packUV(regionIndex
+			, (uint8_t*)m_vertexBuffer
+			, sizeof(TextVertex) * ii * 4 + offsetof(TextVertex, u)
+			, sizeof(TextVertex)
+			);
+	}
+
+	return true;
+}
+
+void TextBuffer::writeInstances(GlyphInstance* _dst) const
+{
+	for (uint32_t ii = 0, num = m_vertexCount/4; ii < num; ++ii)
+	{
+		// Quad vertices are (x0, y0), (x0, y1), (x1, y1) and (x1, y0), and all have same color
+		// and atlas channel.
+		const TextVertex* vertex = &m_vertexBuffer[ii*4];
+		GlyphInstance& instance = _dst[ii];
+
+		instance.rect[0] = vertex[0].x;
+		instance.rect[1] = vertex[0].y;
+		instance.rect[2] = vertex[2].x;
+		instance.rect[3] = vertex[2].y;
+
+		instance.uvw0[0] = toSnorm(vertex[0].u);
+		instance.uvw0[1] = toSnorm(vertex[0].v);
+		instance.uvw0[2] = toSnorm(vertex[0].w);
+		instance.uvw0[3] = toSnorm(vertex[0].t);
+
+		instance.uvw1[0] = toSnorm(vertex[2].u);
+		instance.uvw1[1] = toSnorm(vertex[2].v);
+		instance.uvw1[2] = toSnorm(vertex[2].w);
+		instance.uvw1[3] = float(0
+			| (vertex[1].u != vertex[0].u ? 1 : 0)
+			| (vertex[1].v != vertex[0].v ? 2 : 0)
+			| (vertex[1].w != vertex[0].w ? 4 : 0)
+			);
+
+		const uint8_t* rgba = (const uint8_t*)&vertex[0].rgba;
+		instance.color[0] = rgba[0]/255.0f;
+		instance.color[1] = rgba[1]/255.0f;
+		instance.color[2] = rgba[2]/255.0f;
+		instance.color[3] = rgba[3]/255.0f;
+	}
 }
 
 void TextBuffer::appendGlyph(FontHandle _handle, CodePoint _codePoint)
@@ -396,7 +559,6 @@ void TextBuffer::appendGlyph(FontHandle _handle, CodePoint _codePoint)
 	m_penX += kerning;
 
 	const GlyphInfo& blackGlyph = m_fontManager->getBlackGlyph();
-	const Atlas* atlas = m_fontManager->getAtlas();
 
 	if (m_styleFlags & STYLE_BACKGROUND
 	&&  m_backgroundColor & 0xff000000)
@@ -406,11 +568,7 @@ void TextBuffer::appendGlyph(FontHandle _handle, CodePoint _codePoint)
 		float x1 = ( (float)x0 + (glyph->advance_x) );
 		float y1 = (m_penY + m_lineAscender - m_lineDescender + m_lineGap);
 
-		atlas->packUV(blackGlyph.regionIndex
-			, (uint8_t*)m_vertexBuffer
-			, sizeof(TextVertex) * m_vertexCount + offsetof(TextVertex, u)
-			, sizeof(TextVertex)
-			);
+		packUV(blackGlyph.regionIndex);
 
 		const uint16_t vertexCount = m_vertexCount;
 		setVertex(vertexCount + 0, x0, y0, m_backgroundColor, STYLE_BACKGROUND);
@@ -436,11 +594,7 @@ void TextBuffer::appendGlyph(FontHandle _handle, CodePoint _codePoint)
 		float x1 = ( (float)x0 + (glyph->advance_x) );
 		float y1 = y0 + font.underlineThickness;
 
-		atlas->packUV(blackGlyph.regionIndex
-			, (uint8_t*)m_vertexBuffer
-			, sizeof(TextVertex) * m_vertexCount + offsetof(TextVertex, u)
-			, sizeof(TextVertex)
-			);
+		packUV(blackGlyph.regionIndex);
 
 		setVertex(m_vertexCount + 0, x0, y0, m_underlineColor, STYLE_UNDERLINE);
 		setVertex(m_vertexCount + 1, x0, y1, m_underlineColor, STYLE_UNDERLINE);
@@ -465,11 +619,7 @@ void TextBuffer::appendGlyph(FontHandle _handle, CodePoint _codePoint)
 		float x1 = ( (float)x0 + (glyph->advance_x) );
 		float y1 = y0 + font.underlineThickness;
 
-		m_fontManager->getAtlas()->packUV(blackGlyph.regionIndex
-			, (uint8_t*)m_vertexBuffer
-			, sizeof(TextVertex) * m_vertexCount + offsetof(TextVertex, u)
-			, sizeof(TextVertex)
-			);
+		packUV(blackGlyph.regionIndex);
 
 		setVertex(m_vertexCount + 0, x0, y0, m_overlineColor, STYLE_OVERLINE);
 		setVertex(m_vertexCount + 1, x0, y1, m_overlineColor, STYLE_OVERLINE);
@@ -494,11 +644,7 @@ void TextBuffer::appendGlyph(FontHandle _handle, CodePoint _codePoint)
 		float x1 = ( (float)x0 + (glyph->advance_x) );
 		float y1 = y0 + font.underlineThickness;
 
-		atlas->packUV(blackGlyph.regionIndex
-			, (uint8_t*)m_vertexBuffer
-			, sizeof(TextVertex) * m_vertexCount + offsetof(TextVertex, u)
-			, sizeof(TextVertex)
-			);
+		packUV(blackGlyph.regionIndex);
 
 		setVertex(m_vertexCount + 0, x0, y0, m_strikeThroughColor, STYLE_STRIKE_THROUGH);
 		setVertex(m_vertexCount + 1, x0, y1, m_strikeThroughColor, STYLE_STRIKE_THROUGH);
@@ -520,11 +666,7 @@ void TextBuffer::appendGlyph(FontHandle _handle, CodePoint _codePoint)
 	float x1 = (x0 + glyph->width);
 	float y1 = (y0 + glyph->height);
 
-	atlas->packUV(glyph->regionIndex
-		, (uint8_t*)m_vertexBuffer
-		, sizeof(TextVertex) * m_vertexCount + offsetof(TextVertex, u)
-		, sizeof(TextVertex)
-		);
+	packUV(glyph->regionIndex);
 
 	setVertex(m_vertexCount + 0, x0, y0, m_textColor);
 	setVertex(m_vertexCount + 1, x0, y1, m_textColor);
@@ -573,8 +715,10 @@ void TextBuffer::verticalCenterLastLine(float _dy, float _top, float _bottom)
 	}
 }
 
-TextBufferManager::TextBufferManager(FontManager* _fontManager)
+TextBufferManager::TextBufferManager(FontManager* _fontManager, uint32_t _maxStaticGlyphs)
 	: m_fontManager(_fontManager)
+	, m_poolData(NULL)
+	, m_poolCapacity(_maxStaticGlyphs)
 {
 	m_textBuffers = new BufferCache[MAX_TEXT_BUFFER_COUNT];
 
@@ -606,6 +750,59 @@ TextBufferManager::TextBufferManager(FontManager* _fontManager)
 		.end();
 
 	s_texColor = bgfx::createUniform("s_texColor", bgfx::UniformType::Sampler);
+
+	m_basicInstancedProgram.idx            = bgfx::kInvalidHandle;
+	m_distanceInstancedProgram.idx         = bgfx::kInvalidHandle;
+	m_distanceSubpixelInstancedProgram.idx = bgfx::kInvalidHandle;
+	m_quadVb.idx = bgfx::kInvalidHandle;
+	m_quadIb.idx = bgfx::kInvalidHandle;
+
+	m_instanced = 0 != (bgfx::getCaps()->supported & BGFX_CAPS_INSTANCING);
+
+	if (m_instanced)
+	{
+		m_basicInstancedProgram = bgfx::createProgram(
+			  bgfx::createEmbeddedShader(s_embeddedShaders, type, "vs_font_instanced")
+			, bgfx::createEmbeddedShader(s_embeddedShaders, type, "fs_font_basic")
+			, true
+			);
+
+		m_distanceInstancedProgram = bgfx::createProgram(
+			  bgfx::createEmbeddedShader(s_embeddedShaders, type, "vs_font_instanced")
+			, bgfx::createEmbeddedShader(s_embeddedShaders, type, "fs_font_distance_field")
+			, true
+			);
+
+		m_distanceSubpixelInstancedProgram = bgfx::createProgram(
+			  bgfx::createEmbeddedShader(s_embeddedShaders, type, "vs_font_instanced")
+			, bgfx::createEmbeddedShader(s_embeddedShaders, type, "fs_font_distance_field_subpixel")
+			, true
+			);
+
+		m_quadLayout
+			.begin()
+			.add(bgfx::Attrib::Position, 2, bgfx::AttribType::Float)
+			.end();
+
+		// Only stride of instance layout is used.
+		m_instanceLayout
+			.begin()
+			.add(bgfx::Attrib::TexCoord7, 4, bgfx::AttribType::Float)
+			.add(bgfx::Attrib::TexCoord6, 4, bgfx::AttribType::Float)
+			.add(bgfx::Attrib::TexCoord5, 4, bgfx::AttribType::Float)
+			.add(bgfx::Attrib::TexCoord4, 4, bgfx::AttribType::Float)
+			.end();
+		BX_CHECK(sizeof(GlyphInstance) == m_instanceLayout.getStride(), "Instance layout doesn't match GlyphInstance.");
+
+		m_quadVb = bgfx::createVertexBuffer(bgfx::makeRef(s_quadVertices, sizeof(s_quadVertices) ), m_quadLayout);
+		m_quadIb = bgfx::createIndexBuffer(bgfx::makeRef(s_quadIndices, sizeof(s_quadIndices) ) );
+	}
+
+	// Pool buffer is created on first use.
+	m_poolVb.idx = bgfx::kInvalidHandle;
+
+	const PoolRange range = { 0, m_poolCapacity };
+	m_poolFree.push_back(range);
 }
 
 TextBufferManager::~TextBufferManager()
@@ -615,6 +812,22 @@ TextBufferManager::~TextBufferManager()
 
 	bgfx::destroy(s_texColor);
 
+	if (bgfx::isValid(m_poolVb) )
+	{
+		bgfx::destroy(m_poolVb);
+	}
+
+	delete [] m_poolData;
+
+	if (m_instanced)
+	{
+		bgfx::destroy(m_quadVb);
+		bgfx::destroy(m_quadIb);
+		bgfx::destroy(m_basicInstancedProgram);
+		bgfx::destroy(m_distanceInstancedProgram);
+		bgfx::destroy(m_distanceSubpixelInstancedProgram);
+	}
+
 	bgfx::destroy(m_basicProgram);
 	bgfx::destroy(m_distanceProgram);
 	bgfx::destroy(m_distanceSubpixelProgram);
@@ -630,6 +843,9 @@ TextBufferHandle TextBufferManager::createTextBuffer(uint32_t _type, BufferType:
 	bc.bufferType = _bufferType;
 	bc.indexBufferHandleIdx = bgfx::kInvalidHandle;
 	bc.vertexBufferHandleIdx = bgfx::kInvalidHandle;
+	bc.poolOffset = UINT32_MAX;
+	bc.poolSize = 0;
+	bc.dirty = true;
 
 	TextBufferHandle ret = {textIdx};
 	return ret;
@@ -644,6 +860,13 @@ void TextBufferManager::destroyTextBuffer(TextBufferHandle _handle)
 	delete bc.textBuffer;
 	bc.textBuffer = NULL;
 
+	if (UINT32_MAX != bc.poolOffset)
+	{
+		poolFree(bc.poolOffset, bc.poolSize);
+		bc.poolOffset = UINT32_MAX;
+		bc.poolSize = 0;
+	}
+
 	if (bc.vertexBufferHandleIdx == bgfx::kInvalidHandle)
 	{
 		return;
@@ -651,16 +874,7 @@ void TextBufferManager::destroyTextBuffer(TextBufferHandle _handle)
 
 	switch (bc.bufferType)
 	{
-	case BufferType::Static:
-		{
-			bgfx::IndexBufferHandle ibh;
-			bgfx::VertexBufferHandle vbh;
-			ibh.idx = bc.indexBufferHandleIdx;
-			vbh.idx = bc.vertexBufferHandleIdx;
-			bgfx::destroy(ibh);
-			bgfx::destroy(vbh);
-		}
-
+	case BufferType::Static: // sub-allocated from pool
 		break;
 
 	case BufferType::Dynamic:
@@ -678,27 +892,31 @@ void TextBufferManager::destroyTextBuffer(TextBufferHandle _handle)
 	}
 }
 
-void TextBufferManager::submitTextBuffer(TextBufferHandle _handle, bgfx::ViewId _id, int32_t _depth)
+void TextBufferManager::prepareGlyphs(BufferCache& _bc)
 {
-	BX_CHECK(bgfx::isValid(_handle), "Invalid handle used");
-
-	BufferCache& bc = m_textBuffers[_handle.idx];
-
-	uint32_t indexSize  = bc.textBuffer->getIndexCount()  * bc.textBuffer->getIndexSize();
-	uint32_t vertexSize = bc.textBuffer->getVertexCount() * bc.textBuffer->getVertexSize();
-
-	if (0 == indexSize || 0 == vertexSize)
+	// Glyphs are marked used when drawn, not only when packed, so that eviction picks glyphs
+	// no longer drawn. UVs are repacked if eviction moved glyphs in the atlas.
+	if (_bc.textBuffer->repackUV() )
 	{
-		return;
+		_bc.dirty = true;
 	}
 
-	bgfx::setTexture(0, s_texColor, m_fontManager->getAtlas()->getTextureHandle() );
+	_bc.textBuffer->markUsed();
+}
+
+bgfx::ProgramHandle TextBufferManager::setRenderState(const BufferCache& _bc, bool _instanced)
+{
+	// Glyphs added since last submit are uploaded in few merged texture updates.
+	Atlas* atlas = m_fontManager->getAtlas();
+	atlas->flush();
+
+	bgfx::setTexture(0, s_texColor, atlas->getTextureHandle() );
 
 	bgfx::ProgramHandle program = BGFX_INVALID_HANDLE;
-	switch (bc.fontType)
+	switch (_bc.fontType)
 	{
 	case FONT_TYPE_ALPHA:
-		program = m_basicProgram;
+		program = _instanced ? m_basicInstancedProgram : m_basicProgram;
 		bgfx::setState(0
 			| BGFX_STATE_WRITE_RGB
 			| BGFX_STATE_BLEND_FUNC(BGFX_STATE_BLEND_SRC_ALPHA, BGFX_STATE_BLEND_INV_SRC_ALPHA)
@@ -706,7 +924,7 @@ void TextBufferManager::submitTextBuffer(TextBufferHandle _handle, bgfx::ViewId
 		break;
 
 	case FONT_TYPE_DISTANCE:
-		program = m_distanceProgram;
+		program = _instanced ? m_distanceInstancedProgram : m_distanceProgram;
 		bgfx::setState(0
 			| BGFX_STATE_WRITE_RGB
 			| BGFX_STATE_BLEND_FUNC(BGFX_STATE_BLEND_SRC_ALPHA, BGFX_STATE_BLEND_INV_SRC_ALPHA)
@@ -714,44 +932,196 @@ void TextBufferManager::submitTextBuffer(TextBufferHandle _handle, bgfx::ViewId
 		break;
 
 	case FONT_TYPE_DISTANCE_SUBPIXEL:
-		program = m_distanceSubpixelProgram;
+		program = _instanced ? m_distanceSubpixelInstancedProgram : m_distanceSubpixelProgram;
 		bgfx::setState(0
 			| BGFX_STATE_WRITE_RGB
 			| BGFX_STATE_BLEND_FUNC(BGFX_STATE_BLEND_FACTOR, BGFX_STATE_BLEND_INV_SRC_COLOR)
-			, bc.textBuffer->getTextColor()
+			, _bc.textBuffer->getTextColor()
 			);
 		break;
 	}
 
-	switch (bc.bufferType)
+	return program;
+}
+
+void TextBufferManager::setQuadBuffers()
+{
+	bgfx::setVertexBuffer(0, m_quadVb);
+	bgfx::setIndexBuffer(m_quadIb);
+}
+
+bool TextBufferManager::submitTransient(const BufferCache& _bc)
+{
+	const uint32_t numQuads = _bc.textBuffer->getVertexCount()/4;
+
+	bgfx::InstanceDataBuffer idb;
+	if (m_instanced
+	&&  bgfx::tryAllocInstanceDataBuffer(&idb, numQuads, sizeof(GlyphInstance) ) )
 	{
-	case BufferType::Static:
-		{
-			bgfx::IndexBufferHandle ibh;
-			bgfx::VertexBufferHandle vbh;
+		_bc.textBuffer->writeInstances( (GlyphInstance*)idb.data);
 
-			if (bgfx::kInvalidHandle == bc.vertexBufferHandleIdx)
-			{
-				ibh = bgfx::createIndexBuffer(
-								bgfx::copy(bc.textBuffer->getIndexBuffer(), indexSize)
-								);
+		setQuadBuffers();
+		bgfx::setInstanceDataBuffer(&idb);
+		return true;
+	}
 
-				vbh = bgfx::createVertexBuffer(
-								  bgfx::copy(bc.textBuffer->getVertexBuffer(), vertexSize)
-								, m_vertexLayout
-								);
+	const uint32_t indexSize  = _bc.textBuffer->getIndexCount()  * _bc.textBuffer->getIndexSize();
+	const uint32_t vertexSize = _bc.textBuffer->getVertexCount() * _bc.textBuffer->getVertexSize();
+
+	bgfx::TransientIndexBuffer tib;
+	bgfx::TransientVertexBuffer tvb;
+	bgfx::allocTransientIndexBuffer(&tib, _bc.textBuffer->getIndexCount() );
+	bgfx::allocTransientVertexBuffer(&tvb, _bc.textBuffer->getVertexCount(), m_vertexLayout);
+	bx::memCopy(tib.data, _bc.textBuffer->getIndexBuffer(), indexSize);
+	bx::memCopy(tvb.data, _bc.textBuffer->getVertexBuffer(), vertexSize);
+	bgfx::setVertexBuffer(0, &tvb, 0, _bc.textBuffer->getVertexCount() );
+	bgfx::setIndexBuffer(&tib, 0, _bc.textBuffer->getIndexCount() );
+	return false;
+}
 
-				bc.vertexBufferHandleIdx = vbh.idx;
-				bc.indexBufferHandleIdx = ibh.idx;
-			}
-			else
+uint32_t TextBufferManager::poolAlloc(uint32_t _size)
+{
+	// First fit, so that buffers created one after another end up next to each other.
+	for (uint32_t ii = 0, num = uint32_t(m_poolFree.size() ); ii < num; ++ii)
+	{
+		PoolRange& range = m_poolFree[ii];
+
+		if (range.size >= _size)
+		{
+			const uint32_t offset = range.offset;
+			range.offset += _size;
+			range.size   -= _size;
+
+			if (0 == range.size)
 			{
-				vbh.idx = bc.vertexBufferHandleIdx;
-				ibh.idx = bc.indexBufferHandleIdx;
+				m_poolFree.erase(m_poolFree.begin() + ii);
 			}
 
-			bgfx::setVertexBuffer(0, vbh, 0, bc.textBuffer->getVertexCount() );
-			bgfx::setIndexBuffer(ibh, 0, bc.textBuffer->getIndexCount() );
+			return offset;
+		}
+	}
+
+	return UINT32_MAX;
+}
+
+void TextBufferManager::poolFree(uint32_t _offset, uint32_t _size)
+{
+	const uint32_t num = uint32_t(m_poolFree.size() );
+
+	uint32_t ii = 0;
+	while (ii < num
+	&&     m_poolFree[ii].offset < _offset)
+	{
+		++ii;
+	}
+
+	const bool mergePrev = 0 < ii  && m_poolFree[ii-1].offset + m_poolFree[ii-1].size == _offset;
+	const bool mergeNext = ii < num && _offset + _size == m_poolFree[ii].offset;
+
+	if (mergePrev
+	&&  mergeNext)
+	{
+		m_poolFree[ii-1].size += _size + m_poolFree[ii].size;
+		m_poolFree.erase(m_poolFree.begin() + ii);
+	}
+	else if (mergePrev)
+	{
+		m_poolFree[ii-1].size += _size;
+	}
+	else if (mergeNext)
+	{
+		m_poolFree[ii].offset = _offset;
+		m_poolFree[ii].size  += _size;
+	}
+	else
+	{
+		const PoolRange range = { _offset, _size };
+		m_poolFree.insert(m_poolFree.begin() + ii, range);
+	}
+}
+
+bool TextBufferManager::updatePool(BufferCache& _bc)
+{
+	// Pool holds one instance per quad.
+	if (!m_instanced)
+	{
+		return false;
+	}
+
+	const uint32_t numQuads = _bc.textBuffer->getVertexCount()/4;
+
+	if (numQuads > _bc.poolSize)
+	{
+		if (UINT32_MAX != _bc.poolOffset)
+		{
+			poolFree(_bc.poolOffset, _bc.poolSize);
+		}
+
+		_bc.poolOffset = poolAlloc(numQuads);
+		_bc.poolSize   = UINT32_MAX == _bc.poolOffset ? 0 : numQuads;
+
+		BX_WARN(UINT32_MAX != _bc.poolOffset
+			, "Static text pool is full (requested %d glyphs), text is drawn as transient."
+			, numQuads
+			);
+
+		if (UINT32_MAX == _bc.poolOffset)
+		{
+			return false;
+		}
+	}
+
+	if (!bgfx::isValid(m_poolVb) )
+	{
+		m_poolVb   = bgfx::createDynamicVertexBuffer(m_poolCapacity, m_instanceLayout);
+		m_poolData = new GlyphInstance[m_poolCapacity];
+	}
+
+	GlyphInstance* instances = &m_poolData[_bc.poolOffset];
+	_bc.textBuffer->writeInstances(instances);
+
+	bgfx::update(
+		  m_poolVb
+		, _bc.poolOffset
+		, bgfx::copy(instances, numQuads*sizeof(GlyphInstance) )
+		);
+
+	_bc.dirty = false;
+
+	return true;
+}
+
+void TextBufferManager::submitTextBuffer(TextBufferHandle _handle, bgfx::ViewId _id, int32_t _depth)
+{
+	BX_CHECK(bgfx::isValid(_handle), "Invalid handle used");
+
+	BufferCache& bc = m_textBuffers[_handle.idx];
+
+	uint32_t indexSize  = bc.textBuffer->getIndexCount()  * bc.textBuffer->getIndexSize();
+	uint32_t vertexSize = bc.textBuffer->getVertexCount() * bc.textBuffer->getVertexSize();
+
+	if (0 == indexSize || 0 == vertexSize)
+	{
+		return;
+	}
+
+	prepareGlyphs(bc);
+
+	bool instanced = false;
+
+	switch (bc.bufferType)
+	{
+	case BufferType::Static:
+		if (!bc.dirty
+		||  updatePool(bc) )
+		{
+			setQuadBuffers();
+			bgfx::setInstanceDataBuffer(m_poolVb, bc.poolOffset, bc.textBuffer->getVertexCount()/4);
+			instanced = true;
+		}
+		else
+		{
+			instanced = submitTransient(bc);
 		}
 		break;
 
@@ -779,41 +1149,184 @@ void TextBufferManager::submitTextBuffer(TextBufferHandle _handle, bgfx::ViewId
 				ibh.idx = bc.indexBufferHandleIdx;
 				vbh.idx = bc.vertexBufferHandleIdx;
 
-				bgfx::update(
-					  ibh
-					, 0
-					, bgfx::copy(bc.textBuffer->getIndexBuffer(), indexSize)
-					);
-
-				bgfx::update(
-					  vbh
-					, 0
-					, bgfx::copy(bc.textBuffer->getVertexBuffer(), vertexSize)
-					);
+				if (bc.dirty)
+				{
+					bgfx::update(
+						  ibh
+						, 0
+						, bgfx::copy(bc.textBuffer->getIndexBuffer(), indexSize)
+						);
+
+					bgfx::update(
+						  vbh
+						, 0
+						, bgfx::copy(bc.textBuffer->getVertexBuffer(), vertexSize)
+						);
+				}
 			}
 
+			bc.dirty = false;
+
 			bgfx::setVertexBuffer(0, vbh, 0, bc.textBuffer->getVertexCount() );
 			bgfx::setIndexBuffer(ibh, 0, bc.textBuffer->getIndexCount() );
 		}
 		break;
 
 	case BufferType::Transient:
-		{
-			bgfx::TransientIndexBuffer tib;
-			bgfx::TransientVertexBuffer tvb;
-			bgfx::allocTransientIndexBuffer(&tib, bc.textBuffer->getIndexCount() );
-			bgfx::allocTransientVertexBuffer(&tvb, bc.textBuffer->getVertexCount(), m_vertexLayout);
-			bx::memCopy(tib.data, bc.textBuffer->getIndexBuffer(), indexSize);
-			bx::memCopy(tvb.data, bc.textBuffer->getVertexBuffer(), vertexSize);
-			bgfx::setVertexBuffer(0, &tvb, 0, bc.textBuffer->getVertexCount() );
-			bgfx::setIndexBuffer(&tib, 0, bc.textBuffer->getIndexCount() );
-		}
+		instanced = submitTransient(bc);
 		break;
 	}
 
+	bgfx::ProgramHandle program = setRenderState(bc, instanced);
 	bgfx::submit(_id, program, _depth);
 }
 
+static int32_t compareBatchItem(const void* _lhs, const void* _rhs)
+{
+	const uint32_t* lhs = (const uint32_t*)_lhs;
+	const uint32_t* rhs = (const uint32_t*)_rhs;
+
+	// Compare font type and key first, then offset.
+	for (uint32_t ii = 0; ii < 3; ++ii)
+	{
+		if (lhs[ii] != rhs[ii])
+		{
+			return lhs[ii] < rhs[ii] ? -1 : 1;
+		}
+	}
+
+	return 0;
+}
+
+void TextBufferManager::submitTextBuffers(const TextBufferHandle* _handles, uint32_t _num, bgfx::ViewId _id, int32_t _depth)
+{
+	m_batch.clear();
+
+	for (uint32_t ii = 0; ii < _num; ++ii)
+	{
+		const TextBufferHandle handle = _handles[ii];
+		BX_CHECK(bgfx::isValid(handle), "Invalid handle used");
+
+		BufferCache& bc = m_textBuffers[handle.idx];
+
+		const uint32_t numQuads = bc.textBuffer->getVertexCount()/4;
+
+		if (0 == numQuads)
+		{
+			continue;
+		}
+
+		// Dynamic buffers keep their own vertex and index buffers.
+		if (!m_instanced
+		||  BufferType::Dynamic == bc.bufferType)
+		{
+			submitTextBuffer(handle, _id, _depth);
+			continue;
+		}
+
+		prepareGlyphs(bc);
+
+		// Transient text, and static text that didn't fit into pool, is written directly into
+		// batch instance data.
+		uint32_t offset = UINT32_MAX;
+		if (BufferType::Static == bc.bufferType
+		&&  (!bc.dirty || updatePool(bc) ) )
+		{
+			offset = bc.poolOffset;
+		}
+
+		// Subpixel distance field text uses text color as blend factor, so only buffers with
+		// same color can be drawn together.
+		BatchItem item;
+		item.fontType = bc.fontType;
+		item.key      = FONT_TYPE_DISTANCE_SUBPIXEL == bc.fontType
+			? bc.textBuffer->getTextColor()
+			: 0
+			;
+		item.offset    = offset;
+		item.numQuads  = numQuads;
+		item.handleIdx = handle.idx;
+		m_batch.push_back(item);
+	}
+
+	const uint32_t num = uint32_t(m_batch.size() );
+	if (0 == num)
+	{
+		return;
+	}
+
+	// All buffers share one atlas, so batch is split only by font type and key. Within batch
+	// items are sorted by pool offset, text not in pool comes last.
+	bx::quickSort(&m_batch[0], num, sizeof(BatchItem), compareBatchItem);
+
+	for (uint32_t ii = 0; ii < num;)
+	{
+		const BatchItem& first = m_batch[ii];
+
+		uint32_t last     = ii+1;
+		uint32_t numQuads = first.numQuads;
+		bool     adjacent = UINT32_MAX != first.offset;
+
+		for (; last < num; ++last)
+		{
+			const BatchItem& item = m_batch[last];
+			if (item.fontType != first.fontType
+			||  item.key      != first.key)
+			{
+				break;
+			}
+
+			adjacent &= item.offset == first.offset + numQuads;
+			numQuads += item.numQuads;
+		}
+
+		const BufferCache& bc = m_textBuffers[first.handleIdx];
+
+		bgfx::InstanceDataBuffer idb;
+		if (adjacent)
+		{
+			// Whole batch is one range of static pool, nothing is uploaded.
+			setQuadBuffers();
+			bgfx::setInstanceDataBuffer(m_poolVb, first.offset, numQuads);
+			bgfx::submit(_id, setRenderState(bc, true), _depth);
+		}
+		else if (bgfx::tryAllocInstanceDataBuffer(&idb, numQuads, sizeof(GlyphInstance) ) )
+		{
+			GlyphInstance* dst = (GlyphInstance*)idb.data;
+			for (uint32_t jj = ii; jj < last; ++jj)
+			{
+				const BatchItem& item = m_batch[jj];
+
+				if (UINT32_MAX != item.offset)
+				{
+					bx::memCopy(dst, &m_poolData[item.offset], item.numQuads*sizeof(GlyphInstance) );
+				}
+				else
+				{
+					m_textBuffers[item.handleIdx].textBuffer->writeInstances(dst);
+				}
+
+				dst += item.numQuads;
+			}
+
+			setQuadBuffers();
+			bgfx::setInstanceDataBuffer(&idb);
+			bgfx::submit(_id, setRenderState(bc, true), _depth);
+		}
+		else
+		{
+			// Out of transient instance data, each buffer is drawn on its own.
+			for (uint32_t jj = ii; jj < last; ++jj)
+			{
+				const TextBufferHandle handle = { m_batch[jj].handleIdx };
+				submitTextBuffer(handle, _id, _depth);
+			}
+		}
+
+		ii = last;
+	}
+}
+
 void TextBufferManager::setStyle(TextBufferHandle _handle, uint32_t _flags)
 {
 	BX_CHECK(bgfx::isValid(_handle), "Invalid handle used");
@@ -867,6 +1380,7 @@ void TextBufferManager::appendText(TextBufferHandle _handle, FontHandle _fontHan
 {
 	BX_CHECK(bgfx::isValid(_handle), "Invalid handle used");
 	BufferCache& bc = m_textBuffers[_handle.idx];
+	bc.dirty = true;
 	bc.textBuffer->appendText(_fontHandle, _string, _end);
 }
 
@@ -874,6 +1388,7 @@ void TextBufferManager::appendText(TextBufferHandle _handle, FontHandle _fontHan
 {
 	BX_CHECK(bgfx::isValid(_handle), "Invalid handle used");
 	BufferCache& bc = m_textBuffers[_handle.idx];
+	bc.dirty = true;
 	bc.textBuffer->appendText(_fontHandle, _string, _end);
 }
 
@@ -881,6 +1396,7 @@ void TextBufferManager::appendAtlasFace(TextBufferHandle _handle, uint16_t _face
 {
 	BX_CHECK(bgfx::isValid(_handle), "Invalid handle used");
 	BufferCache& bc = m_textBuffers[_handle.idx];
+	bc.dirty = true;
 	bc.textBuffer->appendAtlasFace(_faceIndex);
 }
 
@@ -888,6 +1404,7 @@ void TextBufferManager::clearTextBuffer(TextBufferHandle _handle)
 {
 	BX_CHECK(bgfx::isValid(_handle), "Invalid handle used");
 	BufferCache& bc = m_textBuffers[_handle.idx];
+	bc.dirty = true;
 	bc.textBuffer->clearTextBuffer();
 }
 
@@ -897,3 +1414,10 @@ TextRectangle TextBufferManager::getRectangle(TextBufferHandle _handle) const
 	BufferCache& bc = m_textBuffers[_handle.idx];
 	return bc.textBuffer->getRectangle();
 }
+
+bool TextBufferManager::isTextBufferStale(TextBufferHandle _handle) const
+{
+	BX_CHECK(bgfx::isValid(_handle), "Invalid handle used");
+	BufferCache& bc = m_textBuffers[_handle.idx];
+	return bc.textBuffer->isStale();
+}
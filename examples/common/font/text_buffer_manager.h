@@ -8,6 +8,10 @@
 
 #include "font_manager.h"
 
+#include <tinystl/allocator.h>
+#include <tinystl/vector.h>
+namespace stl = tinystl;
+
 BGFX_HANDLE(TextBufferHandle);
 
 #define MAX_TEXT_BUFFER_COUNT 64
@@ -17,7 +21,7 @@ struct BufferType
 {
 	enum Enum
 	{
-		Static,
+		Static,    //!< Sub-allocated from shared static instance pool, uploaded only when text changes.
 		Dynamic,
 		Transient,
 	};
@@ -39,16 +43,28 @@ struct TextRectangle
 };
 
 class TextBuffer;
+struct GlyphInstance;
+
 class TextBufferManager
 {
 public:
-	TextBufferManager(FontManager* _fontManager);
+	/// When `BGFX_CAPS_INSTANCING` is supported, static and transient text is drawn as one
+	/// instance per quad (glyph or style decoration). Static text buffers share one instance
+	/// buffer with space for `_maxStaticGlyphs` quads. When pool is full, or instancing is not
+	/// supported, static buffers are drawn as transient.
+	TextBufferManager(FontManager* _fontManager, uint32_t _maxStaticGlyphs = 32<<10);
 	~TextBufferManager();
 
 	TextBufferHandle createTextBuffer(uint32_t _type, BufferType::Enum _bufferType);
 	void destroyTextBuffer(TextBufferHandle _handle);
 	void submitTextBuffer(TextBufferHandle _handle, bgfx::ViewId _id, int32_t _depth = 0);
 
+	/// Submit multiple text buffers. Static and transient buffers sharing atlas and render state
+	/// are drawn with single instanced draw call. When all of them are adjacent in static pool,
+	/// which is usual for static buffers created one after another, nothing is uploaded,
+	/// otherwise their instances are gathered into transient instance data buffer.
+	void submitTextBuffers(const TextBufferHandle* _handles, uint32_t _num, bgfx::ViewId _id, int32_t _depth = 0);
+
 	void setStyle(TextBufferHandle _handle, uint32_t _flags = STYLE_NORMAL);
 	void setTextColor(TextBufferHandle _handle, uint32_t _rgba = 0x000000FF);
 	void setBackgroundColor(TextBufferHandle _handle, uint32_t _rgba = 0x000000FF);
@@ -74,6 +90,11 @@ public:
 	/// Return the rectangular size of the current text buffer (including all its content).
 	TextRectangle getRectangle(TextBufferHandle _handle) const;
 
+	/// Return true if glyphs of the text buffer were evicted from the atlas since text was
+	/// appended. Missing glyphs are not drawn until the text buffer is cleared and text is
+	/// appended again.
+	bool isTextBufferStale(TextBufferHandle _handle) const;
+
 private:
 	struct BufferCache
 	{
@@ -82,16 +103,57 @@ private:
 		TextBuffer* textBuffer;
 		BufferType::Enum bufferType;
 		uint32_t fontType;
+		uint32_t poolOffset; //!< First instance in static pool, UINT32_MAX when not allocated.
+		uint32_t poolSize;   //!< Number of instances allocated in static pool.
+		bool dirty;          //!< Text changed since last upload.
+	};
+
+	struct PoolRange
+	{
+		uint32_t offset;
+		uint32_t size;
+	};
+
+	struct BatchItem
+	{
+		uint32_t fontType;
+		uint32_t key;
+		uint32_t offset;   //!< Offset in static pool, UINT32_MAX when not in pool.
+		uint32_t numQuads;
+		uint16_t handleIdx;
 	};
 
+	void prepareGlyphs(BufferCache& _bc);
+	bgfx::ProgramHandle setRenderState(const BufferCache& _bc, bool _instanced);
+	void setQuadBuffers();
+	bool submitTransient(const BufferCache& _bc);
+	bool updatePool(BufferCache& _bc);
+	uint32_t poolAlloc(uint32_t _size);
+	void poolFree(uint32_t _offset, uint32_t _size);
+
 	BufferCache* m_textBuffers;
 	bx::HandleAllocT<MAX_TEXT_BUFFER_COUNT> m_textBufferHandles;
 	FontManager* m_fontManager;
 	bgfx::VertexLayout m_vertexLayout;
+	bgfx::VertexLayout m_quadLayout;
+	bgfx::VertexLayout m_instanceLayout;
 	bgfx::UniformHandle s_texColor;
 	bgfx::ProgramHandle m_basicProgram;
 	bgfx::ProgramHandle m_distanceProgram;
 	bgfx::ProgramHandle m_distanceSubpixelProgram;
+	bgfx::ProgramHandle m_basicInstancedProgram;
+	bgfx::ProgramHandle m_distanceInstancedProgram;
+	bgfx::ProgramHandle m_distanceSubpixelInstancedProgram;
+	bool m_instanced;
+
+	bgfx::VertexBufferHandle m_quadVb;
+	bgfx::IndexBufferHandle  m_quadIb;
+
+	bgfx::DynamicVertexBufferHandle m_poolVb;
+	GlyphInstance* m_poolData; //!< CPU copy of static pool, used to gather batches.
+	uint32_t m_poolCapacity;
+	stl::vector<PoolRange> m_poolFree; //!< Sorted by offset, adjacent ranges are merged.
+	stl::vector<BatchItem> m_batch;
 };
 
 #endif // TEXT_BUFFER_MANAGER_H_HEADER_GUARD
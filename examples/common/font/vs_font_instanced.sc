@@ -0,0 +1,18 @@
+$input a_position, i_data0, i_data1, i_data2, i_data3
+$output v_color0, v_texcoord0
+
+#include "../../common/common.sh"
+
+void main()
+{
+	// Glyph rectangle is in i_data0, and a_position is quad corner in [0, 1] range. Atlas
+	// coordinates of (x0, y0) and (x1, y1) corners are in i_data1.xyz and i_data2.xyz, bits of
+	// i_data2.w mark coordinates which follow y, others follow x.
+	vec2 pos = mix(i_data0.xy, i_data0.zw, a_position);
+	gl_Position = mul(u_modelViewProj, vec4(pos, 0.0, 1.0) );
+
+	vec3 followY = mod(floor(vec3_splat(i_data2.w) / vec3(1.0, 2.0, 4.0) ), 2.0);
+	vec3 tt = mix(vec3_splat(a_position.x), vec3_splat(a_position.y), followY);
+	v_texcoord0 = vec4(mix(i_data1.xyz, i_data2.xyz, tt), i_data1.w);
+	v_color0 = i_data3;
+}
@@ -79,86 +79,236 @@ struct OcornutImguiContext
 			bgfx::setViewRect(m_viewId, 0, 0, uint16_t(width), uint16_t(height) );
 		}
 
-		// Render command lists
-		for (int32_t ii = 0, num = _drawData->CmdListsCount; ii < num; ++ii)
+		const uint32_t numVertices = uint32_t(_drawData->TotalVtxCount);
+		const uint32_t numIndices  = uint32_t(_drawData->TotalIdxCount);
+
+		if (0 == numIndices)
 		{
-			bgfx::TransientVertexBuffer tvb;
-			bgfx::TransientIndexBuffer tib;
+			return;
+		}
 
-			const ImDrawList* drawList = _drawData->CmdLists[ii];
-			uint32_t numVertices = (uint32_t)drawList->VtxBuffer.size();
-			uint32_t numIndices  = (uint32_t)drawList->IdxBuffer.size();
+		// All draw lists are packed into single allocation. When transient memory is exhausted,
+		// they are uploaded into persistent dynamic buffers instead of skipping the rest of UI.
+		bgfx::TransientVertexBuffer tvb;
+		bgfx::TransientIndexBuffer tib;
+		const bgfx::Memory* vbMem = NULL;
+		const bgfx::Memory* ibMem = NULL;
 
-			if (!checkAvailTransientBuffers(numVertices, m_layout, numIndices) )
+		ImDrawVert* verts;
+		ImDrawIdx*  indices;
+
+		const bool transient = bgfx::allocTransientBuffers(&tvb, m_layout, numVertices, &tib, numIndices);
+		if (transient)
+		{
+			verts   = (ImDrawVert*)tvb.data;
+			indices = (ImDrawIdx*)tib.data;
+		}
+		else
+		{
+			vbMem   = bgfx::alloc(numVertices*sizeof(ImDrawVert) );
+			ibMem   = bgfx::alloc(numIndices*sizeof(ImDrawIdx) );
+			verts   = (ImDrawVert*)vbMem->data;
+			indices = (ImDrawIdx*)ibMem->data;
+		}
+
+		// Draw lists share vertex buffer segments of up to 64K vertices, and their indices are
+		// rebased to segment start, so that commands from different draw lists can be merged.
+		{
+			uint32_t vertexOffset = 0;
+			uint32_t indexOffset  = 0;
+			uint32_t segmentStart = 0;
+
+			for (int32_t ii = 0, num = _drawData->CmdListsCount; ii < num; ++ii)
 			{
-				// not enough space in transient buffer just quit drawing the rest...
-				break;
+				const ImDrawList* drawList = _drawData->CmdLists[ii];
+				const uint32_t listVertices = uint32_t(drawList->VtxBuffer.size() );
+				const uint32_t listIndices  = uint32_t(drawList->IdxBuffer.size() );
+
+				if (vertexOffset + listVertices - segmentStart > kMaxSegmentVertices)
+				{
+					segmentStart = vertexOffset;
+				}
+
+				bx::memCopy(&verts[vertexOffset], drawList->VtxBuffer.begin(), listVertices*sizeof(ImDrawVert) );
+
+				const ImDrawIdx base = ImDrawIdx(vertexOffset - segmentStart);
+				if (0 == base)
+				{
+					bx::memCopy(&indices[indexOffset], drawList->IdxBuffer.begin(), listIndices*sizeof(ImDrawIdx) );
+				}
+				else
+				{
+					const ImDrawIdx* src = drawList->IdxBuffer.begin();
+					ImDrawIdx* dst = &indices[indexOffset];
+					for (uint32_t jj = 0; jj < listIndices; ++jj)
+					{
+						dst[jj] = ImDrawIdx(src[jj] + base);
+					}
+				}
+
+				vertexOffset += listVertices;
+				indexOffset  += listIndices;
+			}
+		}
+
+		if (!transient)
+		{
+			// Buffers are updated before any draw references them, resize can move them.
+			if (!bgfx::isValid(m_vbh) )
+			{
+				m_vbh = bgfx::createDynamicVertexBuffer(numVertices, m_layout, BGFX_BUFFER_ALLOW_RESIZE);
+				m_ibh = bgfx::createDynamicIndexBuffer(numIndices, BGFX_BUFFER_ALLOW_RESIZE);
 			}
 
-			bgfx::allocTransientVertexBuffer(&tvb, numVertices, m_layout);
-			bgfx::allocTransientIndexBuffer(&tib, numIndices);
+			bgfx::update(m_vbh, 0, vbMem);
+			bgfx::update(m_ibh, 0, ibMem);
+		}
 
-			ImDrawVert* verts = (ImDrawVert*)tvb.data;
-			bx::memCopy(verts, drawList->VtxBuffer.begin(), numVertices * sizeof(ImDrawVert) );
+		// Render command lists
+		DrawBatch batch;
+		batch.m_numIndices = 0;
 
-			ImDrawIdx* indices = (ImDrawIdx*)tib.data;
-			bx::memCopy(indices, drawList->IdxBuffer.begin(), numIndices * sizeof(ImDrawIdx) );
+		uint32_t vertexOffset = 0;
+		uint32_t indexOffset  = 0;
+		uint32_t segmentStart = 0;
+
+		for (int32_t ii = 0, num = _drawData->CmdListsCount; ii < num; ++ii)
+		{
+			const ImDrawList* drawList = _drawData->CmdLists[ii];
+			const uint32_t listVertices = uint32_t(drawList->VtxBuffer.size() );
+			const uint32_t listIndices  = uint32_t(drawList->IdxBuffer.size() );
 
-			uint32_t offset = 0;
+			if (vertexOffset + listVertices - segmentStart > kMaxSegmentVertices)
+			{
+				segmentStart = vertexOffset;
+			}
+
+			uint32_t offset = indexOffset;
 			for (const ImDrawCmd* cmd = drawList->CmdBuffer.begin(), *cmdEnd = drawList->CmdBuffer.end(); cmd != cmdEnd; ++cmd)
 			{
 				if (cmd->UserCallback)
 				{
+					submit(batch, transient ? &tvb : NULL, transient ? &tib : NULL, numVertices);
 					cmd->UserCallback(drawList, cmd);
 				}
 				else if (0 != cmd->ElemCount)
 				{
-					uint64_t state = 0
+					DrawBatch next;
+					next.m_state = 0
 						| BGFX_STATE_WRITE_RGB
 						| BGFX_STATE_WRITE_A
 						| BGFX_STATE_MSAA
 						;
 
-					bgfx::TextureHandle th = m_texture;
-					bgfx::ProgramHandle program = m_program;
+					next.m_texture = m_texture;
+					next.m_mip     = 0;
 
 					if (NULL != cmd->TextureId)
 					{
 						union { ImTextureID ptr; struct { bgfx::TextureHandle handle; uint8_t flags; uint8_t mip; } s; } texture = { cmd->TextureId };
-						state |= 0 != (IMGUI_FLAGS_ALPHA_BLEND & texture.s.flags)
+						next.m_state |= 0 != (IMGUI_FLAGS_ALPHA_BLEND & texture.s.flags)
 							? BGFX_STATE_BLEND_FUNC(BGFX_STATE_BLEND_SRC_ALPHA, BGFX_STATE_BLEND_INV_SRC_ALPHA)
 							: BGFX_STATE_NONE
 							;
-						th = texture.s.handle;
-						if (0 != texture.s.mip)
-						{
-							const float lodEnabled[4] = { float(texture.s.mip), 1.0f, 0.0f, 0.0f };
-							bgfx::setUniform(u_imageLodEnabled, lodEnabled);
-							program = m_imageProgram;
-						}
+						next.m_texture = texture.s.handle;
+						next.m_mip     = texture.s.mip;
 					}
 					else
 					{
-						state |= BGFX_STATE_BLEND_FUNC(BGFX_STATE_BLEND_SRC_ALPHA, BGFX_STATE_BLEND_INV_SRC_ALPHA);
+						next.m_state |= BGFX_STATE_BLEND_FUNC(BGFX_STATE_BLEND_SRC_ALPHA, BGFX_STATE_BLEND_INV_SRC_ALPHA);
 					}
 
-					const uint16_t xx = uint16_t(bx::max(cmd->ClipRect.x, 0.0f) );
-					const uint16_t yy = uint16_t(bx::max(cmd->ClipRect.y, 0.0f) );
-					bgfx::setScissor(xx, yy
-						, uint16_t(bx::min(cmd->ClipRect.z, 65535.0f)-xx)
-						, uint16_t(bx::min(cmd->ClipRect.w, 65535.0f)-yy)
-						);
+					const float clipX = bx::max(cmd->ClipRect.x, 0.0f);
+					const float clipY = bx::max(cmd->ClipRect.y, 0.0f);
+					const float clipZ = bx::min(cmd->ClipRect.z, 65535.0f);
+					const float clipW = bx::min(cmd->ClipRect.w, 65535.0f);
 
-					bgfx::setState(state);
-					bgfx::setTexture(0, s_tex, th);
-					bgfx::setVertexBuffer(0, &tvb, 0, numVertices);
-					bgfx::setIndexBuffer(&tib, offset, cmd->ElemCount);
-					bgfx::submit(m_viewId, program);
+					if (clipX < clipZ
+					&&  clipY < clipW)
+					{
+						next.m_scissor[0] = uint16_t(clipX);
+						next.m_scissor[1] = uint16_t(clipY);
+						next.m_scissor[2] = uint16_t(clipZ)-next.m_scissor[0];
+						next.m_scissor[3] = uint16_t(clipW)-next.m_scissor[1];
+						next.m_startVertex = segmentStart;
+						next.m_startIndex  = offset;
+						next.m_numIndices  = cmd->ElemCount;
+
+						// Commands are merged when they are adjacent in index buffer, and draw
+						// with the same texture, state and scissor.
+						if (0 != batch.m_numIndices
+						&&  batch.m_startVertex == next.m_startVertex
+						&&  batch.m_startIndex + batch.m_numIndices == next.m_startIndex
+						&&  batch.m_state       == next.m_state
+						&&  batch.m_texture.idx == next.m_texture.idx
+						&&  batch.m_mip         == next.m_mip
+						&&  0 == bx::memCmp(batch.m_scissor, next.m_scissor, sizeof(next.m_scissor) ) )
+						{
+							batch.m_numIndices += next.m_numIndices;
+						}
+						else
+						{
+							submit(batch, transient ? &tvb : NULL, transient ? &tib : NULL, numVertices);
+							batch = next;
+						}
+					}
 				}
 
 				offset += cmd->ElemCount;
 			}
+
+			vertexOffset += listVertices;
+			indexOffset  += listIndices;
+		}
+
+		submit(batch, transient ? &tvb : NULL, transient ? &tib : NULL, numVertices);
+	}
+
+	struct DrawBatch
+	{
+		uint64_t m_state;
+		bgfx::TextureHandle m_texture;
+		uint8_t  m_mip;
+		uint16_t m_scissor[4];
+		uint32_t m_startVertex;
+		uint32_t m_startIndex;
+		uint32_t m_numIndices;
+	};
+
+	void submit(DrawBatch& _batch, const bgfx::TransientVertexBuffer* _tvb, const bgfx::TransientIndexBuffer* _tib, uint32_t _numVertices)
+	{
+		if (0 == _batch.m_numIndices)
+		{
+			return;
+		}
+
+		bgfx::ProgramHandle program = m_program;
+		if (0 != _batch.m_mip)
+		{
+			const float lodEnabled[4] = { float(_batch.m_mip), 1.0f, 0.0f, 0.0f };
+			bgfx::setUniform(u_imageLodEnabled, lodEnabled);
+			program = m_imageProgram;
+		}
+
+		bgfx::setScissor(_batch.m_scissor[0], _batch.m_scissor[1], _batch.m_scissor[2], _batch.m_scissor[3]);
+		bgfx::setState(_batch.m_state);
+		bgfx::setTexture(0, s_tex, _batch.m_texture);
+
+		const uint32_t numVertices = _numVertices - _batch.m_startVertex;
+		if (NULL != _tvb)
+		{
+			bgfx::setVertexBuffer(0, _tvb, _batch.m_startVertex, numVertices);
+			bgfx::setIndexBuffer(_tib, _batch.m_startIndex, _batch.m_numIndices);
 		}
+		else
+		{
+			bgfx::setVertexBuffer(0, m_vbh, _batch.m_startVertex, numVertices);
+			bgfx::setIndexBuffer(m_ibh, _batch.m_startIndex, _batch.m_numIndices);
+		}
+
+		bgfx::submit(m_viewId, program);
+
+		_batch.m_numIndices = 0;
 	}
 
 	void create(float _fontSize, bx::AllocatorI* _allocator)
@@ -173,6 +323,8 @@ struct OcornutImguiContext
 
 		m_viewId = 255;
 		m_lastScroll = 0;
+		m_vbh = BGFX_INVALID_HANDLE;
+		m_ibh = BGFX_INVALID_HANDLE;
 		m_last = bx::getHPCounter();
 
 		ImGui::SetAllocatorFunctions(memAlloc, memFree, NULL);
@@ -305,6 +457,12 @@ struct OcornutImguiContext
 		ImGui::ShutdownDockContext();
 		ImGui::DestroyContext(m_imgui);
 
+		if (bgfx::isValid(m_vbh) )
+		{
+			bgfx::destroy(m_vbh);
+			bgfx::destroy(m_ibh);
+		}
+
 		bgfx::destroy(s_tex);
 		bgfx::destroy(m_texture);
 
@@ -389,6 +547,8 @@ struct OcornutImguiContext
 		render(ImGui::GetDrawData() );
 	}
 
+	static const uint32_t kMaxSegmentVertices = UINT16_MAX+1;
+
 	ImGuiContext*       m_imgui;
 	bx::AllocatorI*     m_allocator;
 	bgfx::VertexLayout  m_layout;
@@ -397,6 +557,8 @@ struct OcornutImguiContext
 	bgfx::TextureHandle m_texture;
 	bgfx::UniformHandle s_tex;
 	bgfx::UniformHandle u_imageLodEnabled;
+	bgfx::DynamicVertexBufferHandle m_vbh; //!< Fallback when transient memory is exhausted.
+	bgfx::DynamicIndexBufferHandle  m_ibh;
 	ImFont* m_font[ImGui::Font::Count];
 	int64_t m_last;
 	int32_t m_lastScroll;
@@ -0,0 +1,105 @@
+$input v_position, v_texcoord0, v_paint
+
+/*
+ * Copyright 2011-2019 Branimir Karadzic. All rights reserved.
+ * License: https://github.com/bkaradzic/bgfx#license-bsd-2-clause
+ */
+
+#include "bgfx_compute.sh"
+
+#define EDGE_AA 1
+
+// Paint parameters, laid out as GLNVGfragUniforms in nanovg_bgfx.cpp.
+BUFFER_RO(paintBuffer, vec4, 1);
+
+uniform vec4 u_viewSize;
+
+SAMPLER2D(s_tex, 0);
+
+#define u_paintStride (u_viewSize.z)
+
+float sdroundrect(vec2 pt, vec2 ext, float rad)
+{
+	vec2 ext2 = ext - vec2(rad,rad);
+	vec2 d = abs(pt) - ext2;
+	return min(max(d.x, d.y), 0.0) + length(max(d, 0.0) ) - rad;
+}
+
+// Matrices are stored as 3 vec4 columns.
+vec2 transform(uint _offset, vec2 _pt)
+{
+	return paintBuffer[_offset+0u].xy*_pt.x
+		 + paintBuffer[_offset+1u].xy*_pt.y
+		 + paintBuffer[_offset+2u].xy
+		 ;
+}
+
+void main()
+{
+	uint paint = uint(v_paint + 0.5) * uint(u_paintStride);
+
+	vec4  innerCol      = paintBuffer[paint+6u];
+	vec4  outerCol      = paintBuffer[paint+7u];
+	vec4  scissorParams = paintBuffer[paint+8u];
+	vec4  extentRadius  = paintBuffer[paint+9u];
+	vec4  params        = paintBuffer[paint+10u];
+
+	vec2  extent     = extentRadius.xy;
+	float radius     = extentRadius.z;
+	float feather    = extentRadius.w;
+	float strokeMult = params.x;
+	float texType    = params.y;
+	float type       = params.z;
+
+	// Scissoring
+	vec2 sc = abs(transform(paint, v_position) ) - scissorParams.xy;
+	sc = vec2(0.5, 0.5) - sc * scissorParams.zw;
+	float scissor = clamp(sc.x, 0.0, 1.0) * clamp(sc.y, 0.0, 1.0);
+
+	// Stroke - from [0..1] to clipped pyramid, where the slope is 1px.
+#if EDGE_AA
+	float strokeAlpha = min(1.0, (1.0 - abs(v_texcoord0.x*2.0 - 1.0) )*strokeMult) * min(1.0, v_texcoord0.y);
+#else
+	float strokeAlpha = 1.0;
+#endif // EDGE_AA
+
+	vec4 result;
+
+	if (type == 0.0) // Gradient
+	{
+		// Calculate gradient color using box gradient
+		vec2 pt = transform(paint+3u, v_position);
+		float d = clamp( (sdroundrect(pt, extent, radius) + feather*0.5) / feather, 0.0, 1.0);
+		vec4 color = mix(innerCol, outerCol, d);
+		// Combine alpha
+		color *= strokeAlpha * scissor;
+		result = color;
+	}
+	else if (type == 1.0) // Image
+	{
+		// Calculate color from texture
+		vec2 pt = transform(paint+3u, v_position) / extent;
+		vec4 color = texture2D(s_tex, pt);
+		if (texType == 1.0) color = vec4(color.xyz * color.w, color.w);
+		if (texType == 2.0) color = color.xxxx;
+		// Apply color tint and alpha
+		color *= innerCol;
+		// Combine alpha
+		color *= strokeAlpha * scissor;
+		result = color;
+	}
+	else if (type == 2.0) // Stencil fill
+	{
+		result = vec4(1.0, 1.0, 1.0, 1.0);
+	}
+	else // Textured tris
+	{
+		vec4 color = texture2D(s_tex, v_texcoord0.xy);
+		if (texType == 1.0) color = vec4(color.xyz * color.w, color.w);
+		if (texType == 2.0) color = color.xxxx;
+		color *= scissor;
+		result = color * innerCol;
+	}
+
+	gl_FragColor = result;
+}
@@ -37,11 +37,15 @@ BX_PRAGMA_DIAGNOSTIC_IGNORED_MSVC(4244); // warning C4244: '=' : conversion from
 
 #include "vs_nanovg_fill.bin.h"
 #include "fs_nanovg_fill.bin.h"
+#include "vs_nanovg_batch.bin.h"
+#include "fs_nanovg_batch.bin.h"
 
 static const bgfx::EmbeddedShader s_embeddedShaders[] =
 {
 	BGFX_EMBEDDED_SHADER(vs_nanovg_fill),
 	BGFX_EMBEDDED_SHADER(fs_nanovg_fill),
+	BGFX_EMBEDDED_SHADER(vs_nanovg_batch),
+	BGFX_EMBEDDED_SHADER(fs_nanovg_batch),
 
 	BGFX_EMBEDDED_SHADER_END()
 };
@@ -49,6 +53,15 @@ static const bgfx::EmbeddedShader s_embeddedShaders[] =
 namespace
 {
 	static bgfx::VertexLayout s_nvgLayout;
+	static bgfx::VertexLayout s_nvgBatchLayout;
+	static bgfx::VertexLayout s_nvgPaintLayout;
+
+	struct NVGbatchVertex
+	{
+		float x, y;
+		float u, v;
+		float paint, pad;
+	};
 
 	enum GLNVGshaderType
 	{
@@ -162,6 +175,23 @@ namespace
 		int fragSize;
 		int edgeAntiAlias;
 
+		// Batched rendering, all paint parameters of frame are in paint
+		// buffer, and vertices carry index of their paint.
+		bgfx::ProgramHandle batchProg;
+		bgfx::DynamicVertexBufferHandle paintBuffer;
+		uint32_t paintBufferSize;
+		uint32_t paintBufferOffset;
+		uint32_t paintBufferFrame;
+		uint16_t* indices;
+		int cindices;
+		int nindices;
+		int batchFirst;
+		int batchLast;
+		uint64_t batchState;
+		uint32_t batchStencilFront;
+		uint32_t batchStencilBack;
+		bgfx::TextureHandle batchTexture;
+
 		// Per frame buffers
 		struct GLNVGcall* calls;
 		int ccalls;
@@ -288,6 +318,24 @@ namespace
 			.add(bgfx::Attrib::TexCoord0, 2, bgfx::AttribType::Float)
 			.end();
 
+		s_nvgBatchLayout
+			.begin()
+			.add(bgfx::Attrib::Position,  2, bgfx::AttribType::Float)
+			.add(bgfx::Attrib::TexCoord0, 2, bgfx::AttribType::Float)
+			.add(bgfx::Attrib::TexCoord1, 2, bgfx::AttribType::Float)
+			.end();
+
+		s_nvgPaintLayout
+			.begin()
+			.add(bgfx::Attrib::TexCoord0, 4, bgfx::AttribType::Float)
+			.end();
+
+		gl->batchProg.idx   = bgfx::kInvalidHandle;
+		gl->paintBuffer.idx = bgfx::kInvalidHandle;
+		gl->paintBufferSize = 0;
+		gl->paintBufferOffset = 0;
+		gl->paintBufferFrame = UINT32_MAX;
+
 		int align = 16;
 		gl->fragSize = sizeof(struct GLNVGfragUniforms) + align - sizeof(struct GLNVGfragUniforms) % align;
 
@@ -756,11 +804,399 @@ namespace
 		return blend;
 	}
 
+	static int glnvg__maxi(int a, int b) { return a > b ? a : b; }
+	static int glnvg__mini(int a, int b) { return a < b ? a : b; }
+
+	static bgfx::TextureHandle glnvg__imageTexture(struct GLNVGcontext* gl, int image)
+	{
+		if (image != 0)
+		{
+			struct GLNVGtexture* tex = glnvg__findTexture(gl, image);
+			if (tex != NULL)
+			{
+				return tex->id;
+			}
+		}
+
+		return gl->texMissing;
+	}
+
+	static void glnvg__batchSubmit(struct GLNVGcontext* gl)
+	{
+		if (gl->nindices == 0)
+		{
+			return;
+		}
+
+		if (uint32_t(gl->nindices) == bgfx::getAvailTransientIndexBuffer(gl->nindices) )
+		{
+			bgfx::TransientIndexBuffer tib;
+			bgfx::allocTransientIndexBuffer(&tib, gl->nindices);
+			bx::memCopy(tib.data, gl->indices, gl->nindices * sizeof(uint16_t) );
+
+			bgfx::setVertexBuffer(0, &gl->tvb, gl->batchFirst, gl->batchLast - gl->batchFirst);
+			bgfx::setIndexBuffer(&tib);
+			bgfx::setState(gl->batchState);
+			bgfx::setStencil(gl->batchStencilFront, gl->batchStencilBack);
+			bgfx::setTexture(0, gl->s_tex, gl->batchTexture);
+			bgfx::setBuffer(1, gl->paintBuffer, bgfx::Access::Read);
+			bgfx::submit(gl->viewId, gl->batchProg);
+		}
+		else
+		{
+			BX_WARN(false, "Batch dropped due to transient index buffer overflow");
+		}
+
+		gl->nindices = 0;
+	}
+
+	// Returns storage for _numIndices indices of vertices in [_first, _first + _count) range,
+	// indices are relative to returned base vertex. Batch is submitted first if render state
+	// differs, or if vertex range no longer fits 16-bit indices.
+	static uint16_t* glnvg__batchAlloc(
+		  struct GLNVGcontext* gl
+		, int _first
+		, int _count
+		, int _numIndices
+		, uint64_t _state
+		, uint32_t _stencilFront
+		, uint32_t _stencilBack
+		, bgfx::TextureHandle _texture
+		, int* _base
+		)
+	{
+		if (gl->nindices != 0
+		&& (gl->batchState        != _state
+		||  gl->batchStencilFront != _stencilFront
+		||  gl->batchStencilBack  != _stencilBack
+		||  gl->batchTexture.idx  != _texture.idx
+		||  _first < gl->batchFirst
+		||  _first + _count - gl->batchFirst > UINT16_MAX) )
+		{
+			glnvg__batchSubmit(gl);
+		}
+
+		if (gl->nindices == 0)
+		{
+			gl->batchFirst        = _first;
+			gl->batchLast         = _first;
+			gl->batchState        = _state;
+			gl->batchStencilFront = _stencilFront;
+			gl->batchStencilBack  = _stencilBack;
+			gl->batchTexture      = _texture;
+		}
+
+		if (gl->nindices + _numIndices > gl->cindices)
+		{
+			gl->cindices = glnvg__maxi(gl->nindices + _numIndices, 4096) + gl->cindices / 2; // 1.5x Overallocate
+			gl->indices  = (uint16_t*)BX_REALLOC(gl->allocator, gl->indices, sizeof(uint16_t) * gl->cindices);
+		}
+
+		gl->batchLast = glnvg__maxi(gl->batchLast, _first + _count);
+
+		uint16_t* indices = &gl->indices[gl->nindices];
+		gl->nindices += _numIndices;
+		*_base = _first - gl->batchFirst;
+		return indices;
+	}
+
+	static void glnvg__batchFan(struct GLNVGcontext* gl, int _first, int _count, uint64_t _state, uint32_t _stencilFront, uint32_t _stencilBack, bgfx::TextureHandle _texture)
+	{
+		if (_count < 3
+		||  _first + _count > gl->nverts)
+		{
+			return;
+		}
+
+		int base;
+		const int numTris = _count - 2;
+		uint16_t* data = glnvg__batchAlloc(gl, _first, _count, numTris*3, _state, _stencilFront, _stencilBack, _texture, &base);
+		for (int ii = 0; ii < numTris; ++ii)
+		{
+			data[ii*3+0] = uint16_t(base);
+			data[ii*3+1] = uint16_t(base + ii + 1);
+			data[ii*3+2] = uint16_t(base + ii + 2);
+		}
+	}
+
+	static void glnvg__batchStrip(struct GLNVGcontext* gl, int _first, int _count, uint64_t _state, uint32_t _stencil, bgfx::TextureHandle _texture)
+	{
+		if (_count < 3
+		||  _first + _count > gl->nverts)
+		{
+			return;
+		}
+
+		int base;
+		const int numTris = _count - 2;
+		uint16_t* data = glnvg__batchAlloc(gl, _first, _count, numTris*3, _state, _stencil, BGFX_STENCIL_NONE, _texture, &base);
+		for (int ii = 0; ii < numTris; ++ii)
+		{
+			data[ii*3+0] = uint16_t(base + ii);
+			data[ii*3+1] = uint16_t(base + ii + 1);
+			data[ii*3+2] = uint16_t(base + ii + 2);
+		}
+	}
+
+	static void glnvg__batchList(struct GLNVGcontext* gl, int _first, int _count, uint64_t _state, uint32_t _stencil, bgfx::TextureHandle _texture)
+	{
+		if (_count < 3
+		||  _first + _count > gl->nverts)
+		{
+			return;
+		}
+
+		int base;
+		uint16_t* data = glnvg__batchAlloc(gl, _first, _count, _count, _state, _stencil, BGFX_STENCIL_NONE, _texture, &base);
+		for (int ii = 0; ii < _count; ++ii)
+		{
+			data[ii] = uint16_t(base + ii);
+		}
+	}
+
+	static void glnvg__setPaint(NVGbatchVertex* verts, int nverts, int first, int count, float paint)
+	{
+		for (int ii = first, end = glnvg__mini(first + count, nverts); ii < end; ++ii)
+		{
+			verts[ii].paint = paint;
+		}
+	}
+
+	static bool glnvg__fillOverlaps(const struct GLNVGcontext* gl, const struct GLNVGcall* a, const struct GLNVGcall* b)
+	{
+		// Fill cover quad vertex 0 is (min x, max y), and vertex 2 is (max x, min y) corner of
+		// path bounds. Bounds are padded, since antialiased fringes extend past them.
+		const float pad = 1.0f;
+		const NVGvertex* qa = &gl->verts[a->vertexOffset];
+		const NVGvertex* qb = &gl->verts[b->vertexOffset];
+		return qa[0].x - pad < qb[2].x + pad && qb[0].x - pad < qa[2].x + pad
+			&& qa[2].y - pad < qb[0].y + pad && qb[2].y - pad < qa[0].y + pad
+			;
+	}
+
+	static bool glnvg__batchFillGroup(const struct GLNVGcontext* gl, int first, int last, const struct GLNVGcall* call)
+	{
+		if (call->type != GLNVG_FILL
+		||  call->image != gl->calls[first].image
+		||  0 != bx::memCmp(&call->blendFunc, &gl->calls[first].blendFunc, sizeof(GLNVGblend) ) )
+		{
+			return false;
+		}
+
+		for (int ii = first; ii < last; ++ii)
+		{
+			if (glnvg__fillOverlaps(gl, &gl->calls[ii], call) )
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	static void glnvg__renderBatched(struct GLNVGcontext* gl)
+	{
+		const uint32_t paintStride = gl->fragSize / 16;
+		const uint32_t numPaints   = gl->nuniforms * paintStride;
+
+		// Multiple flushes within one bgfx frame append their paints, since all updates are
+		// applied before frame is rendered. Buffer is reused from start in next frame.
+		const uint32_t frame = bgfx::getStats()->numFrames;
+		if (frame != gl->paintBufferFrame)
+		{
+			gl->paintBufferFrame  = frame;
+			gl->paintBufferOffset = 0;
+		}
+
+		// When paints of frame don't fit, buffer is replaced with one big enough for whole
+		// frame. Destroyed buffer stays alive until draws already submitted with it are done.
+		if (gl->paintBufferOffset + numPaints > gl->paintBufferSize)
+		{
+			if (bgfx::isValid(gl->paintBuffer) )
+			{
+				bgfx::destroy(gl->paintBuffer);
+			}
+
+			gl->paintBufferSize   = bx::uint32_max(bx::uint32_nextpow2(gl->paintBufferOffset + numPaints), 4096);
+			gl->paintBufferOffset = 0;
+			gl->paintBuffer = bgfx::createDynamicVertexBuffer(gl->paintBufferSize, s_nvgPaintLayout, BGFX_BUFFER_COMPUTE_READ);
+		}
+
+		const uint32_t paintBase = gl->paintBufferOffset / paintStride;
+		bgfx::updateDynamicVertexBuffer(gl->paintBuffer, gl->paintBufferOffset, bgfx::copy(gl->uniforms, numPaints * 16) );
+		gl->paintBufferOffset += numPaints;
+
+		bgfx::allocTransientVertexBuffer(&gl->tvb, gl->nverts, s_nvgBatchLayout);
+
+		const int nverts = bx::uint32_min(gl->nverts, gl->tvb.size/gl->tvb.stride);
+		BX_WARN(nverts == gl->nverts, "Vertex number truncated due to transient vertex buffer overflow");
+		gl->nverts = nverts;
+
+		NVGbatchVertex* verts = (NVGbatchVertex*)gl->tvb.data;
+		for (int ii = 0; ii < nverts; ++ii)
+		{
+			verts[ii].x = gl->verts[ii].x;
+			verts[ii].y = gl->verts[ii].y;
+			verts[ii].u = gl->verts[ii].u;
+			verts[ii].v = gl->verts[ii].v;
+			verts[ii].paint = 0.0f;
+			verts[ii].pad   = 0.0f;
+		}
+
+		// Tag vertices with paint they are drawn with, stencil pass of fill uses first paint of
+		// the call, and fringes and cover use the second one.
+		for (int ii = 0; ii < gl->ncalls; ++ii)
+		{
+			const struct GLNVGcall* call = &gl->calls[ii];
+			const struct GLNVGpath* paths = &gl->paths[call->pathOffset];
+			const float paint = float(paintBase + call->uniformOffset / gl->fragSize);
+			const float cover = call->type == GLNVG_FILL ? paint + 1.0f : paint;
+
+			for (int jj = 0; jj < call->pathCount; ++jj)
+			{
+				glnvg__setPaint(verts, nverts, paths[jj].fillOffset,   paths[jj].fillCount,   paint);
+				glnvg__setPaint(verts, nverts, paths[jj].strokeOffset, paths[jj].strokeCount, cover);
+			}
+
+			glnvg__setPaint(verts, nverts, call->vertexOffset, call->vertexCount, cover);
+		}
+
+		float viewSize[4] = { gl->view[0], gl->view[1], float(paintStride), 0.0f };
+		bgfx::setUniform(gl->u_viewSize, viewSize);
+
+		const uint32_t stencilFillFront = 0
+			| BGFX_STENCIL_TEST_ALWAYS
+			| BGFX_STENCIL_FUNC_RMASK(0xff)
+			| BGFX_STENCIL_OP_FAIL_S_KEEP
+			| BGFX_STENCIL_OP_FAIL_Z_KEEP
+			| BGFX_STENCIL_OP_PASS_Z_INCR
+			;
+		const uint32_t stencilFillBack = 0
+			| BGFX_STENCIL_TEST_ALWAYS
+			| BGFX_STENCIL_FUNC_RMASK(0xff)
+			| BGFX_STENCIL_OP_FAIL_S_KEEP
+			| BGFX_STENCIL_OP_FAIL_Z_KEEP
+			| BGFX_STENCIL_OP_PASS_Z_DECR
+			;
+		const uint32_t stencilFringe = 0
+			| BGFX_STENCIL_TEST_EQUAL
+			| BGFX_STENCIL_FUNC_RMASK(0xff)
+			| BGFX_STENCIL_OP_FAIL_S_KEEP
+			| BGFX_STENCIL_OP_FAIL_Z_KEEP
+			| BGFX_STENCIL_OP_PASS_Z_KEEP
+			;
+		const uint32_t stencilCover = 0
+			| BGFX_STENCIL_TEST_NOTEQUAL
+			| BGFX_STENCIL_FUNC_RMASK(0xff)
+			| BGFX_STENCIL_OP_FAIL_S_ZERO
+			| BGFX_STENCIL_OP_FAIL_Z_ZERO
+			| BGFX_STENCIL_OP_PASS_Z_ZERO
+			;
+
+		gl->nindices = 0;
+
+		for (int ii = 0; ii < gl->ncalls;)
+		{
+			const struct GLNVGcall* call = &gl->calls[ii];
+			const GLNVGblend* blend = &call->blendFunc;
+			const uint64_t state = BGFX_STATE_BLEND_FUNC_SEPARATE(blend->srcRGB, blend->dstRGB, blend->srcAlpha, blend->dstAlpha)
+				| BGFX_STATE_WRITE_RGB
+				| BGFX_STATE_WRITE_A
+				;
+			const bgfx::TextureHandle texture = glnvg__imageTexture(gl, call->image);
+
+			if (call->type == GLNVG_FILL)
+			{
+				// Consecutive fills with the same paint setup whose bounds don't overlap don't
+				// interact through stencil, so their stencil, fringe and cover passes are grouped.
+				int last = ii + 1;
+				while (last < gl->ncalls
+				&&     last - ii < 64
+				&&     glnvg__batchFillGroup(gl, ii, last, &gl->calls[last]) )
+				{
+					++last;
+				}
+
+				for (int jj = ii; jj < last; ++jj)
+				{
+					const struct GLNVGcall* fill = &gl->calls[jj];
+					const struct GLNVGpath* paths = &gl->paths[fill->pathOffset];
+					for (int kk = 0; kk < fill->pathCount; ++kk)
+					{
+						glnvg__batchFan(gl, paths[kk].fillOffset, paths[kk].fillCount, 0, stencilFillFront, stencilFillBack, gl->texMissing);
+					}
+				}
+
+				if (gl->edgeAntiAlias)
+				{
+					for (int jj = ii; jj < last; ++jj)
+					{
+						const struct GLNVGcall* fill = &gl->calls[jj];
+						const struct GLNVGpath* paths = &gl->paths[fill->pathOffset];
+						for (int kk = 0; kk < fill->pathCount; ++kk)
+						{
+							glnvg__batchStrip(gl, paths[kk].strokeOffset, paths[kk].strokeCount, state, stencilFringe, texture);
+						}
+					}
+				}
+
+				for (int jj = ii; jj < last; ++jj)
+				{
+					const struct GLNVGcall* fill = &gl->calls[jj];
+					glnvg__batchList(gl, fill->vertexOffset, fill->vertexCount, state, stencilCover, texture);
+				}
+
+				ii = last;
+				continue;
+			}
+
+			const struct GLNVGpath* paths = &gl->paths[call->pathOffset];
+
+			switch (call->type)
+			{
+			case GLNVG_CONVEXFILL:
+				for (int jj = 0; jj < call->pathCount; ++jj)
+				{
+					glnvg__batchFan(gl, paths[jj].fillOffset, paths[jj].fillCount, state, BGFX_STENCIL_NONE, BGFX_STENCIL_NONE, texture);
+				}
+
+				if (gl->edgeAntiAlias)
+				{
+					for (int jj = 0; jj < call->pathCount; ++jj)
+					{
+						glnvg__batchStrip(gl, paths[jj].strokeOffset, paths[jj].strokeCount, state, BGFX_STENCIL_NONE, texture);
+					}
+				}
+				break;
+
+			case GLNVG_STROKE:
+				for (int jj = 0; jj < call->pathCount; ++jj)
+				{
+					glnvg__batchStrip(gl, paths[jj].strokeOffset, paths[jj].strokeCount, state, BGFX_STENCIL_NONE, texture);
+				}
+				break;
+
+			case GLNVG_TRIANGLES:
+				glnvg__batchList(gl, call->vertexOffset, call->vertexCount, state, BGFX_STENCIL_NONE, texture);
+				break;
+			}
+
+			++ii;
+		}
+
+		glnvg__batchSubmit(gl);
+	}
+
 	static void nvgRenderFlush(void* _userPtr)
 	{
 		struct GLNVGcontext* gl = (struct GLNVGcontext*)_userPtr;
 
-		if (gl->ncalls > 0)
+		if (gl->ncalls > 0
+		&&  bgfx::isValid(gl->batchProg) )
+		{
+			glnvg__renderBatched(gl);
+		}
+		else if (gl->ncalls > 0)
 		{
 			bgfx::allocTransientVertexBuffer(&gl->tvb, gl->nverts, s_nvgLayout);
 
@@ -823,8 +1259,6 @@ namespace
 		return count;
 	}
 
-	static int glnvg__maxi(int a, int b) { return a > b ? a : b; }
-
 	static struct GLNVGcall* glnvg__allocCall(struct GLNVGcontext* gl)
 	{
 		struct GLNVGcall* ret = NULL;
@@ -1058,6 +1492,16 @@ namespace
 		bgfx::destroy(gl->prog);
 		bgfx::destroy(gl->texMissing);
 
+		if (bgfx::isValid(gl->batchProg) )
+		{
+			bgfx::destroy(gl->batchProg);
+		}
+
+		if (bgfx::isValid(gl->paintBuffer) )
+		{
+			bgfx::destroy(gl->paintBuffer);
+		}
+
 		bgfx::destroy(gl->u_scissorMat);
 		bgfx::destroy(gl->u_paintMat);
 		bgfx::destroy(gl->u_innerCol);
@@ -1082,6 +1526,7 @@ namespace
 			}
 		}
 
+		BX_FREE(gl->allocator, gl->indices);
 		BX_FREE(gl->allocator, gl->uniforms);
 		BX_FREE(gl->allocator, gl->verts);
 		BX_FREE(gl->allocator, gl->paths);
@@ -1153,6 +1598,37 @@ void nvgDelete(NVGcontext* _ctx)
 	nvgDeleteInternal(_ctx);
 }
 
+void nvgSetBatched(NVGcontext* _ctx, bool _batched)
+{
+	struct NVGparams* params = nvgInternalParams(_ctx);
+	struct GLNVGcontext* gl = (struct GLNVGcontext*)params->userPtr;
+
+	if (!_batched)
+	{
+		if (bgfx::isValid(gl->batchProg) )
+		{
+			bgfx::destroy(gl->batchProg);
+			gl->batchProg.idx = bgfx::kInvalidHandle;
+		}
+
+		return;
+	}
+
+	const bool supported = 0 != (bgfx::getCaps()->supported & BGFX_CAPS_COMPUTE);
+	BX_WARN(supported, "Batched rendering requires compute support.");
+
+	if (supported
+	&&  !bgfx::isValid(gl->batchProg) )
+	{
+		bgfx::RendererType::Enum type = bgfx::getRendererType();
+		gl->batchProg = bgfx::createProgram(
+			  bgfx::createEmbeddedShader(s_embeddedShaders, type, "vs_nanovg_batch")
+			, bgfx::createEmbeddedShader(s_embeddedShaders, type, "fs_nanovg_batch")
+			, true
+			);
+	}
+}
+
 void nvgSetViewId(NVGcontext* _ctx, bgfx::ViewId _viewId)
 {
 	struct NVGparams* params = nvgInternalParams(_ctx);
@@ -32,6 +32,13 @@ void nvgDelete(NVGcontext* _ctx);
 ///
 void nvgSetViewId(NVGcontext* _ctx, bgfx::ViewId _viewId);
 
+/// Enable batched rendering. Paint and scissor parameters of all draws in a
+/// frame are packed into single buffer indexed per vertex, consecutive draws
+/// with the same texture and blend state are merged, and stencil passes of
+/// consecutive non-overlapping fills are grouped. Batching is not enabled on
+/// renderers without compute support.
+void nvgSetBatched(NVGcontext* _ctx, bool _batched);
+
 ///
 uint16_t nvgGetViewId(struct NVGcontext* _ctx);
 
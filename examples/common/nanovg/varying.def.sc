@@ -1,5 +1,7 @@
-vec2 v_position  : TEXCOORD0  = vec2(0.0, 0.0);
-vec2 v_texcoord0 : TEXCOORD1 = vec2(0.0, 0.0);
+vec2  v_position  : TEXCOORD0 = vec2(0.0, 0.0);
+vec2  v_texcoord0 : TEXCOORD1 = vec2(0.0, 0.0);
+float v_paint     : TEXCOORD2 = 0.0;
 
 vec2 a_position  : POSITION;
 vec2 a_texcoord0 : TEXCOORD0;
+vec2 a_texcoord1 : TEXCOORD1;
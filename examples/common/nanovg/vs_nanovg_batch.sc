@@ -0,0 +1,19 @@
+$input a_position, a_texcoord0, a_texcoord1
+$output v_position, v_texcoord0, v_paint
+
+/*
+ * Copyright 2011-2019 Branimir Karadzic. All rights reserved.
+ * License: https://github.com/bkaradzic/bgfx#license-bsd-2-clause
+ */
+
+#include "../common.sh"
+
+uniform vec4 u_viewSize;
+
+void main()
+{
+	v_position  = a_position;
+	v_texcoord0 = a_texcoord0;
+	v_paint     = a_texcoord1.x;
+	gl_Position = vec4(2.0*v_position.x/u_viewSize.x - 1.0, 1.0 - 2.0*v_position.y/u_viewSize.y, 0.0, 1.0);
+}
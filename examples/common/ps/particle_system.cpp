@@ -10,8 +10,15 @@
 #include "../bgfx_utils.h"
 #include "../packrect.h"
 
+#include <bx/cpu.h>
 #include <bx/easing.h>
 #include <bx/handlealloc.h>
+#include <bx/simd_t.h>
+#include <bx/sort.h>
+#include <bx/thread.h>
+#include <bx/uint32_t.h>
+
+#include <thread>
 
 #include "vs_particle.bin.h"
 #include "fs_particle.bin.h"
@@ -96,25 +103,52 @@ void EmitterUniforms::reset()
 
 namespace ps
 {
-	struct Particle
+	/// Particle attributes are stored as separate streams (SoA), so that they can be processed
+	/// four at the time with SIMD.
+	struct ParticleStream
 	{
-		bx::Vec3 start;
-		bx::Vec3 end[2];
-		float blendStart;
-		float blendEnd;
-		float scaleStart;
-		float scaleEnd;
-
-		uint32_t rgba[5];
-
-		float life;
-		float lifeSpan;
+		enum Enum
+		{
+			Life, //!< Normalized age, particle dies when it's above 1.
+			InvLifeSpan,
+			StartX,
+			StartY,
+			StartZ,
+			End0X,
+			End0Y,
+			End0Z,
+			End1X,
+			End1Y,
+			End1Z,
+			BlendStart,
+			BlendEnd,
+			ScaleStart,
+			ScaleEnd,
+			Rgba0,
+			Rgba1,
+			Rgba2,
+			Rgba3,
+			Rgba4,
+
+			Count
+		};
 	};
 
-	struct ParticleSort
+	/// Per particle render data for all emitters. It's written by `Emitter::prepare`, sorted,
+	/// and then turned into billboard vertices in sorted order.
+	struct ParticleScratch
 	{
-		float    dist;
-		uint32_t idx;
+		float*    m_x;
+		float*    m_y;
+		float*    m_z;
+		float*    m_blend;
+		float*    m_scale;
+		uint32_t* m_abgr;
+		uint32_t* m_emitter;
+		uint32_t* m_keys;
+		uint32_t* m_tempKeys;
+		uint32_t* m_values;
+		uint32_t* m_tempValues;
 	};
 
 	inline uint32_t toAbgr(const float* _rgba)
@@ -137,6 +171,134 @@ namespace ps
 			;
 	}
 
+	inline bx::simd128_t ease(bx::EaseFn _fn, const float* _tt)
+	{
+		BX_ALIGN_DECL_16(float tmp[4]);
+		tmp[0] = _fn(_tt[0]);
+		tmp[1] = _fn(_tt[1]);
+		tmp[2] = _fn(_tt[2]);
+		tmp[3] = _fn(_tt[3]);
+		return bx::simd_ld<bx::simd128_t>(tmp);
+	}
+
+	inline bx::simd128_t saturate(bx::simd128_t _a)
+	{
+		return bx::simd_min(bx::simd_max(_a, bx::simd_zero<bx::simd128_t>() ), bx::simd_splat(1.0f) );
+	}
+
+	typedef void (*JobFn)(void* _userData, uint32_t _idx);
+
+	/// Minimal job pool. Workers are woken up for each `run`, and calling thread is working along
+	/// with them until all jobs are done.
+	struct JobPool
+	{
+		enum { kMaxThreads = 16 };
+
+		JobPool()
+			: m_numWorkers(0)
+		{
+		}
+
+		void init(uint32_t _numThreads)
+		{
+			m_numWorkers = bx::min<uint32_t>(bx::max<uint32_t>(_numThreads, 1), kMaxThreads) - 1;
+			m_exit = false;
+
+			for (uint32_t ii = 0; ii < m_numWorkers; ++ii)
+			{
+				m_thread[ii].init(worker, this, 0, "ps - worker");
+			}
+		}
+
+		void shutdown()
+		{
+			m_exit = true;
+
+			if (0 < m_numWorkers)
+			{
+				m_start.post(m_numWorkers);
+			}
+
+			for (uint32_t ii = 0; ii < m_numWorkers; ++ii)
+			{
+				m_thread[ii].shutdown();
+			}
+
+			m_numWorkers = 0;
+		}
+
+		void run(JobFn _fn, void* _userData, uint32_t _num)
+		{
+			if (0 == m_numWorkers
+			||  1 >= _num)
+			{
+				for (uint32_t ii = 0; ii < _num; ++ii)
+				{
+					_fn(_userData, ii);
+				}
+
+				return;
+			}
+
+			m_fn       = _fn;
+			m_userData = _userData;
+			m_num      = _num;
+			m_next     = 0;
+
+			const uint32_t numWorkers = bx::min(m_numWorkers, _num-1);
+			m_start.post(numWorkers);
+
+			work();
+
+			for (uint32_t ii = 0; ii < numWorkers; ++ii)
+			{
+				m_done.wait();
+			}
+		}
+
+		void work()
+		{
+			for (uint32_t idx = uint32_t(bx::atomicFetchAndAdd(&m_next, 1) )
+				; idx < m_num
+				; idx = uint32_t(bx::atomicFetchAndAdd(&m_next, 1) )
+				)
+			{
+				m_fn(m_userData, idx);
+			}
+		}
+
+		static int32_t worker(bx::Thread* /*_self*/, void* _userData)
+		{
+			JobPool* pool = (JobPool*)_userData;
+
+			for (;;)
+			{
+				pool->m_start.wait();
+
+				if (pool->m_exit)
+				{
+					break;
+				}
+
+				pool->work();
+				pool->m_done.post();
+			}
+
+			return 0;
+		}
+
+		bx::Thread    m_thread[kMaxThreads];
+		bx::Semaphore m_start;
+		bx::Semaphore m_done;
+		uint32_t      m_numWorkers;
+		bool          m_exit;
+
+		JobFn    m_fn;
+		void*    m_userData;
+		uint32_t m_num;
+		int32_t  m_next;
+	};
+
 #define SPRITE_TEXTURE_SIZE 1024
 	template<uint16_t MaxHandlesT = 256, uint16_t TextureSizeT = 1024>
 	struct SpriteT
@@ -180,9 +342,24 @@ namespace ps
 		RectPack2DT<256>              m_ra;
 	};
 
+	/// GPU emitter state. Particles live in fixed size ring, CPU only tracks how many particles
+	/// should be spawned, and where ring head is.
+	struct GpuEmitter
+	{
+		bgfx::DynamicVertexBufferHandle m_particles; //!< 4 vec4 per particle.
+		bgfx::DynamicIndexBufferHandle  m_sort;      //!< Sort key and particle index pairs.
+		bgfx::DynamicIndexBufferHandle  m_counter;   //!< Number of live particles.
+		bgfx::IndirectBufferHandle      m_indirect;
+
+		uint32_t m_capacity; //!< Power of 2, required by bitonic sort.
+		uint32_t m_head;
+		uint32_t m_numSpawn;
+		float    m_dt;
+	};
+
 	struct Emitter
 	{
-		void create(EmitterShape::Enum _shape, EmitterDirection::Enum _direction, uint32_t _maxParticles);
+		void create(EmitterShape::Enum _shape, EmitterDirection::Enum _direction, uint32_t _maxParticles, EmitterBackend::Enum _backend);
 		void destroy();
 
 		void reset()
@@ -192,35 +369,191 @@ namespace ps
 			m_num = 0;
 			bx::memSet(&m_aabb, 0, sizeof(Aabb) );
 
+			m_gpu.m_numSpawn = 0;
+			m_gpu.m_dt       = 0.0f;
+
 			m_rng.reset();
 		}
 
+		void move(uint32_t _dst, uint32_t _src)
+		{
+			for (uint32_t ii = 0; ii < ParticleStream::Count; ++ii)
+			{
+				uint32_t* stream = (uint32_t*)m_stream[ii];
+				stream[_dst] = stream[_src];
+			}
+		}
+
 		void update(float _dt)
 		{
-			uint32_t num = m_num;
-			for (uint32_t ii = 0; ii < num; ++ii)
+			if (EmitterBackend::Gpu == m_backend)
 			{
-				Particle& particle = m_particles[ii];
-				particle.life += _dt * 1.0f/particle.lifeSpan;
+				updateGpu(_dt);
+				return;
+			}
+
+			float*       life        = m_stream[ParticleStream::Life];
+			const float* invLifeSpan = m_stream[ParticleStream::InvLifeSpan];
+
+			const bx::simd128_t dt  = bx::simd_splat(_dt);
+			const bx::simd128_t one = bx::simd_splat(1.0f);
+			bx::simd128_t dead = bx::simd_zero<bx::simd128_t>();
 
-				if (particle.life > 1.0f)
+			// Streams are padded to multiple of 4, lanes past the end are updated too, but they are
+			// never read back.
+			for (uint32_t ii = 0, num = m_num; ii < num; ii += 4)
+			{
+				const bx::simd128_t tt = bx::simd_madd(dt
+					, bx::simd_ld<bx::simd128_t>(&invLifeSpan[ii])
+					, bx::simd_ld<bx::simd128_t>(&life[ii])
+					);
+				bx::simd_st(&life[ii], tt);
+				dead = bx::simd_or(dead, bx::simd_cmpgt(tt, one) );
+			}
+
+			if (0 != bx::simd_movemask(dead) )
+			{
+				// Walking backward, particle moved into place of dead one was already checked.
+				uint32_t num = m_num;
+				for (uint32_t ii = num; 0 < ii--;)
 				{
-					if (ii != num-1)
+					if (life[ii] > 1.0f)
 					{
-						bx::memCopy(&particle, &m_particles[num-1], sizeof(Particle) );
-						--ii;
+						--num;
+
+						if (ii != num)
+						{
+							move(ii, num);
+						}
 					}
+				}
+
+				m_num = num;
+			}
+
+			if (0 < m_uniforms.m_particlesPerSecond)
+			{
+				spawn(_dt);
+			}
+
+			updateAabb();
+		}
+
+		/// Compute bounds of particles at their current life. Billboard orientation is only known
+		/// when rendering, so each particle is expanded by largest extent its billboard can have
+		/// on any axis, which is scale times sqrt(2).
+		void updateAabb()
+		{
+			const uint32_t num = m_num;
+			if (0 == num)
+			{
+				const float* pos = m_uniforms.m_position;
+				m_aabb.min = { pos[0], pos[1], pos[2] };
+				m_aabb.max = m_aabb.min;
+				return;
+			}
+
+			const uint32_t numAligned = (num+3) & ~3;
+
+			// Replicate last particle into padding lanes, so that only full SIMD width is processed.
+			for (uint32_t ii = num; ii < numAligned; ++ii)
+			{
+				move(ii, num-1);
+			}
+
+			const bx::EaseFn easePos   = bx::getEaseFunc(m_uniforms.m_easePos);
+			const bx::EaseFn easeScale = bx::getEaseFunc(m_uniforms.m_easeScale);
+
+			const bool linearPos   = bx::Easing::Linear == m_uniforms.m_easePos;
+			const bool linearScale = bx::Easing::Linear == m_uniforms.m_easeScale;
+
+			const float* const* stream = m_stream;
+			const float* life = stream[ParticleStream::Life];
+
+			const bx::simd128_t sqrt2 = bx::simd_splat(bx::kSqrt2);
+
+			bx::simd128_t aabbMin[3];
+			bx::simd128_t aabbMax[3];
+			for (uint32_t axis = 0; axis < 3; ++axis)
+			{
+				aabbMin[axis] = bx::simd_splat( bx::kFloatMax);
+				aabbMax[axis] = bx::simd_splat(-bx::kFloatMax);
+			}
+
+			for (uint32_t ii = 0; ii < numAligned; ii += 4)
+			{
+				const bx::simd128_t lifeSimd = bx::simd_ld<bx::simd128_t>(&life[ii]);
+
+				const bx::simd128_t ttPos   = linearPos   ? lifeSimd : ease(easePos,   &life[ii]);
+				const bx::simd128_t ttScale = linearScale ? lifeSimd : ease(easeScale, &life[ii]);
+
+				const bx::simd128_t scaleStart = bx::simd_ld<bx::simd128_t>(&stream[ParticleStream::ScaleStart][ii]);
+				const bx::simd128_t scaleEnd   = bx::simd_ld<bx::simd128_t>(&stream[ParticleStream::ScaleEnd  ][ii]);
+				const bx::simd128_t scale      = bx::simd_madd(bx::simd_sub(scaleEnd, scaleStart), ttScale, scaleStart);
+				const bx::simd128_t ext        = bx::simd_mul(scale, sqrt2);
+
+				for (uint32_t axis = 0; axis < 3; ++axis)
+				{
+					const bx::simd128_t start = bx::simd_ld<bx::simd128_t>(&stream[ParticleStream::StartX+axis][ii]);
+					const bx::simd128_t end0  = bx::simd_ld<bx::simd128_t>(&stream[ParticleStream::End0X +axis][ii]);
+					const bx::simd128_t end1  = bx::simd_ld<bx::simd128_t>(&stream[ParticleStream::End1X +axis][ii]);
+
+					const bx::simd128_t p0  = bx::simd_madd(bx::simd_sub(end0, start), ttPos, start);
+					const bx::simd128_t p1  = bx::simd_madd(bx::simd_sub(end1, end0),  ttPos, end0);
+					const bx::simd128_t pos = bx::simd_madd(bx::simd_sub(p1, p0), ttPos, p0);
 
-					--num;
+					aabbMin[axis] = bx::simd_min(aabbMin[axis], bx::simd_sub(pos, ext) );
+					aabbMax[axis] = bx::simd_max(aabbMax[axis], bx::simd_add(pos, ext) );
 				}
 			}
 
-			m_num = num;
+			BX_ALIGN_DECL_16(float tmp[6][4]);
+			for (uint32_t axis = 0; axis < 3; ++axis)
+			{
+				bx::simd_st(tmp[axis  ], aabbMin[axis]);
+				bx::simd_st(tmp[axis+3], aabbMax[axis]);
+			}
+
+			for (uint32_t axis = 0; axis < 6; ++axis)
+			{
+				const float* lane = tmp[axis];
+				tmp[axis][0] = axis < 3
+					? bx::min(bx::min(lane[0], lane[1]), bx::min(lane[2], lane[3]) )
+					: bx::max(bx::max(lane[0], lane[1]), bx::max(lane[2], lane[3]) )
+					;
+			}
+
+			m_aabb.min = { tmp[0][0], tmp[1][0], tmp[2][0] };
+			m_aabb.max = { tmp[3][0], tmp[4][0], tmp[5][0] };
+		}
+
+		void updateGpu(float _dt)
+		{
+			m_gpu.m_dt += _dt;
 
 			if (0 < m_uniforms.m_particlesPerSecond)
 			{
-				spawn(_dt);
+				const float timePerParticle = 1.0f/m_uniforms.m_particlesPerSecond;
+				m_dt += _dt;
+				const uint32_t numParticles = uint32_t(m_dt / timePerParticle);
+				m_dt -= numParticles * timePerParticle;
+
+				m_gpu.m_numSpawn = bx::min(m_gpu.m_numSpawn + numParticles, m_gpu.m_capacity);
 			}
+
+			// Particles are never read back, bounds are estimated from emitter parameters instead.
+			// Rotation doesn't change distance from emitter, and gravity only extends Y axis.
+			const float offset = 0
+				+ bx::max(bx::abs(m_uniforms.m_offsetStart[0]), bx::abs(m_uniforms.m_offsetStart[1]) )
+				+ bx::max(bx::abs(m_uniforms.m_offsetEnd[0]),   bx::abs(m_uniforms.m_offsetEnd[1])   )
+				+ bx::max(m_uniforms.m_scaleStart[0], m_uniforms.m_scaleStart[1], bx::max(m_uniforms.m_scaleEnd[0], m_uniforms.m_scaleEnd[1]) )
+				;
+			const float lifeSpan = bx::max(m_uniforms.m_lifeSpan[0], m_uniforms.m_lifeSpan[1]);
+			const float gravity  = 9.81f * m_uniforms.m_gravityScale * bx::square(lifeSpan);
+			const float* pos = m_uniforms.m_position;
+
+			m_aabb.min = { pos[0] - offset, pos[1] - offset - bx::max(gravity, 0.0f), pos[2] - offset };
+			m_aabb.max = { pos[0] + offset, pos[1] + offset - bx::min(gravity, 0.0f), pos[2] + offset };
 		}
 
 		void spawn(float _dt)
@@ -245,7 +578,7 @@ namespace ps
 				; ++ii
 				)
 			{
-				Particle& particle = m_particles[m_num];
+				const uint32_t idx = m_num;
 				m_num++;
 
 				bx::Vec3 pos;
@@ -301,125 +634,160 @@ namespace ps
 				const bx::Vec3 tmp1 = bx::mul(dir, endOffset);
 				const bx::Vec3 end  = bx::add(tmp1, start);
 
-				particle.life = time;
-				particle.lifeSpan = bx::lerp(m_uniforms.m_lifeSpan[0], m_uniforms.m_lifeSpan[1], bx::frnd(&m_rng) );
+				const float lifeSpan = bx::lerp(m_uniforms.m_lifeSpan[0], m_uniforms.m_lifeSpan[1], bx::frnd(&m_rng) );
+				m_stream[ParticleStream::Life       ][idx] = time;
+				m_stream[ParticleStream::InvLifeSpan][idx] = 1.0f/lifeSpan;
+
+				const bx::Vec3 gravity = { 0.0f, -9.81f * m_uniforms.m_gravityScale * bx::square(lifeSpan), 0.0f };
 
-				const bx::Vec3 gravity = { 0.0f, -9.81f * m_uniforms.m_gravityScale * bx::square(particle.lifeSpan), 0.0f };
+				const bx::Vec3 start0 = bx::mul(start, mtx);
+				const bx::Vec3 end0   = bx::mul(end,   mtx);
+				const bx::Vec3 end1   = bx::add(end0, gravity);
 
-				particle.start  = bx::mul(start, mtx);
-				particle.end[0] = bx::mul(end,   mtx);
-				particle.end[1] = bx::add(particle.end[0], gravity);
+				m_stream[ParticleStream::StartX][idx] = start0.x;
+				m_stream[ParticleStream::StartY][idx] = start0.y;
+				m_stream[ParticleStream::StartZ][idx] = start0.z;
+				m_stream[ParticleStream::End0X ][idx] = end0.x;
+				m_stream[ParticleStream::End0Y ][idx] = end0.y;
+				m_stream[ParticleStream::End0Z ][idx] = end0.z;
+				m_stream[ParticleStream::End1X ][idx] = end1.x;
+				m_stream[ParticleStream::End1Y ][idx] = end1.y;
+				m_stream[ParticleStream::End1Z ][idx] = end1.z;
 
-				bx::memCopy(particle.rgba, m_uniforms.m_rgba, BX_COUNTOF(m_uniforms.m_rgba)*sizeof(uint32_t) );
+				for (uint32_t jj = 0; jj < BX_COUNTOF(m_uniforms.m_rgba); ++jj)
+				{
+					uint32_t* rgba = (uint32_t*)m_stream[ParticleStream::Rgba0+jj];
+					rgba[idx] = m_uniforms.m_rgba[jj];
+				}
 
-				particle.blendStart = bx::lerp(m_uniforms.m_blendStart[0], m_uniforms.m_blendStart[1], bx::frnd(&m_rng) );
-				particle.blendEnd   = bx::lerp(m_uniforms.m_blendEnd[0],   m_uniforms.m_blendEnd[1],   bx::frnd(&m_rng) );
+				m_stream[ParticleStream::BlendStart][idx] = bx::lerp(m_uniforms.m_blendStart[0], m_uniforms.m_blendStart[1], bx::frnd(&m_rng) );
+				m_stream[ParticleStream::BlendEnd  ][idx] = bx::lerp(m_uniforms.m_blendEnd[0],   m_uniforms.m_blendEnd[1],   bx::frnd(&m_rng) );
 
-				particle.scaleStart = bx::lerp(m_uniforms.m_scaleStart[0], m_uniforms.m_scaleStart[1], bx::frnd(&m_rng) );
-				particle.scaleEnd   = bx::lerp(m_uniforms.m_scaleEnd[0],   m_uniforms.m_scaleEnd[1],   bx::frnd(&m_rng) );
+				m_stream[ParticleStream::ScaleStart][idx] = bx::lerp(m_uniforms.m_scaleStart[0], m_uniforms.m_scaleStart[1], bx::frnd(&m_rng) );
+				m_stream[ParticleStream::ScaleEnd  ][idx] = bx::lerp(m_uniforms.m_scaleEnd[0],   m_uniforms.m_scaleEnd[1],   bx::frnd(&m_rng) );
 
 				time += timePerParticle;
 			}
 		}
 
-		uint32_t render(const float _uv[4], const float* _mtxView, const bx::Vec3& _eye, uint32_t _first, uint32_t _max, ParticleSort* _outSort, PosColorTexCoord0Vertex* _outVertices)
+		/// Compute position, color, blend, scale and sort key of each particle into scratch at
+		/// `_offset`, which must be multiple of 4. Scratch is written up to `m_num` rounded up to
+		/// multiple of 4, padding entries get sort key that puts them at the end.
+		void prepare(const ParticleScratch& _scratch, uint32_t _offset, uint32_t _emitterIdx, const bx::Vec3& _eye)
 		{
-			bx::EaseFn easeRgba  = bx::getEaseFunc(m_uniforms.m_easeRgba);
-			bx::EaseFn easePos   = bx::getEaseFunc(m_uniforms.m_easePos);
-			bx::EaseFn easeBlend = bx::getEaseFunc(m_uniforms.m_easeBlend);
-			bx::EaseFn easeScale = bx::getEaseFunc(m_uniforms.m_easeScale);
+			const uint32_t num        = m_num;
+			const uint32_t numAligned = (num+3) & ~3;
 
-			Aabb aabb =
+			// Replicate last particle into padding lanes, so that only full SIMD width is processed.
+			for (uint32_t ii = num; ii < numAligned; ++ii)
 			{
-				{  bx::kInfinity,  bx::kInfinity,  bx::kInfinity },
-				{ -bx::kInfinity, -bx::kInfinity, -bx::kInfinity },
-			};
+				move(ii, num-1);
+			}
 
-			for (uint32_t jj = 0, num = m_num, current = _first
-				; jj < num && current < _max
-				; ++jj, ++current
-				)
+			const bx::EaseFn easeRgba  = bx::getEaseFunc(m_uniforms.m_easeRgba);
+			const bx::EaseFn easePos   = bx::getEaseFunc(m_uniforms.m_easePos);
+			const bx::EaseFn easeBlend = bx::getEaseFunc(m_uniforms.m_easeBlend);
+			const bx::EaseFn easeScale = bx::getEaseFunc(m_uniforms.m_easeScale);
+
+			const bool linearPos   = bx::Easing::Linear == m_uniforms.m_easePos;
+			const bool linearBlend = bx::Easing::Linear == m_uniforms.m_easeBlend;
+			const bool linearScale = bx::Easing::Linear == m_uniforms.m_easeScale;
+
+			const float* const* stream = m_stream;
+			const float*    life = stream[ParticleStream::Life];
+			const uint32_t* rgba[BX_COUNTOF(m_uniforms.m_rgba)];
+			for (uint32_t ii = 0; ii < BX_COUNTOF(rgba); ++ii)
 			{
-				const Particle& particle = m_particles[jj];
+				rgba[ii] = (const uint32_t*)stream[ParticleStream::Rgba0+ii];
+			}
 
-				const float ttPos   = easePos(particle.life);
-				const float ttScale = easeScale(particle.life);
-				const float ttBlend = bx::clamp(easeBlend(particle.life), 0.0f, 1.0f);
-				const float ttRgba  = bx::clamp(easeRgba(particle.life),  0.0f, 1.0f);
+			const bx::simd128_t eye[3] =
+			{
+				bx::simd_splat(_eye.x),
+				bx::simd_splat(_eye.y),
+				bx::simd_splat(_eye.z),
+			};
 
-				const bx::Vec3 p0  = bx::lerp(particle.start,  particle.end[0], ttPos);
-				const bx::Vec3 p1  = bx::lerp(particle.end[0], particle.end[1], ttPos);
-				const bx::Vec3 pos = bx::lerp(p0, p1, ttPos);
+			// For positive distance this is the same as `floatFlip(bits) ^ UINT32_MAX`, farthest
+			// particle gets smallest key, and sort order is back to front.
+			const bx::simd128_t keyBias = bx::simd_isplat(INT32_MAX);
 
-				ParticleSort& sort = _outSort[current];
-				const bx::Vec3 tmp0 = bx::sub(_eye, pos);
-				sort.dist = bx::length(tmp0);
-				sort.idx  = current;
+			float* outPos[3] =
+			{
+				&_scratch.m_x[_offset],
+				&_scratch.m_y[_offset],
+				&_scratch.m_z[_offset],
+			};
 
-				uint32_t idx = uint32_t(ttRgba*4);
-				float ttmod = bx::mod(ttRgba, 0.25f)/0.25f;
-				uint32_t rgbaStart = particle.rgba[idx];
-				uint32_t rgbaEnd   = particle.rgba[idx+1];
+			for (uint32_t ii = 0; ii < numAligned; ii += 4)
+			{
+				const bx::simd128_t lifeSimd = bx::simd_ld<bx::simd128_t>(&life[ii]);
 
-				float rr = bx::lerp( ( (uint8_t*)&rgbaStart)[0], ( (uint8_t*)&rgbaEnd)[0], ttmod)/255.0f;
-				float gg = bx::lerp( ( (uint8_t*)&rgbaStart)[1], ( (uint8_t*)&rgbaEnd)[1], ttmod)/255.0f;
-				float bb = bx::lerp( ( (uint8_t*)&rgbaStart)[2], ( (uint8_t*)&rgbaEnd)[2], ttmod)/255.0f;
-				float aa = bx::lerp( ( (uint8_t*)&rgbaStart)[3], ( (uint8_t*)&rgbaEnd)[3], ttmod)/255.0f;
+				const bx::simd128_t ttPos   = linearPos   ? lifeSimd : ease(easePos,   &life[ii]);
+				const bx::simd128_t ttScale = linearScale ? lifeSimd : ease(easeScale, &life[ii]);
+				const bx::simd128_t ttBlend = saturate(linearBlend ? lifeSimd : ease(easeBlend, &life[ii]) );
 
-				float blend = bx::lerp(particle.blendStart, particle.blendEnd, ttBlend);
-				float scale = bx::lerp(particle.scaleStart, particle.scaleEnd, ttScale);
+				bx::simd128_t distSq = bx::simd_zero<bx::simd128_t>();
+				bx::simd128_t pos[3];
 
-				uint32_t abgr = toAbgr(rr, gg, bb, aa);
+				for (uint32_t axis = 0; axis < 3; ++axis)
+				{
+					const bx::simd128_t start = bx::simd_ld<bx::simd128_t>(&stream[ParticleStream::StartX+axis][ii]);
+					const bx::simd128_t end0  = bx::simd_ld<bx::simd128_t>(&stream[ParticleStream::End0X +axis][ii]);
+					const bx::simd128_t end1  = bx::simd_ld<bx::simd128_t>(&stream[ParticleStream::End1X +axis][ii]);
 
-				const bx::Vec3 udir = { _mtxView[0]*scale, _mtxView[4]*scale, _mtxView[8]*scale };
-				const bx::Vec3 vdir = { _mtxView[1]*scale, _mtxView[5]*scale, _mtxView[9]*scale };
+					const bx::simd128_t p0 = bx::simd_madd(bx::simd_sub(end0, start), ttPos, start);
+					const bx::simd128_t p1 = bx::simd_madd(bx::simd_sub(end1, end0),  ttPos, end0);
+					pos[axis] = bx::simd_madd(bx::simd_sub(p1, p0), ttPos, p0);
 
-				PosColorTexCoord0Vertex* vertex = &_outVertices[current*4];
+					const bx::simd128_t delta = bx::simd_sub(eye[axis], pos[axis]);
+					distSq = bx::simd_madd(delta, delta, distSq);
 
-				const bx::Vec3 ul = bx::sub(bx::sub(pos, udir), vdir);
-				bx::store(&vertex->m_x, ul);
-				aabbExpand(aabb, ul);
-				vertex->m_abgr  = abgr;
-				vertex->m_u     = _uv[0];
-				vertex->m_v     = _uv[1];
-				vertex->m_blend = blend;
-				++vertex;
+					bx::simd_st(&outPos[axis][ii], pos[axis]);
+				}
 
-				const bx::Vec3 ur = bx::sub(bx::add(pos, udir), vdir);
-				bx::store(&vertex->m_x, ur);
-				aabbExpand(aabb, ur);
-				vertex->m_abgr  = abgr;
-				vertex->m_u     = _uv[2];
-				vertex->m_v     = _uv[1];
-				vertex->m_blend = blend;
-				++vertex;
+				const bx::simd128_t blendStart = bx::simd_ld<bx::simd128_t>(&stream[ParticleStream::BlendStart][ii]);
+				const bx::simd128_t blendEnd   = bx::simd_ld<bx::simd128_t>(&stream[ParticleStream::BlendEnd  ][ii]);
+				const bx::simd128_t scaleStart = bx::simd_ld<bx::simd128_t>(&stream[ParticleStream::ScaleStart][ii]);
+				const bx::simd128_t scaleEnd   = bx::simd_ld<bx::simd128_t>(&stream[ParticleStream::ScaleEnd  ][ii]);
 
-				const bx::Vec3 br = bx::add(bx::add(pos, udir), vdir);
-				bx::store(&vertex->m_x, br);
-				aabbExpand(aabb, br);
-				vertex->m_abgr  = abgr;
-				vertex->m_u     = _uv[2];
-				vertex->m_v     = _uv[3];
-				vertex->m_blend = blend;
-				++vertex;
+				const bx::simd128_t blend = bx::simd_madd(bx::simd_sub(blendEnd, blendStart), ttBlend, blendStart);
+				const bx::simd128_t scale = bx::simd_madd(bx::simd_sub(scaleEnd, scaleStart), ttScale, scaleStart);
 
-				const bx::Vec3 bl = bx::add(bx::sub(pos, udir), vdir);
-				bx::store(&vertex->m_x, bl);
-				aabbExpand(aabb, bl);
-				vertex->m_abgr  = abgr;
-				vertex->m_u     = _uv[0];
-				vertex->m_v     = _uv[3];
-				vertex->m_blend = blend;
-				++vertex;
-			}
+				bx::simd_st(&_scratch.m_blend[_offset+ii], blend);
+				bx::simd_st(&_scratch.m_scale[_offset+ii], scale);
+				bx::simd_st(&_scratch.m_keys[_offset+ii], bx::simd_isub(keyBias, bx::simd_sqrt(distSq) ) );
 
-			m_aabb = aabb;
+				for (uint32_t jj = 0; jj < 4; ++jj)
+				{
+					const uint32_t idx = ii+jj;
+
+					const float ttRgba = bx::clamp(easeRgba(life[idx]), 0.0f, 1.0f);
+					const uint32_t segment = bx::min<uint32_t>(uint32_t(ttRgba*4.0f), 3);
+					const float ttmod = ttRgba*4.0f - float(segment);
+					const uint8_t* rgbaStart = (const uint8_t*)&rgba[segment  ][idx];
+					const uint8_t* rgbaEnd   = (const uint8_t*)&rgba[segment+1][idx];
+
+					const float rr = bx::lerp(rgbaStart[0], rgbaEnd[0], ttmod)/255.0f;
+					const float gg = bx::lerp(rgbaStart[1], rgbaEnd[1], ttmod)/255.0f;
+					const float bb = bx::lerp(rgbaStart[2], rgbaEnd[2], ttmod)/255.0f;
+					const float aa = bx::lerp(rgbaStart[3], rgbaEnd[3], ttmod)/255.0f;
+
+					_scratch.m_abgr[_offset+idx]    = toAbgr(rr, gg, bb, aa);
+					_scratch.m_emitter[_offset+idx] = _emitterIdx;
+					_scratch.m_values[_offset+idx]  = _offset+idx;
+				}
+			}
 
-			return m_num;
+			for (uint32_t ii = num; ii < numAligned; ++ii)
+			{
+				_scratch.m_keys[_offset+ii] = UINT32_MAX;
+			}
 		}
 
 		EmitterShape::Enum     m_shape;
 		EmitterDirection::Enum m_direction;
+		EmitterBackend::Enum   m_backend;
 
 		float           m_dt;
 		bx::RngMwc      m_rng;
@@ -427,21 +795,24 @@ namespace ps
 
 		Aabb m_aabb;
 
-		Particle* m_particles;
+		float  m_uv[4];    //!< Sprite UV rect, updated before rendering.
+		uint32_t m_offset; //!< Offset into scratch, updated before rendering.
+
+		float*   m_stream[ParticleStream::Count];
+		float*   m_data;
 		uint32_t m_num;
 		uint32_t m_max;
-	};
 
-	static int32_t particleSortFn(const void* _lhs, const void* _rhs)
-	{
-		const ParticleSort& lhs = *(const ParticleSort*)_lhs;
-		const ParticleSort& rhs = *(const ParticleSort*)_rhs;
-		return lhs.dist > rhs.dist ? -1 : 1;
-	}
+		GpuEmitter m_gpu;
+	};
 
 	struct ParticleSystem
 	{
-		void init(uint16_t _maxEmitters, bx::AllocatorI* _allocator)
+		/// Particles are drawn in batches with static quad index buffer, with 16-bit indices
+		/// batch can't have more than 64K vertices.
+		enum { kMaxBatch = 16<<10 };
+
+		void init(uint16_t _maxEmitters, bx::AllocatorI* _allocator, uint16_t _numThreads)
 		{
 			m_allocator = _allocator;
 
@@ -453,11 +824,21 @@ namespace ps
 
 			m_emitterAlloc = bx::createHandleAlloc(m_allocator, _maxEmitters);
 			m_emitter = (Emitter*)BX_ALLOC(m_allocator, sizeof(Emitter)*_maxEmitters);
+			m_active  = (uint16_t*)BX_ALLOC(m_allocator, sizeof(uint16_t)*_maxEmitters);
 
 			PosColorTexCoord0Vertex::init();
 
 			m_num = 0;
 
+			bx::memSet(&m_scratch, 0, sizeof(m_scratch) );
+			m_scratchData = NULL;
+			m_scratchSize = 0;
+
+			m_jobs.init(0 == _numThreads
+				? std::thread::hardware_concurrency()
+				: _numThreads
+				);
+
 			s_texColor = bgfx::createUniform("s_texColor", bgfx::UniformType::Sampler);
 			m_texture  = bgfx::createTexture2D(
 				  SPRITE_TEXTURE_SIZE
@@ -467,6 +848,50 @@ namespace ps
 				, bgfx::TextureFormat::BGRA8
 				);
 
+			const bgfx::Memory* mem = bgfx::alloc(kMaxBatch*6*sizeof(uint16_t) );
+			uint16_t* index = (uint16_t*)mem->data;
+			for (uint32_t ii = 0; ii < kMaxBatch; ++ii)
+			{
+				const uint16_t idx = uint16_t(ii*4);
+				index[0] = idx+0;
+				index[1] = idx+1;
+				index[2] = idx+2;
+				index[3] = idx+2;
+				index[4] = idx+3;
+				index[5] = idx+0;
+				index += 6;
+			}
+
+			m_quadIb = bgfx::createIndexBuffer(mem);
+
+			m_quadLayout
+				.begin()
+				.add(bgfx::Attrib::Position, 2, bgfx::AttribType::Float)
+				.end();
+
+			static const float s_quadVertices[] =
+			{
+				-1.0f, -1.0f,
+				 1.0f, -1.0f,
+				 1.0f,  1.0f,
+				-1.0f,  1.0f,
+			};
+
+			m_quadVb = bgfx::createVertexBuffer(bgfx::makeRef(s_quadVertices, sizeof(s_quadVertices) ), m_quadLayout);
+
+			m_particleLayout
+				.begin()
+				.add(bgfx::Attrib::TexCoord0, 4, bgfx::AttribType::Float)
+				.end();
+
+			u_params     = bgfx::createUniform("u_params",     bgfx::UniformType::Vec4, BX_COUNTOF(m_gpuParams) );
+			u_rgba       = bgfx::createUniform("u_rgba",       bgfx::UniformType::Vec4, BX_COUNTOF(m_gpuRgba) );
+			u_easeLut    = bgfx::createUniform("u_easeLut",    bgfx::UniformType::Vec4, BX_COUNTOF(m_gpuEaseLut) );
+			u_emitterMtx = bgfx::createUniform("u_emitterMtx", bgfx::UniformType::Mat4);
+			u_sortParams = bgfx::createUniform("u_sortParams", bgfx::UniformType::Vec4);
+
+			m_gpuSupported = false;
+
 			bgfx::RendererType::Enum type = bgfx::getRendererType();
 			m_particleProgram = bgfx::createProgram(
 				  bgfx::createEmbeddedShader(s_embeddedShaders, type, "vs_particle")
@@ -478,10 +903,26 @@ namespace ps
 		void shutdown()
 		{
 			bgfx::destroy(m_particleProgram);
+			bgfx::destroy(u_params);
+			bgfx::destroy(u_rgba);
+			bgfx::destroy(u_easeLut);
+			bgfx::destroy(u_emitterMtx);
+			bgfx::destroy(u_sortParams);
+			bgfx::destroy(m_quadVb);
+			bgfx::destroy(m_quadIb);
 			bgfx::destroy(m_texture);
 			bgfx::destroy(s_texColor);
 
+			m_jobs.shutdown();
+
+			if (NULL != m_scratchData)
+			{
+				BX_ALIGNED_FREE(m_allocator, m_scratchData, 16);
+				m_scratchData = NULL;
+			}
+
 			bx::destroyHandleAlloc(m_allocator, m_emitterAlloc);
+			BX_FREE(m_allocator, m_active);
 			BX_FREE(m_allocator, m_emitter);
 
 			m_allocator = NULL;
@@ -514,111 +955,414 @@ namespace ps
 			m_sprite.destroy(_handle);
 		}
 
+		static void updateJob(void* _userData, uint32_t _idx)
+		{
+			ParticleSystem* ps = (ParticleSystem*)_userData;
+			const uint16_t idx = ps->m_emitterAlloc->getHandleAt(uint16_t(_idx) );
+			ps->m_emitter[idx].update(ps->m_dt);
+		}
+
 		void update(float _dt)
 		{
+			m_dt = _dt;
+			m_jobs.run(updateJob, this, m_emitterAlloc->getNumHandles() );
+
 			uint32_t numParticles = 0;
 			for (uint16_t ii = 0, num = m_emitterAlloc->getNumHandles(); ii < num; ++ii)
 			{
 				const uint16_t idx = m_emitterAlloc->getHandleAt(ii);
-				Emitter& emitter = m_emitter[idx];
-				emitter.update(_dt);
-				numParticles += emitter.m_num;
+				numParticles += m_emitter[idx].m_num;
 			}
 
 			m_num = numParticles;
 		}
 
+		void reserveScratch(uint32_t _num)
+		{
+			if (_num <= m_scratchSize)
+			{
+				return;
+			}
+
+			if (NULL != m_scratchData)
+			{
+				BX_ALIGNED_FREE(m_allocator, m_scratchData, 16);
+			}
+
+			m_scratchSize = bx::max(_num, m_scratchSize*2);
+
+			const uint32_t numStreams = sizeof(ParticleScratch)/sizeof(void*);
+			m_scratchData = (uint8_t*)BX_ALIGNED_ALLOC(m_allocator, numStreams*m_scratchSize*sizeof(uint32_t), 16);
+
+			uint8_t* data = m_scratchData;
+			const uint32_t size = m_scratchSize*sizeof(uint32_t);
+			m_scratch.m_x          = (float*   )data; data += size;
+			m_scratch.m_y          = (float*   )data; data += size;
+			m_scratch.m_z          = (float*   )data; data += size;
+			m_scratch.m_blend      = (float*   )data; data += size;
+			m_scratch.m_scale      = (float*   )data; data += size;
+			m_scratch.m_abgr       = (uint32_t*)data; data += size;
+			m_scratch.m_emitter    = (uint32_t*)data; data += size;
+			m_scratch.m_keys       = (uint32_t*)data; data += size;
+			m_scratch.m_tempKeys   = (uint32_t*)data; data += size;
+			m_scratch.m_values     = (uint32_t*)data; data += size;
+			m_scratch.m_tempValues = (uint32_t*)data;
+		}
+
+		static void prepareJob(void* _userData, uint32_t _idx)
+		{
+			ParticleSystem* ps = (ParticleSystem*)_userData;
+			const uint16_t idx = ps->m_active[_idx];
+			Emitter& emitter = ps->m_emitter[idx];
+			emitter.prepare(ps->m_scratch, emitter.m_offset, idx, ps->m_eye);
+		}
+
+		static void vertexJob(void* _userData, uint32_t _idx)
+		{
+			ParticleSystem* ps = (ParticleSystem*)_userData;
+			ps->writeVertices(_idx*kMaxBatch, bx::min<uint32_t>(ps->m_numRender - _idx*kMaxBatch, kMaxBatch) );
+		}
+
+		void writeVertices(uint32_t _first, uint32_t _num)
+		{
+			const float* mtx = m_mtxView;
+			const uint32_t* values = &m_scratch.m_values[m_firstRender + _first];
+			PosColorTexCoord0Vertex* vertex = &m_vertices[_first*4];
+
+			for (uint32_t ii = 0; ii < _num; ++ii)
+			{
+				const uint32_t idx = values[ii];
+
+				const float xx    = m_scratch.m_x[idx];
+				const float yy    = m_scratch.m_y[idx];
+				const float zz    = m_scratch.m_z[idx];
+				const float scale = m_scratch.m_scale[idx];
+				const float blend = m_scratch.m_blend[idx];
+				const uint32_t abgr = m_scratch.m_abgr[idx];
+				const float* uv = m_emitter[m_scratch.m_emitter[idx] ].m_uv;
+
+				const float ux = mtx[0]*scale, uy = mtx[4]*scale, uz = mtx[8]*scale;
+				const float vx = mtx[1]*scale, vy = mtx[5]*scale, vz = mtx[9]*scale;
+
+				vertex->m_x     = xx - ux - vx;
+				vertex->m_y     = yy - uy - vy;
+				vertex->m_z     = zz - uz - vz;
+				vertex->m_abgr  = abgr;
+				vertex->m_u     = uv[0];
+				vertex->m_v     = uv[1];
+				vertex->m_blend = blend;
+				vertex->m_angle = 0.0f;
+				++vertex;
+
+				vertex->m_x     = xx + ux - vx;
+				vertex->m_y     = yy + uy - vy;
+				vertex->m_z     = zz + uz - vz;
+				vertex->m_abgr  = abgr;
+				vertex->m_u     = uv[2];
+				vertex->m_v     = uv[1];
+				vertex->m_blend = blend;
+				vertex->m_angle = 0.0f;
+				++vertex;
+
+				vertex->m_x     = xx + ux + vx;
+				vertex->m_y     = yy + uy + vy;
+				vertex->m_z     = zz + uz + vz;
+				vertex->m_abgr  = abgr;
+				vertex->m_u     = uv[2];
+				vertex->m_v     = uv[3];
+				vertex->m_blend = blend;
+				vertex->m_angle = 0.0f;
+				++vertex;
+
+				vertex->m_x     = xx - ux + vx;
+				vertex->m_y     = yy - uy + vy;
+				vertex->m_z     = zz - uz + vz;
+				vertex->m_abgr  = abgr;
+				vertex->m_u     = uv[0];
+				vertex->m_v     = uv[3];
+				vertex->m_blend = blend;
+				vertex->m_angle = 0.0f;
+				++vertex;
+			}
+		}
+
 		void render(uint8_t _view, const float* _mtxView, const bx::Vec3& _eye)
 		{
-			if (0 != m_num)
+			renderCpu(_view, _mtxView, _eye);
+
+			for (uint16_t ii = 0, numEmitters = m_emitterAlloc->getNumHandles(); ii < numEmitters; ++ii)
 			{
-				bgfx::TransientVertexBuffer tvb;
-				bgfx::TransientIndexBuffer tib;
+				const uint16_t idx = m_emitterAlloc->getHandleAt(ii);
+				Emitter& emitter = m_emitter[idx];
 
-				const uint32_t numVertices = bgfx::getAvailTransientVertexBuffer(m_num*4, PosColorTexCoord0Vertex::ms_layout);
-				const uint32_t numIndices  = bgfx::getAvailTransientIndexBuffer(m_num*6);
-				const uint32_t max = bx::uint32_min(numVertices/4, numIndices/6);
-				BX_WARN(m_num == max
-					, "Truncating transient buffer for particles to maximum available (requested %d, available %d)."
-					, m_num
-					, max
-					);
+				if (EmitterBackend::Gpu == emitter.m_backend)
+				{
+					renderGpu(_view, _mtxView, _eye, emitter);
+				}
+			}
+		}
+
+		void renderCpu(uint8_t _view, const float* _mtxView, const bx::Vec3& _eye)
+		{
+			if (0 == m_num)
+			{
+				return;
+			}
+
+			// Each emitter writes its own range of scratch, aligned to SIMD width.
+			uint32_t numActive = 0;
+			uint32_t offset    = 0;
+			for (uint16_t ii = 0, numEmitters = m_emitterAlloc->getNumHandles(); ii < numEmitters; ++ii)
+			{
+				const uint16_t idx = m_emitterAlloc->getHandleAt(ii);
+				Emitter& emitter = m_emitter[idx];
 
-				if (0 < max)
+				if (0 == emitter.m_num)
 				{
-					bgfx::allocTransientBuffers(&tvb
-						, PosColorTexCoord0Vertex::ms_layout
-						, max*4
-						, &tib
-						, max*6
-						);
-					PosColorTexCoord0Vertex* vertices = (PosColorTexCoord0Vertex*)tvb.data;
+					continue;
+				}
 
-					ParticleSort* particleSort = (ParticleSort*)BX_ALLOC(m_allocator, max*sizeof(ParticleSort) );
+				const Pack2D& pack = m_sprite.get(emitter.m_uniforms.m_handle);
+				const float invTextureSize = 1.0f/SPRITE_TEXTURE_SIZE;
+				emitter.m_uv[0] =  pack.m_x                  * invTextureSize;
+				emitter.m_uv[1] =  pack.m_y                  * invTextureSize;
+				emitter.m_uv[2] = (pack.m_x + pack.m_width ) * invTextureSize;
+				emitter.m_uv[3] = (pack.m_y + pack.m_height) * invTextureSize;
 
-					uint32_t pos = 0;
-					for (uint16_t ii = 0, numEmitters = m_emitterAlloc->getNumHandles(); ii < numEmitters; ++ii)
-					{
-						const uint16_t idx = m_emitterAlloc->getHandleAt(ii);
-						Emitter& emitter = m_emitter[idx];
+				emitter.m_offset = offset;
+				offset += (emitter.m_num+3) & ~3;
 
-						const Pack2D& pack = m_sprite.get(emitter.m_uniforms.m_handle);
-						const float invTextureSize = 1.0f/SPRITE_TEXTURE_SIZE;
-						const float uv[4] =
-						{
-							 pack.m_x                  * invTextureSize,
-							 pack.m_y                  * invTextureSize,
-							(pack.m_x + pack.m_width ) * invTextureSize,
-							(pack.m_y + pack.m_height) * invTextureSize,
-						};
+				m_active[numActive++] = idx;
+			}
 
-						pos += emitter.render(uv, _mtxView, _eye, pos, max, particleSort, vertices);
-					}
+			reserveScratch(offset);
 
-					qsort(particleSort
-						, max
-						, sizeof(ParticleSort)
-						, particleSortFn
-						);
+			bx::memCopy(m_mtxView, _mtxView, sizeof(m_mtxView) );
+			m_eye = _eye;
 
-					uint16_t* indices = (uint16_t*)tib.data;
-					for (uint32_t ii = 0; ii < max; ++ii)
-					{
-						const ParticleSort& sort = particleSort[ii];
-						uint16_t* index = &indices[ii*6];
-						uint16_t idx = (uint16_t)sort.idx;
-						index[0] = idx*4+0;
-						index[1] = idx*4+1;
-						index[2] = idx*4+2;
-						index[3] = idx*4+2;
-						index[4] = idx*4+3;
-						index[5] = idx*4+0;
-					}
+			m_jobs.run(prepareJob, this, numActive);
 
-					BX_FREE(m_allocator, particleSort);
+			// Padding entries are sorted to the end, past m_num.
+			bx::radixSort(m_scratch.m_keys, m_scratch.m_tempKeys, m_scratch.m_values, m_scratch.m_tempValues, offset);
 
-					bgfx::setState(0
-						| BGFX_STATE_WRITE_RGB
-						| BGFX_STATE_WRITE_A
-						| BGFX_STATE_DEPTH_TEST_LESS
-						| BGFX_STATE_CULL_CW
-						| BGFX_STATE_BLEND_NORMAL
-						);
-					bgfx::setVertexBuffer(0, &tvb);
-					bgfx::setIndexBuffer(&tib);
-					bgfx::setTexture(0, s_texColor, m_texture);
-					bgfx::submit(_view, m_particleProgram);
+			const uint32_t numVertices = bgfx::getAvailTransientVertexBuffer(m_num*4, PosColorTexCoord0Vertex::ms_layout);
+			const uint32_t max = numVertices/4;
+			BX_WARN(m_num == max
+				, "Truncating transient buffer for particles to maximum available (requested %d, available %d)."
+				, m_num
+				, max
+				);
+
+			if (0 == max)
+			{
+				return;
+			}
+
+			bgfx::TransientVertexBuffer tvb;
+			bgfx::allocTransientVertexBuffer(&tvb, max*4, PosColorTexCoord0Vertex::ms_layout);
+
+			// When truncated, farthest particles are dropped.
+			m_vertices    = (PosColorTexCoord0Vertex*)tvb.data;
+			m_firstRender = m_num - max;
+			m_numRender   = max;
+
+			const uint32_t numBatches = (max + kMaxBatch - 1)/kMaxBatch;
+			m_jobs.run(vertexJob, this, numBatches);
+
+			// Draws with equal sort key keep submission order, batches are drawn back to front.
+			for (uint32_t ii = 0; ii < numBatches; ++ii)
+			{
+				const uint32_t first = ii*kMaxBatch;
+				const uint32_t num   = bx::min<uint32_t>(max - first, kMaxBatch);
+
+				bgfx::setState(0
+					| BGFX_STATE_WRITE_RGB
+					| BGFX_STATE_WRITE_A
+					| BGFX_STATE_DEPTH_TEST_LESS
+					| BGFX_STATE_CULL_CW
+					| BGFX_STATE_BLEND_NORMAL
+					);
+				bgfx::setVertexBuffer(0, &tvb, first*4, num*4);
+				bgfx::setIndexBuffer(m_quadIb, 0, num*6);
+				bgfx::setTexture(0, s_texColor, m_texture);
+				bgfx::submit(_view, m_particleProgram);
+			}
+		}
+
+		void setGpuUniforms()
+		{
+			bgfx::setUniform(u_params,     m_gpuParams,  BX_COUNTOF(m_gpuParams) );
+			bgfx::setUniform(u_rgba,       m_gpuRgba,    BX_COUNTOF(m_gpuRgba) );
+			bgfx::setUniform(u_easeLut,    m_gpuEaseLut, BX_COUNTOF(m_gpuEaseLut) );
+			bgfx::setUniform(u_emitterMtx, m_gpuMtx);
+		}
+
+		void renderGpu(uint8_t _view, const float* _mtxView, const bx::Vec3& _eye, Emitter& _emitter)
+		{
+			GpuEmitter& gpu = _emitter.m_gpu;
+			const EmitterUniforms& uniforms = _emitter.m_uniforms;
+
+			bx::mtxSRT(m_gpuMtx
+				, 1.0f, 1.0f, 1.0f
+				, uniforms.m_angle[0],    uniforms.m_angle[1],    uniforms.m_angle[2]
+				, uniforms.m_position[0], uniforms.m_position[1], uniforms.m_position[2]
+				);
+
+			const float timePerParticle = 0 < uniforms.m_particlesPerSecond
+				? 1.0f/uniforms.m_particlesPerSecond
+				: 0.0f
+				;
+
+			const Pack2D& pack = m_sprite.get(uniforms.m_handle);
+			const float invTextureSize = 1.0f/SPRITE_TEXTURE_SIZE;
+
+			float* params = &m_gpuParams[0][0];
+			params[ 0] = gpu.m_dt;
+			params[ 1] = bx::bitsToFloat(gpu.m_numSpawn);
+			params[ 2] = bx::bitsToFloat(gpu.m_head);
+			params[ 3] = bx::bitsToFloat(gpu.m_capacity);
+			params[ 4] = bx::bitsToFloat(_emitter.m_rng.gen() );
+			params[ 5] = bx::bitsToFloat(uint32_t(_emitter.m_shape) );
+			params[ 6] = bx::bitsToFloat(uint32_t(_emitter.m_direction) );
+			params[ 7] = uniforms.m_gravityScale;
+			params[ 8] = uniforms.m_offsetStart[0];
+			params[ 9] = uniforms.m_offsetStart[1];
+			params[10] = uniforms.m_offsetEnd[0];
+			params[11] = uniforms.m_offsetEnd[1];
+			params[12] = uniforms.m_lifeSpan[0];
+			params[13] = uniforms.m_lifeSpan[1];
+			params[14] = timePerParticle;
+			params[15] = 0.0f;
+			params[16] = uniforms.m_blendStart[0];
+			params[17] = uniforms.m_blendStart[1];
+			params[18] = uniforms.m_blendEnd[0];
+			params[19] = uniforms.m_blendEnd[1];
+			params[20] = uniforms.m_scaleStart[0];
+			params[21] = uniforms.m_scaleStart[1];
+			params[22] = uniforms.m_scaleEnd[0];
+			params[23] = uniforms.m_scaleEnd[1];
+			params[24] = _eye.x;
+			params[25] = _eye.y;
+			params[26] = _eye.z;
+			params[27] = 0.0f;
+			params[28] =  pack.m_x                  * invTextureSize;
+			params[29] =  pack.m_y                  * invTextureSize;
+			params[30] = (pack.m_x + pack.m_width ) * invTextureSize;
+			params[31] = (pack.m_y + pack.m_height) * invTextureSize;
+			params[32] = _mtxView[0];
+			params[33] = _mtxView[4];
+			params[34] = _mtxView[8];
+			params[35] = 0.0f;
+			params[36] = _mtxView[1];
+			params[37] = _mtxView[5];
+			params[38] = _mtxView[9];
+			params[39] = 0.0f;
+
+			for (uint32_t ii = 0; ii < BX_COUNTOF(m_gpuRgba); ++ii)
+			{
+				const uint8_t* rgba = (const uint8_t*)&uniforms.m_rgba[ii];
+				m_gpuRgba[ii][0] = rgba[0]/255.0f;
+				m_gpuRgba[ii][1] = rgba[1]/255.0f;
+				m_gpuRgba[ii][2] = rgba[2]/255.0f;
+				m_gpuRgba[ii][3] = rgba[3]/255.0f;
+			}
+
+			// Easing functions are not evaluated in shader, they are sampled into lookup table.
+			const bx::EaseFn easePos   = bx::getEaseFunc(uniforms.m_easePos);
+			const bx::EaseFn easeRgba  = bx::getEaseFunc(uniforms.m_easeRgba);
+			const bx::EaseFn easeBlend = bx::getEaseFunc(uniforms.m_easeBlend);
+			const bx::EaseFn easeScale = bx::getEaseFunc(uniforms.m_easeScale);
+
+			for (uint32_t ii = 0; ii < BX_COUNTOF(m_gpuEaseLut); ++ii)
+			{
+				const float tt = float(ii)/float(BX_COUNTOF(m_gpuEaseLut)-1);
+				m_gpuEaseLut[ii][0] = easePos(tt);
+				m_gpuEaseLut[ii][1] = easeRgba(tt);
+				m_gpuEaseLut[ii][2] = easeBlend(tt);
+				m_gpuEaseLut[ii][3] = easeScale(tt);
+			}
+
+			if (0 < gpu.m_numSpawn)
+			{
+				setGpuUniforms();
+				bgfx::setBuffer(0, gpu.m_particles, bgfx::Access::ReadWrite);
+				bgfx::dispatch(_view, m_gpuPrograms.spawn, (gpu.m_numSpawn + 63)/64);
+			}
+
+			const uint32_t numGroups = gpu.m_capacity/256;
+
+			setGpuUniforms();
+			bgfx::setBuffer(0, gpu.m_particles, bgfx::Access::ReadWrite);
+			bgfx::setBuffer(1, gpu.m_sort,      bgfx::Access::Write);
+			bgfx::setBuffer(2, gpu.m_counter,   bgfx::Access::ReadWrite);
+			bgfx::dispatch(_view, m_gpuPrograms.update, numGroups);
+
+			for (uint32_t block = 2; block <= gpu.m_capacity; block <<= 1)
+			{
+				for (uint32_t stride = block>>1; 0 < stride; stride >>= 1)
+				{
+					const float sortParams[4] = { bx::bitsToFloat(block), bx::bitsToFloat(stride), 0.0f, 0.0f };
+					bgfx::setUniform(u_sortParams, sortParams);
+					bgfx::setBuffer(1, gpu.m_sort, bgfx::Access::ReadWrite);
+					bgfx::dispatch(_view, m_gpuPrograms.sort, numGroups);
 				}
 			}
+
+			bgfx::setBuffer(2, gpu.m_counter,  bgfx::Access::ReadWrite);
+			bgfx::setBuffer(3, gpu.m_indirect, bgfx::Access::ReadWrite);
+			bgfx::dispatch(_view, m_gpuPrograms.indirect, 1);
+
+			setGpuUniforms();
+			bgfx::setState(0
+				| BGFX_STATE_WRITE_RGB
+				| BGFX_STATE_WRITE_A
+				| BGFX_STATE_DEPTH_TEST_LESS
+				| BGFX_STATE_CULL_CW
+				| BGFX_STATE_BLEND_NORMAL
+				);
+			bgfx::setVertexBuffer(0, m_quadVb);
+			bgfx::setIndexBuffer(m_quadIb, 0, 6);
+			bgfx::setBuffer(1, gpu.m_particles, bgfx::Access::Read);
+			bgfx::setBuffer(2, gpu.m_sort,      bgfx::Access::Read);
+			bgfx::setTexture(0, s_texColor, m_texture);
+			bgfx::submit(_view, m_gpuPrograms.draw, gpu.m_indirect, 0);
+
+			gpu.m_head     = (gpu.m_head + gpu.m_numSpawn) & (gpu.m_capacity-1);
+			gpu.m_numSpawn = 0;
+			gpu.m_dt       = 0.0f;
 		}
 
-		EmitterHandle createEmitter(EmitterShape::Enum _shape, EmitterDirection::Enum _direction, uint32_t _maxParticles)
+		void setGpuPrograms(const EmitterGpuPrograms& _programs)
+		{
+			m_gpuPrograms = _programs;
+
+			const uint64_t required = 0
+				| BGFX_CAPS_COMPUTE
+				| BGFX_CAPS_DRAW_INDIRECT
+				| BGFX_CAPS_INSTANCING
+				;
+
+			m_gpuSupported = true
+				&& required == (bgfx::getCaps()->supported & required)
+				&& bgfx::isValid(_programs.spawn)
+				&& bgfx::isValid(_programs.update)
+				&& bgfx::isValid(_programs.sort)
+				&& bgfx::isValid(_programs.indirect)
+				&& bgfx::isValid(_programs.draw)
+				;
+		}
+
+		EmitterHandle createEmitter(EmitterShape::Enum _shape, EmitterDirection::Enum _direction, uint32_t _maxParticles, EmitterBackend::Enum _backend)
 		{
 			EmitterHandle handle = { m_emitterAlloc->alloc() };
 
 			if (UINT16_MAX != handle.idx)
 			{
-				m_emitter[handle.idx].create(_shape, _direction, _maxParticles);
+				const EmitterBackend::Enum backend = m_gpuSupported
+					? _backend
+					: EmitterBackend::Cpu
+					;
+				m_emitter[handle.idx].create(_shape, _direction, _maxParticles, backend);
 			}
 
 			return handle;
@@ -666,43 +1410,120 @@ namespace ps
 		bx::AllocatorI* m_allocator;
 
 		bx::HandleAlloc* m_emitterAlloc;
-		Emitter* m_emitter;
+		Emitter*  m_emitter;
+		uint16_t* m_active;
 
 		typedef SpriteT<256, SPRITE_TEXTURE_SIZE> Sprite;
 		Sprite m_sprite;
 
-		bgfx::UniformHandle s_texColor;
-		bgfx::TextureHandle m_texture;
-		bgfx::ProgramHandle m_particleProgram;
+		JobPool m_jobs;
+
+		ParticleScratch m_scratch;
+		uint8_t*        m_scratchData;
+		uint32_t        m_scratchSize;
+
+		// Per frame job parameters.
+		float    m_dt;
+		float    m_mtxView[16];
+		bx::Vec3 m_eye;
+		PosColorTexCoord0Vertex* m_vertices;
+		uint32_t m_firstRender;
+		uint32_t m_numRender;
+
+		bgfx::UniformHandle     s_texColor;
+		bgfx::TextureHandle     m_texture;
+		bgfx::IndexBufferHandle m_quadIb;
+		bgfx::ProgramHandle     m_particleProgram;
+
+		// GPU emitters.
+		bgfx::VertexLayout       m_quadLayout;
+		bgfx::VertexLayout       m_particleLayout;
+		bgfx::VertexBufferHandle m_quadVb;
+		bgfx::UniformHandle      u_params;
+		bgfx::UniformHandle      u_rgba;
+		bgfx::UniformHandle      u_easeLut;
+		bgfx::UniformHandle      u_emitterMtx;
+		bgfx::UniformHandle      u_sortParams;
+		EmitterGpuPrograms       m_gpuPrograms;
+		bool                     m_gpuSupported;
+
+		float m_gpuParams[10][4];
+		float m_gpuRgba[5][4];
+		float m_gpuEaseLut[32][4];
+		float m_gpuMtx[16];
 
 		uint32_t m_num;
 	};
 
 	static ParticleSystem s_ctx;
 
-	void Emitter::create(EmitterShape::Enum _shape, EmitterDirection::Enum _direction, uint32_t _maxParticles)
+	void Emitter::create(EmitterShape::Enum _shape, EmitterDirection::Enum _direction, uint32_t _maxParticles, EmitterBackend::Enum _backend)
 	{
 		reset();
 
 		m_shape     = _shape;
 		m_direction = _direction;
+		m_backend   = _backend;
 		m_max       = _maxParticles;
-		m_particles = (Particle*)BX_ALLOC(s_ctx.m_allocator, m_max*sizeof(Particle) );
+
+		if (EmitterBackend::Gpu == m_backend)
+		{
+			// CPU streams are not used, all particle data stays in GPU buffers.
+			m_data = NULL;
+			m_max  = 0;
+
+			GpuEmitter& gpu = m_gpu;
+			gpu.m_capacity = bx::uint32_nextpow2(bx::max<uint32_t>(_maxParticles, 256) );
+			gpu.m_head     = 0;
+
+			// Zeroed particle has zero inverse life span, which marks slot as never used.
+			const bgfx::Memory* mem = bgfx::alloc(gpu.m_capacity*4*sizeof(float)*4);
+			bx::memSet(mem->data, 0, mem->size);
+			gpu.m_particles = bgfx::createDynamicVertexBuffer(mem, s_ctx.m_particleLayout, BGFX_BUFFER_COMPUTE_READ_WRITE);
+
+			gpu.m_sort = bgfx::createDynamicIndexBuffer(gpu.m_capacity*2, BGFX_BUFFER_COMPUTE_READ_WRITE|BGFX_BUFFER_INDEX32);
+
+			mem = bgfx::alloc(sizeof(uint32_t) );
+			bx::memSet(mem->data, 0, mem->size);
+			gpu.m_counter  = bgfx::createDynamicIndexBuffer(mem, BGFX_BUFFER_COMPUTE_READ_WRITE|BGFX_BUFFER_INDEX32);
+			gpu.m_indirect = bgfx::createIndirectBuffer(1);
+
+			return;
+		}
+
+		// Streams are padded to multiple of 4, so that SIMD loops don't need scalar tail.
+		const uint32_t capacity = (bx::max<uint32_t>(m_max, 1) + 3) & ~3;
+		m_data = (float*)BX_ALIGNED_ALLOC(s_ctx.m_allocator, ParticleStream::Count*capacity*sizeof(float), 16);
+		bx::memSet(m_data, 0, ParticleStream::Count*capacity*sizeof(float) );
+
+		for (uint32_t ii = 0; ii < ParticleStream::Count; ++ii)
+		{
+			m_stream[ii] = &m_data[ii*capacity];
+		}
 	}
 
 	void Emitter::destroy()
 	{
-		BX_FREE(s_ctx.m_allocator, m_particles);
-		m_particles = NULL;
+		if (EmitterBackend::Gpu == m_backend)
+		{
+			bgfx::destroy(m_gpu.m_particles);
+			bgfx::destroy(m_gpu.m_sort);
+			bgfx::destroy(m_gpu.m_counter);
+			bgfx::destroy(m_gpu.m_indirect);
+			return;
+		}
+
+		BX_ALIGNED_FREE(s_ctx.m_allocator, m_data, 16);
+		m_data = NULL;
 	}
 
 } // namespace ps
 
 using namespace ps;
 
-void psInit(uint16_t _maxEmitters, bx::AllocatorI* _allocator)
+void psInit(uint16_t _maxEmitters, bx::AllocatorI* _allocator, uint16_t _numThreads)
 {
-	s_ctx.init(_maxEmitters, _allocator);
+	s_ctx.init(_maxEmitters, _allocator, _numThreads);
 }
 
 void psShutdown()
@@ -720,9 +1541,14 @@ void psDestroy(EmitterSpriteHandle _handle)
 	s_ctx.destroy(_handle);
 }
 
-EmitterHandle psCreateEmitter(EmitterShape::Enum _shape, EmitterDirection::Enum _direction, uint32_t _maxParticles)
+void psSetGpuPrograms(const EmitterGpuPrograms& _programs)
+{
+	s_ctx.setGpuPrograms(_programs);
+}
+
+EmitterHandle psCreateEmitter(EmitterShape::Enum _shape, EmitterDirection::Enum _direction, uint32_t _maxParticles, EmitterBackend::Enum _backend)
 {
-	return s_ctx.createEmitter(_shape, _direction, _maxParticles);
+	return s_ctx.createEmitter(_shape, _direction, _maxParticles, _backend);
 }
 
 void psUpdateEmitter(EmitterHandle _handle, const EmitterUniforms* _uniforms)
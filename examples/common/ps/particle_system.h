@@ -6,6 +6,7 @@
 #ifndef PARTICLE_SYSTEM_H_HEADER_GUARD
 #define PARTICLE_SYSTEM_H_HEADER_GUARD
 
+#include <bgfx/bgfx.h>
 #include <bx/allocator.h>
 #include <bx/easing.h>
 #include <bx/rng.h>
@@ -46,6 +47,28 @@ struct EmitterDirection
 	};
 };
 
+struct EmitterBackend
+{
+	enum Enum
+	{
+		Cpu, //!< Simulated on CPU, sorted together with particles of other CPU emitters.
+		Gpu, //!< Spawned, simulated, sorted and drawn with compute shaders and indirect draw.
+
+		Count
+	};
+};
+
+/// Programs used by GPU emitters. Programs are owned by caller, reference implementation is
+/// in `examples/32-particles/cs_particle_*.sc` and `vs_particle_gpu.sc`.
+struct EmitterGpuPrograms
+{
+	bgfx::ProgramHandle spawn;
+	bgfx::ProgramHandle update;
+	bgfx::ProgramHandle sort;
+	bgfx::ProgramHandle indirect;
+	bgfx::ProgramHandle draw;
+};
+
 struct EmitterUniforms
 {
 	void reset();
@@ -73,8 +96,10 @@ struct EmitterUniforms
 	EmitterSpriteHandle m_handle;
 };
 
-///
-void psInit(uint16_t _maxEmitters = 64, bx::AllocatorI* _allocator = NULL);
+/// Initialize particle system. Emitters are updated, and billboards are generated on
+/// `_numThreads` threads, calling thread included. When `_numThreads` is zero, number of
+/// hardware threads is used.
+void psInit(uint16_t _maxEmitters = 64, bx::AllocatorI* _allocator = NULL, uint16_t _numThreads = 0);
 
 ///
 void psShutdown();
@@ -85,13 +110,23 @@ EmitterSpriteHandle psCreateSprite(uint16_t _width, uint16_t _height, const void
 ///
 void psDestroy(EmitterSpriteHandle _handle);
 
+/// Set programs used by GPU emitters. GPU emitter created before programs are set, or when
+/// compute and indirect draw are not supported, falls back to CPU.
+void psSetGpuPrograms(const EmitterGpuPrograms& _programs);
+
 ///
-EmitterHandle psCreateEmitter(EmitterShape::Enum _shape, EmitterDirection::Enum _direction, uint32_t _maxParticles);
+EmitterHandle psCreateEmitter(
+	  EmitterShape::Enum _shape
+	, EmitterDirection::Enum _direction
+	, uint32_t _maxParticles
+	, EmitterBackend::Enum _backend = EmitterBackend::Cpu
+	);
 
 ///
 void psUpdateEmitter(EmitterHandle _handle, const EmitterUniforms* _uniforms = NULL);
 
-///
+/// Get emitter bounds computed by last `psUpdate`. Empty emitter has zero size bounds at emitter
+/// position.
 void psGetAabb(EmitterHandle _handle, Aabb& _outAabb);
 
 ///
@@ -0,0 +1,247 @@
+/*
+ * Copyright 2011-2019 Branimir Karadzic. All rights reserved.
+ * License: https://github.com/bkaradzic/bgfx#license-bsd-2-clause
+ */
+
+#include <bx/math.h>
+#include <bx/uint32_t.h>
+#include "entry/entry.h"
+#include "readback.h"
+
+ReadbackQueue::ReadbackQueue(uint32_t _stagingSize)
+	: m_capacity(_stagingSize)
+	, m_head(0)
+	, m_tail(0)
+	, m_nextId(1)
+	, m_lastDone(0)
+	, m_copyProgram(BGFX_INVALID_HANDLE)
+	, m_computeTexture(BGFX_INVALID_HANDLE)
+{
+	m_staging = (uint8_t*)BX_ALLOC(entry::getAllocator(), m_capacity);
+
+	u_readbackParams = bgfx::createUniform("u_readbackParams", bgfx::UniformType::Vec4);
+
+	for (uint32_t ii = 0; ii < kNumBufferTextures; ++ii)
+	{
+		m_bufferTexture[ii].m_readback.idx = bgfx::kInvalidHandle;
+		m_bufferTexture[ii].m_height = 0;
+		m_bufferTexture[ii].m_busy   = 0;
+	}
+}
+
+ReadbackQueue::~ReadbackQueue()
+{
+	for (uint32_t ii = 0; ii < kNumBufferTextures; ++ii)
+	{
+		if (bgfx::isValid(m_bufferTexture[ii].m_readback) )
+		{
+			bgfx::destroy(m_bufferTexture[ii].m_readback);
+		}
+	}
+
+	if (bgfx::isValid(m_computeTexture) )
+	{
+		bgfx::destroy(m_computeTexture);
+	}
+
+	bgfx::destroy(u_readbackParams);
+
+	BX_FREE(entry::getAllocator(), m_staging);
+}
+
+void ReadbackQueue::setCopyProgram(bgfx::ProgramHandle _program)
+{
+	m_copyProgram = _program;
+}
+
+uint32_t ReadbackQueue::alloc(uint32_t _size)
+{
+	if (m_pending.empty() )
+	{
+		m_head = 0;
+		m_tail = 0;
+	}
+
+	// Requests are released in order they were issued, so staging memory is used as ring. Head
+	// never catches up with tail, to keep full and empty state apart.
+	if (m_head >= m_tail)
+	{
+		if (m_capacity - m_head >= _size)
+		{
+			const uint32_t offset = m_head;
+			m_head += _size;
+			return offset;
+		}
+
+		if (!m_pending.empty()
+		&&  m_tail > _size)
+		{
+			m_head = _size;
+			return 0;
+		}
+	}
+	else if (m_tail - m_head > _size)
+	{
+		const uint32_t offset = m_head;
+		m_head += _size;
+		return offset;
+	}
+
+	return UINT32_MAX;
+}
+
+ReadbackFence ReadbackQueue::readTextureAsync(bgfx::TextureHandle _handle, uint32_t _size, uint8_t _mip, ReadbackFn _fn, void* _userData)
+{
+	ReadbackFence fence = { 0 };
+
+	const uint32_t offset = alloc(_size);
+	if (UINT32_MAX == offset)
+	{
+		return fence;
+	}
+
+	Request req;
+	req.m_id       = m_nextId++;
+	req.m_frame    = bgfx::readTexture(_handle, &m_staging[offset], _mip);
+	req.m_offset   = offset;
+	req.m_size     = _size;
+	req.m_fn       = _fn;
+	req.m_userData = _userData;
+	m_pending.push_back(req);
+
+	fence.id = req.m_id;
+	return fence;
+}
+
+ReadbackFence ReadbackQueue::readBufferAsync(bgfx::ViewId _computeViewId, bgfx::ViewId _blitViewId, bgfx::DynamicVertexBufferHandle _handle, uint32_t _num, ReadbackFn _fn, void* _userData)
+{
+	ReadbackFence fence = { 0 };
+
+	const uint64_t required = 0
+		| BGFX_CAPS_COMPUTE
+		| BGFX_CAPS_TEXTURE_BLIT
+		| BGFX_CAPS_TEXTURE_READ_BACK
+		;
+
+	if (!bgfx::isValid(m_copyProgram)
+	||  required != (bgfx::getCaps()->supported & required)
+	||  0 == _num
+	||  kBufferTextureWidth*kBufferTextureHeight < _num)
+	{
+		return fence;
+	}
+
+	BufferTexture* texture = NULL;
+	for (uint32_t ii = 0; ii < kNumBufferTextures && NULL == texture; ++ii)
+	{
+		if (isDone({ m_bufferTexture[ii].m_busy }) )
+		{
+			texture = &m_bufferTexture[ii];
+		}
+	}
+
+	if (NULL == texture)
+	{
+		return fence;
+	}
+
+	// Readback texture only has as many rows as request needs, rounded up to power of two so
+	// that textures are not recreated for every size. Whole texture is read back, but elements
+	// are laid out row by row, so first _num elements are contiguous at the start of staging
+	// memory.
+	const uint32_t numRows = (_num + kBufferTextureWidth - 1)/kBufferTextureWidth;
+	const uint32_t height  = bx::uint32_nextpow2(numRows);
+	const uint32_t size    = kBufferTextureWidth*height*16;
+	const uint32_t offset  = alloc(size);
+	if (UINT32_MAX == offset)
+	{
+		return fence;
+	}
+
+	if (!bgfx::isValid(m_computeTexture) )
+	{
+		m_computeTexture = bgfx::createTexture2D(
+			  kBufferTextureWidth
+			, kBufferTextureHeight
+			, false
+			, 1
+			, bgfx::TextureFormat::RGBA32F
+			, BGFX_TEXTURE_COMPUTE_WRITE
+			);
+	}
+
+	if (bgfx::isValid(texture->m_readback)
+	&&  height != texture->m_height)
+	{
+		bgfx::destroy(texture->m_readback);
+		texture->m_readback.idx = bgfx::kInvalidHandle;
+	}
+
+	if (!bgfx::isValid(texture->m_readback) )
+	{
+		texture->m_height   = height;
+		texture->m_readback = bgfx::createTexture2D(
+			  kBufferTextureWidth
+			, uint16_t(height)
+			, false
+			, 1
+			, bgfx::TextureFormat::RGBA32F
+			, BGFX_TEXTURE_BLIT_DST|BGFX_TEXTURE_READ_BACK
+			);
+	}
+
+	const float params[4] =
+	{
+		bx::bitsToFloat(_num),
+		bx::bitsToFloat(uint32_t(kBufferTextureWidth) ),
+		0.0f,
+		0.0f,
+	};
+
+	bgfx::setUniform(u_readbackParams, params);
+	bgfx::setBuffer(0, _handle, bgfx::Access::Read);
+	bgfx::setImage(1, m_computeTexture, 0, bgfx::Access::Write, bgfx::TextureFormat::RGBA32F);
+	bgfx::dispatch(_computeViewId, m_copyProgram, uint16_t( (_num+63)/64), 1, 1);
+
+	bgfx::blit(_blitViewId, texture->m_readback, 0, 0, m_computeTexture, 0, 0, kBufferTextureWidth, uint16_t(numRows) );
+
+	Request req;
+	req.m_id       = m_nextId++;
+	req.m_frame    = bgfx::readTexture(texture->m_readback, &m_staging[offset]);
+	req.m_offset   = offset;
+	req.m_size     = _num*16;
+	req.m_fn       = _fn;
+	req.m_userData = _userData;
+	m_pending.push_back(req);
+
+	texture->m_busy = req.m_id;
+
+	fence.id = req.m_id;
+	return fence;
+}
+
+void ReadbackQueue::update(uint32_t _frame)
+{
+	while (!m_pending.empty()
+	&&     m_pending[0].m_frame <= _frame)
+	{
+		const Request req = m_pending[0];
+
+		m_lastDone = req.m_id;
+
+		// Request is released only after callback returns, so that readbacks issued from
+		// callback can't reuse its staging memory.
+		if (NULL != req.m_fn)
+		{
+			ReadbackFence fence = { req.m_id };
+			req.m_fn(req.m_userData, fence, &m_staging[req.m_offset], req.m_size);
+		}
+
+		m_pending.erase(m_pending.begin() );
+
+		if (!m_pending.empty() )
+		{
+			m_tail = m_pending[0].m_offset;
+		}
+	}
+}
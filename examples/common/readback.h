@@ -0,0 +1,132 @@
+/*
+ * Copyright 2011-2019 Branimir Karadzic. All rights reserved.
+ * License: https://github.com/bkaradzic/bgfx#license-bsd-2-clause
+ */
+
+#ifndef READBACK_H_HEADER_GUARD
+#define READBACK_H_HEADER_GUARD
+
+#include <bgfx/bgfx.h>
+
+#include <tinystl/allocator.h>
+#include <tinystl/vector.h>
+namespace stl = tinystl;
+
+/// Fence identifying readback request. Fences are signaled in order they were issued.
+struct ReadbackFence
+{
+	uint32_t id;
+};
+
+///
+inline bool isValid(ReadbackFence _fence)
+{
+	return 0 != _fence.id;
+}
+
+/// Called from `ReadbackQueue::update` when readback data is available. Data is only valid
+/// during callback.
+typedef void (*ReadbackFn)(void* _userData, ReadbackFence _fence, const void* _data, uint32_t _size);
+
+/// Asynchronous GPU readback on top of `bgfx::readTexture`. Instead of polling frame numbers,
+/// each request returns fence, and optional callback is invoked once data is available. All
+/// requests share single staging memory ring, which is released in order requests complete.
+///
+class ReadbackQueue
+{
+public:
+	///
+	ReadbackQueue(uint32_t _stagingSize = 4<<20);
+
+	///
+	~ReadbackQueue();
+
+	/// Set compute program used by `readBufferAsync`. Program must copy `vec4` buffer at stage 0
+	/// into `rgba32f` image at stage 1, see `examples/24-nbody/cs_readback_buffer.sc`.
+	void setCopyProgram(bgfx::ProgramHandle _program);
+
+	/// Read texture. Texture must be created with `BGFX_TEXTURE_READ_BACK` flag.
+	///
+	/// @param[in] _size Size of texture mip in bytes.
+	///
+	/// @returns Fence, invalid when staging memory is exhausted.
+	///
+	ReadbackFence readTextureAsync(
+		  bgfx::TextureHandle _handle
+		, uint32_t _size
+		, uint8_t _mip = 0
+		, ReadbackFn _fn = NULL
+		, void* _userData = NULL
+		);
+
+	/// Read compute buffer of `_num` vec4 elements. Buffer is copied into texture with compute
+	/// program in view `_computeViewId`, and blitted into readback texture in `_blitViewId`.
+	/// Blits are executed before other work in view, so blit view must come after compute view.
+	///
+	/// @returns Fence, invalid when staging memory or readback textures are exhausted, or when
+	///   compute is not supported.
+	///
+	ReadbackFence readBufferAsync(
+		  bgfx::ViewId _computeViewId
+		, bgfx::ViewId _blitViewId
+		, bgfx::DynamicVertexBufferHandle _handle
+		, uint32_t _num
+		, ReadbackFn _fn = NULL
+		, void* _userData = NULL
+		);
+
+	/// Signal completed fences, and invoke their callbacks. Must be called once per frame, with
+	/// frame number returned by `bgfx::frame`.
+	void update(uint32_t _frame);
+
+	/// Returns true if fence was signaled.
+	bool isDone(ReadbackFence _fence) const
+	{
+		return _fence.id <= m_lastDone;
+	}
+
+	///
+	uint32_t getNumPending() const
+	{
+		return uint32_t(m_pending.size() );
+	}
+
+private:
+	uint32_t alloc(uint32_t _size);
+
+	struct Request
+	{
+		uint32_t   m_id;
+		uint32_t   m_frame;
+		uint32_t   m_offset;
+		uint32_t   m_size;
+		ReadbackFn m_fn;
+		void*      m_userData;
+	};
+
+	enum { kBufferTextureWidth = 256, kBufferTextureHeight = 256, kNumBufferTextures = 4 };
+
+	struct BufferTexture
+	{
+		bgfx::TextureHandle m_readback;
+		uint32_t m_height; //!< Number of rows in readback texture.
+		uint32_t m_busy;   //!< Fence id of last request using this texture.
+	};
+
+	stl::vector<Request> m_pending;
+
+	uint8_t* m_staging;
+	uint32_t m_capacity;
+	uint32_t m_head;
+	uint32_t m_tail;
+
+	uint32_t m_nextId;
+	uint32_t m_lastDone;
+
+	bgfx::ProgramHandle m_copyProgram;
+	bgfx::UniformHandle u_readbackParams;
+	bgfx::TextureHandle m_computeTexture;
+	BufferTexture m_bufferTexture[kNumBufferTextures];
+};
+
+#endif // READBACK_H_HEADER_GUARD
@@ -664,7 +664,13 @@ namespace bgfx
 		uint32_t height;            //!< Backbuffer height.
 		uint32_t reset;	            //!< Reset parameters.
 		uint8_t  numBackBuffers;    //!< Number of back buffers.
-		uint8_t  maxFrameLatency;   //!< Maximum frame latency.
+		uint8_t  maxFrameLatency;   //!< Maximum frame latency. When not zero, render thread waits
+		                            //!  before submitting new frame while this many frames are
+		                            //!  still queued on GPU. This is not limited to DXGI swap
+		                            //!  chain, it applies to every renderer that tracks GPU
+		                            //!  progress with timer queries (Direct3D 9, 11, 12 and
+		                            //!  OpenGL). Direct3D 11 and 12 also pass it, clamped to 3,
+		                            //!  as DXGI maximum frame latency.
 	};
 
 	/// Initialization parameters used by `bgfx::init`.
@@ -962,6 +968,25 @@ namespace bgfx
 		int64_t cpuTimeEnd;   //!< Encoder thread CPU submit end time.
 	};
 
+	/// Frame timing history entry.
+	///
+	/// @attention C99 equivalent is `bgfx_frame_timing_t`.
+	///
+	/// @remarks Render thread and GPU times are zero until frame is rendered, and GPU result
+	///   for it is read back.
+	///
+	struct FrameTiming
+	{
+		uint32_t frameNum;           //!< Frame number, as returned by `bgfx::frame`.
+		uint32_t gpuLatency;         //!< Number of frames GPU was behind when frame was rendered.
+		int64_t  cpuTimeSubmitBegin; //!< API thread time when previous `bgfx::frame` returned.
+		int64_t  cpuTimeSubmitEnd;   //!< API thread time when `bgfx::frame` was called.
+		int64_t  cpuTimeRenderBegin; //!< Render thread CPU submit begin time.
+		int64_t  cpuTimeRenderEnd;   //!< Render thread CPU submit end time.
+		int64_t  gpuTimeBegin;       //!< GPU frame begin time.
+		int64_t  gpuTimeEnd;         //!< GPU frame end time.
+	};
+
 	/// Renderer statistics data.
 	///
 	/// @attention C99 equivalent is `bgfx_stats_t`.
@@ -987,6 +1012,8 @@ namespace bgfx
 		uint32_t numCompute;                //!< Number of compute calls submitted.
 		uint32_t numBlit;                   //!< Number of blit calls submitted.
 		uint32_t maxGpuLatency;             //!< GPU driver latency.
+		uint32_t gpuFrameLatency;           //!< Number of frames GPU was behind when last frame
+		                                    //!  was rendered.
 
 		uint16_t numDynamicIndexBuffers;    //!< Number of used dynamic index buffers.
 		uint16_t numDynamicVertexBuffers;   //!< Number of used dynamic vertex buffers.
@@ -1020,6 +1047,12 @@ namespace bgfx
 
 		uint8_t       numEncoders;          //!< Number of encoders used during frame.
 		EncoderStats* encoderStats;         //!< Array of encoder stats.
+
+		uint16_t     numFrameTimings;       //!< Number of frame timing entries.
+		FrameTiming* frameTimings;          //!< Frame timing history ring, entry for frame is at
+		                                    //!  index `frameNum % numFrameTimings`.
+		uint32_t     numFrames;             //!< Number of frames submitted so far. Changes once per
+		                                    //!  `bgfx::frame` call.
 	};
 
 	/// Encoders are used for submitting draw calls from multiple threads. Only one encoder
@@ -2052,6 +2085,16 @@ namespace bgfx
 	///
 	uint32_t frame(bool _capture = false);
 
+	/// Sleep API thread just long enough that following `bgfx::frame` call doesn't have to
+	/// wait for render thread. Call it right before sampling input, to reduce input latency.
+	/// Sleep time is predicted from frame timing history.
+	///
+	/// @returns Time slept in CPU timer ticks. Zero in single threaded mode.
+	///
+	/// @attention C99 equivalent is `bgfx_pace_frame`.
+	///
+	int64_t paceFrame();
+
 	/// Returns current renderer backend API type.
 	///
 	/// @remarks
@@ -2553,6 +2596,28 @@ namespace bgfx
 		, uint16_t _stride
 		);
 
+	/// Check for required space and allocate instance data buffer. If space
+	/// requirement is satisfied function returns true, otherwise `_idb` is
+	/// left untouched.
+	///
+	/// @param[out] _idb InstanceDataBuffer structure is filled and is valid
+	///   for duration of frame, and it can be reused for multiple draw
+	///   calls.
+	/// @param[in] _num Number of instances.
+	/// @param[in] _stride Instance stride. Must be multiple of 16.
+	///
+	/// @remarks
+	///   Check and allocation are done atomically, it's safe to call from
+	///   multiple threads.
+	///
+	/// @attention C99 equivalent is `bgfx_try_alloc_instance_data_buffer`.
+	///
+	bool tryAllocInstanceDataBuffer(
+		  InstanceDataBuffer* _idb
+		, uint32_t _num
+		, uint16_t _stride
+		);
+
 	/// Create draw indirect buffer.
 	///
 	/// @param[in] _num Number of indirect calls.
@@ -3261,6 +3326,17 @@ namespace bgfx
 		, int32_t* _result = NULL
 		);
 
+	/// Retrieve number of frames passed since occlusion query result was read back
+	/// from GPU.
+	///
+	/// @param[in] _handle Handle to occlusion query object.
+	/// @returns Number of frames since result was read back, or `UINT32_MAX` if
+	///   there is no result yet.
+	///
+	/// @attention C99 equivalent is `bgfx_get_result_age`.
+	///
+	uint32_t getResultAge(OcclusionQueryHandle _handle);
+
 	/// Destroy occlusion query.
 	///
 	/// @param[in] _handle Handle to occlusion query object.
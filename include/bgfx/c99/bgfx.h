@@ -617,7 +617,7 @@ typedef struct bgfx_resolution_s
     uint32_t             height;             /** Backbuffer height.                       */
     uint32_t             reset;              /** Reset parameters.                        */
     uint8_t              numBackBuffers;     /** Number of back buffers.                  */
-    uint8_t              maxFrameLatency;    /** Maximum frame latency.                   */
+    uint8_t              maxFrameLatency;    /** Maximum frame latency. When not zero, render thread waits before submitting new frame while this many frames are still queued on GPU. This is not limited to DXGI swap chain, it applies to every renderer that tracks GPU progress with timer queries (Direct3D 9, 11, 12 and OpenGL). Direct3D 11 and 12 also pass it, clamped to 3, as DXGI maximum frame latency. */
 
 } bgfx_resolution_t;
 
@@ -816,6 +816,25 @@ typedef struct bgfx_encoder_stats_s
 
 } bgfx_encoder_stats_t;
 
+/**
+ * Frame timing history entry.
+ * @remarks Render thread and GPU times are zero until frame is rendered, and
+ * GPU result for it is read back.
+ *
+ */
+typedef struct bgfx_frame_timing_s
+{
+    uint32_t             frameNum;           /** Frame number, as returned by `bgfx::frame`. */
+    uint32_t             gpuLatency;         /** Number of frames GPU was behind when frame was rendered. */
+    int64_t              cpuTimeSubmitBegin; /** API thread time when previous `bgfx::frame` returned. */
+    int64_t              cpuTimeSubmitEnd;   /** API thread time when `bgfx::frame` was called. */
+    int64_t              cpuTimeRenderBegin; /** Render thread CPU submit begin time.     */
+    int64_t              cpuTimeRenderEnd;   /** Render thread CPU submit end time.       */
+    int64_t              gpuTimeBegin;       /** GPU frame begin time.                    */
+    int64_t              gpuTimeEnd;         /** GPU frame end time.                      */
+
+} bgfx_frame_timing_t;
+
 /**
  * Renderer statistics data.
  * @remarks All time values are high-resolution timestamps, while
@@ -837,6 +856,7 @@ typedef struct bgfx_stats_s
     uint32_t             numCompute;         /** Number of compute calls submitted.       */
     uint32_t             numBlit;            /** Number of blit calls submitted.          */
     uint32_t             maxGpuLatency;      /** GPU driver latency.                      */
+    uint32_t             gpuFrameLatency;    /** Number of frames GPU was behind when last frame was rendered. */
     uint16_t             numDynamicIndexBuffers; /** Number of used dynamic index buffers.    */
     uint16_t             numDynamicVertexBuffers; /** Number of used dynamic vertex buffers.   */
     uint16_t             numFrameBuffers;    /** Number of used frame buffers.            */
@@ -863,6 +883,9 @@ typedef struct bgfx_stats_s
     bgfx_view_stats_t*   viewStats;          /** Array of View stats.                     */
     uint8_t              numEncoders;        /** Number of encoders used during frame.    */
     bgfx_encoder_stats_t* encoderStats;      /** Array of encoder stats.                  */
+    uint16_t             numFrameTimings;    /** Number of frame timing entries.          */
+    bgfx_frame_timing_t* frameTimings;       /** Frame timing history ring, entry for frame is at index `frameNum % numFrameTimings`. */
+    uint32_t             numFrames;          /** Number of frames submitted so far. Changes once per `bgfx::frame` call. */
 
 } bgfx_stats_t;
 
@@ -1128,6 +1151,16 @@ BGFX_C_API void bgfx_reset(uint32_t _width, uint32_t _height, uint32_t _flags, b
  */
 BGFX_C_API uint32_t bgfx_frame(bool _capture);
 
+/**
+ * Sleep API thread just long enough that following `bgfx::frame` call doesn't
+ * have to wait for render thread. Call it right before sampling input, to
+ * reduce input latency. Sleep time is predicted from frame timing history.
+ *
+ * @returns Time slept in CPU timer ticks. Zero in single threaded mode.
+ *
+ */
+BGFX_C_API int64_t bgfx_pace_frame(void);
+
 /**
  * Returns current renderer backend API type.
  * @remarks
@@ -1582,6 +1615,23 @@ BGFX_C_API bool bgfx_alloc_transient_buffers(bgfx_transient_vertex_buffer_t* _tv
  */
 BGFX_C_API void bgfx_alloc_instance_data_buffer(bgfx_instance_data_buffer_t* _idb, uint32_t _num, uint16_t _stride);
 
+/**
+ * Check for required space and allocate instance data buffer. If space
+ * requirement is satisfied function returns true, otherwise `_idb` is
+ * left untouched.
+ * @remarks
+ *   Check and allocation are done atomically, it's safe to call from
+ *   multiple threads.
+ *
+ * @param[out] _idb InstanceDataBuffer structure is filled and is valid
+ *  for duration of frame, and it can be reused for multiple draw
+ *  calls.
+ * @param[in] _num Number of instances.
+ * @param[in] _stride Instance stride. Must be multiple of 16.
+ *
+ */
+BGFX_C_API bool bgfx_try_alloc_instance_data_buffer(bgfx_instance_data_buffer_t* _idb, uint32_t _num, uint16_t _stride);
+
 /**
  * Create draw indirect buffer.
  *
@@ -2112,6 +2162,18 @@ BGFX_C_API bgfx_occlusion_query_handle_t bgfx_create_occlusion_query(void);
  */
 BGFX_C_API bgfx_occlusion_query_result_t bgfx_get_result(bgfx_occlusion_query_handle_t _handle, int32_t* _result);
 
+/**
+ * Retrieve number of frames passed since occlusion query result was read back
+ * from GPU.
+ *
+ * @param[in] _handle Handle to occlusion query object.
+ *
+ * @returns Number of frames since result was read back, or
+ *  `UINT32_MAX` if there is no result yet.
+ *
+ */
+BGFX_C_API uint32_t bgfx_get_result_age(bgfx_occlusion_query_handle_t _handle);
+
 /**
  * Destroy occlusion query.
  *
@@ -3449,6 +3511,7 @@ struct bgfx_interface_vtbl
     void (*shutdown)(void);
     void (*reset)(uint32_t _width, uint32_t _height, uint32_t _flags, bgfx_texture_format_t _format);
     uint32_t (*frame)(bool _capture);
+    int64_t (*pace_frame)(void);
     bgfx_renderer_type_t (*get_renderer_type)(void);
     const bgfx_caps_t* (*get_caps)(void);
     const bgfx_stats_t* (*get_stats)(void);
@@ -3484,6 +3547,7 @@ struct bgfx_interface_vtbl
     void (*alloc_transient_vertex_buffer)(bgfx_transient_vertex_buffer_t* _tvb, uint32_t _num, const bgfx_vertex_layout_t * _layout);
     bool (*alloc_transient_buffers)(bgfx_transient_vertex_buffer_t* _tvb, const bgfx_vertex_layout_t * _layout, uint32_t _numVertices, bgfx_transient_index_buffer_t* _tib, uint32_t _numIndices);
     void (*alloc_instance_data_buffer)(bgfx_instance_data_buffer_t* _idb, uint32_t _num, uint16_t _stride);
+    bool (*try_alloc_instance_data_buffer)(bgfx_instance_data_buffer_t* _idb, uint32_t _num, uint16_t _stride);
     bgfx_indirect_buffer_handle_t (*create_indirect_buffer)(uint32_t _num);
     void (*destroy_indirect_buffer)(bgfx_indirect_buffer_handle_t _handle);
     bgfx_shader_handle_t (*create_shader)(const bgfx_memory_t* _mem);
@@ -3520,6 +3584,7 @@ struct bgfx_interface_vtbl
     void (*destroy_uniform)(bgfx_uniform_handle_t _handle);
     bgfx_occlusion_query_handle_t (*create_occlusion_query)(void);
     bgfx_occlusion_query_result_t (*get_result)(bgfx_occlusion_query_handle_t _handle, int32_t* _result);
+    uint32_t (*get_result_age)(bgfx_occlusion_query_handle_t _handle);
     void (*destroy_occlusion_query)(bgfx_occlusion_query_handle_t _handle);
     void (*set_palette_color)(uint8_t _index, const float _rgba[4]);
     void (*set_palette_color_rgba8)(uint8_t _index, uint32_t _rgba);
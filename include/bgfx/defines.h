@@ -15,7 +15,7 @@
 #ifndef BGFX_DEFINES_H_HEADER_GUARD
 #define BGFX_DEFINES_H_HEADER_GUARD
 
-#define BGFX_API_VERSION UINT32_C(102)
+#define BGFX_API_VERSION UINT32_C(106)
 
 /**
  * Color RGB/alpha/depth write. When it's not specified write will be disabled.
@@ -43,6 +43,11 @@ newoption {
 	description = "Enable building tools.",
 }
 
+newoption {
+	trigger = "with-tests",
+	description = "Enable building tests.",
+}
+
 newoption {
 	trigger = "with-combined-examples",
 	description = "Enable building examples (combined as single executable).",
@@ -445,6 +450,18 @@ function exampleProjectDefaults()
 	strip()
 end
 
+-- Libraries only some examples need. Listed before exampleProjectDefaults so that they
+-- precede the libraries they depend on on the link line.
+function exampleProjectLinks(_name)
+
+	if _name == "40-svt" then
+		links {
+			"bimg_encode",
+		}
+	end
+
+end
+
 function exampleProject(_combined, ...)
 
 	if _combined then
@@ -471,6 +488,10 @@ function exampleProject(_combined, ...)
 			path.join(BGFX_DIR, "examples/25-c99/helloworld.c"), -- hack for _main_
 		}
 
+		for _, name in ipairs({...}) do
+			exampleProjectLinks(name)
+		end
+
 		exampleProjectDefaults()
 
 	else
@@ -494,6 +515,7 @@ function exampleProject(_combined, ...)
 				"ENTRY_CONFIG_IMPLEMENT_MAIN=1",
 			}
 
+			exampleProjectLinks(name)
 			exampleProjectDefaults()
 		end
 	end
@@ -509,7 +531,9 @@ dofile(path.join(BX_DIR,   "scripts/bx.lua"))
 dofile(path.join(BIMG_DIR, "scripts/bimg.lua"))
 dofile(path.join(BIMG_DIR, "scripts/bimg_decode.lua"))
 
-if _OPTIONS["with-tools"] then
+if _OPTIONS["with-tools"]
+or _OPTIONS["with-examples"]
+or _OPTIONS["with-combined-examples"] then
 	dofile(path.join(BIMG_DIR, "scripts/bimg_encode.lua"))
 end
 
@@ -729,3 +753,8 @@ if _OPTIONS["with-tools"] then
 	dofile "geometryc.lua"
 	dofile "geometryv.lua"
 end
+
+if _OPTIONS["with-tests"] then
+	group "tests"
+	dofile "tests.lua"
+end
@@ -23,6 +23,7 @@ all:
 	@echo "  TARGET=5 (metal)"
 	@echo "  TARGET=6 (pssl)"
 	@echo "  TARGET=7 (spirv)"
+	@echo Usage: make archive
 
 .PHONY: rebuild
 rebuild:
@@ -34,6 +35,17 @@ rebuild:
 #	@make -s --no-print-directory TARGET=5 clean all
 	@make -s --no-print-directory TARGET=7 clean all
 
+# Packs already compiled shaders of this example, for every renderer profile found in
+# $(RUNTIME_DIR)/shaders/, into single shader archive $(RUNTIME_DIR)/<example>.sar.
+ARCHIVE_NAME=$(notdir $(abspath $(CURDIR)))
+ARCHIVE_SOURCES=$(basename $(notdir $(wildcard $(addprefix $(SHADERS_DIR), vs_*.sc fs_*.sc cs_*.sc))))
+
+.PHONY: archive
+archive:
+	@echo [$(ARCHIVE_NAME).sar]
+	$(SILENT) cd $(RUNTIME_DIR) && ls $(foreach name, $(ARCHIVE_SOURCES), shaders/*/$(name).bin) 2>/dev/null > $(ARCHIVE_NAME).sar.txt; true
+	$(SILENT) $(SHADERC) --archive -f $(RUNTIME_DIR)/$(ARCHIVE_NAME).sar.txt -o $(RUNTIME_DIR)/$(ARCHIVE_NAME).sar
+
 else
 
 ADDITIONAL_INCLUDES?=
@@ -0,0 +1,44 @@
+--
+-- Copyright 2010-2019 Branimir Karadzic. All rights reserved.
+-- License: https://github.com/bkaradzic/bgfx#license-bsd-2-clause
+--
+
+project "test-cpu-occlusion"
+	uuid (os.uuid("test-cpu-occlusion"))
+	kind "ConsoleApp"
+
+	includedirs {
+		path.join(BX_DIR, "include"),
+		path.join(BGFX_DIR, "3rdparty"),
+		path.join(BGFX_DIR, "examples/common"),
+	}
+
+	files {
+		path.join(BGFX_DIR, "tests/cpu_occlusion_test.cpp"),
+		path.join(BGFX_DIR, "examples/common/bounds.**"),
+		path.join(BGFX_DIR, "examples/common/cpu_occlusion.**"),
+	}
+
+	links {
+		"bx",
+	}
+
+	configuration { "mingw-*" }
+		targetextension ".exe"
+		links {
+			"psapi",
+		}
+
+	configuration { "osx" }
+		links {
+			"Cocoa.framework",
+		}
+
+	configuration { "vs20*" }
+		links {
+			"psapi",
+		}
+
+	configuration {}
+
+	strip()
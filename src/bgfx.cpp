@@ -1799,6 +1799,8 @@ namespace bgfx
 		m_frames  = 0;
 		m_debug   = BGFX_DEBUG_NONE;
 		m_frameTimeLast = bx::getHPCounter();
+		m_frameTimeSubmit = m_frameTimeLast;
+		bx::memSet(m_frameTiming, 0, sizeof(m_frameTiming) );
 
 		m_submit->create();
 
@@ -2181,6 +2183,8 @@ namespace bgfx
 
 	uint32_t Context::frame(bool _capture)
 	{
+		m_frameTimeSubmit = bx::getHPCounter();
+
 		m_encoder[0].end(true);
 
 #if BGFX_CONFIG_MULTITHREADED
@@ -2212,6 +2216,99 @@ namespace bgfx
 		apiSemPost();
 	}
 
+	int64_t Context::paceFrame()
+	{
+		if (!BX_ENABLED(BGFX_CONFIG_MULTITHREADED)
+		||  m_singleThreaded
+		||  0 == m_paceRender)
+		{
+			return 0;
+		}
+
+		// Render thread starts frame in flight once it's released by API thread, and it's done
+		// flipping previous frame. Next `bgfx::frame` call should arrive right when it's done.
+		const int64_t freq        = bx::getHPFrequency();
+		const int64_t renderBegin = bx::max(m_frameTimeLast, m_paceRenderEnd + m_paceFlip);
+		const int64_t renderEnd   = renderBegin + m_paceRender;
+		const int64_t margin      = m_paceSubmit/8 + freq/1000;
+
+		const int64_t start = bx::getHPCounter();
+		const int64_t wake  = bx::min(renderEnd - m_paceSubmit - margin, start + m_paceFlip + m_paceRender);
+
+		for (int64_t now = start; now < wake; now = bx::getHPCounter() )
+		{
+			const int64_t ms = (wake - now)*1000/freq;
+			if (1 < ms)
+			{
+				bx::sleep(uint32_t(ms-1) );
+			}
+			else
+			{
+				bx::yield();
+			}
+		}
+
+		const int64_t slept = bx::getHPCounter() - start;
+		m_paceSleep += slept;
+
+		return slept;
+	}
+
+	void Context::updateFrameTiming()
+	{
+		FrameTiming& submit = m_frameTiming[m_frames % BGFX_CONFIG_MAX_FRAME_TIMINGS];
+		bx::memSet(&submit, 0, sizeof(submit) );
+		submit.frameNum           = m_frames;
+		submit.cpuTimeSubmitBegin = m_frameTimeLast;
+		submit.cpuTimeSubmitEnd   = m_frameTimeSubmit;
+
+		const int64_t submitTime = m_frameTimeSubmit - m_frameTimeLast - m_paceSleep;
+		m_paceSubmit += (submitTime - m_paceSubmit)/8;
+		m_paceSleep   = 0;
+
+		// At this point render thread is done with m_render, and its stats are complete.
+		const Stats& stats = m_render->m_perfStats;
+		const uint32_t frameNum = m_render->m_frameNum;
+
+		if (frameNum >= m_frames
+		||  0 == stats.cpuTimeEnd)
+		{
+			return;
+		}
+
+		FrameTiming& rendered = m_frameTiming[frameNum % BGFX_CONFIG_MAX_FRAME_TIMINGS];
+		if (frameNum == rendered.frameNum)
+		{
+			rendered.gpuLatency         = stats.gpuFrameLatency;
+			rendered.cpuTimeRenderBegin = stats.cpuTimeBegin;
+			rendered.cpuTimeRenderEnd   = stats.cpuTimeEnd;
+		}
+
+		// GPU timer results are read back with latency, they belong to older frame.
+		if (stats.gpuFrameLatency <= frameNum
+		&&  stats.gpuTimeEnd > stats.gpuTimeBegin)
+		{
+			const uint32_t gpuFrameNum = frameNum - stats.gpuFrameLatency;
+			FrameTiming& gpu = m_frameTiming[gpuFrameNum % BGFX_CONFIG_MAX_FRAME_TIMINGS];
+			if (gpuFrameNum == gpu.frameNum)
+			{
+				gpu.gpuTimeBegin = stats.gpuTimeBegin;
+				gpu.gpuTimeEnd   = stats.gpuTimeEnd;
+			}
+		}
+
+		if (0 != m_paceRenderEnd)
+		{
+			// Time between frames on render thread, excluding time spent waiting for API thread,
+			// is mostly flip (and V-Sync) time.
+			const int64_t flipTime = bx::max<int64_t>(stats.cpuTimeBegin - m_paceRenderEnd - m_render->m_waitSubmit, 0);
+			m_paceFlip += (flipTime - m_paceFlip)/8;
+		}
+
+		m_paceRender   += (stats.cpuTimeEnd - stats.cpuTimeBegin - m_paceRender)/8;
+		m_paceRenderEnd = stats.cpuTimeEnd;
+	}
+
 	void Context::swap()
 	{
 		freeDynamicBuffers();
@@ -2232,11 +2329,22 @@ namespace bgfx
 		freeAllHandles(m_submit);
 		m_submit->resetFreeHandles();
 
+		updateFrameTiming();
+
+		m_submit->m_frameNum = m_frames;
 		m_submit->finish();
 
 		bx::swap(m_render, m_submit);
 
-		bx::memCopy(m_render->m_occlusion, m_submit->m_occlusion, sizeof(m_submit->m_occlusion) );
+		// Only occlusion query entries changed since last swap are copied between frames. After swap
+		// m_render holds entries written on API thread, and m_submit results written by renderer.
+		// Renderer results are merged first, skipping entries API thread changed, then API entries
+		// are applied to both frames, so that results for reused handles are dropped and both frames
+		// end up with same values.
+		m_render->copyOcclusion(*m_submit, true);
+		m_submit->copyOcclusion(*m_render, false);
+		m_submit->resetOcclusionDirty();
+		m_render->resetOcclusionDirty();
 
 		if (!BX_ENABLED(BGFX_CONFIG_MULTITHREADED)
 		||  m_singleThreaded)
@@ -3893,6 +4001,12 @@ namespace bgfx
 		return s_ctx->frame(_capture);
 	}
 
+	int64_t paceFrame()
+	{
+		BGFX_CHECK_API_THREAD();
+		return s_ctx->paceFrame();
+	}
+
 	const Caps* getCaps()
 	{
 		return &g_caps;
@@ -4164,6 +4278,19 @@ namespace bgfx
 			);
 	}
 
+	bool tryAllocInstanceDataBuffer(InstanceDataBuffer* _idb, uint32_t _num, uint16_t _stride)
+	{
+		BGFX_MUTEX_SCOPE(s_ctx->m_resourceApiLock);
+
+		if (_num == getAvailInstanceDataBuffer(_num, _stride) )
+		{
+			allocInstanceDataBuffer(_idb, _num, _stride);
+			return true;
+		}
+
+		return false;
+	}
+
 	IndirectBufferHandle createIndirectBuffer(uint32_t _num)
 	{
 		return s_ctx->createIndirectBuffer(_num);
@@ -4723,6 +4850,12 @@ namespace bgfx
 		return s_ctx->getResult(_handle, _result);
 	}
 
+	uint32_t getResultAge(OcclusionQueryHandle _handle)
+	{
+		BGFX_CHECK_CAPS(BGFX_CAPS_OCCLUSION_QUERY, "Occlusion query is not supported!");
+		return s_ctx->getResultAge(_handle);
+	}
+
 	void destroy(OcclusionQueryHandle _handle)
 	{
 		BGFX_CHECK_CAPS(BGFX_CAPS_OCCLUSION_QUERY, "Occlusion query is not supported!");
@@ -159,6 +159,11 @@ BGFX_C_API uint32_t bgfx_frame(bool _capture)
 	return bgfx::frame(_capture);
 }
 
+BGFX_C_API int64_t bgfx_pace_frame(void)
+{
+	return bgfx::paceFrame();
+}
+
 BGFX_C_API bgfx_renderer_type_t bgfx_get_renderer_type(void)
 {
 	return (bgfx_renderer_type_t)bgfx::getRendererType();
@@ -367,6 +372,11 @@ BGFX_C_API void bgfx_alloc_instance_data_buffer(bgfx_instance_data_buffer_t* _id
 	bgfx::allocInstanceDataBuffer((bgfx::InstanceDataBuffer*)_idb, _num, _stride);
 }
 
+BGFX_C_API bool bgfx_try_alloc_instance_data_buffer(bgfx_instance_data_buffer_t* _idb, uint32_t _num, uint16_t _stride)
+{
+	return bgfx::tryAllocInstanceDataBuffer((bgfx::InstanceDataBuffer*)_idb, _num, _stride);
+}
+
 BGFX_C_API bgfx_indirect_buffer_handle_t bgfx_create_indirect_buffer(uint32_t _num)
 {
 	union { bgfx_indirect_buffer_handle_t c; bgfx::IndirectBufferHandle cpp; } handle_ret;
@@ -604,6 +614,12 @@ BGFX_C_API bgfx_occlusion_query_result_t bgfx_get_result(bgfx_occlusion_query_ha
 	return (bgfx_occlusion_query_result_t)bgfx::getResult(handle.cpp, _result);
 }
 
+BGFX_C_API uint32_t bgfx_get_result_age(bgfx_occlusion_query_handle_t _handle)
+{
+	union { bgfx_occlusion_query_handle_t c; bgfx::OcclusionQueryHandle cpp; } handle = { _handle };
+	return bgfx::getResultAge(handle.cpp);
+}
+
 BGFX_C_API void bgfx_destroy_occlusion_query(bgfx_occlusion_query_handle_t _handle)
 {
 	union { bgfx_occlusion_query_handle_t c; bgfx::OcclusionQueryHandle cpp; } handle = { _handle };
@@ -1226,6 +1242,7 @@ BGFX_C_API bgfx_interface_vtbl_t* bgfx_get_interface(uint32_t _version)
 			bgfx_shutdown,
 			bgfx_reset,
 			bgfx_frame,
+			bgfx_pace_frame,
 			bgfx_get_renderer_type,
 			bgfx_get_caps,
 			bgfx_get_stats,
@@ -1261,6 +1278,7 @@ BGFX_C_API bgfx_interface_vtbl_t* bgfx_get_interface(uint32_t _version)
 			bgfx_alloc_transient_vertex_buffer,
 			bgfx_alloc_transient_buffers,
 			bgfx_alloc_instance_data_buffer,
+			bgfx_try_alloc_instance_data_buffer,
 			bgfx_create_indirect_buffer,
 			bgfx_destroy_indirect_buffer,
 			bgfx_create_shader,
@@ -1297,6 +1315,7 @@ BGFX_C_API bgfx_interface_vtbl_t* bgfx_get_interface(uint32_t _version)
 			bgfx_destroy_uniform,
 			bgfx_create_occlusion_query,
 			bgfx_get_result,
+			bgfx_get_result_age,
 			bgfx_destroy_occlusion_query,
 			bgfx_set_palette_color,
 			bgfx_set_palette_color_rgba8,
@@ -1928,6 +1928,10 @@ constexpr uint64_t kSortKeyComputeProgramMask  = uint64_t(BGFX_CONFIG_MAX_PROGRA
 			m_sortKeys[BGFX_CONFIG_MAX_DRAW_CALLS]   = term.encodeDraw(SortKey::SortProgram);
 			m_sortValues[BGFX_CONFIG_MAX_DRAW_CALLS] = BGFX_CONFIG_MAX_DRAW_CALLS;
 			bx::memSet(m_occlusion, 0xff, sizeof(m_occlusion) );
+			bx::memSet(m_occlusionFrame, 0xff, sizeof(m_occlusionFrame) );
+			bx::memSet(m_occlusionDirtyMask, 0, sizeof(m_occlusionDirtyMask) );
+			m_numOcclusionDirty = 0;
+			m_frameNum = 0;
 
 			m_perfStats.viewStats = m_viewStats;
 		}
@@ -2115,7 +2119,59 @@ constexpr uint64_t kSortKeyComputeProgramMask  = uint64_t(BGFX_CONFIG_MAX_PROGRA
 
 		View m_view[BGFX_CONFIG_MAX_VIEWS];
 
-		int32_t m_occlusion[BGFX_CONFIG_MAX_OCCLUSION_QUERIES];
+		void setOcclusion(uint16_t _idx, int32_t _result, uint32_t _frame)
+		{
+			m_occlusion[_idx]      = _result;
+			m_occlusionFrame[_idx] = _frame;
+
+			if (!isOcclusionDirty(_idx) )
+			{
+				m_occlusionDirtyMask[_idx>>5] |= UINT32_C(1)<<(_idx&31);
+				m_occlusionDirty[m_numOcclusionDirty++] = _idx;
+			}
+		}
+
+		void setOcclusionResult(OcclusionQueryHandle _handle, int32_t _result)
+		{
+			setOcclusion(_handle.idx, _result, m_frameNum);
+		}
+
+		bool isOcclusionDirty(uint16_t _idx) const
+		{
+			return 0 != (m_occlusionDirtyMask[_idx>>5] & (UINT32_C(1)<<(_idx&31) ) );
+		}
+
+		void copyOcclusion(const Frame& _from, bool _keepDirty)
+		{
+			for (uint32_t ii = 0, num = _from.m_numOcclusionDirty; ii < num; ++ii)
+			{
+				const uint16_t idx = _from.m_occlusionDirty[ii];
+				if (!_keepDirty
+				||  !isOcclusionDirty(idx) )
+				{
+					m_occlusion[idx]      = _from.m_occlusion[idx];
+					m_occlusionFrame[idx] = _from.m_occlusionFrame[idx];
+				}
+			}
+		}
+
+		void resetOcclusionDirty()
+		{
+			for (uint32_t ii = 0, num = m_numOcclusionDirty; ii < num; ++ii)
+			{
+				const uint16_t idx = m_occlusionDirty[ii];
+				m_occlusionDirtyMask[idx>>5] = 0;
+			}
+
+			m_numOcclusionDirty = 0;
+		}
+
+		int32_t  m_occlusion[BGFX_CONFIG_MAX_OCCLUSION_QUERIES];
+		uint32_t m_occlusionFrame[BGFX_CONFIG_MAX_OCCLUSION_QUERIES];
+		uint16_t m_occlusionDirty[BGFX_CONFIG_MAX_OCCLUSION_QUERIES];
+		uint32_t m_occlusionDirtyMask[(BGFX_CONFIG_MAX_OCCLUSION_QUERIES+31)/32];
+		uint32_t m_numOcclusionDirty;
+		uint32_t m_frameNum;
 
 		uint64_t m_sortKeys[BGFX_CONFIG_MAX_DRAW_CALLS+1];
 		RenderItemCount m_sortValues[BGFX_CONFIG_MAX_DRAW_CALLS+1];
@@ -3008,6 +3064,9 @@ constexpr uint64_t kSortKeyComputeProgramMask  = uint64_t(BGFX_CONFIG_MAX_PROGRA
 			stats.textWidth  = tvm->m_width;
 			stats.textHeight = tvm->m_height;
 			stats.encoderStats = m_encoderStats;
+			stats.numFrameTimings = BGFX_CONFIG_MAX_FRAME_TIMINGS;
+			stats.frameTimings    = m_frameTiming;
+			stats.numFrames       = m_frames;
 
 			stats.numDynamicIndexBuffers  = m_dynamicIndexBufferHandle.getNumHandles();
 			stats.numDynamicVertexBuffers = m_dynamicVertexBufferHandle.getNumHandles();
@@ -4757,7 +4816,7 @@ constexpr uint64_t kSortKeyComputeProgramMask  = uint64_t(BGFX_CONFIG_MAX_PROGRA
 			OcclusionQueryHandle handle = { m_occlusionQueryHandle.alloc() };
 			if (isValid(handle) )
 			{
-				m_submit->m_occlusion[handle.idx] = INT32_MIN;
+				m_submit->setOcclusion(handle.idx, INT32_MIN, UINT32_MAX);
 
 				CommandBuffer& cmdbuf = getCommandBuffer(CommandBuffer::InvalidateOcclusionQuery);
 				cmdbuf.write(handle);
@@ -4787,6 +4846,21 @@ constexpr uint64_t kSortKeyComputeProgramMask  = uint64_t(BGFX_CONFIG_MAX_PROGRA
 			return OcclusionQueryResult::Visible;
 		}
 
+		BGFX_API_FUNC(uint32_t getResultAge(OcclusionQueryHandle _handle) )
+		{
+			BGFX_MUTEX_SCOPE(m_resourceApiLock);
+
+			BGFX_CHECK_HANDLE("getResultAge", m_occlusionQueryHandle, _handle);
+
+			const uint32_t frame = m_submit->m_occlusionFrame[_handle.idx];
+			if (UINT32_MAX == frame)
+			{
+				return UINT32_MAX;
+			}
+
+			return m_frames - frame;
+		}
+
 		BGFX_API_FUNC(void destroyOcclusionQuery(OcclusionQueryHandle _handle) )
 		{
 			BGFX_MUTEX_SCOPE(m_resourceApiLock);
@@ -4938,6 +5012,8 @@ constexpr uint64_t kSortKeyComputeProgramMask  = uint64_t(BGFX_CONFIG_MAX_PROGRA
 
 		BGFX_API_FUNC(uint32_t frame(bool _capture = false) );
 
+		BGFX_API_FUNC(int64_t paceFrame() );
+
 		uint32_t getSeqIncr(ViewId _id)
 		{
 			return bx::atomicFetchAndAdd<uint32_t>(&m_seq[_id], 1);
@@ -4947,6 +5023,7 @@ constexpr uint64_t kSortKeyComputeProgramMask  = uint64_t(BGFX_CONFIG_MAX_PROGRA
 		void freeDynamicBuffers();
 		void freeAllHandles(Frame* _frame);
 		void frameNoRenderWait();
+		void updateFrameTiming();
 		void swap();
 
 		// render thread
@@ -5129,6 +5206,15 @@ constexpr uint64_t kSortKeyComputeProgramMask  = uint64_t(BGFX_CONFIG_MAX_PROGRA
 
 		Init     m_init;
 		int64_t  m_frameTimeLast;
+		int64_t  m_frameTimeSubmit = 0;
+		FrameTiming m_frameTiming[BGFX_CONFIG_MAX_FRAME_TIMINGS];
+
+		// Frame pacing estimates, smoothed over last few frames.
+		int64_t  m_paceRenderEnd = 0;
+		int64_t  m_paceFlip      = 0;
+		int64_t  m_paceRender    = 0;
+		int64_t  m_paceSubmit    = 0;
+		int64_t  m_paceSleep     = 0;
 		uint32_t m_frames = 0;
 		uint32_t m_debug = BGFX_DEBUG_NONE;
 
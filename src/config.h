@@ -301,9 +301,13 @@ BX_STATIC_ASSERT(bx::isPowerOf2(BGFX_CONFIG_MAX_VIEWS), "BGFX_CONFIG_MAX_VIEWS m
 #endif // BGFX_CONFIG_MAX_UNIFORMS
 
 #ifndef BGFX_CONFIG_MAX_OCCLUSION_QUERIES
-#	define BGFX_CONFIG_MAX_OCCLUSION_QUERIES 256
+#	define BGFX_CONFIG_MAX_OCCLUSION_QUERIES 4096
 #endif // BGFX_CONFIG_MAX_OCCLUSION_QUERIES
 
+#ifndef BGFX_CONFIG_MAX_FRAME_TIMINGS
+#	define BGFX_CONFIG_MAX_FRAME_TIMINGS 64
+#endif // BGFX_CONFIG_MAX_FRAME_TIMINGS
+
 #ifndef BGFX_CONFIG_MAX_COMMAND_BUFFER_SIZE
 #	define BGFX_CONFIG_MAX_COMMAND_BUFFER_SIZE (64<<10)
 #endif // BGFX_CONFIG_MAX_COMMAND_BUFFER_SIZE
@@ -490,6 +490,28 @@ namespace bgfx
 		return false;
 	}
 
+	/// Wait while `_maxLatency` or more frames are still queued on GPU. Progress is tracked with
+	/// frame timer query, when timer queries are not supported there is nothing to wait for.
+	template<typename Ty>
+	inline void waitGpuFrameLatency(Ty& _gpuTimer, uint32_t _maxLatency)
+	{
+		if (0 == _maxLatency)
+		{
+			return;
+		}
+
+		BGFX_PROFILER_SCOPE("bgfx/GPU frame latency wait", 0xff2040ff);
+
+		const typename Ty::Result& result = _gpuTimer.m_result[BGFX_CONFIG_MAX_VIEWS];
+		while (result.m_pending >= _maxLatency)
+		{
+			if (!_gpuTimer.update() )
+			{
+				bx::yield();
+			}
+		}
+	}
+
 	template<typename Ty>
 	struct Profiler
 	{
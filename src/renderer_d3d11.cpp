@@ -5213,7 +5213,7 @@ namespace bgfx { namespace d3d11
 					break;
 				}
 
-				_render->m_occlusion[query.m_handle.idx] = int32_t(result);
+				_render->setOcclusionResult(query.m_handle, int32_t(result) );
 			}
 
 			m_control.consume(1);
@@ -5324,6 +5324,8 @@ namespace bgfx { namespace d3d11
 
 		ID3D11DeviceContext* deviceCtx = m_deviceCtx;
 
+		waitGpuFrameLatency(m_gpuTimer, _render->m_resolution.maxFrameLatency);
+
 		int64_t timeBegin = bx::getHPCounter();
 		int64_t captureElapsed = 0;
 
@@ -6326,6 +6328,7 @@ namespace bgfx { namespace d3d11
 		perfStats.numCompute    = statsKeyType[1];
 		perfStats.numBlit       = _render->m_numBlitItems;
 		perfStats.maxGpuLatency = maxGpuLatency;
+		perfStats.gpuFrameLatency = m_gpuTimer.m_result[BGFX_CONFIG_MAX_VIEWS].m_pending;
 		bx::memCopy(perfStats.numPrims, statsNumPrimsRendered, sizeof(perfStats.numPrims) );
 		m_nvapi.getMemoryInfo(perfStats.gpuMemoryUsed, perfStats.gpuMemoryMax);
 
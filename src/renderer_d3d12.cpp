@@ -5496,9 +5496,16 @@ namespace bgfx { namespace d3d12
 				return false;
 			}
 
-			if (query.m_fence > s_renderD3D12->m_cmd.m_completedFence)
+			CommandQueueD3D12& cmd = s_renderD3D12->m_cmd;
+			if (query.m_fence > cmd.m_completedFence)
 			{
-				return false;
+				// Completed fence is otherwise only refreshed when command list is consumed, and
+				// frame latency wait polls this until query completes.
+				cmd.m_completedFence = cmd.m_fence->GetCompletedValue();
+				if (query.m_fence > cmd.m_completedFence)
+				{
+					return false;
+				}
 			}
 
 			m_control.consume(1);
@@ -5553,7 +5560,7 @@ namespace bgfx { namespace d3d12
 			OcclusionQueryHandle handle = m_handle[m_control.m_read];
 			if (isValid(handle) )
 			{
-				_render->m_occlusion[handle.idx] = int32_t(m_result[handle.idx]);
+				_render->setOcclusionResult(handle, int32_t(m_result[handle.idx]) );
 			}
 			m_control.consume(1);
 		}
@@ -5717,6 +5724,8 @@ namespace bgfx { namespace d3d12
 
 		BGFX_D3D12_PROFILER_BEGIN_LITERAL("rendererSubmit", kColorFrame);
 
+		waitGpuFrameLatency(m_gpuTimer, _render->m_resolution.maxFrameLatency);
+
 		int64_t timeBegin = bx::getHPCounter();
 		int64_t captureElapsed = 0;
 
@@ -6620,6 +6629,7 @@ namespace bgfx { namespace d3d12
 		perfStats.numCompute    = statsKeyType[1];
 		perfStats.numBlit       = _render->m_numBlitItems;
 		perfStats.maxGpuLatency = maxGpuLatency;
+		perfStats.gpuFrameLatency = m_gpuTimer.m_result[BGFX_CONFIG_MAX_VIEWS].m_pending;
 		bx::memCopy(perfStats.numPrims, statsNumPrimsRendered, sizeof(perfStats.numPrims) );
 		perfStats.gpuMemoryMax  = -INT64_MAX;
 		perfStats.gpuMemoryUsed = -INT64_MAX;
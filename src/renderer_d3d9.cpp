@@ -3627,7 +3627,7 @@ namespace bgfx { namespace d3d9
 					break;
 				}
 
-				_render->m_occlusion[query.m_handle.idx] = int32_t(result);
+				_render->setOcclusionResult(query.m_handle, int32_t(result) );
 			}
 
 			m_control.consume(1);
@@ -3710,6 +3710,8 @@ namespace bgfx { namespace d3d9
 
 		BGFX_D3D9_PROFILER_BEGIN_LITERAL("rendererSubmit", kColorView);
 
+		waitGpuFrameLatency(m_gpuTimer, _render->m_resolution.maxFrameLatency);
+
 		int64_t timeBegin = bx::getHPCounter();
 		int64_t captureElapsed = 0;
 
@@ -4450,6 +4452,7 @@ namespace bgfx { namespace d3d9
 		perfStats.numCompute    = statsKeyType[1];
 		perfStats.numBlit       = _render->m_numBlitItems;
 		perfStats.maxGpuLatency = maxGpuLatency;
+		perfStats.gpuFrameLatency = m_gpuTimer.m_result[BGFX_CONFIG_MAX_VIEWS].m_pending;
 		bx::memCopy(perfStats.numPrims, statsNumPrimsRendered, sizeof(perfStats.numPrims) );
 		m_nvapi.getMemoryInfo(perfStats.gpuMemoryUsed, perfStats.gpuMemoryMax);
 
@@ -6420,7 +6420,7 @@ BX_TRACE("%d, %d, %d, %s", _array, _srgb, _mipAutogen, getName(_format) );
 				}
 
 				GL_CHECK(glGetQueryObjectiv(query.m_id, GL_QUERY_RESULT, &result) );
-				_render->m_occlusion[query.m_handle.idx] = int32_t(result);
+				_render->setOcclusionResult(query.m_handle, int32_t(result) );
 			}
 
 			m_control.consume(1);
@@ -6513,6 +6513,8 @@ BX_TRACE("%d, %d, %d, %s", _array, _srgb, _mipAutogen, getName(_format) );
 
 		updateResolution(_render->m_resolution);
 
+		waitGpuFrameLatency(m_gpuTimer, _render->m_resolution.maxFrameLatency);
+
 		int64_t timeBegin = bx::getHPCounter();
 		int64_t captureElapsed = 0;
 
@@ -7719,6 +7721,7 @@ BX_TRACE("%d, %d, %d, %s", _array, _srgb, _mipAutogen, getName(_format) );
 		perfStats.numCompute    = statsKeyType[1];
 		perfStats.numBlit       = _render->m_numBlitItems;
 		perfStats.maxGpuLatency = maxGpuLatency;
+		perfStats.gpuFrameLatency = m_gpuTimer.m_result[BGFX_CONFIG_MAX_VIEWS].m_pending;
 		bx::memCopy(perfStats.numPrims, statsNumPrimsRendered, sizeof(perfStats.numPrims) );
 		perfStats.gpuMemoryMax  = -INT64_MAX;
 		perfStats.gpuMemoryUsed = -INT64_MAX;
@@ -3500,7 +3500,7 @@ namespace bgfx { namespace mtl
 			if (isValid(query.m_handle) )
 			{
 				uint64_t result = ( (uint64_t*)m_buffer.contents() )[query.m_handle.idx];
-				_render->m_occlusion[query.m_handle.idx] = int32_t(result);
+				_render->setOcclusionResult(query.m_handle, int32_t(result) );
 			}
 
 			m_control.consume(1);
@@ -4638,6 +4638,7 @@ namespace bgfx { namespace mtl
 		perfStats.numCompute    = statsKeyType[1];
 		perfStats.numBlit       = _render->m_numBlitItems;
 		perfStats.maxGpuLatency = maxGpuLatency;
+		perfStats.gpuFrameLatency = m_gpuTimer.m_control.available();
 		bx::memCopy(perfStats.numPrims, statsNumPrimsRendered, sizeof(perfStats.numPrims) );
 		perfStats.gpuMemoryMax  = -INT64_MAX;
 		perfStats.gpuMemoryUsed = -INT64_MAX;
@@ -3902,7 +3902,7 @@ namespace bgfx { namespace webgpu
 			if (isValid(query.m_handle) )
 			{
 				uint64_t result = 0; // ((uint64_t*)m_buffer.contents())[query.m_handle.idx];
-				_render->m_occlusion[query.m_handle.idx] = int32_t(result);
+				_render->setOcclusionResult(query.m_handle, int32_t(result) );
 			}
 
 			m_control.consume(1);
@@ -4846,6 +4846,7 @@ namespace bgfx { namespace webgpu
 		perfStats.numCompute    = statsKeyType[1];
 		perfStats.numBlit       = _render->m_numBlitItems;
 		perfStats.maxGpuLatency = maxGpuLatency;
+		perfStats.gpuFrameLatency = m_gpuTimer.m_control.available();
 		bx::memCopy(perfStats.numPrims, statsNumPrimsRendered, sizeof(perfStats.numPrims) );
 		perfStats.gpuMemoryMax  = -INT64_MAX;
 		perfStats.gpuMemoryUsed = -INT64_MAX;
@@ -0,0 +1,158 @@
+/*
+ * Copyright 2011-2019 Branimir Karadzic. All rights reserved.
+ * License: https://github.com/bkaradzic/bgfx#license-bsd-2-clause
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <bx/math.h>
+#include "cpu_occlusion.h"
+
+static uint32_t s_numFailed = 0;
+
+#define TEST_CHECK(_condition)                                      \
+	do {                                                            \
+		if (!(_condition) )                                         \
+		{                                                           \
+			fprintf(stderr, "%s(%d): FAILED %s\n"                   \
+				, __FILE__                                          \
+				, __LINE__                                          \
+				, #_condition                                       \
+				);                                                  \
+			++s_numFailed;                                          \
+		}                                                           \
+	} while (0)
+
+// Quad at z = 5 in front of camera, covering [-2, 2] on x and y.
+static const float s_occluderVertices[4][3] =
+{
+	{ -2.0f,  2.0f, 5.0f },
+	{  2.0f,  2.0f, 5.0f },
+	{ -2.0f, -2.0f, 5.0f },
+	{  2.0f, -2.0f, 5.0f },
+};
+
+static const uint16_t s_occluderIndices[6] =
+{
+	0, 1, 2,
+	1, 3, 2,
+};
+
+static Aabb makeAabb(float _minX, float _minY, float _minZ, float _maxX, float _maxY, float _maxZ)
+{
+	Aabb aabb;
+	aabb.min = { _minX, _minY, _minZ };
+	aabb.max = { _maxX, _maxY, _maxZ };
+	return aabb;
+}
+
+static void testCpuOcclusion(bool _homogeneousDepth)
+{
+	float view[16];
+	bx::mtxLookAt(view, { 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 1.0f });
+
+	float proj[16];
+	bx::mtxProj(proj, 60.0f, 1.0f, 0.1f, 100.0f, _homogeneousDepth);
+
+	float viewProj[16];
+	bx::mtxMul(viewProj, view, proj);
+
+	float identity[16];
+	bx::mtxIdentity(identity);
+
+	CpuOcclusion occlusion;
+	occlusion.create(64, 48);
+
+	// 64x48, 32x24, 16x12, 8x6, 4x3, 2x2, 1x1.
+	TEST_CHECK(7 == occlusion.getNumLevels() );
+	TEST_CHECK(64*48 + 32*24 + 16*12 + 8*6 + 4*3 + 2*2 + 1 == uint32_t(occlusion.m_depth.size() ) );
+
+	const Aabb behind   = makeAabb(-0.5f, -0.5f, 8.0f, 0.5f, 0.5f,  9.0f);
+	const Aabb inFront  = makeAabb(-0.5f, -0.5f, 2.0f, 0.5f, 0.5f,  3.0f);
+	const Aabb aside    = makeAabb( 4.0f, -0.5f, 8.0f, 5.0f, 0.5f,  9.0f);
+	const Aabb offside  = makeAabb(50.0f, -0.5f, 8.0f, 51.0f, 0.5f, 9.0f);
+	const Aabb atCamera = makeAabb(-1.0f, -1.0f, -1.0f, 1.0f, 1.0f, 1.0f);
+
+	// Without occluders everything on screen is visible.
+	occlusion.begin(viewProj, _homogeneousDepth);
+	occlusion.end();
+
+	TEST_CHECK( occlusion.isVisible(behind) );
+	TEST_CHECK( occlusion.isVisible(inFront) );
+	TEST_CHECK( occlusion.isVisible(aside) );
+	TEST_CHECK(!occlusion.isVisible(offside) );
+	TEST_CHECK( occlusion.isVisible(atCamera) );
+
+	occlusion.begin(viewProj, _homogeneousDepth);
+	occlusion.addOccluder(
+		  identity
+		, s_occluderVertices
+		, BX_COUNTOF(s_occluderVertices)
+		, sizeof(s_occluderVertices[0])
+		, s_occluderIndices
+		, BX_COUNTOF(s_occluderIndices)
+		);
+	occlusion.end();
+
+	TEST_CHECK(!occlusion.isVisible(behind) );
+	TEST_CHECK( occlusion.isVisible(inFront) );
+	TEST_CHECK( occlusion.isVisible(aside) );
+	TEST_CHECK(!occlusion.isVisible(offside) );
+
+	// Boxes crossing near plane are always visible.
+	TEST_CHECK( occlusion.isVisible(atCamera) );
+
+	// Each Hi-Z texel must keep farthest depth of texels below it.
+	for (uint32_t ii = 1, num = occlusion.getNumLevels(); ii < num; ++ii)
+	{
+		const CpuOcclusion::Level& src = occlusion.m_level[ii-1];
+		const CpuOcclusion::Level& dst = occlusion.m_level[ii];
+
+		for (uint32_t yy = 0; yy < src.m_height; ++yy)
+		{
+			for (uint32_t xx = 0; xx < src.m_width; ++xx)
+			{
+				const float srcDepth = occlusion.m_depth[src.m_offset + yy*src.m_width + xx];
+				const float dstDepth = occlusion.m_depth[dst.m_offset + (yy/2)*dst.m_width + xx/2];
+				TEST_CHECK(dstDepth >= srcDepth);
+			}
+		}
+	}
+
+	// Occluder moved aside doesn't hide box anymore.
+	float mtx[16];
+	bx::mtxTranslate(mtx, 20.0f, 0.0f, 0.0f);
+
+	occlusion.begin(viewProj, _homogeneousDepth);
+	occlusion.addOccluder(
+		  mtx
+		, s_occluderVertices
+		, BX_COUNTOF(s_occluderVertices)
+		, sizeof(s_occluderVertices[0])
+		, s_occluderIndices
+		, BX_COUNTOF(s_occluderIndices)
+		);
+	occlusion.end();
+
+	TEST_CHECK(occlusion.isVisible(behind) );
+
+	occlusion.destroy();
+	TEST_CHECK(0 == occlusion.getNumLevels() );
+}
+
+int main(int _argc, const char* _argv[])
+{
+	BX_UNUSED(_argc, _argv);
+
+	testCpuOcclusion(false);
+	testCpuOcclusion(true);
+
+	if (0 != s_numFailed)
+	{
+		fprintf(stderr, "%d check(s) failed.\n", s_numFailed);
+		return EXIT_FAILURE;
+	}
+
+	printf("All checks passed.\n");
+	return EXIT_SUCCESS;
+}
@@ -4,6 +4,7 @@
  */
 
 #include <algorithm>
+#include <thread>
 
 #include <bx/string.h>
 #include <bgfx/bgfx.h>
@@ -20,7 +21,7 @@ namespace stl = tinystl;
 #include <cgltf/cgltf.h>
 
 #define BGFX_GEOMETRYC_VERSION_MAJOR 1
-#define BGFX_GEOMETRYC_VERSION_MINOR 0
+#define BGFX_GEOMETRYC_VERSION_MINOR 3
 
 #if 0
 #	define BX_TRACE(_format, ...) \
@@ -54,6 +55,16 @@ namespace stl = tinystl;
 #include <bx/uint32_t.h>
 #include <bx/math.h>
 #include <bx/file.h>
+#include <bx/thread.h>
+#include <bx/semaphore.h>
+#include <bx/cpu.h>
+
+#if BX_PLATFORM_POSIX
+#	include <fcntl.h>
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#	include <unistd.h>
+#endif // BX_PLATFORM_POSIX
 
 #include "bounds.h"
 
@@ -151,6 +162,9 @@ struct Mesh
 };
 
 static uint32_t s_obbSteps = 17;
+static bool     s_verbose  = false;
+
+static int64_t s_boundsElapsed = 0;
 
 #define BGFX_CHUNK_MAGIC_VB  BX_MAKEFOURCC('V', 'B', ' ', 0x1)
 #define BGFX_CHUNK_MAGIC_VBC BX_MAKEFOURCC('V', 'B', 'C', 0x0)
@@ -158,15 +172,155 @@ static uint32_t s_obbSteps = 17;
 #define BGFX_CHUNK_MAGIC_IBC BX_MAKEFOURCC('I', 'B', 'C', 0x1)
 #define BGFX_CHUNK_MAGIC_PRI BX_MAKEFOURCC('P', 'R', 'I', 0x0)
 
-void optimizeVertexCache(uint16_t* _indices, uint32_t _numIndices, uint32_t _numVertices)
+#define BGFX_CHUNK_MAGIC_VB32  BX_MAKEFOURCC('V', 'B', ' ', 0x2)
+#define BGFX_CHUNK_MAGIC_VBC32 BX_MAKEFOURCC('V', 'B', 'C', 0x1)
+#define BGFX_CHUNK_MAGIC_IB32  BX_MAKEFOURCC('I', 'B', ' ', 0x1)
+#define BGFX_CHUNK_MAGIC_IBC32 BX_MAKEFOURCC('I', 'B', 'C', 0x2)
+#define BGFX_CHUNK_MAGIC_MSH   BX_MAKEFOURCC('M', 'S', 'H', 0x0)
+#define BGFX_CHUNK_MAGIC_LOD   BX_MAKEFOURCC('L', 'O', 'D', 0x0)
+
+static const uint32_t s_meshletMaxVertices  = 64;
+static const uint32_t s_meshletMaxTriangles = 124;
+
+static uint32_t s_lodNum   = 0;
+static float    s_lodRatio = 0.5f;
+static float    s_lodError = 0.01f;
+
+typedef void (*ParallelForFn)(uint32_t _idx, void* _userData);
+
+struct ParallelFor
+{
+	ParallelForFn m_fn;
+	void* m_userData;
+	uint32_t m_num;
+	int32_t m_next;
+};
+
+static uint32_t s_numThreads = 0;
+
+static void parallelForRun(ParallelFor* _pf)
+{
+	for (uint32_t idx = uint32_t(bx::atomicFetchAndAdd(&_pf->m_next, 1) )
+		; idx < _pf->m_num
+		; idx = uint32_t(bx::atomicFetchAndAdd(&_pf->m_next, 1) )
+		)
+	{
+		_pf->m_fn(idx, _pf->m_userData);
+	}
+}
+
+// Worker threads are created once per run and parked on semaphore between parallelFor
+// calls, instead of being spawned and joined for every parallel stage.
+struct WorkerPool
+{
+	bx::Thread* m_threads;
+	uint32_t m_numThreads;
+	bx::Semaphore m_work;
+	bx::Semaphore m_done;
+	ParallelFor* m_pf;
+	bool m_quit;
+};
+
+static WorkerPool s_pool;
+
+static int32_t workerPoolThread(bx::Thread* /*_self*/, void* _userData)
 {
-	uint16_t* newIndexList = new uint16_t[_numIndices];
+	WorkerPool* pool = (WorkerPool*)_userData;
+
+	for (;;)
+	{
+		pool->m_work.wait();
+
+		if (pool->m_quit)
+		{
+			break;
+		}
+
+		parallelForRun(pool->m_pf);
+		pool->m_done.post();
+	}
+
+	return bx::kExitSuccess;
+}
+
+static void workerPoolInit(uint32_t _numThreads)
+{
+	s_pool.m_numThreads = _numThreads > 1 ? _numThreads-1 : 0;
+	s_pool.m_threads    = NULL;
+	s_pool.m_pf         = NULL;
+	s_pool.m_quit       = false;
+
+	if (0 < s_pool.m_numThreads)
+	{
+		s_pool.m_threads = new bx::Thread[s_pool.m_numThreads];
+		for (uint32_t ii = 0; ii < s_pool.m_numThreads; ++ii)
+		{
+			s_pool.m_threads[ii].init(workerPoolThread, &s_pool, 0, "geometryc - worker");
+		}
+	}
+}
+
+static void workerPoolShutdown()
+{
+	s_pool.m_quit = true;
+	s_pool.m_work.post(s_pool.m_numThreads);
+
+	for (uint32_t ii = 0; ii < s_pool.m_numThreads; ++ii)
+	{
+		s_pool.m_threads[ii].shutdown();
+	}
+
+	delete [] s_pool.m_threads;
+	s_pool.m_threads    = NULL;
+	s_pool.m_numThreads = 0;
+}
+
+void parallelFor(uint32_t _num, ParallelForFn _fn, void* _userData)
+{
+	ParallelFor pf;
+	pf.m_fn       = _fn;
+	pf.m_userData = _userData;
+	pf.m_num      = _num;
+	pf.m_next     = 0;
+
+	const uint32_t numWorkers = bx::uint32_min(s_pool.m_numThreads, _num > 1 ? _num-1 : 0);
+
+	s_pool.m_pf = &pf;
+	s_pool.m_work.post(numWorkers);
+
+	parallelForRun(&pf);
+
+	for (uint32_t ii = 0; ii < numWorkers; ++ii)
+	{
+		s_pool.m_done.wait();
+	}
+
+	s_pool.m_pf = NULL;
+}
+
+void optimizeVertexCache(uint32_t* _indices, uint32_t _numIndices, uint32_t _numVertices)
+{
+	uint32_t* newIndexList = new uint32_t[_numIndices];
 	meshopt_optimizeVertexCache(newIndexList, _indices, _numIndices, _numVertices);
-	bx::memCopy(_indices, newIndexList, _numIndices * 2);
+	bx::memCopy(_indices, newIndexList, _numIndices * sizeof(uint32_t) );
 	delete[] newIndexList;
 }
 
-uint32_t optimizeVertexFetch(uint16_t* _indices, uint32_t _numIndices, uint8_t* _vertexData, uint32_t _numVertices, uint16_t _stride)
+struct OptimizeVertexCache
+{
+	uint32_t* m_indices;
+	const Primitive* m_primitives;
+	uint32_t m_numVertices;
+};
+
+static void optimizeVertexCacheFn(uint32_t _idx, void* _userData)
+{
+	OptimizeVertexCache* ovc = (OptimizeVertexCache*)_userData;
+	const Primitive& prim = ovc->m_primitives[_idx];
+	optimizeVertexCache(ovc->m_indices + prim.m_startIndex, prim.m_numIndices, ovc->m_numVertices);
+}
+
+uint32_t optimizeVertexFetch(uint32_t* _indices, uint32_t _numIndices, uint8_t* _vertexData, uint32_t _numVertices, uint16_t _stride)
 {
 	unsigned char* newVertices = (unsigned char*)malloc(_numVertices * _stride );
 	size_t vertexCount = meshopt_optimizeVertexFetch(newVertices, _indices, _numIndices, _vertexData, _numVertices, _stride);
@@ -176,15 +330,15 @@ uint32_t optimizeVertexFetch(uint16_t* _indices, uint32_t _numIndices, uint8_t*
 	return uint32_t(vertexCount);
 }
 
-void writeCompressedIndices(bx::WriterI* _writer, const uint16_t* _indices, uint32_t _numIndices, uint32_t _numVertices)
+void writeCompressedIndices(bx::WriterI* _writer, const uint32_t* _indices, uint32_t _numIndices, uint32_t _numVertices, uint32_t _indexSize)
 {
 	size_t maxSize = meshopt_encodeIndexBufferBound(_numIndices, _numVertices);
 	unsigned char* compressedIndices = (unsigned char*)malloc(maxSize);
 	size_t compressedSize = meshopt_encodeIndexBuffer(compressedIndices, maxSize, _indices, _numIndices);
 	bx::printf( "indices uncompressed: %10d, compressed: %10d, ratio: %0.2f%%\n"
-		, _numIndices*2
+		, _numIndices*_indexSize
 		, (uint32_t)compressedSize
-		, 100.0f - float(compressedSize ) / float(_numIndices*2)*100.0f
+		, 100.0f - float(compressedSize ) / float(_numIndices*_indexSize)*100.0f
 		);
 
 	bx::write(_writer, (uint32_t)compressedSize);
@@ -208,7 +362,7 @@ void writeCompressedVertices(bx::WriterI* _writer,  const uint8_t* _vertices, ui
 	free(compressedVertices);
 }
 
-void calcTangents(void* _vertices, uint16_t _numVertices, bgfx::VertexLayout _layout, const uint16_t* _indices, uint32_t _numIndices)
+void calcTangents(void* _vertices, uint32_t _numVertices, bgfx::VertexLayout _layout, const uint32_t* _indices, uint32_t _numIndices)
 {
 	struct PosTexcoord
 	{
@@ -231,7 +385,7 @@ void calcTangents(void* _vertices, uint16_t _numVertices, bgfx::VertexLayout _la
 
 	for (uint32_t ii = 0, num = _numIndices/3; ii < num; ++ii)
 	{
-		const uint16_t* indices = &_indices[ii*3];
+		const uint32_t* indices = &_indices[ii*3];
 		uint32_t i0 = indices[0];
 		uint32_t i1 = indices[1];
 		uint32_t i2 = indices[2];
@@ -305,39 +459,249 @@ void calcTangents(void* _vertices, uint16_t _numVertices, bgfx::VertexLayout _la
 	delete [] tangents;
 }
 
-void write(bx::WriterI* _writer, const void* _vertices, uint32_t _numVertices, uint32_t _stride)
+struct Bounds
+{
+	const void* m_vertices;
+	uint32_t m_numVertices;
+	uint32_t m_stride;
+
+	Sphere m_sphere;
+	Aabb m_aabb;
+	Obb m_obb;
+};
+
+void calcBounds(Bounds& _bounds)
 {
 	Sphere maxSphere;
-	calcMaxBoundingSphere(maxSphere, _vertices, _numVertices, _stride);
+	calcMaxBoundingSphere(maxSphere, _bounds.m_vertices, _bounds.m_numVertices, _bounds.m_stride);
 
 	Sphere minSphere;
-	calcMinBoundingSphere(minSphere, _vertices, _numVertices, _stride);
+	calcMinBoundingSphere(minSphere, _bounds.m_vertices, _bounds.m_numVertices, _bounds.m_stride);
 
-	if (minSphere.radius > maxSphere.radius)
+	_bounds.m_sphere = minSphere.radius > maxSphere.radius
+		? maxSphere
+		: minSphere
+		;
+
+	toAabb(_bounds.m_aabb, _bounds.m_vertices, _bounds.m_numVertices, _bounds.m_stride);
+	calcObb(_bounds.m_obb, _bounds.m_vertices, _bounds.m_numVertices, _bounds.m_stride, s_obbSteps);
+}
+
+static void calcBoundsFn(uint32_t _idx, void* _userData)
+{
+	Bounds* bounds = (Bounds*)_userData;
+	calcBounds(bounds[_idx]);
+}
+
+void write(bx::WriterI* _writer, const Bounds& _bounds)
+{
+	bx::write(_writer, _bounds.m_sphere);
+	bx::write(_writer, _bounds.m_aabb);
+	bx::write(_writer, _bounds.m_obb);
+}
+
+void writeMeshlets(bx::WriterI* _writer
+		, const uint8_t* _vertices
+		, uint32_t _numVertices
+		, uint32_t _stride
+		, const uint32_t* _indices
+		, uint32_t _numIndices
+		)
+{
+	using namespace bx;
+
+	const size_t maxMeshlets = meshopt_buildMeshletsBound(_numIndices, s_meshletMaxVertices, s_meshletMaxTriangles);
+	meshopt_Meshlet* meshlets = (meshopt_Meshlet*)malloc(maxMeshlets*sizeof(meshopt_Meshlet) );
+	const uint32_t numMeshlets = uint32_t(meshopt_buildMeshlets(
+		  meshlets
+		, _indices
+		, _numIndices
+		, _numVertices
+		, s_meshletMaxVertices
+		, s_meshletMaxTriangles
+		) );
+
+	write(_writer, BGFX_CHUNK_MAGIC_MSH);
+	write(_writer, numMeshlets);
+
+	uint32_t numMeshletVertices  = 0;
+	uint32_t numMeshletTriangles = 0;
+
+	for (uint32_t ii = 0; ii < numMeshlets; ++ii)
 	{
-		bx::write(_writer, maxSphere);
+		const meshopt_Meshlet& meshlet = meshlets[ii];
+		const meshopt_Bounds bounds = meshopt_computeMeshletBounds(&meshlet, (const float*)_vertices, _numVertices, _stride);
+
+		write(_writer, numMeshletVertices);
+		write(_writer, numMeshletTriangles);
+		write(_writer, uint32_t(meshlet.vertex_count) );
+		write(_writer, uint32_t(meshlet.triangle_count) );
+		write(_writer, bounds.center, sizeof(bounds.center) );
+		write(_writer, bounds.radius);
+		write(_writer, bounds.cone_apex, sizeof(bounds.cone_apex) );
+		write(_writer, bounds.cone_axis, sizeof(bounds.cone_axis) );
+		write(_writer, bounds.cone_cutoff);
+
+		numMeshletVertices  += meshlet.vertex_count;
+		numMeshletTriangles += meshlet.triangle_count;
 	}
-	else
+
+	write(_writer, numMeshletVertices);
+	for (uint32_t ii = 0; ii < numMeshlets; ++ii)
+	{
+		const meshopt_Meshlet& meshlet = meshlets[ii];
+		write(_writer, meshlet.vertices, meshlet.vertex_count*sizeof(uint32_t) );
+	}
+
+	// Micro-indices are packed as 8:8:8 local vertex indices per triangle.
+	write(_writer, numMeshletTriangles);
+	for (uint32_t ii = 0; ii < numMeshlets; ++ii)
 	{
-		bx::write(_writer, minSphere);
+		const meshopt_Meshlet& meshlet = meshlets[ii];
+		for (uint32_t tri = 0; tri < meshlet.triangle_count; ++tri)
+		{
+			const uint32_t packed = 0
+				| (uint32_t(meshlet.indices[tri][0])    )
+				| (uint32_t(meshlet.indices[tri][1])<< 8)
+				| (uint32_t(meshlet.indices[tri][2])<<16)
+				;
+			write(_writer, packed);
+		}
 	}
 
+	bx::printf("meshlets: %10d, vertices: %10d, triangles: %10d\n"
+		, numMeshlets
+		, numMeshletVertices
+		, numMeshletTriangles
+		);
+
+	free(meshlets);
+}
+
+// LOD chunk is self-contained (own compacted vertex and index data), and it's prefixed with its
+// size, so that reader can skip it and stream it in later only when needed:
+//   uint32_t magic ('LOD', 0)
+//   uint32_t size
+//   uint8_t  lod, uint8_t indexSize, float error
+//   uint32_t numVertices, vertices[numVertices*stride]
+//   uint32_t numIndices, indices[numIndices*indexSize]
+//
+// LODs are simplified from base mesh, error is geometric deviation measured by simplifier, in mesh
+// units.
+void writeLods(bx::WriterI* _writer
+		, const uint8_t* _vertices
+		, uint32_t _numVertices
+		, uint32_t _stride
+		, const uint32_t* _indices
+		, uint32_t _numIndices
+		, bool _index32
+		)
+{
+	using namespace bx;
+
 	Aabb aabb;
 	toAabb(aabb, _vertices, _numVertices, _stride);
-	bx::write(_writer, aabb);
+	const bx::Vec3 extents = bx::sub(aabb.max, aabb.min);
+	const float extent = bx::max(extents.x, extents.y, extents.z);
+
+	uint32_t* lodIndices  = new uint32_t[_numIndices];
+	uint8_t*  lodVertices = new uint8_t[_numVertices*_stride];
+
+	const uint8_t indexSize = _index32 ? 4 : 2;
+
+	float ratio = 1.0f;
+	uint32_t prevNumIndices = _numIndices;
+
+	for (uint32_t lod = 1; lod <= s_lodNum; ++lod)
+	{
+		ratio *= s_lodRatio;
+
+		const uint32_t targetNumIndices = uint32_t(float(_numIndices)*ratio)/3*3;
+		const float targetError = bx::min(s_lodError*float(1<<(lod-1) ), 1.0f);
+
+		float resultError = 0.0f;
+		uint32_t numIndices = uint32_t(meshopt_simplify(
+			  lodIndices
+			, _indices
+			, _numIndices
+			, (const float*)_vertices
+			, _numVertices
+			, _stride
+			, targetNumIndices
+			, targetError
+			, &resultError
+			) );
+
+		if (0 == numIndices
+		||  prevNumIndices == numIndices)
+		{
+			break;
+		}
+
+		prevNumIndices = numIndices;
+
+		optimizeVertexCache(lodIndices, numIndices, _numVertices);
 
-	Obb obb;
-	calcObb(obb, _vertices, _numVertices, _stride, s_obbSteps);
-	bx::write(_writer, obb);
+		bx::memCopy(lodVertices, _vertices, _numVertices*_stride);
+		const uint32_t numVertices = optimizeVertexFetch(lodIndices, numIndices, lodVertices, _numVertices, uint16_t(_stride) );
+
+		// Simplifier error is relative to mesh extent.
+		const float error = resultError*extent;
+
+		const uint32_t size = 0
+			+ sizeof(uint8_t)*2
+			+ sizeof(float)
+			+ sizeof(uint32_t) + numVertices*_stride
+			+ sizeof(uint32_t) + numIndices*indexSize
+			;
+
+		write(_writer, BGFX_CHUNK_MAGIC_LOD);
+		write(_writer, size);
+		write(_writer, uint8_t(lod) );
+		write(_writer, indexSize);
+		write(_writer, error);
+		write(_writer, numVertices);
+		write(_writer, lodVertices, numVertices*_stride);
+		write(_writer, numIndices);
+
+		if (_index32)
+		{
+			write(_writer, lodIndices, numIndices*4);
+		}
+		else
+		{
+			uint16_t* indices16 = new uint16_t[numIndices];
+			for (uint32_t ii = 0; ii < numIndices; ++ii)
+			{
+				indices16[ii] = uint16_t(lodIndices[ii]);
+			}
+
+			write(_writer, indices16, numIndices*2);
+
+			delete [] indices16;
+		}
+
+		bx::printf("lod %d: vertices %10d, indices %10d, error %f\n"
+			, lod
+			, numVertices
+			, numIndices
+			, error
+			);
+	}
+
+	delete [] lodVertices;
+	delete [] lodIndices;
 }
 
 void write(bx::WriterI* _writer
 		, const uint8_t* _vertices
 		, uint32_t _numVertices
 		, const bgfx::VertexLayout& _layout
-		, const uint16_t* _indices
+		, const uint32_t* _indices
 		, uint32_t _numIndices
 		, bool _compress
+		, bool _index32
+		, bool _meshlets
 		, const stl::string& _material
 		, const PrimitiveArray& _primitives
 		)
@@ -347,38 +711,99 @@ void write(bx::WriterI* _writer
 
 	uint32_t stride = _layout.getStride();
 
+	// Bounds of whole vertex buffer are followed by bounds of each primitive. OBB search is
+	// the most expensive part of writing, so all bounds are calculated in parallel up front.
+	const uint32_t numBounds = 1 + uint32_t(_primitives.size() );
+	Bounds* bounds = new Bounds[numBounds];
+
+	bounds[0].m_vertices    = _vertices;
+	bounds[0].m_numVertices = _numVertices;
+	bounds[0].m_stride      = stride;
+
+	for (uint32_t ii = 1; ii < numBounds; ++ii)
+	{
+		const Primitive& prim = _primitives[ii-1];
+		bounds[ii].m_vertices    = &_vertices[prim.m_startVertex*stride];
+		bounds[ii].m_numVertices = prim.m_numVertices;
+		bounds[ii].m_stride      = stride;
+	}
+
+	s_boundsElapsed -= bx::getHPCounter();
+	parallelFor(numBounds, calcBoundsFn, bounds);
+	s_boundsElapsed += bx::getHPCounter();
+
 	if (_compress)
 	{
-		write(_writer, BGFX_CHUNK_MAGIC_VBC);
-		write(_writer, _vertices, _numVertices, stride);
+		write(_writer, _index32 ? BGFX_CHUNK_MAGIC_VBC32 : BGFX_CHUNK_MAGIC_VBC);
+		write(_writer, bounds[0]);
 
 		write(_writer, _layout);
 
-		write(_writer, uint16_t(_numVertices) );
+		if (_index32)
+		{
+			write(_writer, _numVertices);
+		}
+		else
+		{
+			write(_writer, uint16_t(_numVertices) );
+		}
+
 		writeCompressedVertices(_writer, _vertices, _numVertices, uint16_t(stride));
 	}
 	else
 	{
-		write(_writer, BGFX_CHUNK_MAGIC_VB);
-		write(_writer, _vertices, _numVertices, stride);
+		write(_writer, _index32 ? BGFX_CHUNK_MAGIC_VB32 : BGFX_CHUNK_MAGIC_VB);
+		write(_writer, bounds[0]);
 
 		write(_writer, _layout);
 
-		write(_writer, uint16_t(_numVertices) );
+		if (_index32)
+		{
+			write(_writer, _numVertices);
+		}
+		else
+		{
+			write(_writer, uint16_t(_numVertices) );
+		}
+
 		write(_writer, _vertices, _numVertices*stride);
 	}
 
 	if (_compress)
 	{
-		write(_writer, BGFX_CHUNK_MAGIC_IBC);
+		write(_writer, _index32 ? BGFX_CHUNK_MAGIC_IBC32 : BGFX_CHUNK_MAGIC_IBC);
+		write(_writer, _numIndices);
+		writeCompressedIndices(_writer, _indices, _numIndices, _numVertices, _index32 ? 4 : 2);
+	}
+	else if (_index32)
+	{
+		write(_writer, BGFX_CHUNK_MAGIC_IB32);
 		write(_writer, _numIndices);
-		writeCompressedIndices(_writer, _indices, _numIndices, _numVertices);
+		write(_writer, _indices, _numIndices*4);
 	}
 	else
 	{
+		uint16_t* indices16 = new uint16_t[_numIndices];
+		for (uint32_t ii = 0; ii < _numIndices; ++ii)
+		{
+			indices16[ii] = uint16_t(_indices[ii]);
+		}
+
 		write(_writer, BGFX_CHUNK_MAGIC_IB);
 		write(_writer, _numIndices);
-		write(_writer, _indices, _numIndices*2);
+		write(_writer, indices16, _numIndices*2);
+
+		delete [] indices16;
+	}
+
+	if (_meshlets)
+	{
+		writeMeshlets(_writer, _vertices, _numVertices, stride, _indices, _numIndices);
+	}
+
+	if (0 < s_lodNum)
+	{
+		writeLods(_writer, _vertices, _numVertices, stride, _indices, _numIndices, _index32);
 	}
 
 	write(_writer, BGFX_CHUNK_MAGIC_PRI);
@@ -386,9 +811,9 @@ void write(bx::WriterI* _writer
 	write(_writer, nameLen);
 	write(_writer, _material.c_str(), nameLen);
 	write(_writer, uint16_t(_primitives.size() ) );
-	for (PrimitiveArray::const_iterator primIt = _primitives.begin(); primIt != _primitives.end(); ++primIt)
+	for (uint32_t ii = 1; ii < numBounds; ++ii)
 	{
-		const Primitive& prim = *primIt;
+		const Primitive& prim = _primitives[ii-1];
 		nameLen = uint16_t(prim.m_name.size() );
 		write(_writer, nameLen);
 		write(_writer, prim.m_name.c_str(), nameLen);
@@ -396,8 +821,10 @@ void write(bx::WriterI* _writer
 		write(_writer, prim.m_numIndices);
 		write(_writer, prim.m_startVertex);
 		write(_writer, prim.m_numVertices);
-		write(_writer, &_vertices[prim.m_startVertex*stride], prim.m_numVertices, stride);
+		write(_writer, bounds[ii]);
 	}
+
+	delete [] bounds;
 }
 
 inline uint32_t rgbaToAbgr(uint8_t _r, uint8_t _g, uint8_t _b, uint8_t _a)
@@ -462,29 +889,61 @@ float mtxDeterminant(const float* _a)
 }
 
 
-void parseObj(char* _data, uint32_t _size, Mesh* _mesh, bool _hasBc)
+struct ObjEvent
 {
-	// Reference(s):
-	// - Wavefront .obj file
-	//   https://en.wikipedia.org/wiki/Wavefront_.obj_file
+	enum Enum
+	{
+		Vertex,
+		Group,
+		Material,
+	};
 
-	// Coordinate system is right-handed, but up/forward is not defined, but +Y Up, +Z Forward seems to be a common default
-	_mesh->m_coordinateSystem.m_handness = bx::Handness::Right;
-	_mesh->m_coordinateSystem.m_up = Axis::PositiveY;
-	_mesh->m_coordinateSystem.m_forward = Axis::PositiveZ;
+	Enum m_type;
+	uint32_t m_triangle;
+	stl::string m_name;
+};
 
-	uint32_t num = 0;
+typedef stl::vector<ObjEvent> ObjEventArray;
 
-	Group group;
-	group.m_startTriangle = 0;
-	group.m_numTriangles = 0;
+// Index flags, index is relative to chunk start (OBJ negative index), and chunk base offset
+// must be added during merge.
+#define OBJ_RELATIVE_POSITION UINT8_C(0x1)
+#define OBJ_RELATIVE_TEXCOORD UINT8_C(0x2)
+#define OBJ_RELATIVE_NORMAL   UINT8_C(0x4)
 
+struct ObjChunk
+{
+	const char* m_data;
+	uint32_t m_size;
+	uint32_t m_numLines;
+	bool m_hasBc;
+
+	Vec3Array m_positions;
+	Vec3Array m_normals;
+	Vec3Array m_texcoords;
+	TriangleArray m_triangles;
+	stl::vector<uint16_t> m_relative;
+	ObjEventArray m_events;
+
+	uint32_t m_positionBase;
+	uint32_t m_normalBase;
+	uint32_t m_texcoordBase;
+	uint32_t m_triangleBase;
+};
+
+// Parses chunk of OBJ file independently of other chunks. Positions, normals, and texcoords
+// are chunk local, and group/material changes are recorded as events, so that merge step can
+// replay them in file order.
+void parseObjChunk(ObjChunk* _chunk)
+{
 	char commandLine[2048];
 	uint32_t len = sizeof(commandLine);
 	int argc;
 	char* argv[64];
-	
-	for (bx::StringView next(_data, _size); !next.isEmpty(); )
+
+	bool lastWasVertex = false;
+
+	for (bx::StringView next(_chunk->m_data, _chunk->m_size); !next.isEmpty(); )
 	{
 		next = bx::tokenizeCommandLine(next, commandLine, len, argc, argv, BX_COUNTOF(argv), '\n');
 
@@ -499,18 +958,21 @@ void parseObj(char* _data, uint32_t _size, Mesh* _mesh, bool _hasBc)
 			}
 			else if (0 == bx::strCmp(argv[0], "f") )
 			{
+				lastWasVertex = false;
+
 				TriIndices triangle;
 				bx::memSet(&triangle, 0, sizeof(TriIndices) );
-				
-				const int numNormals   = (int)_mesh->m_normals.size();
-				const int numTexcoords = (int)_mesh->m_texcoords.size();
-				const int numPositions = (int)_mesh->m_positions.size();
+				uint8_t relative[3] = { 0, 0, 0 };
+
+				const int numNormals   = (int)_chunk->m_normals.size();
+				const int numTexcoords = (int)_chunk->m_texcoords.size();
+				const int numPositions = (int)_chunk->m_positions.size();
 				for (uint32_t edge = 0, numEdges = argc-1; edge < numEdges; ++edge)
 				{
 					Index3 index;
 					index.m_texcoord = -1;
 					index.m_normal = -1;
-					if (_hasBc)
+					if (_chunk->m_hasBc)
 					{
 						index.m_vbc = edge < 3 ? edge : (1+(edge+1) )&1;
 					}
@@ -519,6 +981,8 @@ void parseObj(char* _data, uint32_t _size, Mesh* _mesh, bool _hasBc)
 						index.m_vbc = 0;
 					}
 
+					uint8_t flags = 0;
+
 					{
 						bx::StringView triplet(argv[edge + 1]);
 						bx::StringView vertex(triplet);
@@ -533,6 +997,7 @@ void parseObj(char* _data, uint32_t _size, Mesh* _mesh, bool _hasBc)
 								int32_t nn;
 								bx::fromString(&nn, bx::StringView(normal.getPtr() + 1, triplet.getTerm()));
 								index.m_normal = (nn < 0) ? nn + numNormals : nn - 1;
+								flags |= (nn < 0) ? OBJ_RELATIVE_NORMAL : 0;
 							}
 
 							texcoord.set(texcoord.getPtr() + 1, normal.getPtr());
@@ -545,45 +1010,60 @@ void parseObj(char* _data, uint32_t _size, Mesh* _mesh, bool _hasBc)
 								int32_t tex;
 								bx::fromString(&tex, texcoord);
 								index.m_texcoord = (tex < 0) ? tex + numTexcoords : tex - 1;
+								flags |= (tex < 0) ? OBJ_RELATIVE_TEXCOORD : 0;
 							}
 						}
 
 						int32_t pos;
 						bx::fromString(&pos, vertex);
 						index.m_position = (pos < 0) ? pos + numPositions : pos - 1;
+						flags |= (pos < 0) ? OBJ_RELATIVE_POSITION : 0;
 					}
 
 					switch (edge)
 					{
 					case 0:	case 1:	case 2:
 						triangle.m_index[edge] = index;
+						relative[edge] = flags;
 						if (2 == edge)
 						{
-							_mesh->m_triangles.push_back(triangle);
+							_chunk->m_triangles.push_back(triangle);
+							_chunk->m_relative.push_back(uint16_t(relative[0] | (relative[1]<<3) | (relative[2]<<6) ) );
 						}
 						break;
-							
+
 					default:
 						triangle.m_index[1] = triangle.m_index[2];
 						triangle.m_index[2] = index;
-							
-						_mesh->m_triangles.push_back(triangle);
+						relative[1] = relative[2];
+						relative[2] = flags;
+
+						_chunk->m_triangles.push_back(triangle);
+						_chunk->m_relative.push_back(uint16_t(relative[0] | (relative[1]<<3) | (relative[2]<<6) ) );
 						break;
 					}
 				}
 			}
 			else if (0 == bx::strCmp(argv[0], "g") )
 			{
-				group.m_name = argv[1];
+				lastWasVertex = false;
+
+				ObjEvent event;
+				event.m_type     = ObjEvent::Group;
+				event.m_triangle = uint32_t(_chunk->m_triangles.size() );
+				event.m_name     = argv[1];
+				_chunk->m_events.push_back(event);
 			}
 			else if (*argv[0] == 'v')
 			{
-				group.m_numTriangles = (uint32_t)(_mesh->m_triangles.size() ) - group.m_startTriangle;
-				if (0 < group.m_numTriangles)
+				if (!lastWasVertex)
 				{
-					_mesh->m_groups.push_back(group);
-					group.m_startTriangle = (uint32_t)(_mesh->m_triangles.size() );
-					group.m_numTriangles = 0;
+					lastWasVertex = true;
+
+					ObjEvent event;
+					event.m_type     = ObjEvent::Vertex;
+					event.m_triangle = uint32_t(_chunk->m_triangles.size() );
+					_chunk->m_events.push_back(event);
 				}
 
 				if (0 == bx::strCmp(argv[0], "vn") )
@@ -592,8 +1072,8 @@ void parseObj(char* _data, uint32_t _size, Mesh* _mesh, bool _hasBc)
 					bx::fromString(&normal.x, argv[1]);
 					bx::fromString(&normal.y, argv[2]);
 					bx::fromString(&normal.z, argv[3]);
-					
-					_mesh->m_normals.push_back(normal);
+
+					_chunk->m_normals.push_back(normal);
 				}
 				else if (0 == bx::strCmp(argv[0], "vp") )
 				{
@@ -625,8 +1105,8 @@ void parseObj(char* _data, uint32_t _size, Mesh* _mesh, bool _hasBc)
 					default:
 						break;
 					}
-					
-					_mesh->m_texcoords.push_back(texcoord);
+
+					_chunk->m_texcoords.push_back(texcoord);
 				}
 				else
 				{
@@ -643,7 +1123,7 @@ void parseObj(char* _data, uint32_t _size, Mesh* _mesh, bool _hasBc)
 					{
 						pw = 1.0f;
 					}
-					
+
 					float invW = 1.0f/pw;
 					px *= invW;
 					py *= invW;
@@ -653,26 +1133,19 @@ void parseObj(char* _data, uint32_t _size, Mesh* _mesh, bool _hasBc)
 					pos.x = px;
 					pos.y = py;
 					pos.z = pz;
-					
-					_mesh->m_positions.push_back(pos);
+
+					_chunk->m_positions.push_back(pos);
 				}
 			}
 			else if (0 == bx::strCmp(argv[0], "usemtl") )
 			{
-				stl::string material(argv[1]);
+				lastWasVertex = false;
 
-				if (0 != bx::strCmp(material.c_str(), group.m_material.c_str() ) )
-				{
-					group.m_numTriangles = (uint32_t)(_mesh->m_triangles.size() ) - group.m_startTriangle;
-					if (0 < group.m_numTriangles)
-					{
-						_mesh->m_groups.push_back(group);
-						group.m_startTriangle = (uint32_t)(_mesh->m_triangles.size() );
-						group.m_numTriangles = 0;
-					}
-				}
-
-				group.m_material = material;
+				ObjEvent event;
+				event.m_type     = ObjEvent::Material;
+				event.m_triangle = uint32_t(_chunk->m_triangles.size() );
+				event.m_name     = argv[1];
+				_chunk->m_events.push_back(event);
 			}
 // unsupported tags
 // 				else if (0 == bx::strCmp(argv[0], "mtllib") )
@@ -686,9 +1159,186 @@ void parseObj(char* _data, uint32_t _size, Mesh* _mesh, bool _hasBc)
 // 				}
 		}
 
-		++num;
+		++_chunk->m_numLines;
 	}
-	
+}
+
+static void parseObjChunkFn(uint32_t _idx, void* _userData)
+{
+	ObjChunk* chunks = (ObjChunk*)_userData;
+	parseObjChunk(&chunks[_idx]);
+}
+
+struct ObjMerge
+{
+	ObjChunk* m_chunks;
+	Mesh* m_mesh;
+};
+
+static void mergeObjChunkFn(uint32_t _idx, void* _userData)
+{
+	ObjMerge* merge = (ObjMerge*)_userData;
+	const ObjChunk& chunk = merge->m_chunks[_idx];
+	Mesh* mesh = merge->m_mesh;
+
+	if (!chunk.m_positions.empty() )
+	{
+		bx::memCopy(&mesh->m_positions[chunk.m_positionBase], &chunk.m_positions[0], chunk.m_positions.size()*sizeof(bx::Vec3) );
+	}
+
+	if (!chunk.m_normals.empty() )
+	{
+		bx::memCopy(&mesh->m_normals[chunk.m_normalBase], &chunk.m_normals[0], chunk.m_normals.size()*sizeof(bx::Vec3) );
+	}
+
+	if (!chunk.m_texcoords.empty() )
+	{
+		bx::memCopy(&mesh->m_texcoords[chunk.m_texcoordBase], &chunk.m_texcoords[0], chunk.m_texcoords.size()*sizeof(bx::Vec3) );
+	}
+
+	for (uint32_t ii = 0, num = uint32_t(chunk.m_triangles.size() ); ii < num; ++ii)
+	{
+		TriIndices triangle = chunk.m_triangles[ii];
+		const uint16_t relative = chunk.m_relative[ii];
+
+		for (uint32_t edge = 0; edge < 3; ++edge)
+		{
+			const uint8_t flags = uint8_t(relative >> (edge*3) );
+			Index3& index = triangle.m_index[edge];
+			index.m_position += 0 != (flags & OBJ_RELATIVE_POSITION) ? int32_t(chunk.m_positionBase) : 0;
+			index.m_texcoord += 0 != (flags & OBJ_RELATIVE_TEXCOORD) ? int32_t(chunk.m_texcoordBase) : 0;
+			index.m_normal   += 0 != (flags & OBJ_RELATIVE_NORMAL)   ? int32_t(chunk.m_normalBase)   : 0;
+		}
+
+		mesh->m_triangles[chunk.m_triangleBase + ii] = triangle;
+	}
+}
+
+void parseObj(const char* _data, uint32_t _size, Mesh* _mesh, bool _hasBc)
+{
+	// Reference(s):
+	// - Wavefront .obj file
+	//   https://en.wikipedia.org/wiki/Wavefront_.obj_file
+
+	// Coordinate system is right-handed, but up/forward is not defined, but +Y Up, +Z Forward seems to be a common default
+	_mesh->m_coordinateSystem.m_handness = bx::Handness::Right;
+	_mesh->m_coordinateSystem.m_up = Axis::PositiveY;
+	_mesh->m_coordinateSystem.m_forward = Axis::PositiveZ;
+
+	// Split file into chunks on line boundaries, and parse them in parallel.
+	const uint32_t minChunkSize = 1<<20;
+	const uint32_t numChunks = bx::uint32_max(1, bx::uint32_min(s_numThreads*4, _size/minChunkSize) );
+
+	ObjChunk* chunks = new ObjChunk[numChunks];
+
+	for (uint32_t ii = 0, start = 0; ii < numChunks; ++ii)
+	{
+		uint32_t end = ii == numChunks-1 ? _size : bx::uint32_max(start, uint32_t(uint64_t(_size)*(ii+1)/numChunks) );
+		while (end < _size
+		&&     '\n' != _data[end])
+		{
+			++end;
+		}
+
+		end = bx::uint32_min(end + (end < _size ? 1 : 0), _size);
+
+		ObjChunk& chunk = chunks[ii];
+		chunk.m_data     = &_data[start];
+		chunk.m_size     = end - start;
+		chunk.m_numLines = 0;
+		chunk.m_hasBc    = _hasBc;
+
+		start = end;
+	}
+
+	int64_t elapsed = -bx::getHPCounter();
+
+	parallelFor(numChunks, parseObjChunkFn, chunks);
+
+	int64_t now = bx::getHPCounter();
+	elapsed += now;
+	int64_t mergeElapsed = -now;
+
+	uint32_t num = 0;
+	uint32_t numPositions = 0;
+	uint32_t numNormals   = 0;
+	uint32_t numTexcoords = 0;
+	uint32_t numTriangles = 0;
+
+	for (uint32_t ii = 0; ii < numChunks; ++ii)
+	{
+		ObjChunk& chunk = chunks[ii];
+		chunk.m_positionBase = numPositions;
+		chunk.m_normalBase   = numNormals;
+		chunk.m_texcoordBase = numTexcoords;
+		chunk.m_triangleBase = numTriangles;
+
+		num          += chunk.m_numLines;
+		numPositions += uint32_t(chunk.m_positions.size() );
+		numNormals   += uint32_t(chunk.m_normals.size() );
+		numTexcoords += uint32_t(chunk.m_texcoords.size() );
+		numTriangles += uint32_t(chunk.m_triangles.size() );
+	}
+
+	_mesh->m_positions.resize(numPositions);
+	_mesh->m_normals.resize(numNormals);
+	_mesh->m_texcoords.resize(numTexcoords);
+	_mesh->m_triangles.resize(numTriangles);
+
+	ObjMerge merge;
+	merge.m_chunks = chunks;
+	merge.m_mesh   = _mesh;
+	parallelFor(numChunks, mergeObjChunkFn, &merge);
+
+	// Replay group and material changes in file order.
+	Group group;
+	group.m_startTriangle = 0;
+	group.m_numTriangles = 0;
+
+	for (uint32_t ii = 0; ii < numChunks; ++ii)
+	{
+		const ObjChunk& chunk = chunks[ii];
+
+		for (ObjEventArray::const_iterator it = chunk.m_events.begin(), itEnd = chunk.m_events.end(); it != itEnd; ++it)
+		{
+			const uint32_t triangle = chunk.m_triangleBase + it->m_triangle;
+
+			switch (it->m_type)
+			{
+			case ObjEvent::Group:
+				group.m_name = it->m_name;
+				break;
+
+			case ObjEvent::Vertex:
+				group.m_numTriangles = triangle - group.m_startTriangle;
+				if (0 < group.m_numTriangles)
+				{
+					_mesh->m_groups.push_back(group);
+					group.m_startTriangle = triangle;
+					group.m_numTriangles = 0;
+				}
+				break;
+
+			case ObjEvent::Material:
+				if (0 != bx::strCmp(it->m_name.c_str(), group.m_material.c_str() ) )
+				{
+					group.m_numTriangles = triangle - group.m_startTriangle;
+					if (0 < group.m_numTriangles)
+					{
+						_mesh->m_groups.push_back(group);
+						group.m_startTriangle = triangle;
+						group.m_numTriangles = 0;
+					}
+				}
+
+				group.m_material = it->m_name;
+				break;
+			}
+		}
+	}
+
+	delete [] chunks;
+
 	group.m_numTriangles = (uint32_t)(_mesh->m_triangles.size() ) - group.m_startTriangle;
 	if (0 < group.m_numTriangles)
 	{
@@ -696,9 +1346,20 @@ void parseObj(char* _data, uint32_t _size, Mesh* _mesh, bool _hasBc)
 		group.m_startTriangle = (uint32_t)(_mesh->m_triangles.size() );
 		group.m_numTriangles = 0;
 	}
-	
+
+	mergeElapsed += bx::getHPCounter();
+
 	bx::printf("obj parser # %d\n"
 			   , num );
+
+	if (s_verbose)
+	{
+		bx::printf("obj parse %f [s], merge %f [s], chunks %d\n"
+			, double(elapsed)/bx::getHPFrequency()
+			, double(mergeElapsed)/bx::getHPFrequency()
+			, numChunks
+			);
+	}
 }
 
 
@@ -843,7 +1504,7 @@ void processGltfNode(cgltf_node* _node, Mesh* _mesh, Group* _group, bool _hasBc)
 		processGltfNode(_node->children[childIndex], _mesh, _group, _hasBc);
 }
 
-void parseGltf(char* _data, uint32_t _size, Mesh* _mesh, bool _hasBc, const bx::StringView& _path)
+void parseGltf(const char* _data, uint32_t _size, Mesh* _mesh, bool _hasBc, const bx::StringView& _path)
 {
 	// Reference(s):
 	// - Gltf 2.0 specification
@@ -889,6 +1550,82 @@ void parseGltf(char* _data, uint32_t _size, Mesh* _mesh, bool _hasBc, const bx::
 }
 
 
+struct MappedFile
+{
+	const char* m_data;
+	uint32_t m_size;
+	bool m_mapped;
+};
+
+// Maps input file into memory when possible, otherwise file is read into heap buffer.
+bool mappedFileOpen(MappedFile& _file, const char* _filePath)
+{
+	_file.m_data   = NULL;
+	_file.m_size   = 0;
+	_file.m_mapped = false;
+
+#if BX_PLATFORM_POSIX
+	int fd = ::open(_filePath, O_RDONLY);
+	if (-1 != fd)
+	{
+		struct stat st;
+		if (0 == ::fstat(fd, &st)
+		&&  0 < st.st_size
+		&&  UINT32_MAX > uint64_t(st.st_size) )
+		{
+			void* ptr = ::mmap(NULL, size_t(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+			if (MAP_FAILED != ptr)
+			{
+				::madvise(ptr, size_t(st.st_size), MADV_SEQUENTIAL);
+
+				_file.m_data   = (const char*)ptr;
+				_file.m_size   = uint32_t(st.st_size);
+				_file.m_mapped = true;
+			}
+		}
+
+		::close(fd);
+
+		if (_file.m_mapped)
+		{
+			return true;
+		}
+	}
+#endif // BX_PLATFORM_POSIX
+
+	bx::FileReader fr;
+	if (!bx::open(&fr, _filePath) )
+	{
+		return false;
+	}
+
+	uint32_t size = (uint32_t)bx::getSize(&fr);
+	char* data = new char[size+1];
+	size = bx::read(&fr, data, size);
+	data[size] = '\0';
+	bx::close(&fr);
+
+	_file.m_data = data;
+	_file.m_size = size;
+
+	return true;
+}
+
+void mappedFileClose(MappedFile& _file)
+{
+#if BX_PLATFORM_POSIX
+	if (_file.m_mapped)
+	{
+		::munmap(const_cast<char*>(_file.m_data), _file.m_size);
+		_file.m_data = NULL;
+		return;
+	}
+#endif // BX_PLATFORM_POSIX
+
+	delete [] _file.m_data;
+	_file.m_data = NULL;
+}
+
 void help(const char* _error = NULL)
 {
 	if (NULL != _error)
@@ -934,7 +1671,14 @@ void help(const char* _error = NULL)
 		  "      --tangent            Calculate tangent vectors (packing mode is the same as normal).\n"
 		  "      --barycentric        Adds barycentric vertex attribute (packed in bgfx::Attrib::Color1).\n"
 		  "  -c, --compress           Compress indices.\n"
+		  "      --index32            Use 32-bit indices, meshes are not split into 64K vertex chunks.\n"
+		  "      --meshlets           Build meshlets (bounds, normal cones, packed micro-indices) for cluster culling.\n"
+		  "      --lod <num>          Number of simplified LOD levels to generate (default 0).\n"
+		  "      --lodratio <num>     Triangle ratio between consecutive LOD levels (default 0.5).\n"
+		  "      --loderror <num>     Relative error target for first LOD level, doubled each level (default 0.01).\n"
 		  "      --[l/r]h-up+[y/z]	  Coordinate system. Default is '--lh-up+y' Left-Handed +Y is up.\n"
+		  "      --threads <num>      Number of worker threads (default 0, use all hardware threads).\n"
+		  "      --verbose            Print timing breakdown.\n"
 
 		  "\n"
 		  "For additional information, see https://github.com/bkaradzic/bgfx\n"
@@ -987,10 +1731,30 @@ int main(int _argc, const char* _argv[])
 	}
 
 	bool compress = cmdLine.hasArg('c', "compress");
+	bool index32  = cmdLine.hasArg("index32");
+	bool meshlets = cmdLine.hasArg("meshlets");
+
+	cmdLine.hasArg(s_lodNum, '\0', "lod");
+	s_lodNum = bx::uint32_min(s_lodNum, 8);
+
+	cmdLine.hasArg(s_lodRatio, '\0', "lodratio");
+	s_lodRatio = bx::clamp(s_lodRatio, 0.01f, 0.99f);
+
+	cmdLine.hasArg(s_lodError, '\0', "loderror");
+	s_lodError = bx::clamp(s_lodError, 0.0f, 1.0f);
 
 	cmdLine.hasArg(s_obbSteps, '\0', "obb");
 	s_obbSteps = bx::uint32_min(bx::uint32_max(s_obbSteps, 1), 90);
 
+	cmdLine.hasArg(s_numThreads, '\0', "threads");
+	if (0 == s_numThreads)
+	{
+		s_numThreads = std::thread::hardware_concurrency();
+	}
+	s_numThreads = bx::uint32_min(bx::uint32_max(s_numThreads, 1), 256);
+
+	s_verbose = cmdLine.hasArg("verbose");
+
 	uint32_t packNormal = 0;
 	cmdLine.hasArg(packNormal, '\0', "packnormal");
 
@@ -1014,31 +1778,33 @@ int main(int _argc, const char* _argv[])
 		}
 	}
 
-	bx::FileReader fr;
-	if (!bx::open(&fr, filePath) )
+	int64_t readElapsed = -bx::getHPCounter();
+
+	MappedFile file;
+	if (!mappedFileOpen(file, filePath) )
 	{
 		bx::printf("Unable to open input file '%s'.", filePath);
 		return bx::kExitFailure;
 	}
 
-	int64_t parseElapsed = -bx::getHPCounter();
-	int64_t triReorderElapsed = 0;
+	workerPoolInit(s_numThreads);
 
-	uint32_t size = (uint32_t)bx::getSize(&fr);
-	char* data = new char[size+1];
-	size = bx::read(&fr, data, size);
-	data[size] = '\0';
-	bx::close(&fr);
+	int64_t now = bx::getHPCounter();
+	readElapsed += now;
+
+	int64_t parseElapsed = -now;
+	int64_t triReorderElapsed = 0;
+	int64_t tangentElapsed = 0;
 
 	Mesh mesh;
 	bx::StringView ext = bx::FilePath(filePath).getExt();
 	if (0 == bx::strCmpI(ext, ".obj"))
 	{
-		parseObj(data, size, &mesh, hasBc);
+		parseObj(file.m_data, file.m_size, &mesh, hasBc);
 	}
 	else if (0 == bx::strCmpI(ext, ".gltf") || 0 == bx::strCmpI(ext, ".glb"))
 	{
-		parseGltf(data, size, &mesh, hasBc, bx::FilePath(filePath).getPath());
+		parseGltf(file.m_data, file.m_size, &mesh, hasBc, bx::FilePath(filePath).getPath());
 	}
 	else
 	{
@@ -1046,9 +1812,9 @@ int main(int _argc, const char* _argv[])
 		exit(bx::kExitFailure);
 	}
 
-	delete [] data;
+	mappedFileClose(file);
 
-	int64_t now = bx::getHPCounter();
+	now = bx::getHPCounter();
 	parseElapsed += now;
 	int64_t convertElapsed = -now;
 
@@ -1189,7 +1955,7 @@ int main(int _argc, const char* _argv[])
 
 	uint32_t stride = layout.getStride();
 	uint8_t* vertexData = new uint8_t[mesh.m_triangles.size() * 3 * stride];
-	uint16_t* indexData = new uint16_t[mesh.m_triangles.size() * 3];
+	uint32_t* indexData = new uint32_t[mesh.m_triangles.size() * 3];
 	int32_t numVertices = 0;
 	int32_t numIndices = 0;
 
@@ -1198,9 +1964,14 @@ int main(int _argc, const char* _argv[])
 	int32_t writtenIndices = 0;
 
 	uint8_t* vertices = vertexData;
-	uint16_t* indices = indexData;
-	
-	const uint32_t tableSize = 65536 * 2;
+	uint32_t* indices = indexData;
+
+	const uint32_t maxVertices = index32 ? UINT32_MAX - 3 : 65533;
+
+	const uint32_t tableSize = index32
+		? bx::uint32_nextpow2(bx::uint32_max(65536 * 2, uint32_t(mesh.m_triangles.size() ) * 3 * 2) )
+		: 65536 * 2
+		;
 	const uint32_t hashmod = tableSize - 1;
 	uint32_t* table = new uint32_t[tableSize];
 	bx::memSet(table, 0xff, tableSize * sizeof(uint32_t));
@@ -1236,7 +2007,7 @@ int main(int _argc, const char* _argv[])
 		{
 			if (0 != bx::strCmp(material.c_str(), groupIt->m_material.c_str() )
 			|| sentinel
-			||  65533 <= numVertices)
+			||  maxVertices <= uint32_t(numVertices) )
 			{
 				prim.m_numVertices = numVertices - prim.m_startVertex;
 				prim.m_numIndices  = numIndices  - prim.m_startIndex;
@@ -1247,14 +2018,20 @@ int main(int _argc, const char* _argv[])
 
 				if (hasTangent)
 				{
-					calcTangents(vertexData, uint16_t(numVertices), layout, indexData, numIndices);
+					tangentElapsed -= bx::getHPCounter();
+					calcTangents(vertexData, numVertices, layout, indexData, numIndices);
+					tangentElapsed += bx::getHPCounter();
 				}
 
 				triReorderElapsed -= bx::getHPCounter();
-				for (PrimitiveArray::const_iterator primIt = primitives.begin(); primIt != primitives.end(); ++primIt)
+				if (!primitives.empty() )
 				{
-					const Primitive& prim1 = *primIt;
-					optimizeVertexCache(indexData + prim1.m_startIndex, prim1.m_numIndices, numVertices);
+					// Primitives own disjoint index ranges, so they can be optimized independently.
+					OptimizeVertexCache ovc;
+					ovc.m_indices     = indexData;
+					ovc.m_primitives  = &primitives[0];
+					ovc.m_numVertices = numVertices;
+					parallelFor(uint32_t(primitives.size() ), optimizeVertexCacheFn, &ovc);
 				}
 				numVertices = optimizeVertexFetch(indexData, numIndices, vertexData, numVertices, uint16_t(stride));
 
@@ -1269,6 +2046,8 @@ int main(int _argc, const char* _argv[])
 						  , indexData
 						  , numIndices
 						  , compress
+						  , index32
+						  , meshlets
 						  , material
 						  , primitives
 						  );
@@ -1372,7 +2151,7 @@ int main(int _argc, const char* _argv[])
 					exit(bx::kExitFailure);
 				}
 				
-				*indices++ = (uint16_t)vertexIndex;
+				*indices++ = vertexIndex;
 				++numIndices;
 			}
 		}
@@ -1417,5 +2196,28 @@ int main(int _argc, const char* _argv[])
 		, writtenIndices
 		);
 
+	if (s_verbose)
+	{
+		const double freq = double(bx::getHPFrequency() );
+		bx::printf("threads %d\n"
+			"  read     %f [s] (%s)\n"
+			"  parse    %f [s]\n"
+			"  tangents %f [s]\n"
+			"  optimize %f [s]\n"
+			"  bounds   %f [s]\n"
+			"  write    %f [s]\n"
+			, s_numThreads
+			, double(readElapsed)/freq
+			, file.m_mapped ? "mmap" : "read"
+			, double(parseElapsed)/freq
+			, double(tangentElapsed)/freq
+			, double(triReorderElapsed)/freq
+			, double(s_boundsElapsed)/freq
+			, double(convertElapsed - tangentElapsed - triReorderElapsed - s_boundsElapsed)/freq
+			);
+	}
+
+	workerPoolShutdown();
+
 	return bx::kExitSuccess;
 }
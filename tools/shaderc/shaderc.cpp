@@ -18,9 +18,15 @@ extern "C"
 #define BGFX_CHUNK_MAGIC_FSH BX_MAKEFOURCC('F', 'S', 'H', BGFX_SHADER_BIN_VERSION)
 #define BGFX_CHUNK_MAGIC_GSH BX_MAKEFOURCC('G', 'S', 'H', BGFX_SHADER_BIN_VERSION)
 #define BGFX_CHUNK_MAGIC_VSH BX_MAKEFOURCC('V', 'S', 'H', BGFX_SHADER_BIN_VERSION)
+#define BGFX_CHUNK_MAGIC_SVP BX_MAKEFOURCC('S', 'V', 'P', 0x1)
+#define BGFX_CHUNK_MAGIC_SAR BX_MAKEFOURCC('S', 'A', 'R', 0x1)
+
+#define SHADERC_ARCHIVE_ALIGN 16
 
 #define BGFX_SHADERC_VERSION_MAJOR 1
-#define BGFX_SHADERC_VERSION_MINOR 16
+#define BGFX_SHADERC_VERSION_MINOR 17
+
+#define SHADERC_MAX_VARIANT_KEYWORDS 32
 
 namespace bgfx
 {
@@ -203,6 +209,8 @@ namespace bgfx
 		, keepIntermediate(false)
 		, optimize(false)
 		, optimizationLevel(3)
+		, preprocessFilter(NULL)
+		, preprocessFilterUserData(NULL)
 	{
 	}
 
@@ -431,6 +439,28 @@ namespace bgfx
 		Buffer m_buffer;
 	};
 
+	class BufferWriter : public bx::FileWriter
+	{
+	public:
+		BufferWriter()
+		{
+		}
+
+		virtual ~BufferWriter()
+		{
+		}
+
+		virtual int32_t write(const void* _data, int32_t _size, bx::Error*) override
+		{
+			const uint8_t* data = (const uint8_t*)_data;
+			m_buffer.insert(m_buffer.end(), data, data+_size);
+			return _size;
+		}
+
+		typedef std::vector<uint8_t> Buffer;
+		Buffer m_buffer;
+	};
+
 	struct Varying
 	{
 		std::string m_precision;
@@ -879,6 +909,7 @@ namespace bgfx
 
 		bx::printf(
 			  "Usage: shaderc -f <in> -o <out> --type <v/f> --platform <platform>\n"
+			  "       shaderc --archive -f <list> -o <out>\n"
 
 			  "\n"
 			  "Options:\n"
@@ -887,6 +918,8 @@ namespace bgfx
 			  "  -f <file path>                Input file path.\n"
 			  "  -i <include path>             Include path (for multiple paths use -i multiple times).\n"
 			  "  -o <file path>                Output file path.\n"
+			  "      --archive                 Pack compiled shaders listed in input file (one path per line,\n"
+			  "                                relative to list file) into single shader archive.\n"
 			  "      --bin2c [array name]      Generate C header file. If array name is not specified base file name will be used as name.\n"
 			  "      --depends                 Generate makefile style depends file.\n"
 			  "      --platform <platform>     Target platform.\n"
@@ -907,6 +940,9 @@ namespace bgfx
 				"           spirv\n"
 			  "      --preprocess              Preprocess only.\n"
 			  "      --define <defines>        Add defines to preprocessor (semicolon separated).\n"
+			  "      --variants <sets>         Build multi-variant shader pack. Keyword sets are semicolon separated,\n"
+			  "                                keywords within set are comma separated, '_' means no keyword.\n"
+			  "                                (e.g. \"_,SHADOW;FOG_LINEAR,FOG_EXP\")\n"
 			  "      --raw                     Do not process shader. No preprocessor, and no glsl-optimizer (GLSL only).\n"
 			  "      --type <type>             Shader type (vertex, fragment)\n"
 			  "      --varyingdef <file path>  Path to varying.def.sc file.\n"
@@ -1447,6 +1483,16 @@ namespace bgfx
 					{
 						bx::write(_writer, preprocessor.m_preprocessed.c_str(), (int32_t)preprocessor.m_preprocessed.size() );
 
+						delete [] data;
+
+						return true;
+					}
+
+					if (NULL != _options.preprocessFilter
+					&&  !_options.preprocessFilter(preprocessor.m_preprocessed, _options.preprocessFilterUserData) )
+					{
+						delete [] data;
+
 						return true;
 					}
 
@@ -1681,6 +1727,16 @@ namespace bgfx
 					{
 						bx::write(_writer, preprocessor.m_preprocessed.c_str(), (int32_t)preprocessor.m_preprocessed.size());
 
+						delete [] data;
+
+						return true;
+					}
+
+					if (NULL != _options.preprocessFilter
+					&&  !_options.preprocessFilter(preprocessor.m_preprocessed, _options.preprocessFilterUserData) )
+					{
+						delete [] data;
+
 						return true;
 					}
 
@@ -2153,6 +2209,16 @@ namespace bgfx
 						}
 						bx::write(_writer, preprocessor.m_preprocessed.c_str(), (int32_t)preprocessor.m_preprocessed.size() );
 
+						delete [] data;
+
+						return true;
+					}
+
+					if (NULL != _options.preprocessFilter
+					&&  !_options.preprocessFilter(preprocessor.m_preprocessed, _options.preprocessFilterUserData) )
+					{
+						delete [] data;
+
 						return true;
 					}
 
@@ -2527,6 +2593,353 @@ namespace bgfx
 		return compiled;
 	}
 
+	typedef std::vector<std::string> KeywordSet;
+	typedef std::vector<KeywordSet> KeywordSetArray;
+
+	void parseKeywordSets(KeywordSetArray& _sets, const char* _str)
+	{
+		bx::StringView parse(_str);
+
+		while (!parse.isEmpty() )
+		{
+			bx::StringView eos = bx::strFind(parse, ';');
+			bx::StringView set(parse.getPtr(), eos.getPtr() );
+
+			KeywordSet keywords;
+			while (!set.isEmpty() )
+			{
+				bx::StringView eok = bx::strFind(set, ',');
+				bx::StringView keyword = bx::strRTrim(bx::strLTrimSpace(bx::StringView(set.getPtr(), eok.getPtr() ) ), " \t");
+
+				if (!keyword.isEmpty() )
+				{
+					keywords.push_back(std::string(keyword.getPtr(), keyword.getTerm() ) );
+				}
+
+				set = eok.isEmpty() ? bx::StringView() : bx::StringView(eok.getPtr()+1, set.getTerm() );
+			}
+
+			if (!keywords.empty() )
+			{
+				_sets.push_back(keywords);
+			}
+
+			parse = eos.isEmpty() ? bx::StringView() : bx::StringView(eos.getPtr()+1, parse.getTerm() );
+		}
+	}
+
+	static char* copyShaderSource(const char* _shader, uint32_t _shaderLen, uint32_t _padding)
+	{
+		char* data = new char[_shaderLen+_padding+1];
+		bx::memCopy(data, _shader, _shaderLen+_padding+1);
+		return data;
+	}
+
+	// Compiles every combination of keywords from keyword sets, and writes them into single
+	// shader pack. Variants with identical preprocessed output share the same compiled shader,
+	// so only unique variants hit the backend compiler.
+	//
+	// Shader pack format:
+	//   uint32_t magic ('SVP', 1)
+	//   uint8_t  numKeywords, { uint8_t len, char name[len] } * numKeywords
+	//   uint16_t numVariants, { uint32_t keywordMask, uint16_t shaderIndex } * numVariants
+	//   uint16_t numShaders,  { uint32_t size, uint8_t shader[size] } * numShaders
+	//
+	bool compileShaderVariants(const char* _varying, const char* _comment, const char* _shader, uint32_t _shaderLen, uint32_t _padding, const KeywordSetArray& _sets, Options& _options, bx::FileWriter* _writer)
+	{
+		typedef std::vector<std::string> KeywordArray;
+		KeywordArray keywords;
+
+		uint32_t numCombinations = 1;
+		for (KeywordSetArray::const_iterator it = _sets.begin(), itEnd = _sets.end(); it != itEnd; ++it)
+		{
+			for (KeywordSet::const_iterator kt = it->begin(), ktEnd = it->end(); kt != ktEnd; ++kt)
+			{
+				if ("_" != *kt
+				&&  keywords.end() == std::find(keywords.begin(), keywords.end(), *kt) )
+				{
+					keywords.push_back(*kt);
+				}
+			}
+
+			numCombinations *= uint32_t(it->size() );
+		}
+
+		if (SHADERC_MAX_VARIANT_KEYWORDS < keywords.size() )
+		{
+			bx::printf("Too many variant keywords %d (max %d).\n", uint32_t(keywords.size() ), SHADERC_MAX_VARIANT_KEYWORDS);
+			return false;
+		}
+
+		if (UINT16_MAX < numCombinations)
+		{
+			bx::printf("Too many shader variants %d (max %d).\n", numCombinations, UINT16_MAX);
+			return false;
+		}
+
+		struct Variant
+		{
+			uint32_t mask;
+			uint16_t shaderIndex;
+		};
+
+		struct CompiledShader
+		{
+			uint32_t hash;
+			std::string preprocessed;
+			BufferWriter::Buffer code;
+		};
+
+		// Variant is preprocessed only once. Filter looks for unique shader with identical
+		// preprocessed output, and lets backend compile the variant only when there is none.
+		struct Dedupe
+		{
+			static bool filter(const std::string& _preprocessed, void* _userData)
+			{
+				Dedupe& dedupe = *(Dedupe*)_userData;
+
+				const uint32_t hash = bx::hash<bx::HashMurmur2A>(_preprocessed.c_str(), uint32_t(_preprocessed.size() ) );
+
+				for (uint32_t ii = 0, num = uint32_t(dedupe.shaders.size() ); ii < num; ++ii)
+				{
+					const CompiledShader& shader = dedupe.shaders[ii];
+					if (hash == shader.hash
+					&&  _preprocessed == shader.preprocessed)
+					{
+						dedupe.shaderIndex = ii;
+						return false;
+					}
+				}
+
+				CompiledShader shader;
+				shader.hash         = hash;
+				shader.preprocessed = _preprocessed;
+				dedupe.shaderIndex  = uint32_t(dedupe.shaders.size() );
+				dedupe.shaders.push_back(shader);
+
+				return true;
+			}
+
+			std::vector<CompiledShader> shaders;
+			uint32_t shaderIndex;
+		};
+
+		std::vector<Variant> variants;
+		Dedupe dedupe;
+
+		for (uint32_t ii = 0; ii < numCombinations; ++ii)
+		{
+			Options options = _options;
+			options.depends = _options.depends && 0 == ii;
+			options.preprocessFilter = Dedupe::filter;
+			options.preprocessFilterUserData = &dedupe;
+
+			Variant variant;
+			variant.mask = 0;
+
+			for (uint32_t jj = 0, rem = ii, num = uint32_t(_sets.size() ); jj < num; ++jj)
+			{
+				const KeywordSet& set = _sets[jj];
+				const std::string& keyword = set[rem % set.size()];
+				rem /= uint32_t(set.size() );
+
+				if ("_" != keyword)
+				{
+					const uint32_t idx = uint32_t(std::find(keywords.begin(), keywords.end(), keyword) - keywords.begin() );
+					variant.mask |= UINT32_C(1) << idx;
+					options.defines.push_back(keyword + "=1");
+				}
+			}
+
+			const uint32_t numShaders = uint32_t(dedupe.shaders.size() );
+			dedupe.shaderIndex = UINT32_MAX;
+
+			BufferWriter code;
+			if (!compileShader(_varying, _comment, copyShaderSource(_shader, _shaderLen, _padding), _shaderLen, options, &code)
+			||  UINT32_MAX == dedupe.shaderIndex)
+			{
+				bx::printf("Failed to compile shader variant 0x%08x.\n", variant.mask);
+				return false;
+			}
+
+			if (numShaders != dedupe.shaders.size() )
+			{
+				dedupe.shaders.back().code.swap(code.m_buffer);
+			}
+
+			BX_TRACE("Variant 0x%08x -> shader %d.", variant.mask, dedupe.shaderIndex);
+
+			variant.shaderIndex = uint16_t(dedupe.shaderIndex);
+			variants.push_back(variant);
+		}
+
+		const std::vector<CompiledShader>& shaders = dedupe.shaders;
+
+		BX_TRACE("Variants: %d, unique shaders: %d.", uint32_t(variants.size() ), uint32_t(shaders.size() ) );
+
+		bx::write(_writer, BGFX_CHUNK_MAGIC_SVP);
+
+		bx::write(_writer, uint8_t(keywords.size() ) );
+		for (KeywordArray::const_iterator it = keywords.begin(), itEnd = keywords.end(); it != itEnd; ++it)
+		{
+			bx::write(_writer, uint8_t(it->size() ) );
+			bx::write(_writer, it->c_str(), int32_t(it->size() ) );
+		}
+
+		bx::write(_writer, uint16_t(variants.size() ) );
+		for (std::vector<Variant>::const_iterator it = variants.begin(), itEnd = variants.end(); it != itEnd; ++it)
+		{
+			bx::write(_writer, it->mask);
+			bx::write(_writer, it->shaderIndex);
+		}
+
+		bx::write(_writer, uint16_t(shaders.size() ) );
+		for (std::vector<CompiledShader>::const_iterator it = shaders.begin(), itEnd = shaders.end(); it != itEnd; ++it)
+		{
+			const uint32_t size = uint32_t(it->code.size() );
+			bx::write(_writer, size);
+			bx::write(_writer, it->code.data(), int32_t(size) );
+		}
+
+		return true;
+	}
+
+	// Shader archive contains compiled shaders for any number of renderer profiles, so that
+	// runtime can map single file instead of opening each shader separately.
+	//
+	// Shader archive format:
+	//   uint32_t magic ('SAR', 1)
+	//   uint32_t numEntries
+	//   { uint32_t hash, uint32_t offset, uint32_t size } * numEntries, sorted by hash
+	//   shader data, each shader aligned to SHADERC_ARCHIVE_ALIGN bytes
+	//
+	// Entry hash is MurmurHash2A of shader path relative to list file, without .bin extension
+	// (e.g. "shaders/glsl/vs_cubes").
+	//
+	int buildShaderArchive(const char* _listFilePath, const char* _outFilePath)
+	{
+		File list;
+		list.load(_listFilePath);
+
+		if (NULL == list.getData() )
+		{
+			bx::printf("Unable to open file '%s'.\n", _listFilePath);
+			return bx::kExitFailure;
+		}
+
+		std::string dir;
+		{
+			bx::FilePath fp(_listFilePath);
+			bx::StringView path(fp.getPath() );
+			dir.assign(path.getPtr(), path.getTerm() );
+		}
+
+		struct Entry
+		{
+			uint32_t hash;
+			uint32_t offset;
+			uint32_t size;
+
+			bool operator<(const Entry& _rhs) const
+			{
+				return hash < _rhs.hash;
+			}
+		};
+
+		std::vector<Entry> entries;
+		std::vector<std::string> names;
+		BufferWriter::Buffer data;
+
+		bx::StringView parse(list.getData() );
+		while (!parse.isEmpty() )
+		{
+			bx::StringView eol  = bx::strFindEol(parse);
+			bx::StringView path = bx::strRTrim(bx::strLTrimSpace(bx::StringView(parse.getPtr(), eol.getPtr() ) ), " \t\r");
+			parse = bx::strLTrimSpace(bx::strFindNl(eol) );
+
+			if (path.isEmpty()
+			||  '#' == path.getPtr()[0])
+			{
+				continue;
+			}
+
+			std::string name(path.getPtr(), path.getTerm() );
+			std::string filePath = dir + name;
+
+			bx::StringView ext = bx::strFindI(name.c_str(), ".bin");
+			if (!ext.isEmpty() )
+			{
+				name.resize(ext.getPtr() - name.c_str() );
+			}
+
+			File shader;
+			shader.load(filePath.c_str() );
+
+			if (NULL == shader.getData() )
+			{
+				bx::printf("Unable to open file '%s'.\n", filePath.c_str() );
+				return bx::kExitFailure;
+			}
+
+			Entry entry;
+			entry.hash   = bx::hash<bx::HashMurmur2A>(name.c_str(), uint32_t(name.size() ) );
+			entry.offset = uint32_t(data.size() );
+			entry.size   = shader.getSize();
+
+			for (uint32_t ii = 0, num = uint32_t(entries.size() ); ii < num; ++ii)
+			{
+				if (entries[ii].hash == entry.hash)
+				{
+					bx::printf("Shader '%s' hash collides with '%s'.\n", name.c_str(), names[ii].c_str() );
+					return bx::kExitFailure;
+				}
+			}
+
+			const uint8_t* shaderData = (const uint8_t*)shader.getData();
+			data.insert(data.end(), shaderData, shaderData + entry.size);
+			data.resize(bx::alignUp(uint32_t(data.size() ), SHADERC_ARCHIVE_ALIGN), 0);
+
+			BX_TRACE("%08x %8d %s", entry.hash, entry.size, name.c_str() );
+
+			entries.push_back(entry);
+			names.push_back(name);
+		}
+
+		std::sort(entries.begin(), entries.end() );
+
+		const uint32_t numEntries = uint32_t(entries.size() );
+		const uint32_t headerSize = bx::alignUp(uint32_t(sizeof(uint32_t)*2 + sizeof(Entry)*numEntries), SHADERC_ARCHIVE_ALIGN);
+
+		bx::FileWriter writer;
+		if (!bx::open(&writer, _outFilePath) )
+		{
+			bx::printf("Unable to open output file '%s'.\n", _outFilePath);
+			return bx::kExitFailure;
+		}
+
+		bx::write(&writer, BGFX_CHUNK_MAGIC_SAR);
+		bx::write(&writer, numEntries);
+
+		for (std::vector<Entry>::const_iterator it = entries.begin(), itEnd = entries.end(); it != itEnd; ++it)
+		{
+			bx::write(&writer, it->hash);
+			bx::write(&writer, headerSize + it->offset);
+			bx::write(&writer, it->size);
+		}
+
+		const uint8_t zero[SHADERC_ARCHIVE_ALIGN] = {};
+		bx::write(&writer, zero, int32_t(headerSize - sizeof(uint32_t)*2 - sizeof(Entry)*numEntries) );
+
+		if (!data.empty() )
+		{
+			bx::write(&writer, data.data(), int32_t(data.size() ) );
+		}
+
+		bx::close(&writer);
+
+		return bx::kExitSuccess;
+	}
+
 	char     _shaderErrorBuffer[UINT16_MAX];
 	uint16_t _shaderErrorBufferPos = 0;
 
@@ -2581,6 +2994,11 @@ namespace bgfx
 			return bx::kExitFailure;
 		}
 
+		if (cmdLine.hasArg("archive") )
+		{
+			return buildShaderArchive(filePath, outFilePath);
+		}
+
 		const char* type = cmdLine.findOption('\0', "type");
 		if (NULL == type)
 		{
@@ -2698,6 +3116,20 @@ namespace bgfx
 			defines = ';' == *eol.getPtr() ? eol.getPtr()+1 : eol.getPtr();
 		}
 
+		KeywordSetArray keywordSets;
+		const char* variants = cmdLine.findOption("variants");
+		if (NULL != variants)
+		{
+			parseKeywordSets(keywordSets, variants);
+
+			if (options.raw
+			||  options.preprocessOnly)
+			{
+				help("Shader variants can't be used with --raw or --preprocess.");
+				return bx::kExitFailure;
+			}
+		}
+
 		std::string commandLineComment = "// shaderc command line:\n//";
 		for (int32_t ii = 0, num = cmdLine.getNum(); ii < num; ++ii)
 		{
@@ -2771,7 +3203,15 @@ namespace bgfx
 				return bx::kExitFailure;
 			}
 
-			compiled = compileShader(varying, commandLineComment.c_str(), data, size, options, writer);
+			if (keywordSets.empty() )
+			{
+				compiled = compileShader(varying, commandLineComment.c_str(), data, size, options, writer);
+			}
+			else
+			{
+				compiled = compileShaderVariants(varying, commandLineComment.c_str(), data, size, uint32_t(padding), keywordSets, options, writer);
+				delete [] data;
+			}
 
 			bx::close(writer);
 			delete writer;
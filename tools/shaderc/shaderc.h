@@ -125,6 +125,10 @@ namespace bgfx
 		uint8_t texDimension;
 	};
 
+	/// Called with preprocessed shader source before it's compiled. Returning false skips
+	/// compilation, and shader is reported as compiled without writing any output.
+	typedef bool (*PreprocessFilterFn)(const std::string& _preprocessed, void* _userData);
+
 	struct Options
 	{
 		Options();
@@ -159,6 +163,9 @@ namespace bgfx
 
 		bool optimize;
 		uint32_t optimizationLevel;
+
+		PreprocessFilterFn preprocessFilter;
+		void* preprocessFilterUserData;
 	};
 
 	typedef std::vector<Uniform> UniformArray;